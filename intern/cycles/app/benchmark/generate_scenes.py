@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+#
+# Copyright 2011-2015 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License
+
+# <pep8 compliant>
+
+"""
+Generate the synthetic XML scenes used to benchmark the standalone Cycles
+application. Scenes are generated from fixed seeds, so the same arguments
+always give the same files.
+
+Usage:
+    generate_scenes.py [--output DIR] [--scale FACTOR] [--texture-size SIZE]
+
+Render a scene and print timings as JSON with:
+    cycles --benchmark --samples 16 DIR/instancing.xml
+"""
+
+import argparse
+import math
+import os
+import random
+
+
+# ----------------------------------------------------------------------------
+# Helpers
+
+
+def fmt(values):
+    return " ".join("%.6g" % v for v in values)
+
+
+def uv_sphere(segments, rings, radius=1.0):
+    """Quad/triangle sphere, returns (P, nverts, verts)."""
+    P = [(0.0, 0.0, radius)]
+    for r in range(1, rings):
+        theta = math.pi * r / rings
+        for s in range(segments):
+            phi = 2.0 * math.pi * s / segments
+            P.append((radius * math.sin(theta) * math.cos(phi),
+                      radius * math.sin(theta) * math.sin(phi),
+                      radius * math.cos(theta)))
+    P.append((0.0, 0.0, -radius))
+
+    nverts = []
+    verts = []
+    last = len(P) - 1
+
+    for s in range(segments):
+        nverts.append(3)
+        verts += [0, 1 + s, 1 + (s + 1) % segments]
+
+    for r in range(rings - 2):
+        row = 1 + r * segments
+        next_row = row + segments
+        for s in range(segments):
+            s1 = (s + 1) % segments
+            nverts.append(4)
+            verts += [row + s, next_row + s, next_row + s1, row + s1]
+
+    row = 1 + (rings - 2) * segments
+    for s in range(segments):
+        nverts.append(3)
+        verts += [row + (s + 1) % segments, row + s, last]
+
+    return P, nverts, verts
+
+
+def mesh_xml(P, nverts, verts, name=None):
+    attrs = ""
+    if name:
+        attrs = ' name="%s"' % name
+    return '<mesh%s P="%s" nverts="%s" verts="%s" />\n' % (
+        attrs,
+        fmt(c for p in P for c in p),
+        " ".join(str(n) for n in nverts),
+        " ".join(str(v) for v in verts))
+
+
+def header(width=960, height=540, camera_z=-10.0):
+    return (
+        '<camera width="%d" height="%d" />\n'
+        '<transform translate="0 0 %g" scale="1 1 -1">\n'
+        '\t<camera type="perspective" />\n'
+        '</transform>\n'
+        '<background>\n'
+        '\t<background name="bg" strength="1.0" color="0.3 0.35 0.4" />\n'
+        '\t<connect from="bg background" to="output surface" />\n'
+        '</background>\n'
+        '<shader name="floor">\n'
+        '\t<diffuse_bsdf name="floor_closure" color="0.8 0.8 0.8" />\n'
+        '\t<connect from="floor_closure bsdf" to="output surface" />\n'
+        '</shader>\n'
+        '<state shader="floor">\n'
+        '\t<mesh P="-50 -3 -50 50 -3 -50 50 -3 50 -50 -3 50" nverts="4" verts="0 1 2 3" />\n'
+        '</state>\n') % (width, height, camera_z)
+
+
+def write(directory, name, text):
+    filepath = os.path.join(directory, name)
+    with open(filepath, "w") as f:
+        f.write(text)
+    print("Wrote %s" % filepath)
+
+
+# ----------------------------------------------------------------------------
+# Scenes
+
+
+def scene_instancing(directory, scale):
+    """Many instances of a single mesh, stresses the top level BVH."""
+    rng = random.Random(1)
+    P, nverts, verts = uv_sphere(32, 16, 0.2)
+    count = int(20000 * scale)
+
+    text = header()
+    text += ('<shader name="leaves">\n'
+             '\t<diffuse_bsdf name="leaves_closure" color="0.2 0.5 0.1" />\n'
+             '\t<connect from="leaves_closure bsdf" to="output surface" />\n'
+             '</shader>\n'
+             '<state shader="leaves" interpolation="smooth">\n')
+    text += "\t" + mesh_xml(P, nverts, verts, name="tree")
+    for i in range(count):
+        x = rng.uniform(-20.0, 20.0)
+        z = rng.uniform(0.0, 40.0)
+        s = rng.uniform(0.5, 1.5)
+        text += '\t<transform translate="%g -2.8 %g" scale="%g %g %g"><instance mesh="tree" /></transform>\n' % (
+            x, z, s, s, s)
+    text += '</state>\n'
+
+    write(directory, "instancing.xml", text)
+
+
+def scene_hair(directory, scale):
+    """Dense hair strands on a sphere."""
+    rng = random.Random(2)
+    count = int(50000 * scale)
+    keys = 5
+
+    text = header()
+    text += ('<shader name="hair">\n'
+             '\t<hair_bsdf name="hair_closure" color="0.4 0.25 0.1" component="Reflection" />\n'
+             '\t<connect from="hair_closure bsdf" to="output surface" />\n'
+             '</shader>\n'
+             '<state shader="hair">\n')
+
+    P = []
+    for i in range(count):
+        # uniform direction on the sphere
+        z = rng.uniform(-1.0, 1.0)
+        phi = rng.uniform(0.0, 2.0 * math.pi)
+        r = math.sqrt(1.0 - z * z)
+        d = (r * math.cos(phi), r * math.sin(phi), z)
+        for k in range(keys):
+            t = 2.0 + 0.3 * k
+            P.append((d[0] * t, d[1] * t - 0.5 * (k * 0.1) ** 2, d[2] * t))
+
+    text += '\t<hair P="%s" nkeys="%s" radius="0.004" />\n' % (
+        fmt(c for p in P for c in p), " ".join([str(keys)] * count))
+    text += '</state>\n'
+
+    write(directory, "hair.xml", text)
+
+
+def scene_sss(directory, scale):
+    """Subsurface scattering on a dense sphere."""
+    segments = int(256 * math.sqrt(scale))
+    P, nverts, verts = uv_sphere(segments, segments // 2, 2.5)
+
+    text = header()
+    text += ('<shader name="skin">\n'
+             '\t<subsurface_scattering name="sss" color="0.9 0.6 0.5" scale="0.5" radius="1.0 0.3 0.1" />\n'
+             '\t<connect from="sss bssrdf" to="output surface" />\n'
+             '</shader>\n'
+             '<state shader="skin" interpolation="smooth">\n')
+    text += "\t" + mesh_xml(P, nverts, verts)
+    text += '</state>\n'
+
+    write(directory, "sss.xml", text)
+
+
+def scene_volumes(directory, scale):
+    """Scattering and absorbing volumes inside closed meshes."""
+    rng = random.Random(4)
+    P, nverts, verts = uv_sphere(32, 16, 1.0)
+    count = max(1, int(8 * scale))
+
+    text = header()
+    text += ('<shader name="smoke">\n'
+             '\t<scatter_volume name="scatter" color="0.8 0.8 0.8" density="0.5" />\n'
+             '\t<absorption_volume name="absorb" color="0.6 0.7 0.9" density="0.3" />\n'
+             '\t<add_closure name="add" />\n'
+             '\t<connect from="scatter volume" to="add closure1" />\n'
+             '\t<connect from="absorb volume" to="add closure2" />\n'
+             '\t<connect from="add closure" to="output volume" />\n'
+             '</shader>\n'
+             '<state shader="smoke">\n')
+    text += "\t" + mesh_xml(P, nverts, verts, name="blob")
+    for i in range(count):
+        x = rng.uniform(-5.0, 5.0)
+        y = rng.uniform(-1.0, 2.0)
+        z = rng.uniform(0.0, 6.0)
+        s = rng.uniform(0.8, 2.0)
+        text += '\t<transform translate="%g %g %g" scale="%g %g %g"><instance mesh="blob" /></transform>\n' % (
+            x, y, z, s, s, s)
+    text += '</state>\n'
+
+    write(directory, "volumes.xml", text)
+
+
+def scene_many_lights(directory, scale):
+    """Many small point lights, stresses light sampling."""
+    rng = random.Random(5)
+    count = int(2000 * scale)
+    P, nverts, verts = uv_sphere(64, 32, 2.0)
+
+    text = header()
+    text += ('<shader name="lamp">\n'
+             '\t<emission name="emit" color="1 0.9 0.8" strength="20" />\n'
+             '\t<connect from="emit emission" to="output surface" />\n'
+             '</shader>\n'
+             '<state interpolation="smooth">\n')
+    text += "\t" + mesh_xml(P, nverts, verts)
+    text += '</state>\n'
+    text += '<state shader="lamp">\n'
+    for i in range(count):
+        text += '\t<light type="0" P="%g %g %g" size="0.05" />\n' % (
+            rng.uniform(-15.0, 15.0), rng.uniform(-2.5, 8.0), rng.uniform(-5.0, 25.0))
+    text += '</state>\n'
+
+    write(directory, "many_lights.xml", text)
+
+
+def write_ppm(filepath, size, seed):
+    """Binary RGB image with a deterministic pattern."""
+    rng = random.Random(seed)
+    freq = [rng.uniform(4.0, 32.0) for i in range(3)]
+    with open(filepath, "wb") as f:
+        f.write(b"P6\n%d %d\n255\n" % (size, size))
+        row = bytearray(size * 3)
+        for y in range(size):
+            for x in range(size):
+                for c in range(3):
+                    v = math.sin(freq[c] * x / size * 2.0 * math.pi) * math.cos(freq[c] * y / size * 2.0 * math.pi)
+                    row[x * 3 + c] = int(127.5 + 127.5 * v)
+            f.write(row)
+    print("Wrote %s" % filepath)
+
+
+def scene_textures(directory, scale, texture_size):
+    """Several large image textures mixed on one surface."""
+    count = 4
+    for i in range(count):
+        write_ppm(os.path.join(directory, "texture_%d.ppm" % i), texture_size, 6 + i)
+
+    P, nverts, verts = uv_sphere(64, 32, 2.5)
+
+    text = header()
+    text += '<shader name="textured">\n'
+    for i in range(count):
+        text += '\t<image_texture name="tex%d" src="texture_%d.ppm" />\n' % (i, i)
+    text += ('\t<mix name="mix_a" type="Mix" fac="0.5" />\n'
+             '\t<mix name="mix_b" type="Mix" fac="0.5" />\n'
+             '\t<mix name="mix_c" type="Multiply" fac="0.5" />\n'
+             '\t<diffuse_bsdf name="diffuse" />\n'
+             '\t<connect from="tex0 color" to="mix_a color1" />\n'
+             '\t<connect from="tex1 color" to="mix_a color2" />\n'
+             '\t<connect from="tex2 color" to="mix_b color1" />\n'
+             '\t<connect from="tex3 color" to="mix_b color2" />\n'
+             '\t<connect from="mix_a color" to="mix_c color1" />\n'
+             '\t<connect from="mix_b color" to="mix_c color2" />\n'
+             '\t<connect from="mix_c color" to="diffuse color" />\n'
+             '\t<connect from="diffuse bsdf" to="output surface" />\n'
+             '</shader>\n'
+             '<state shader="textured" interpolation="smooth">\n')
+    text += "\t" + mesh_xml(P, nverts, verts)
+    text += '</state>\n'
+
+    write(directory, "textures.xml", text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate Cycles benchmark scenes")
+    parser.add_argument("--output", default="scenes", help="Directory to write the scenes to")
+    parser.add_argument("--scale", type=float, default=1.0, help="Multiplier for the amount of geometry and lights")
+    parser.add_argument("--texture-size", type=int, default=4096, help="Resolution of the image textures")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.output):
+        os.makedirs(args.output)
+
+    scene_instancing(args.output, args.scale)
+    scene_hair(args.output, args.scale)
+    scene_sss(args.output, args.scale)
+    scene_volumes(args.output, args.scale)
+    scene_many_lights(args.output, args.scale)
+    scene_textures(args.output, args.scale, args.texture_size)
+
+
+if __name__ == "__main__":
+    main()
@@ -21,6 +21,7 @@
 #include "device.h"
 #include "scene.h"
 #include "session.h"
+#include "svm.h"
 
 #include "util_args.h"
 #include "util_foreach.h"
@@ -47,9 +48,181 @@ struct Options {
 	SceneParams scene_params;
 	SessionParams session_params;
 	bool quiet;
+	bool benchmark;
 	bool show_help, interactive, pause;
 } options;
 
+/* Benchmark
+ *
+ * Time and device memory peak of each stage of a background render, detected
+ * from the session status messages and printed as JSON when done. */
+
+struct BenchmarkStage {
+	string name;
+	double time;
+	size_t mem_peak;
+};
+
+static struct Benchmark {
+	vector<BenchmarkStage> stages;
+	string stage;
+	double stage_start;
+	double start;
+} benchmark;
+
+static string benchmark_stage_name(const string& status)
+{
+	if(string_startswith(status, "Loading render kernels"))
+		return "kernel_load";
+	else if(string_startswith(status, "Updating Mesh BVH") || string_startswith(status, "Updating Scene BVH"))
+		return "bvh_build";
+	else if(string_startswith(status, "Updating"))
+		return "scene_sync";
+	else if(string_startswith(status, "Path Tracing") || string_startswith(status, "Rendering"))
+		return "render";
+
+	return "other";
+}
+
+static void benchmark_add_time(const string& name, double time)
+{
+	size_t mem_peak = (options.session)? options.session->stats.mem_peak: 0;
+
+	foreach(BenchmarkStage& stage, benchmark.stages) {
+		if(stage.name == name) {
+			stage.time += time;
+			if(mem_peak > stage.mem_peak)
+				stage.mem_peak = mem_peak;
+			return;
+		}
+	}
+
+	BenchmarkStage stage;
+	stage.name = name;
+	stage.time = time;
+	stage.mem_peak = mem_peak;
+	benchmark.stages.push_back(stage);
+}
+
+static void benchmark_begin_stage(const string& name)
+{
+	double now = time_dt();
+
+	if(benchmark.stage != "")
+		benchmark_add_time(benchmark.stage, now - benchmark.stage_start);
+
+	benchmark.stage = name;
+	benchmark.stage_start = now;
+}
+
+/* progress update callback, calls are serialized by Progress */
+static void benchmark_progress_update()
+{
+	string status, substatus;
+	options.session->progress.get_status(status, substatus);
+
+	string name = benchmark_stage_name(status);
+
+	if(name != benchmark.stage)
+		benchmark_begin_stage(name);
+}
+
+static void benchmark_write_tile(RenderTile& /*rtile*/)
+{
+	/* nothing to write, setting the callback makes the session free tile buffers */
+}
+
+static double benchmark_stage_time(const string& name)
+{
+	foreach(BenchmarkStage& stage, benchmark.stages)
+		if(stage.name == name)
+			return stage.time;
+
+	return 0.0;
+}
+
+#ifdef WITH_CYCLES_STATS
+static void kernel_stats_print(const KernelStats& kstats, const char *indent)
+{
+	printf("{\n");
+
+	printf("%s  \"rays\": {", indent);
+	for(int i = 0; i < KernelStats::NUM_RAY_TYPES; i++)
+		printf("%s\"%s\": %llu", (i > 0)? ", ": "", KernelStats::ray_type_name(i),
+		       (unsigned long long)kstats.num_rays[i]);
+	printf("},\n");
+
+	printf("%s  \"bvh_nodes\": %llu,\n", indent, (unsigned long long)kstats.num_bvh_nodes);
+	printf("%s  \"primitive_tests\": %llu,\n", indent, (unsigned long long)kstats.num_primitive_tests);
+	printf("%s  \"shader_evals\": %llu,\n", indent, (unsigned long long)kstats.num_shader_evals);
+
+	printf("%s  \"svm_nodes\": {", indent);
+	bool first = true;
+	for(int i = 0; i < KernelStats::MAX_SVM_NODES; i++) {
+		if(kstats.num_svm_nodes[i]) {
+			printf("%s\"%s\": %llu", (first)? "": ", ", svm_node_type_name(i),
+			       (unsigned long long)kstats.num_svm_nodes[i]);
+			first = false;
+		}
+	}
+	printf("},\n");
+
+	/* path depth histogram, without trailing empty bins */
+	int num_depths = KernelStats::MAX_PATH_DEPTH;
+	while(num_depths > 1 && kstats.path_depth[num_depths - 1] == 0)
+		num_depths--;
+
+	printf("%s  \"path_depth\": [", indent);
+	for(int i = 0; i < num_depths; i++)
+		printf("%s%llu", (i > 0)? ", ": "", (unsigned long long)kstats.path_depth[i]);
+	printf("]\n");
+
+	printf("%s}", indent);
+}
+#endif
+
+static void benchmark_print()
+{
+	double render_time = benchmark_stage_time("render");
+	double total_time = time_dt() - benchmark.start;
+	int samples = options.session_params.samples;
+	double tail_time, max_tail_time;
+	double pixel_samples = (double)options.width * (double)options.height * (double)samples;
+
+	printf("{\n");
+	printf("  \"scene\": \"%s\",\n", path_filename(options.filepath).c_str());
+	printf("  \"device\": \"%s\",\n", options.session_params.device.description.c_str());
+	printf("  \"threads\": %d,\n", options.session_params.threads);
+	printf("  \"width\": %d,\n", options.width);
+	printf("  \"height\": %d,\n", options.height);
+	printf("  \"samples\": %d,\n", samples);
+	printf("  \"stages\": {\n");
+
+	for(size_t i = 0; i < benchmark.stages.size(); i++) {
+		BenchmarkStage& stage = benchmark.stages[i];
+		printf("    \"%s\": {\"time\": %.6f, \"mem_peak\": %lu}%s\n",
+		       stage.name.c_str(), stage.time, (unsigned long)stage.mem_peak,
+		       (i + 1 < benchmark.stages.size())? ",": "");
+	}
+
+	printf("  },\n");
+	printf("  \"total_time\": %.6f,\n", total_time);
+
+	options.session->progress.get_tail_time(tail_time, max_tail_time);
+	printf("  \"tail_time\": %.6f,\n", tail_time);
+	printf("  \"max_tail_time\": %.6f,\n", max_tail_time);
+	printf("  \"samples_per_second\": %.6f,\n", (render_time > 0.0)? samples / render_time: 0.0);
+	printf("  \"pixel_samples_per_second\": %.1f,\n", (render_time > 0.0)? pixel_samples / render_time: 0.0);
+#ifdef WITH_CYCLES_STATS
+	printf("  \"kernel\": ");
+	kernel_stats_print(options.session->stats.kernel, "  ");
+	printf(",\n");
+#endif
+	printf("  \"mem_peak\": %lu\n", (unsigned long)options.session->stats.mem_peak);
+	printf("}\n");
+	fflush(stdout);
+}
+
 static void session_print(const string& str)
 {
 	/* print with carriage return to overwrite previous */
@@ -103,7 +276,11 @@ static void session_init()
 	options.session->reset(session_buffer_params(), options.session_params.samples);
 	options.session->scene = options.scene;
 
-	if(options.session_params.background && !options.quiet)
+	if(options.benchmark) {
+		options.session->write_render_tile_cb = function_bind(&benchmark_write_tile, _1);
+		options.session->progress.set_update_callback(function_bind(&benchmark_progress_update));
+	}
+	else if(options.session_params.background && !options.quiet)
 		options.session->progress.set_update_callback(function_bind(&session_print_status));
 #ifdef WITH_CYCLES_STANDALONE_GUI
 	else
@@ -120,6 +297,9 @@ static void scene_init()
 	options.scene = new Scene(options.scene_params, options.session_params.device);
 
 	/* Read XML */
+	if(options.benchmark)
+		benchmark_begin_stage("scene_load");
+
 	xml_read_file(options.scene, options.filepath.c_str());
 
 	/* Camera width/height override? */
@@ -138,6 +318,18 @@ static void scene_init()
 
 static void session_exit()
 {
+	if(options.benchmark) {
+		benchmark_begin_stage("");
+		benchmark_print();
+	}
+#ifdef WITH_CYCLES_STATS
+	else if(options.session && options.session_params.background && !options.quiet) {
+		printf("\nKernel statistics: ");
+		kernel_stats_print(options.session->stats.kernel, "");
+		printf("\n");
+	}
+#endif
+
 	if(options.session) {
 		delete options.session;
 		options.session = NULL;
@@ -311,6 +503,7 @@ static void options_parse(int argc, const char **argv)
 	options.filepath = "";
 	options.session = NULL;
 	options.quiet = false;
+	options.benchmark = false;
 
 	/* device names */
 	string device_names = "";
@@ -341,6 +534,7 @@ static void options_parse(int argc, const char **argv)
 #endif
 		"--background", &options.session_params.background, "Render in background, without user interface",
 		"--quiet", &options.quiet, "In background mode, don't print progress messages",
+		"--benchmark", &options.benchmark, "Render in background and print time and memory of each stage as JSON",
 		"--samples %d", &options.session_params.samples, "Number of samples to render",
 		"--output %s", &options.session_params.output_path, "File path to write output image",
 		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
@@ -381,8 +575,17 @@ static void options_parse(int argc, const char **argv)
 	options.session_params.background = true;
 #endif
 
-	/* Use progressive rendering */
-	options.session_params.progressive = true;
+	if(options.benchmark) {
+		/* Render tiles with all samples, like final renders do */
+		options.session_params.background = true;
+		options.session_params.progressive = false;
+		options.quiet = true;
+		benchmark.start = time_dt();
+	}
+	else {
+		/* Use progressive rendering */
+		options.session_params.progressive = true;
+	}
 
 	/* find matching device */
 	DeviceType device_type = Device::type_from_string(devicename.c_str());
@@ -423,7 +626,8 @@ static void options_parse(int argc, const char **argv)
 	}
 
 	/* For smoother Viewport */
-	options.session_params.start_resolution = 64;
+	if(!options.benchmark)
+		options.session_params.start_resolution = 64;
 
 	/* load scene */
 	scene_init();
@@ -843,6 +843,9 @@ static void xml_read_mesh(const XMLReadState& state, pugi::xml_node node)
 	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
 	mesh->used_shaders.push_back(state.shader);
 
+	/* name, for instancing */
+	xml_read_ustring(&mesh->name, node, "name");
+
 	/* read state */
 	int shader = state.shader;
 	bool smooth = state.smooth;
@@ -928,6 +931,74 @@ static void xml_read_mesh(const XMLReadState& state, pugi::xml_node node)
 	mesh->attributes.remove(ATTR_STD_VERTEX_NORMAL);
 }
 
+/* Instance */
+
+static void xml_read_instance(const XMLReadState& state, pugi::xml_node node)
+{
+	ustring name;
+
+	if(!xml_read_ustring(&name, node, "mesh")) {
+		fprintf(stderr, "Instance without mesh name.\n");
+		return;
+	}
+
+	/* share the mesh with a previously read named mesh */
+	foreach(Mesh *mesh, state.scene->meshes) {
+		if(mesh->name == name) {
+			Object *object = new Object();
+			object->mesh = mesh;
+			object->tfm = state.tfm;
+			state.scene->objects.push_back(object);
+			return;
+		}
+	}
+
+	fprintf(stderr, "Unknown mesh \"%s\" for instance.\n", name.c_str());
+}
+
+/* Hair */
+
+static void xml_read_hair(const XMLReadState& state, pugi::xml_node node)
+{
+	/* add mesh */
+	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
+	mesh->used_shaders.push_back(state.shader);
+
+	/* read curve keys and number of keys per curve */
+	vector<float3> P;
+	vector<int> nkeys;
+	vector<float> radius;
+	float default_radius = 0.01f;
+
+	xml_read_float3_array(P, node, "P");
+	xml_read_int_array(nkeys, node, "nkeys");
+	xml_read_float_array(radius, node, "radius");
+
+	if(radius.size() == 1) {
+		default_radius = radius[0];
+		radius.clear();
+	}
+
+	/* create curves */
+	int key_offset = 0;
+
+	for(size_t i = 0; i < nkeys.size(); i++) {
+		if(key_offset + nkeys[i] > (int)P.size()) {
+			fprintf(stderr, "Invalid number of keys for hair.\n");
+			break;
+		}
+
+		for(int j = 0; j < nkeys[i]; j++) {
+			int k = key_offset + j;
+			mesh->add_curve_key(P[k], (k < (int)radius.size())? radius[k]: default_radius);
+		}
+
+		mesh->add_curve(key_offset, nkeys[i], state.shader);
+
+		key_offset += nkeys[i];
+	}
+}
+
 /* Patch */
 
 static void xml_read_patch(const XMLReadState& state, pugi::xml_node node)
@@ -1117,6 +1188,12 @@ static void xml_read_scene(const XMLReadState& state, pugi::xml_node scene_node)
 		else if(string_iequals(node.name(), "mesh")) {
 			xml_read_mesh(state, node);
 		}
+		else if(string_iequals(node.name(), "instance")) {
+			xml_read_instance(state, node);
+		}
+		else if(string_iequals(node.name(), "hair")) {
+			xml_read_hair(state, node);
+		}
 		else if(string_iequals(node.name(), "patch")) {
 			xml_read_patch(state, node);
 		}
@@ -100,3 +100,17 @@ def with_osl():
 def with_network():
     import _cycles
     return _cycles.with_network
+
+
+def with_stats():
+    import _cycles
+    return _cycles.with_stats
+
+
+def kernel_stats(engine):
+    """Ray and shading statistics of the render, None if built without WITH_CYCLES_STATS"""
+    import _cycles
+    session = getattr(engine, "session", None)
+    if session is None:
+        return None
+    return _cycles.kernel_stats(session)
@@ -21,6 +21,8 @@
 #include "blender_sync.h"
 #include "blender_session.h"
 
+#include "svm.h"
+
 #include "util_foreach.h"
 #include "util_md5.h"
 #include "util_opengl.h"
@@ -267,6 +269,54 @@ static PyObject *sync_func(PyObject *self, PyObject *value)
 	Py_RETURN_NONE;
 }
 
+#ifdef WITH_CYCLES_STATS
+static void dict_set_uint64(PyObject *dict, const char *key, uint64_t value)
+{
+	PyObject *item = PyLong_FromUnsignedLongLong(value);
+	PyDict_SetItemString(dict, key, item);
+	Py_DECREF(item);
+}
+#endif
+
+static PyObject *kernel_stats_func(PyObject *self, PyObject *value)
+{
+#ifdef WITH_CYCLES_STATS
+	BlenderSession *session = (BlenderSession*)PyLong_AsVoidPtr(value);
+	const KernelStats& kstats = session->session->stats.kernel;
+
+	PyObject *ret = PyDict_New();
+	PyObject *rays = PyDict_New();
+	PyObject *svm_nodes = PyDict_New();
+	PyObject *path_depth = PyList_New(KernelStats::MAX_PATH_DEPTH);
+
+	for(int i = 0; i < KernelStats::NUM_RAY_TYPES; i++)
+		dict_set_uint64(rays, KernelStats::ray_type_name(i), kstats.num_rays[i]);
+
+	for(int i = 0; i < KernelStats::MAX_SVM_NODES; i++)
+		if(kstats.num_svm_nodes[i])
+			dict_set_uint64(svm_nodes, svm_node_type_name(i), kstats.num_svm_nodes[i]);
+
+	for(int i = 0; i < KernelStats::MAX_PATH_DEPTH; i++)
+		PyList_SET_ITEM(path_depth, i, PyLong_FromUnsignedLongLong(kstats.path_depth[i]));
+
+	PyDict_SetItemString(ret, "rays", rays);
+	PyDict_SetItemString(ret, "svm_nodes", svm_nodes);
+	PyDict_SetItemString(ret, "path_depth", path_depth);
+	Py_DECREF(rays);
+	Py_DECREF(svm_nodes);
+	Py_DECREF(path_depth);
+
+	dict_set_uint64(ret, "bvh_nodes", kstats.num_bvh_nodes);
+	dict_set_uint64(ret, "primitive_tests", kstats.num_primitive_tests);
+	dict_set_uint64(ret, "shader_evals", kstats.num_shader_evals);
+
+	return ret;
+#else
+	(void)value;
+	Py_RETURN_NONE;
+#endif
+}
+
 static PyObject *available_devices_func(PyObject *self, PyObject *args)
 {
 	vector<DeviceInfo>& devices = Device::available_devices();
@@ -498,6 +548,7 @@ static PyMethodDef methods[] = {
 	{"osl_compile", osl_compile_func, METH_VARARGS, ""},
 #endif
 	{"available_devices", available_devices_func, METH_NOARGS, ""},
+	{"kernel_stats", kernel_stats_func, METH_O, ""},
 	{NULL, NULL, 0, NULL},
 };
 
@@ -583,6 +634,14 @@ void *CCL_python_module_init()
 	PyModule_AddStringConstant(mod, "osl_version_string", "unknown");
 #endif
 
+#ifdef WITH_CYCLES_STATS
+	PyModule_AddObject(mod, "with_stats", Py_True);
+	Py_INCREF(Py_True);
+#else /* WITH_CYCLES_STATS */
+	PyModule_AddObject(mod, "with_stats", Py_False);
+	Py_INCREF(Py_False);
+#endif /* WITH_CYCLES_STATS */
+
 #ifdef WITH_NETWORK
 	PyModule_AddObject(mod, "with_network", Py_True);
 	Py_INCREF(Py_True);
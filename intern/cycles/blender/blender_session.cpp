@@ -817,6 +817,7 @@ void BlenderSession::update_status_progress()
 	string scene = "";
 	float progress;
 	double total_time, remaining_time = 0;
+	double tail_time, max_tail_time;
 	char time_str[128];
 	float mem_used = (float)session->stats.mem_used / 1024.0f / 1024.0f;
 	float mem_peak = (float)session->stats.mem_peak / 1024.0f / 1024.0f;
@@ -851,6 +852,19 @@ void BlenderSession::update_status_progress()
 	
 	timestatus += string_printf("Mem:%.2fM, Peak:%.2fM", (double)mem_used, (double)mem_peak);
 
+	/* time the last tiles of a pass kept the render going with idle threads */
+	session->progress.get_tail_time(tail_time, max_tail_time);
+	if(tail_time > 0) {
+		BLI_timestr(tail_time, time_str, sizeof(time_str));
+		timestatus += " | Tail:" + string(time_str);
+	}
+
+#ifdef WITH_CYCLES_STATS
+	uint64_t num_rays = session->stats.kernel.total_rays();
+	if(num_rays > 0)
+		timestatus += string_printf(" | Rays:%.2fM", (double)num_rays / 1e6);
+#endif
+
 	if(status.size() > 0)
 		status = " | " + status;
 	if(substatus.size() > 0)
@@ -18,12 +18,15 @@
 //#define __KERNEL_SSE__
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "bvh_binning.h"
 
 #include "util_algorithm.h"
 #include "util_boundbox.h"
+#include "util_task.h"
 #include "util_types.h"
+#include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -68,43 +71,33 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange& job, BVHReference *prims)
 		bin_bounds[i][0] = bin_bounds[i][1] = bin_bounds[i][2] = BoundBox::empty;
 	}
 
-	/* map geometry to bins, unrolled once */
-	{
-		ssize_t i;
-
-		for(i = 0; i < ssize_t(size()) - 1; i += 2) {
-			prefetch_L2(&prims[start() + i + 8]);
-
-			/* map even and odd primitive to bin */
-			BVHReference prim0 = prims[start() + i + 0];
-			BVHReference prim1 = prims[start() + i + 1];
+	/* map geometry to bins */
+	if(size() >= THREAD_BIN_SIZE) {
+		/* bin chunks in parallel and merge them */
+		size_t chunks = num_chunks();
+		vector<BinChunk> chunk(chunks);
+		TaskPool pool;
 
-			int4 bin0 = get_bin(prim0.bounds());
-			int4 bin1 = get_bin(prim1.bounds());
+		for(size_t c = 0; c < chunks; c++) {
+			size_t begin = start() + c*size()/chunks;
+			size_t end = start() + (c+1)*size()/chunks;
 
-			/* increase bounds for bins for even primitive */
-			int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(prim0.bounds());
-			int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(prim0.bounds());
-			int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(prim0.bounds());
-
-			/* increase bounds of bins for odd primitive */
-			int b10 = (int)extract<0>(bin1); bin_count[b10][0]++; bin_bounds[b10][0].grow(prim1.bounds());
-			int b11 = (int)extract<1>(bin1); bin_count[b11][1]++; bin_bounds[b11][1].grow(prim1.bounds());
-			int b12 = (int)extract<2>(bin1); bin_count[b12][2]++; bin_bounds[b12][2].grow(prim1.bounds());
+			pool.push(function_bind(&BVHObjectBinning::bin_chunk, this, prims, begin, end, &chunk[c]));
 		}
 
-		/* for uneven number of primitives */
-		if(i < ssize_t(size())) {
-			/* map primitive to bin */
-			BVHReference prim0 = prims[start() + i];
-			int4 bin0 = get_bin(prim0.bounds());
+		pool.wait_work();
+
+		for(size_t c = 0; c < chunks; c++) {
+			for(size_t i = 0; i < num_bins; i++) {
+				bin_count[i] = bin_count[i] + chunk[c].bin_count[i];
 
-			/* increase bounds of bins */
-			int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(prim0.bounds());
-			int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(prim0.bounds());
-			int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(prim0.bounds());
+				for(int d = 0; d < 3; d++)
+					bin_bounds[i][d] = merge(bin_bounds[i][d], chunk[c].bin_bounds[i][d]);
+			}
 		}
 	}
+	else
+		bin_range(prims, start(), end(), bin_bounds, bin_count);
 
 	/* sweep from right to left and compute parallel prefix of merged bounds */
 	float4 r_area[MAX_BINS];	/* area of bounds of primitives on the right */
@@ -161,42 +154,219 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange& job, BVHReference *prims)
 	leafSAH	= bounds().half_area() * blocks(size());
 }
 
-void BVHObjectBinning::split(BVHReference* prims, BVHObjectBinning& left_o, BVHObjectBinning& right_o) const
+size_t BVHObjectBinning::num_chunks() const
 {
-	size_t N = size();
+	size_t num_threads = max(TaskScheduler::num_threads(), 1);
+	size_t max_chunks = (size() + THREAD_CHUNK_SIZE - 1)/THREAD_CHUNK_SIZE;
 
-	BoundBox lgeom_bounds = BoundBox::empty;
-	BoundBox rgeom_bounds = BoundBox::empty;
-	BoundBox lcent_bounds = BoundBox::empty;
-	BoundBox rcent_bounds = BoundBox::empty;
+	return min(num_threads*4, max_chunks);
+}
+
+void BVHObjectBinning::bin_range(const BVHReference *prims, size_t begin, size_t end,
+                                 BoundBox bin_bounds[][4], int4 *bin_count) const
+{
+	/* map geometry to bins, unrolled once */
+	size_t i;
+
+	for(i = begin; i + 1 < end; i += 2) {
+		prefetch_L2(&prims[i + 8]);
 
-	ssize_t l = 0, r = N-1;
+		/* map even and odd primitive to bin */
+		BVHReference prim0 = prims[i + 0];
+		BVHReference prim1 = prims[i + 1];
 
-	while(l <= r) {
-		prefetch_L2(&prims[start() + l + 8]);
-		prefetch_L2(&prims[start() + r - 8]);
+		int4 bin0 = get_bin(prim0.bounds());
+		int4 bin1 = get_bin(prim1.bounds());
 
-		BVHReference prim = prims[start() + l];
+		/* increase bounds for bins for even primitive */
+		int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(prim0.bounds());
+		int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(prim0.bounds());
+		int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(prim0.bounds());
+
+		/* increase bounds of bins for odd primitive */
+		int b10 = (int)extract<0>(bin1); bin_count[b10][0]++; bin_bounds[b10][0].grow(prim1.bounds());
+		int b11 = (int)extract<1>(bin1); bin_count[b11][1]++; bin_bounds[b11][1].grow(prim1.bounds());
+		int b12 = (int)extract<2>(bin1); bin_count[b12][2]++; bin_bounds[b12][2].grow(prim1.bounds());
+	}
+
+	/* for uneven number of primitives */
+	if(i < end) {
+		/* map primitive to bin */
+		BVHReference prim0 = prims[i];
+		int4 bin0 = get_bin(prim0.bounds());
+
+		/* increase bounds of bins */
+		int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(prim0.bounds());
+		int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(prim0.bounds());
+		int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(prim0.bounds());
+	}
+}
+
+void BVHObjectBinning::bin_chunk(const BVHReference *prims, size_t begin, size_t end, BinChunk *chunk) const
+{
+	for(size_t i = 0; i < num_bins; i++) {
+		chunk->bin_count[i] = make_int4(0);
+		chunk->bin_bounds[i][0] = chunk->bin_bounds[i][1] = chunk->bin_bounds[i][2] = BoundBox::empty;
+	}
+
+	bin_range(prims, begin, end, chunk->bin_bounds, chunk->bin_count);
+}
+
+void BVHObjectBinning::split_count_chunk(const BVHReference *prims, SplitChunk *chunk) const
+{
+	chunk->lgeom_bounds = BoundBox::empty;
+	chunk->rgeom_bounds = BoundBox::empty;
+	chunk->lcent_bounds = BoundBox::empty;
+	chunk->rcent_bounds = BoundBox::empty;
+	chunk->num_left = 0;
+
+	for(size_t i = chunk->begin; i < chunk->end; i++) {
+		const BVHReference& prim = prims[i];
 		float3 center = prim.bounds().center2();
 
 		if(get_bin(center)[dim] < pos) {
-			lgeom_bounds.grow(prim.bounds());
-			lcent_bounds.grow(center);
-			l++;
+			chunk->lgeom_bounds.grow(prim.bounds());
+			chunk->lcent_bounds.grow(center);
+			chunk->num_left++;
 		}
 		else {
-			rgeom_bounds.grow(prim.bounds());
-			rcent_bounds.grow(center);
-			swap(prims[start()+l],prims[start()+r]);
-			r--;
+			chunk->rgeom_bounds.grow(prim.bounds());
+			chunk->rcent_bounds.grow(center);
 		}
 	}
+}
+
+void BVHObjectBinning::split_scatter_chunk(const BVHReference *prims, BVHReference *dst, SplitChunk *chunk) const
+{
+	size_t l = chunk->left_offset;
+	size_t r = chunk->right_offset;
+
+	for(size_t i = chunk->begin; i < chunk->end; i++) {
+		const BVHReference& prim = prims[i];
+
+		if(get_bin(prim.bounds().center2())[dim] < pos)
+			dst[l++] = prim;
+		else
+			dst[r++] = prim;
+	}
+}
+
+static void copy_references(BVHReference *dst, const BVHReference *src, size_t num)
+{
+	memcpy(dst, src, sizeof(BVHReference)*num);
+}
+
+/* Split in three parallel passes: count and bound both sides of each chunk,
+ * scatter the chunks into a temporary array at their offsets, then copy back.
+ * Returns false if all primitives ended up on one side. */
+bool BVHObjectBinning::split_threaded(BVHReference *prims, BVHObjectBinning& left_o, BVHObjectBinning& right_o) const
+{
+	size_t N = size();
+	size_t chunks = num_chunks();
+	vector<SplitChunk> chunk(chunks);
+	TaskPool pool;
+
+	for(size_t c = 0; c < chunks; c++) {
+		chunk[c].begin = start() + c*N/chunks;
+		chunk[c].end = start() + (c+1)*N/chunks;
+
+		pool.push(function_bind(&BVHObjectBinning::split_count_chunk, this, prims, &chunk[c]));
+	}
+
+	pool.wait_work();
+
+	/* merge bounds and compute offsets of chunks in the output */
+	BoundBox lgeom_bounds = BoundBox::empty;
+	BoundBox rgeom_bounds = BoundBox::empty;
+	BoundBox lcent_bounds = BoundBox::empty;
+	BoundBox rcent_bounds = BoundBox::empty;
+	size_t num_left = 0;
+
+	for(size_t c = 0; c < chunks; c++) {
+		lgeom_bounds = merge(lgeom_bounds, chunk[c].lgeom_bounds);
+		rgeom_bounds = merge(rgeom_bounds, chunk[c].rgeom_bounds);
+		lcent_bounds = merge(lcent_bounds, chunk[c].lcent_bounds);
+		rcent_bounds = merge(rcent_bounds, chunk[c].rcent_bounds);
+
+		chunk[c].left_offset = num_left;
+		num_left += chunk[c].num_left;
+	}
+
+	if(num_left == 0 || num_left == N)
+		return false;
+
+	size_t right_offset = num_left;
+
+	for(size_t c = 0; c < chunks; c++) {
+		chunk[c].right_offset = right_offset;
+		right_offset += (chunk[c].end - chunk[c].begin) - chunk[c].num_left;
+	}
+
+	/* scatter and copy back */
+	vector<BVHReference> tmp(N);
+
+	for(size_t c = 0; c < chunks; c++)
+		pool.push(function_bind(&BVHObjectBinning::split_scatter_chunk, this, prims, &tmp[0], &chunk[c]));
+
+	pool.wait_work();
 
-	/* finish */
-	if(l != 0 && N-1-r != 0) {
-		right_o = BVHObjectBinning(BVHRange(rgeom_bounds, rcent_bounds, start() + l, N-1-r), prims);
-		left_o  = BVHObjectBinning(BVHRange(lgeom_bounds, lcent_bounds, start(), l), prims);
-		return;
+	for(size_t c = 0; c < chunks; c++) {
+		size_t offset = chunk[c].begin - start();
+		size_t num = chunk[c].end - chunk[c].begin;
+
+		pool.push(function_bind(&copy_references, prims + chunk[c].begin, &tmp[offset], num));
+	}
+
+	pool.wait_work();
+
+	right_o = BVHObjectBinning(BVHRange(rgeom_bounds, rcent_bounds, start() + num_left, N - num_left), prims);
+	left_o  = BVHObjectBinning(BVHRange(lgeom_bounds, lcent_bounds, start(), num_left), prims);
+
+	return true;
+}
+
+void BVHObjectBinning::split(BVHReference* prims, BVHObjectBinning& left_o, BVHObjectBinning& right_o) const
+{
+	size_t N = size();
+
+	BoundBox lgeom_bounds = BoundBox::empty;
+	BoundBox rgeom_bounds = BoundBox::empty;
+	BoundBox lcent_bounds = BoundBox::empty;
+	BoundBox rcent_bounds = BoundBox::empty;
+
+	if(N >= THREAD_BIN_SIZE) {
+		if(split_threaded(prims, left_o, right_o))
+			return;
+	}
+	else {
+		ssize_t l = 0, r = N-1;
+
+		while(l <= r) {
+			prefetch_L2(&prims[start() + l + 8]);
+			prefetch_L2(&prims[start() + r - 8]);
+
+			BVHReference prim = prims[start() + l];
+			float3 center = prim.bounds().center2();
+
+			if(get_bin(center)[dim] < pos) {
+				lgeom_bounds.grow(prim.bounds());
+				lcent_bounds.grow(center);
+				l++;
+			}
+			else {
+				rgeom_bounds.grow(prim.bounds());
+				rcent_bounds.grow(center);
+				swap(prims[start()+l],prims[start()+r]);
+				r--;
+			}
+		}
+
+		/* finish */
+		if(l != 0 && N-1-r != 0) {
+			right_o = BVHObjectBinning(BVHRange(rgeom_bounds, rcent_bounds, start() + l, N-1-r), prims);
+			left_o  = BVHObjectBinning(BVHRange(lgeom_bounds, lcent_bounds, start(), l), prims);
+			return;
+		}
 	}
 
 	/* object medium split if we did not make progress, can happen when all
@@ -24,12 +24,16 @@
 
 CCL_NAMESPACE_BEGIN
 
-/* Single threaded object binner. Finds the split with the best SAH heuristic
- * by testing for each dimension multiple partitionings for regular spaced
- * partition locations. A partitioning for a partition location is computed,
- * by putting primitives whose centroid is on the left and right of the split
- * location to different sets. The SAH is evaluated by computing the number of
- * blocks occupied by the primitives in the partitions. */
+/* Object binner. Finds the split with the best SAH heuristic by testing for
+ * each dimension multiple partitionings for regular spaced partition
+ * locations. A partitioning for a partition location is computed, by putting
+ * primitives whose centroid is on the left and right of the split location to
+ * different sets. The SAH is evaluated by computing the number of blocks
+ * occupied by the primitives in the partitions.
+ *
+ * Large ranges are binned and partitioned in chunks by multiple threads, these
+ * are the top levels of the tree where the builder itself has not yet split
+ * the work into tasks. */
 
 class BVHObjectBinning : public BVHRange
 {
@@ -51,6 +55,34 @@ protected:
 	enum { MAX_BINS = 32 };
 	enum { LOG_BLOCK_SIZE = 2 };
 
+	/* ranges with at least this many primitives are binned and split in
+	 * parallel, in chunks of at least THREAD_CHUNK_SIZE primitives */
+	enum { THREAD_BIN_SIZE = 65536 };
+	enum { THREAD_CHUNK_SIZE = 16384 };
+
+	/* bins of one chunk, merged after binning in parallel */
+	struct BinChunk {
+		BoundBox bin_bounds[MAX_BINS][4];
+		int4 bin_count[MAX_BINS];
+	};
+
+	/* left and right side of one chunk, for splitting in parallel */
+	struct SplitChunk {
+		BoundBox lgeom_bounds, rgeom_bounds;
+		BoundBox lcent_bounds, rcent_bounds;
+		size_t begin, end;
+		size_t num_left;
+		size_t left_offset, right_offset;
+	};
+
+	size_t num_chunks() const;
+	void bin_range(const BVHReference *prims, size_t begin, size_t end,
+	               BoundBox bin_bounds[][4], int4 *bin_count) const;
+	void bin_chunk(const BVHReference *prims, size_t begin, size_t end, BinChunk *chunk) const;
+	bool split_threaded(BVHReference *prims, BVHObjectBinning& left_o, BVHObjectBinning& right_o) const;
+	void split_count_chunk(const BVHReference *prims, SplitChunk *chunk) const;
+	void split_scatter_chunk(const BVHReference *prims, BVHReference *dst, SplitChunk *chunk) const;
+
 	/* computes the bin numbers for each dimension for a box. */
 	__forceinline int4 get_bin(const BoundBox& box) const
 	{
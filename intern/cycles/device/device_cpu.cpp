@@ -62,6 +62,8 @@ public:
 		kernel_globals.osl = &osl_globals;
 #endif
 
+		num_stealing_threads = 0;
+
 		/* do now to avoid thread issues */
 		system_cpu_support_sse2();
 		system_cpu_support_sse3();
@@ -156,158 +158,303 @@ public:
 		}
 	};
 
-	void thread_path_trace(DeviceTask& task)
-	{
-		if(task_pool.canceled()) {
-			if(task.need_finish_queue == false)
-				return;
+	/* Work stealing for path tracing
+	 *
+	 * Near the end of a pass there are fewer tiles left than threads. Threads
+	 * that can no longer acquire a tile ask a thread that is still rendering
+	 * to hand over the remaining rows of its tile. The rows are rendered into
+	 * the same buffers, and the tile is released once all parts are done. */
+
+	struct TileShare {
+		RenderTile tile;
+		int num_parts;
+
+		/* rows rendered by all parts, progress is reported per whole tile sample */
+		int rows_done;
+		int samples_done;
+	};
+
+	/* all members are protected by steal_mutex, except tile.h which is
+	 * only changed by the rendering thread and so may be read by it */
+	struct TilePart {
+		TileShare *share;
+		RenderTile tile;
+
+		/* current position of the rendering thread */
+		int sample;
+		int row;
+		bool split_requested;
+
+		TilePart(TileShare *share_, const RenderTile& tile_)
+		: share(share_), tile(tile_),
+		  sample(tile_.start_sample), row(tile_.y), split_requested(false)
+		{
+			tile.sample = tile.start_sample;
 		}
 
-		KernelGlobals kg = kernel_globals;
+		/* number of rows left to render, summed over the remaining samples */
+		int remaining_rows()
+		{
+			int end_sample = tile.start_sample + tile.num_samples;
+			return (end_sample - sample) * tile.h - (row - tile.y);
+		}
+	};
 
-#ifdef WITH_OSL
-		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
+	thread_mutex steal_mutex;
+	thread_condition_variable steal_cond;
+	list<TilePart*> active_parts;
+	list<TilePart*> stolen_parts;
+	int num_stealing_threads;
+
+#ifdef WITH_CYCLES_STATS
+	/* protects summing per thread kernel statistics into Stats */
+	thread_mutex kernel_stats_mutex;
 #endif
 
+	bool acquire_tile_part(DeviceTask& task, TilePart *&part)
+	{
 		RenderTile tile;
-		
-		while(task.acquire_tile(this, tile)) {
-			float *render_buffer = (float*)tile.buffer;
-			uint *rng_state = (uint*)tile.rng_state;
-			int start_sample = tile.start_sample;
-			int end_sample = tile.start_sample + tile.num_samples;
 
-#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
-			if(system_cpu_support_avx2()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
+		if(task.acquire_tile(this, tile)) {
+			TileShare *share = new TileShare();
+			share->tile = tile;
+			share->tile.sample = tile.start_sample + tile.num_samples;
+			share->num_parts = 1;
+			share->rows_done = 0;
+			share->samples_done = 0;
 
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_avx2_path_trace(&kg, render_buffer, rng_state,
-													  sample, x, y, tile.offset, tile.stride);
-						}
-					}
+			part = new TilePart(share, tile);
 
-					tile.sample = sample + 1;
+			thread_scoped_lock steal_lock(steal_mutex);
+			active_parts.push_back(part);
+			return true;
+		}
 
-					task.update_progress(&tile);
-				}
+		/* no tiles left, help finishing tiles still being rendered */
+		thread_scoped_lock steal_lock(steal_mutex);
+		bool found = false;
+
+		num_stealing_threads++;
+
+		while(true) {
+			if(!stolen_parts.empty()) {
+				part = stolen_parts.front();
+				stolen_parts.pop_front();
+				active_parts.push_back(part);
+				found = true;
+				break;
 			}
-			else
-#endif
-#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
-			if(system_cpu_support_avx()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
 
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_avx_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
+			if(task.get_cancel() || task_pool.canceled()) {
+				if(task.need_finish_queue == false)
+					break;
+			}
 
-					tile.sample = sample + 1;
+			TilePart *victim = NULL;
+			bool waiting = false;
 
-					task.update_progress(&tile);
+			foreach(TilePart *active, active_parts) {
+				if(active->split_requested) {
+					waiting = true;
+				}
+				else if(active->tile.h >= 2 && active->remaining_rows() >= 4) {
+					if(!victim || active->remaining_rows() > victim->remaining_rows())
+						victim = active;
 				}
 			}
-			else
-#endif
-#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41			
-			if(system_cpu_support_sse41()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
 
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_sse41_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
+			if(victim) {
+				victim->split_requested = true;
+			}
+			else if(!waiting) {
+				break;
+			}
+
+			steal_cond.wait(steal_lock);
+		}
 
-					tile.sample = sample + 1;
+		num_stealing_threads--;
 
-					task.update_progress(&tile);
-				}
-			}
-			else
+		return found;
+	}
+
+	/* called with steal_mutex locked */
+	void split_tile_part(TilePart *part, int sample, int y)
+	{
+		RenderTile& tile = part->tile;
+		int end_sample = tile.start_sample + tile.num_samples;
+		int tile_end = tile.y + tile.h;
+		int split_y;
+
+		part->split_requested = false;
+
+		/* rows from y on are not rendered for this sample yet, so they can be
+		 * handed over starting from this sample. with more samples to go the
+		 * tile is halved, otherwise only the rest of the current sample. */
+		if(sample < end_sample - 1)
+			split_y = max(y, tile.y + tile.h/2);
+		else
+			split_y = y + (tile_end - y)/2;
+
+		bool can_split = (split_y > tile.y && split_y < tile_end) &&
+		                 (split_y > y || sample < end_sample - 1);
+
+		/* only split when a thread is waiting to take the part */
+		if(!can_split || num_stealing_threads <= (int)stolen_parts.size()) {
+			steal_cond.notify_all();
+			return;
+		}
+
+		RenderTile stolen_tile = tile;
+		stolen_tile.y = split_y;
+		stolen_tile.h = tile_end - split_y;
+		stolen_tile.start_sample = sample;
+		stolen_tile.num_samples = end_sample - sample;
+		stolen_tile.sample = sample;
+
+		tile.h = split_y - tile.y;
+
+		part->share->num_parts++;
+		stolen_parts.push_back(new TilePart(part->share, stolen_tile));
+
+		steal_cond.notify_all();
+	}
+
+	/* publishes the position of the rendering thread, and hands over rows
+	 * if a thread asked for them */
+	void update_tile_part(TilePart *part, int sample, int y)
+	{
+		thread_scoped_lock steal_lock(steal_mutex);
+
+		part->sample = sample;
+		part->row = y;
+
+		if(part->split_requested)
+			split_tile_part(part, sample, y);
+	}
+
+	/* adds the rows a part rendered for one sample, returns the number of
+	 * samples of the whole tile that are complete now */
+	int add_tile_part_rows(TilePart *part, int rows)
+	{
+		thread_scoped_lock steal_lock(steal_mutex);
+		TileShare *share = part->share;
+
+		share->rows_done += rows;
+
+		int samples = share->rows_done / share->tile.h - share->samples_done;
+		share->samples_done += samples;
+
+		return samples;
+	}
+
+	void release_tile_part(DeviceTask& task, TilePart *part)
+	{
+		TileShare *share = part->share;
+		bool release;
+
+		{
+			thread_scoped_lock steal_lock(steal_mutex);
+
+			active_parts.remove(part);
+
+			/* the tile is as far as its least advanced part */
+			share->tile.sample = min(share->tile.sample, part->tile.sample);
+
+			release = (--share->num_parts == 0);
+
+			steal_cond.notify_all();
+		}
+
+		if(release) {
+			task.release_tile(share->tile);
+			delete share;
+		}
+
+		delete part;
+	}
+
+	void thread_path_trace(DeviceTask& task)
+	{
+		if(task_pool.canceled()) {
+			if(task.need_finish_queue == false)
+				return;
+		}
+
+		KernelGlobals kg = kernel_globals;
+
+#ifdef WITH_CYCLES_STATS
+		kg.stats.reset();
 #endif
-#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE3
-			if(system_cpu_support_sse3()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
 
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_sse3_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
+#ifdef WITH_OSL
+		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
+#endif
 
-					tile.sample = sample + 1;
+		void(*path_trace_kernel)(KernelGlobals*, float*, unsigned int*, int, int, int, int, int);
 
-					task.update_progress(&tile);
-				}
-			}
-			else
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+		if(system_cpu_support_avx2())
+			path_trace_kernel = kernel_cpu_avx2_path_trace;
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
+		if(system_cpu_support_avx())
+			path_trace_kernel = kernel_cpu_avx_path_trace;
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41
+		if(system_cpu_support_sse41())
+			path_trace_kernel = kernel_cpu_sse41_path_trace;
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE3
+		if(system_cpu_support_sse3())
+			path_trace_kernel = kernel_cpu_sse3_path_trace;
+		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE2
-			if(system_cpu_support_sse2()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
+		if(system_cpu_support_sse2())
+			path_trace_kernel = kernel_cpu_sse2_path_trace;
+		else
+#endif
+			path_trace_kernel = kernel_cpu_path_trace;
 
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_sse2_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
+		TilePart *part;
 
-					tile.sample = sample + 1;
+		while(acquire_tile_part(task, part)) {
+			RenderTile& tile = part->tile;
+			float *render_buffer = (float*)tile.buffer;
+			uint *rng_state = (uint*)tile.rng_state;
+			int start_sample = tile.start_sample;
+			int end_sample = tile.start_sample + tile.num_samples;
 
-					task.update_progress(&tile);
+			for(int sample = start_sample; sample < end_sample; sample++) {
+				if (task.get_cancel() || task_pool.canceled()) {
+					if(task.need_finish_queue == false)
+						break;
 				}
-			}
-			else
-#endif
-			{
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
 
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
+				/* tile.h shrinks when rows are handed over to another thread */
+				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					update_tile_part(part, sample, y);
+
+					for(int x = tile.x; x < tile.x + tile.w; x++) {
+						path_trace_kernel(&kg, render_buffer, rng_state,
+						                  sample, x, y, tile.offset, tile.stride);
 					}
+				}
 
-					tile.sample = sample + 1;
+				tile.sample = sample + 1;
 
+				/* progress is counted in samples of the whole tile, rows that
+				 * were handed over count when the thread rendering them is done */
+				int num_samples = add_tile_part_rows(part, tile.h);
+				for(int i = 0; i < num_samples; i++)
 					task.update_progress(&tile);
-				}
 			}
 
-			task.release_tile(tile);
+			release_tile_part(task, part);
 
 			if(task_pool.canceled()) {
 				if(task.need_finish_queue == false)
@@ -315,6 +462,13 @@ public:
 			}
 		}
 
+#ifdef WITH_CYCLES_STATS
+		{
+			thread_scoped_lock stats_lock(kernel_stats_mutex);
+			stats.kernel.add(kg.stats);
+		}
+#endif
+
 #ifdef WITH_OSL
 		OSLShader::thread_free(&kg);
 #endif
@@ -168,9 +168,35 @@ CCL_NAMESPACE_BEGIN
 #include "geom_bvh_volume.h"
 #endif
 
+/* Ray statistics, by the type of ray being traced */
+
+#ifdef __KERNEL_STATS__
+ccl_device_inline void scene_intersect_stats(KernelGlobals *kg, const uint visibility)
+{
+	int type;
+
+	if(visibility & PATH_RAY_SHADOW)
+		type = KernelStats::RAY_SHADOW;
+	else if(visibility & PATH_RAY_CAMERA)
+		type = KernelStats::RAY_CAMERA;
+	else if(visibility & PATH_RAY_VOLUME_SCATTER)
+		type = KernelStats::RAY_VOLUME;
+	else if(visibility & PATH_RAY_TRANSMIT)
+		type = KernelStats::RAY_TRANSMIT;
+	else
+		type = KernelStats::RAY_REFLECT;
+
+	kg->stats.num_rays[type]++;
+}
+#else
+#define scene_intersect_stats(kg, visibility)
+#endif
+
 ccl_device_intersect bool scene_intersect(KernelGlobals *kg, const Ray *ray, const uint visibility, Intersection *isect,
 					 uint *lcg_state, float difl, float extmax)
 {
+	scene_intersect_stats(kg, visibility);
+
 #ifdef __OBJECT_MOTION__
 	if(kernel_data.bvh.have_motion) {
 #ifdef __HAIR__
@@ -209,6 +235,8 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg, const Ray *ray, con
 #ifdef __SUBSURFACE__
 ccl_device_intersect uint scene_intersect_subsurface(KernelGlobals *kg, const Ray *ray, Intersection *isect, int subsurface_object, uint *lcg_state, int max_hits)
 {
+	kernel_stats_inc(kg, num_rays[KernelStats::RAY_SUBSURFACE]);
+
 #ifdef __OBJECT_MOTION__
 	if(kernel_data.bvh.have_motion) {
 #ifdef __HAIR__
@@ -248,6 +276,8 @@ ccl_device_intersect uint scene_intersect_subsurface(KernelGlobals *kg, const Ra
 #ifdef __SHADOW_RECORD_ALL__
 ccl_device_intersect bool scene_intersect_shadow_all(KernelGlobals *kg, const Ray *ray, Intersection *isect, uint max_hits, uint *num_hits)
 {
+	kernel_stats_inc(kg, num_rays[KernelStats::RAY_SHADOW]);
+
 #ifdef __OBJECT_MOTION__
 	if(kernel_data.bvh.have_motion) {
 #ifdef __HAIR__
@@ -278,6 +308,8 @@ ccl_device_intersect bool scene_intersect_volume(KernelGlobals *kg,
                             const Ray *ray,
                             Intersection *isect)
 {
+	kernel_stats_inc(kg, num_rays[KernelStats::RAY_VOLUME]);
+
 #ifdef __OBJECT_MOTION__
 	if(kernel_data.bvh.have_motion) {
 #ifdef __HAIR__
@@ -85,6 +85,8 @@ ccl_device uint BVH_FUNCTION_NAME(KernelGlobals *kg, const Ray *ray, Intersectio
 			/* traverse internal nodes */
 			while(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL)
 			{
+				kernel_stats_inc(kg, num_bvh_nodes);
+
 				bool traverseChild0, traverseChild1;
 				int nodeAddrChild1;
 
@@ -204,6 +206,8 @@ ccl_device uint BVH_FUNCTION_NAME(KernelGlobals *kg, const Ray *ray, Intersectio
 
 					/* primitive intersection */
 					for(; primAddr < primAddr2; primAddr++) {
+						kernel_stats_inc(kg, num_primitive_tests);
+
 						/* only primitives from the same object */
 						uint tri_object = (object == OBJECT_NONE)? kernel_tex_fetch(__prim_object, primAddr): object;
 
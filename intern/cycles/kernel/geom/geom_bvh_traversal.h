@@ -94,6 +94,8 @@ ccl_device bool BVH_FUNCTION_NAME
 		do {
 			/* traverse internal nodes */
 			while(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL) {
+				kernel_stats_inc(kg, num_bvh_nodes);
+
 				bool traverseChild0, traverseChild1;
 				int nodeAddrChild1;
 
@@ -252,6 +254,8 @@ ccl_device bool BVH_FUNCTION_NAME
 
 					/* primitive intersection */
 					while(primAddr < primAddr2) {
+						kernel_stats_inc(kg, num_primitive_tests);
+
 						bool hit;
 						uint type = kernel_tex_fetch(__prim_type, primAddr);
 
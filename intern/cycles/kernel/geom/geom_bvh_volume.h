@@ -88,6 +88,8 @@ ccl_device bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 		do {
 			/* traverse internal nodes */
 			while(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL) {
+				kernel_stats_inc(kg, num_bvh_nodes);
+
 				bool traverseChild0, traverseChild1;
 				int nodeAddrChild1;
 
@@ -208,6 +210,8 @@ ccl_device bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 
 					/* primitive intersection */
 					for(; primAddr < primAddr2; primAddr++) {
+						kernel_stats_inc(kg, num_primitive_tests);
+
 						/* only primitives from volume object */
 						uint tri_object = (object == OBJECT_NONE)? kernel_tex_fetch(__prim_object, primAddr): object;
 						int object_flag = kernel_tex_fetch(__object_flag, tri_object);
@@ -23,6 +23,7 @@
 #include "util_math.h"
 #include "util_simd.h"
 #include "util_half.h"
+#include "util_stats.h"
 #include "util_types.h"
 
 /* On 64bit linux single precision exponent is really slow comparing to the
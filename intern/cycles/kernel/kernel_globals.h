@@ -52,6 +52,11 @@ typedef struct KernelGlobals {
 	OSLThreadData *osl_tdata;
 #endif
 
+#ifdef __KERNEL_STATS__
+	/* ray and shading statistics of the thread using this copy */
+	KernelStats stats;
+#endif
+
 } KernelGlobals;
 
 #endif
@@ -90,6 +95,18 @@ typedef struct KernelGlobals {
 
 #endif
 
+/* Statistics counters, only compiled in for the CPU kernels when building
+ * with WITH_CYCLES_STATS */
+
+#ifdef __KERNEL_STATS__
+#  define kernel_stats_inc(kg, counter) ((kg)->stats.counter++)
+#  define kernel_stats_path_depth(kg, depth) \
+	((kg)->stats.path_depth[min((int)(depth), (int)KernelStats::MAX_PATH_DEPTH - 1)]++)
+#else
+#  define kernel_stats_inc(kg, counter)
+#  define kernel_stats_path_depth(kg, depth)
+#endif
+
 /* Interpolated lookup table access */
 
 ccl_device float lookup_table_read(KernelGlobals *kg, float x, int offset, int size)
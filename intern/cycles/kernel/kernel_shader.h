@@ -786,6 +786,8 @@ ccl_device float3 shader_holdout_eval(KernelGlobals *kg, ShaderData *sd)
 ccl_device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 	float randb, int path_flag, ShaderContext ctx)
 {
+	kernel_stats_inc(kg, num_shader_evals);
+
 	sd->num_closure = 0;
 	sd->randb_closure = randb;
 
@@ -809,6 +811,8 @@ ccl_device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 
 ccl_device float3 shader_eval_background(KernelGlobals *kg, ShaderData *sd, int path_flag, ShaderContext ctx)
 {
+	kernel_stats_inc(kg, num_shader_evals);
+
 	sd->num_closure = 0;
 	sd->randb_closure = 0.0f;
 
@@ -975,6 +979,8 @@ ccl_device void shader_eval_volume(KernelGlobals *kg, ShaderData *sd,
 		}
 
 		/* evaluate shader */
+		kernel_stats_inc(kg, num_shader_evals);
+
 #ifdef __SVM__
 #ifdef __OSL__
 		if(kg->osl) {
@@ -999,6 +1005,8 @@ ccl_device void shader_eval_volume(KernelGlobals *kg, ShaderData *sd,
 
 ccl_device void shader_eval_displacement(KernelGlobals *kg, ShaderData *sd, ShaderContext ctx)
 {
+	kernel_stats_inc(kg, num_shader_evals);
+
 	sd->num_closure = 0;
 	sd->randb_closure = 0.0f;
 
@@ -161,6 +161,10 @@ CCL_NAMESPACE_BEGIN
 #  define __KERNEL_DEBUG__
 #endif
 
+#if defined(WITH_CYCLES_STATS) && defined(__KERNEL_CPU__)
+#  define __KERNEL_STATS__
+#endif
+
 /* Random Numbers */
 
 typedef uint RNG;
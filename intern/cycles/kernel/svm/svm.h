@@ -190,6 +190,8 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, Shade
 	while(1) {
 		uint4 node = read_node(kg, &offset);
 
+		kernel_stats_inc(kg, num_svm_nodes[node.x]);
+
 		switch(node.x) {
 			case NODE_SHADER_JUMP: {
 				if(type == SHADER_TYPE_SURFACE) offset = node.y;
@@ -28,6 +28,7 @@
 
 #include "osl_globals.h"
 
+#include "util_algorithm.h"
 #include "util_cache.h"
 #include "util_foreach.h"
 #include "util_progress.h"
@@ -1029,6 +1030,14 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	dscene->data.bvh.root = pack.root_index;
 }
 
+static bool mesh_bvh_size_greater(const Mesh *a, const Mesh *b)
+{
+	size_t a_size = a->triangles.size() + a->curve_keys.size();
+	size_t b_size = b->triangles.size() + b->curve_keys.size();
+
+	return a_size > b_size;
+}
+
 void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	if(!need_update)
@@ -1090,13 +1099,21 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		if(mesh->need_update && !mesh->transform_applied)
 			num_bvh++;
 
+	/* build the largest BVHs first, so one big mesh queued last does not
+	 * keep a single thread busy after all the others are done */
+	vector<Mesh*> bvh_meshes;
+
+	foreach(Mesh *mesh, scene->meshes)
+		if(mesh->need_update)
+			bvh_meshes.push_back(mesh);
+
+	sort(bvh_meshes.begin(), bvh_meshes.end(), mesh_bvh_size_greater);
+
 	TaskPool pool;
 
-	foreach(Mesh *mesh, scene->meshes) {
-		if(mesh->need_update) {
-			pool.push(function_bind(&Mesh::compute_bvh, mesh, &scene->params, &progress, i, num_bvh));
-			i++;
-		}
+	foreach(Mesh *mesh, bvh_meshes) {
+		pool.push(function_bind(&Mesh::compute_bvh, mesh, &scene->params, &progress, i, num_bvh));
+		i++;
 	}
 
 	pool.wait_work();
@@ -68,6 +68,8 @@ Session::Session(const SessionParams& params_)
 	preview_time = 0.0;
 	paused_time = 0.0;
 	last_update_time = 0.0;
+	tail_start_time = 0.0;
+	last_release_time = 0.0;
 
 	delayed_reset.do_reset = false;
 	delayed_reset.samples = 0;
@@ -271,6 +273,8 @@ void Session::run_gpu()
 
 			device->task_wait();
 
+			update_tail_time();
+
 			if(!device->error_message().empty())
 				progress.set_cancel(device->error_message());
 
@@ -359,8 +363,13 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	Tile tile;
 	int device_num = device->device_number(tile_device);
 
-	if(!tile_manager.next_tile(tile, device_num))
+	if(!tile_manager.next_tile(tile, device_num)) {
+		/* first device thread without work marks the start of the pass tail */
+		if(tail_start_time == 0.0)
+			tail_start_time = time_dt();
+
 		return false;
+	}
 	
 	/* fill render tile */
 	rtile.x = tile_manager.state.buffer.full_x + tile.x;
@@ -453,6 +462,8 @@ void Session::release_tile(RenderTile& rtile)
 {
 	thread_scoped_lock tile_lock(tile_mutex);
 
+	last_release_time = time_dt();
+
 	if(write_render_tile_cb) {
 		if(params.progressive_refine == false) {
 			/* todo: optimize this by making it thread safe and removing lock */
@@ -563,6 +574,8 @@ void Session::run_cpu()
 
 		device->task_wait();
 
+		update_tail_time();
+
 		{
 			thread_scoped_lock reset_lock(delayed_reset.mutex);
 			thread_scoped_lock buffers_lock(buffers_mutex);
@@ -660,6 +673,9 @@ void Session::reset_(BufferParams& buffer_params, int samples)
 
 	tile_manager.reset(buffer_params, samples);
 
+	/* kernel statistics are for the samples since the last reset */
+	stats.kernel.reset();
+
 	start_time = time_dt();
 	preview_time = 0.0;
 	paused_time = 0.0;
@@ -838,6 +854,17 @@ void Session::update_progress_sample()
 	progress.increment_sample();
 }
 
+void Session::update_tail_time()
+{
+	thread_scoped_lock tile_lock(tile_mutex);
+
+	if(tail_start_time != 0.0 && last_release_time > tail_start_time)
+		progress.add_tail_time(last_release_time - tail_start_time);
+
+	tail_start_time = 0.0;
+	last_release_time = 0.0;
+}
+
 void Session::path_trace()
 {
 	/* add path trace task */
@@ -171,6 +171,7 @@ protected:
 	void release_tile(RenderTile& tile);
 
 	void update_progress_sample();
+	void update_tail_time();
 
 	bool device_use_gl;
 
@@ -196,6 +197,10 @@ protected:
 	double preview_time;
 	double paused_time;
 
+	/* tail latency of the current pass, protected by tile_mutex */
+	double tail_start_time;
+	double last_release_time;
+
 	/* progressive refine */
 	double last_update_time;
 	bool update_progressive_refine(bool cancel);
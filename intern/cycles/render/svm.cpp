@@ -739,5 +739,88 @@ void SVMCompiler::compile(Shader *shader, vector<int4>& global_svm_nodes, int in
 	global_svm_nodes.insert(global_svm_nodes.end(), svm_nodes.begin(), svm_nodes.end());
 }
 
-CCL_NAMESPACE_END
+/* Node Type Names */
+
+const char *svm_node_type_name(int type)
+{
+	switch(type) {
+		case NODE_END: return "end";
+		case NODE_CLOSURE_BSDF: return "closure_bsdf";
+		case NODE_CLOSURE_EMISSION: return "closure_emission";
+		case NODE_CLOSURE_BACKGROUND: return "closure_background";
+		case NODE_CLOSURE_SET_WEIGHT: return "closure_set_weight";
+		case NODE_CLOSURE_WEIGHT: return "closure_weight";
+		case NODE_MIX_CLOSURE: return "mix_closure";
+		case NODE_JUMP_IF_ZERO: return "jump_if_zero";
+		case NODE_JUMP_IF_ONE: return "jump_if_one";
+		case NODE_TEX_IMAGE: return "tex_image";
+		case NODE_TEX_IMAGE_BOX: return "tex_image_box";
+		case NODE_TEX_SKY: return "tex_sky";
+		case NODE_GEOMETRY: return "geometry";
+		case NODE_GEOMETRY_DUPLI: return "geometry_dupli";
+		case NODE_LIGHT_PATH: return "light_path";
+		case NODE_VALUE_F: return "value_f";
+		case NODE_VALUE_V: return "value_v";
+		case NODE_MIX: return "mix";
+		case NODE_ATTR: return "attr";
+		case NODE_CONVERT: return "convert";
+		case NODE_FRESNEL: return "fresnel";
+		case NODE_WIREFRAME: return "wireframe";
+		case NODE_WAVELENGTH: return "wavelength";
+		case NODE_BLACKBODY: return "blackbody";
+		case NODE_EMISSION_WEIGHT: return "emission_weight";
+		case NODE_TEX_GRADIENT: return "tex_gradient";
+		case NODE_TEX_VORONOI: return "tex_voronoi";
+		case NODE_TEX_MUSGRAVE: return "tex_musgrave";
+		case NODE_TEX_WAVE: return "tex_wave";
+		case NODE_TEX_MAGIC: return "tex_magic";
+		case NODE_TEX_NOISE: return "tex_noise";
+		case NODE_SHADER_JUMP: return "shader_jump";
+		case NODE_SET_DISPLACEMENT: return "set_displacement";
+		case NODE_GEOMETRY_BUMP_DX: return "geometry_bump_dx";
+		case NODE_GEOMETRY_BUMP_DY: return "geometry_bump_dy";
+		case NODE_SET_BUMP: return "set_bump";
+		case NODE_MATH: return "math";
+		case NODE_VECTOR_MATH: return "vector_math";
+		case NODE_VECTOR_TRANSFORM: return "vector_transform";
+		case NODE_MAPPING: return "mapping";
+		case NODE_TEX_COORD: return "tex_coord";
+		case NODE_TEX_COORD_BUMP_DX: return "tex_coord_bump_dx";
+		case NODE_TEX_COORD_BUMP_DY: return "tex_coord_bump_dy";
+		case NODE_ATTR_BUMP_DX: return "attr_bump_dx";
+		case NODE_ATTR_BUMP_DY: return "attr_bump_dy";
+		case NODE_TEX_ENVIRONMENT: return "tex_environment";
+		case NODE_CLOSURE_HOLDOUT: return "closure_holdout";
+		case NODE_LAYER_WEIGHT: return "layer_weight";
+		case NODE_CLOSURE_VOLUME: return "closure_volume";
+		case NODE_SEPARATE_VECTOR: return "separate_vector";
+		case NODE_COMBINE_VECTOR: return "combine_vector";
+		case NODE_SEPARATE_HSV: return "separate_hsv";
+		case NODE_COMBINE_HSV: return "combine_hsv";
+		case NODE_HSV: return "hsv";
+		case NODE_CAMERA: return "camera";
+		case NODE_INVERT: return "invert";
+		case NODE_NORMAL: return "normal";
+		case NODE_GAMMA: return "gamma";
+		case NODE_TEX_CHECKER: return "tex_checker";
+		case NODE_BRIGHTCONTRAST: return "brightcontrast";
+		case NODE_RGB_RAMP: return "rgb_ramp";
+		case NODE_RGB_CURVES: return "rgb_curves";
+		case NODE_VECTOR_CURVES: return "vector_curves";
+		case NODE_MIN_MAX: return "min_max";
+		case NODE_LIGHT_FALLOFF: return "light_falloff";
+		case NODE_OBJECT_INFO: return "object_info";
+		case NODE_PARTICLE_INFO: return "particle_info";
+		case NODE_TEX_BRICK: return "tex_brick";
+		case NODE_CLOSURE_SET_NORMAL: return "closure_set_normal";
+		case NODE_CLOSURE_AMBIENT_OCCLUSION: return "closure_ambient_occlusion";
+		case NODE_TANGENT: return "tangent";
+		case NODE_NORMAL_MAP: return "normal_map";
+		case NODE_HAIR_INFO: return "hair_info";
+		case NODE_UVMAP: return "uvmap";
+	}
 
+	return "unknown";
+}
+
+CCL_NAMESPACE_END
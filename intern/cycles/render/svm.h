@@ -152,6 +152,9 @@ protected:
 	bool compile_failed;
 };
 
+/* Name of an SVM node type, for kernel statistics */
+const char *svm_node_type_name(int type);
+
 CCL_NAMESPACE_END
 
 #endif /* __SVM_H__ */
@@ -39,6 +39,8 @@ public:
 		start_time = time_dt();
 		total_time = 0.0f;
 		tile_time = 0.0f;
+		tail_time = 0.0f;
+		max_tail_time = 0.0f;
 		status = "Initializing";
 		substatus = "";
 		sync_status = "";
@@ -60,6 +62,7 @@ public:
 
 		progress.get_status(status, substatus);
 		progress.get_tile(tile, total_time, tile_time);
+		progress.get_tail_time(tail_time, max_tail_time);
 
 		sample = progress.get_sample();
 
@@ -73,6 +76,8 @@ public:
 		start_time = time_dt();
 		total_time = 0.0f;
 		tile_time = 0.0f;
+		tail_time = 0.0f;
+		max_tail_time = 0.0f;
 		status = "Initializing";
 		substatus = "";
 		sync_status = "";
@@ -135,6 +140,26 @@ public:
 		tile_time_ = tile_time;
 	}
 
+	/* tail latency, time between the first render thread running out of tiles
+	 * and the last tile of the pass being finished */
+
+	void add_tail_time(double tail_time_)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		tail_time += tail_time_;
+		if(tail_time_ > max_tail_time)
+			max_tail_time = tail_time_;
+	}
+
+	void get_tail_time(double& tail_time_, double& max_tail_time_)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		tail_time_ = tail_time;
+		max_tail_time_ = max_tail_time;
+	}
+
 	void reset_sample()
 	{
 		thread_scoped_lock lock(progress_mutex);
@@ -250,6 +275,8 @@ protected:
 	double start_time;
 	double total_time;
 	double tile_time;
+	double tail_time;      /* tail latency summed over all passes */
+	double max_tail_time;  /* longest tail latency of a single pass */
 
 	string status;
 	string substatus;
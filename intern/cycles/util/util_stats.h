@@ -17,8 +17,73 @@
 #ifndef __UTIL_STATS_H__
 #define __UTIL_STATS_H__
 
+#include <string.h>
+
+#include "util_types.h"
+
 CCL_NAMESPACE_BEGIN
 
+/* Ray and shading statistics. The CPU kernels count these per thread when
+ * built with WITH_CYCLES_STATS, and they are summed when a thread is done. */
+
+class KernelStats {
+public:
+	enum RayType {
+		RAY_CAMERA = 0,
+		RAY_REFLECT,
+		RAY_TRANSMIT,
+		RAY_SHADOW,
+		RAY_SUBSURFACE,
+		RAY_VOLUME,
+		NUM_RAY_TYPES
+	};
+
+	enum { MAX_SVM_NODES = 128 };
+	enum { MAX_PATH_DEPTH = 64 };
+
+	KernelStats() { reset(); }
+
+	void reset() {
+		memset(this, 0, sizeof(KernelStats));
+	}
+
+	void add(const KernelStats& other) {
+		for(int i = 0; i < NUM_RAY_TYPES; i++)
+			num_rays[i] += other.num_rays[i];
+
+		num_bvh_nodes += other.num_bvh_nodes;
+		num_primitive_tests += other.num_primitive_tests;
+		num_shader_evals += other.num_shader_evals;
+
+		for(int i = 0; i < MAX_SVM_NODES; i++)
+			num_svm_nodes[i] += other.num_svm_nodes[i];
+		for(int i = 0; i < MAX_PATH_DEPTH; i++)
+			path_depth[i] += other.path_depth[i];
+	}
+
+	uint64_t total_rays() const {
+		uint64_t total = 0;
+		for(int i = 0; i < NUM_RAY_TYPES; i++)
+			total += num_rays[i];
+		return total;
+	}
+
+	static const char *ray_type_name(int type) {
+		static const char *names[NUM_RAY_TYPES] = {
+			"camera", "reflect", "transmit", "shadow", "subsurface", "volume"};
+		return names[type];
+	}
+
+	uint64_t num_rays[NUM_RAY_TYPES];
+	uint64_t num_bvh_nodes;
+	uint64_t num_primitive_tests;
+	uint64_t num_shader_evals;
+	/* number of executed SVM nodes, indexed by NodeType */
+	uint64_t num_svm_nodes[MAX_SVM_NODES];
+	/* number of paths ending at each bounce, the last bin includes deeper paths */
+	uint64_t path_depth[MAX_PATH_DEPTH];
+};
+
 class Stats {
 public:
 	Stats() : mem_used(0), mem_peak(0) {}
@@ -36,6 +101,9 @@ public:
 
 	size_t mem_used;
 	size_t mem_peak;
+
+	/* only filled in by the CPU device, when built with WITH_CYCLES_STATS */
+	KernelStats kernel;
 };
 
 CCL_NAMESPACE_END
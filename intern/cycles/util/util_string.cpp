@@ -86,6 +86,16 @@ void string_split(vector<string>& tokens, const string& str, const string& separ
 			tokens.push_back(token);
 }
 
+bool string_startswith(const string& s, const char *start)
+{
+	size_t len = strlen(start);
+
+	if(len > s.size())
+		return 0;
+	else
+		return strncmp(s.c_str(), start, len) == 0;
+}
+
 bool string_endswith(const string& s, const char *end)
 {
 	size_t len = strlen(end);
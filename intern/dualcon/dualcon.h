@@ -56,6 +56,8 @@ typedef void (*DualConAddQuad)(void *output, const int vert_indices[4]);
 
 typedef enum {
 	DUALCON_FLOOD_FILL = 1,
+	/* print the time taken by each phase to stdout */
+	DUALCON_PRINT_TIMINGS = 2,
 } DualConFlags;
 
 typedef enum {
@@ -76,6 +78,10 @@ typedef enum {
  * add_quad callbacks will then be called for each new vertex and
  * quad, and the callback should add the new mesh elements to the
  * structure.
+ *
+ * When built with OpenMP the octree and the output are generated on
+ * multiple threads, the callbacks are always called from the calling
+ * thread and in the same order as a single threaded run.
  */
 void *dualcon(const DualConInput *input_mesh,
               /* callbacks for output */
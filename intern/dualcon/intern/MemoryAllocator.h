@@ -71,7 +71,7 @@ class MemoryAllocator : public VirtualMemoryAllocator
 private:
 
 /// Constants
-int HEAP_UNIT, HEAP_MASK;
+int HEAP_SHIFT, HEAP_UNIT, HEAP_MASK;
 
 /// Data array
 UCHAR **data;
@@ -124,12 +124,13 @@ void allocateStackBlock( )
 
 public:
 /**
- * Constructor
+ * Constructor, objects are allocated in blocks of (1 << heap_base)
  */
-MemoryAllocator( )
+MemoryAllocator(int heap_base = HEAP_BASE)
 {
-	HEAP_UNIT = 1 << HEAP_BASE;
-	HEAP_MASK = (1 << HEAP_BASE) - 1;
+	HEAP_SHIFT = heap_base;
+	HEAP_UNIT = 1 << heap_base;
+	HEAP_MASK = (1 << heap_base) - 1;
 
 	data = ( UCHAR ** )malloc(sizeof(UCHAR *) );
 	data[0] = ( UCHAR * )malloc(HEAP_UNIT * N);
@@ -177,7 +178,7 @@ void *allocate( )
 
 	// printf("Allocating %d\n", header[ allocated ]) ;
 	available--;
-	return (void *)stack[available >> HEAP_BASE][available & HEAP_MASK];
+	return (void *)stack[available >> HEAP_SHIFT][available & HEAP_MASK];
 }
 
 /**
@@ -191,7 +192,7 @@ void deallocate(void *obj)
 	}
 
 	// printf("De-allocating %d\n", ( obj - data ) / N ) ;
-	stack[available >> HEAP_BASE][available & HEAP_MASK] = (UCHAR *)obj;
+	stack[available >> HEAP_SHIFT][available & HEAP_MASK] = (UCHAR *)obj;
 	available++;
 	// printf("%d %d\n", allocated, header[ allocated ]) ;
 }
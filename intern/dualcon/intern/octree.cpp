@@ -29,6 +29,10 @@
 #include <limits>
 #include <time.h>
 
+#if PARALLEL == 1
+#include <omp.h>
+#endif
+
 /**
  * Implementations of Octree member functions.
  *
@@ -46,6 +50,69 @@
 #define dc_printf(...) do {} while (0)
 #endif
 
+/* Above this depth the output is generated on one thread, streaming
+ * straight into the output mesh. Generating it in parallel needs the
+ * vertices and quads of each octant buffered until they can be added
+ * in order, which is too much memory for the finest octrees. */
+#define PARALLEL_OUTPUT_MAX_DEPTH 10
+
+/* Allocators of the octant subtrees use smaller blocks than the main
+ * ones (1 << HEAP_BASE), there are eight sets of them */
+#define OCTANT_HEAP_BASE 12
+
+static double dc_time()
+{
+#if PARALLEL == 1
+	return omp_get_wtime();
+#else
+	return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* print the time since 'time_prev' and reset it */
+static void print_phase_time(int use_timings, const char *phase, double &time_prev)
+{
+	double time_curr = dc_time();
+	if (use_timings) {
+		printf("dualcon: %s: %.3f sec\n", phase, time_curr - time_prev);
+	}
+	time_prev = time_curr;
+}
+
+static void create_allocators(VirtualMemoryAllocator *alloc[9],
+                              VirtualMemoryAllocator *leafalloc[4],
+                              int heap_base)
+{
+	leafalloc[0] = new MemoryAllocator<sizeof(LeafNode)>(heap_base);
+	leafalloc[1] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS>(heap_base);
+	leafalloc[2] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 2>(heap_base);
+	leafalloc[3] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 3>(heap_base);
+
+	alloc[0] = new MemoryAllocator<sizeof(InternalNode)>(heap_base);
+	alloc[1] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *)>(heap_base);
+	alloc[2] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 2>(heap_base);
+	alloc[3] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 3>(heap_base);
+	alloc[4] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 4>(heap_base);
+	alloc[5] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 5>(heap_base);
+	alloc[6] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 6>(heap_base);
+	alloc[7] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 7>(heap_base);
+	alloc[8] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 8>(heap_base);
+}
+
+static void destroy_allocators(VirtualMemoryAllocator *alloc[9],
+                               VirtualMemoryAllocator *leafalloc[4])
+{
+	for (int i = 0; i < 9; i++) {
+		alloc[i]->destroy();
+		delete alloc[i];
+	}
+
+	for (int i = 0; i < 4; i++) {
+		leafalloc[i]->destroy();
+		delete leafalloc[i];
+	}
+}
+
 Octree::Octree(ModelReader *mr,
                DualConAllocOutput alloc_output_func,
                DualConAddVert add_vert_func,
@@ -72,6 +139,7 @@ Octree::Octree(ModelReader *mr,
 	use_manifold(false),
 	hermite_num(sharpness),
 	mode(dualcon_mode),
+	use_timings(flags & DUALCON_PRINT_TIMINGS),
 	alloc_output(alloc_output_func),
 	add_vert(add_vert_func),
 	add_quad(add_quad_func)
@@ -112,35 +180,21 @@ Octree::~Octree()
 
 void Octree::scanConvert()
 {
-	// Scan triangles
-#if DC_DEBUG
-	clock_t start, finish;
-	start = clock();
-#endif
+	double time_start = dc_time(), time_prev = time_start;
 
+	// Scan triangles
 	addAllTriangles();
 	resetMinimalEdges();
 	preparePrimalEdgesMask(&root->internal);
 
-#if DC_DEBUG
-	finish = clock();
-	dc_printf("Time taken: %f seconds                   \n",
-	          (double)(finish - start) / CLOCKS_PER_SEC);
-#endif
+	print_phase_time(use_timings, "scan conversion", time_prev);
 
 	// Generate signs
 	// Find holes
-#if DC_DEBUG
 	dc_printf("Patching...\n");
-	start = clock();
-#endif
 	trace();
-#if DC_DEBUG
-	finish = clock();
-	dc_printf("Time taken: %f seconds \n",  (double)(finish - start) / CLOCKS_PER_SEC);
 #ifdef IN_VERBOSE_MODE
 	dc_printf("Holes: %d Average Length: %f Max Length: %d \n", numRings, (float)totRingLengths / (float) numRings, maxRingLength);
-#endif
 #endif
 
 	// Check again
@@ -151,15 +205,12 @@ void Octree::scanConvert()
 #endif
 	numRings = tnumRings;
 
-#if DC_DEBUG
+	print_phase_time(use_timings, "patching", time_prev);
+
 	dc_printf("Building signs...\n");
-	start = clock();
-#endif
 	buildSigns();
-#if DC_DEBUG
-	finish = clock();
-	dc_printf("Time taken: %f seconds \n",  (double)(finish - start) / CLOCKS_PER_SEC);
-#endif
+
+	print_phase_time(use_timings, "signs", time_prev);
 
 	if (use_flood_fill) {
 		/*
@@ -174,29 +225,20 @@ void Octree::scanConvert()
 		   finish = clock();
 		   dc_printf("Time taken: %f seconds \n",	(double)(finish - start) / CLOCKS_PER_SEC);
 		 */
-#if DC_DEBUG
-		start = clock();
 		dc_printf("Removing components...\n");
-#endif
 		floodFill();
 		buildSigns();
 		//	dc_printf("Checking...\n");
 		//	floodFill();
-#if DC_DEBUG
-		finish = clock();
-		dc_printf("Time taken: %f seconds \n", (double)(finish - start) / CLOCKS_PER_SEC);
-#endif
+
+		print_phase_time(use_timings, "flood fill", time_prev);
 	}
 
 	// Output
-#if DC_DEBUG
-	start = clock();
-#endif
 	writeOut();
-#if DC_DEBUG
-	finish = clock();
-#endif
-	// dc_printf("Time taken: %f seconds \n",	(double)(finish - start) / CLOCKS_PER_SEC);
+
+	print_phase_time(use_timings, "contouring", time_prev);
+	print_phase_time(use_timings, "total", time_start);
 
 	// Print info
 #ifdef IN_VERBOSE_MODE
@@ -206,32 +248,25 @@ void Octree::scanConvert()
 
 void Octree::initMemory()
 {
-	leafalloc[0] = new MemoryAllocator<sizeof(LeafNode)>();
-	leafalloc[1] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS>();
-	leafalloc[2] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 2>();
-	leafalloc[3] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 3>();
+	create_allocators(alloc, leafalloc, HEAP_BASE);
 
-	alloc[0] = new MemoryAllocator<sizeof(InternalNode)>();
-	alloc[1] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *)>();
-	alloc[2] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 2>();
-	alloc[3] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 3>();
-	alloc[4] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 4>();
-	alloc[5] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 5>();
-	alloc[6] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 6>();
-	alloc[7] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 7>();
-	alloc[8] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 8>();
+	/* created when building in parallel */
+	for (int i = 0; i < 8; i++) {
+		octantalloc[i] = NULL;
+	}
 }
 
 void Octree::freeMemory()
 {
-	for (int i = 0; i < 9; i++) {
-		alloc[i]->destroy();
-		delete alloc[i];
-	}
+	destroy_allocators(alloc, leafalloc);
 
-	for (int i = 0; i < 4; i++) {
-		leafalloc[i]->destroy();
-		delete leafalloc[i];
+	/* nodes of the octants may have been moved to the main allocators
+	 * free lists and the other way around, so all are freed together */
+	for (int i = 0; i < 8; i++) {
+		if (octantalloc[i]) {
+			destroy_allocators(octantalloc[i]->alloc, octantalloc[i]->leafalloc);
+			delete octantalloc[i];
+		}
 	}
 }
 
@@ -267,6 +302,14 @@ void Octree::addAllTriangles()
 	Triangle *trian;
 	int count = 0;
 
+#if PARALLEL == 1
+	/* the children of the root have to be internal nodes */
+	if (maxDepth > 1 && omp_get_max_threads() > 1) {
+		addAllTrianglesParallel();
+		return;
+	}
+#endif
+
 #if DC_DEBUG
 	int total = reader->getNumTriangles();
 	int unitcount = 1000;
@@ -321,25 +364,133 @@ void Octree::addAllTriangles()
 	putchar(13);
 }
 
-/* Prepare a triangle for insertion into the octree; call the other
-   addTriangle() to (recursively) build the octree */
-void Octree::addTriangle(Triangle *trian, int triind)
+/* Build the subtrees of the root's children in parallel. Triangles are
+   first sorted into the children they intersect, each subtree is then
+   built from its own list with its own allocators. Triangles are added
+   in the same order as addAllTriangles(), so the tree is the same. */
+void Octree::addAllTrianglesParallel()
+{
+	std::vector<Triangle> trians;
+	std::vector<int> octant_trians[8];
+	InternalNode *octants[8] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+	Triangle *trian;
+	int i;
+
+	trians.reserve(reader->getNumTriangles());
+
+	while ((trian = reader->getNextTriangle()) != NULL) {
+		const int triind = (int)trians.size();
+		int64_t cube[2][3] = {{0, 0, 0}, {dimen, dimen, dimen}};
+		int64_t trig[3][3];
+		int pos[3] = {0, 0, 0};
+
+		projectTriangle(trian, trig);
+		trians.push_back(*trian);
+		delete trian;
+
+		/* Same test as addTriangle() does for the children of the root */
+		CubeTriangleIsect *proj = new CubeTriangleIsect(cube, trig, (int64_t)0, triind);
+		CubeTriangleIsect *subp = new CubeTriangleIsect(proj);
+		unsigned char boxmask = proj->getBoxMask();
+
+		for (i = 0; i < 8; i++) {
+			if (boxmask & (1 << i)) {
+				int off[3] = {vertmap[i][0] - pos[0],
+				              vertmap[i][1] - pos[1],
+				              vertmap[i][2] - pos[2]};
+				subp->shift(off);
+				pos[0] = vertmap[i][0];
+				pos[1] = vertmap[i][1];
+				pos[2] = vertmap[i][2];
+
+				if (subp->isIntersecting()) {
+					octant_trians[i].push_back(triind);
+				}
+			}
+		}
+
+		delete subp;
+		delete proj->inherit;
+		delete proj;
+	}
+
+	for (i = 0; i < 8; i++) {
+		if (!octant_trians[i].empty() && octantalloc[i] == NULL) {
+			octantalloc[i] = new NodeAllocators;
+			create_allocators(octantalloc[i]->alloc, octantalloc[i]->leafalloc, OCTANT_HEAP_BASE);
+		}
+	}
+
+#pragma omp parallel for schedule(dynamic)
+	for (i = 0; i < 8; i++) {
+		const std::vector<int> &tri_indices = octant_trians[i];
+		NodeAllocators *mem = octantalloc[i];
+
+		if (tri_indices.empty()) {
+			continue;
+		}
+
+		InternalNode *node = createInternal(0, mem);
+
+		for (size_t j = 0; j < tri_indices.size(); j++) {
+			const Triangle *t = &trians[tri_indices[j]];
+			int64_t cube[2][3] = {{0, 0, 0}, {dimen, dimen, dimen}};
+			int64_t trig[3][3];
+			int off[3] = {vertmap[i][0], vertmap[i][1], vertmap[i][2]};
+
+			for (int k = 0; k < 3; k++) {
+				for (int l = 0; l < 3; l++)
+					trig[k][l] = (int64_t)(t->vt[k][l]);
+			}
+
+			CubeTriangleIsect *proj = new CubeTriangleIsect(cube, trig, (int64_t)0, tri_indices[j]);
+			CubeTriangleIsect *subp = new CubeTriangleIsect(proj);
+			subp->shift(off);
+
+			node = addTriangle(node, subp, maxDepth - 1, mem);
+
+			delete subp;
+			delete proj->inherit;
+			delete proj;
+		}
+
+		octants[i] = node;
+	}
+
+	/* Attach the subtrees to the root */
+	int count = 0;
+	for (i = 0; i < 8; i++) {
+		if (octants[i]) {
+			root = (Node *)addInternalChild(&root->internal, i, count, octants[i]);
+			count++;
+		}
+	}
+}
+
+/* Project the triangle's coordinates into the grid */
+void Octree::projectTriangle(Triangle *trian, int64_t trig[3][3]) const
 {
 	int i, j;
 
-	/* Project the triangle's coordinates into the grid */
 	for (i = 0; i < 3; i++) {
 		for (j = 0; j < 3; j++)
 			trian->vt[i][j] = dimen * (trian->vt[i][j] - origin[j]) / range;
 	}
 
-	/* Generate projections */
-	int64_t cube[2][3] = {{0, 0, 0}, {dimen, dimen, dimen}};
-	int64_t trig[3][3];
 	for (i = 0; i < 3; i++) {
 		for (j = 0; j < 3; j++)
 			trig[i][j] = (int64_t)(trian->vt[i][j]);
 	}
+}
+
+/* Prepare a triangle for insertion into the octree; call the other
+   addTriangle() to (recursively) build the octree */
+void Octree::addTriangle(Triangle *trian, int triind)
+{
+	/* Generate projections */
+	int64_t cube[2][3] = {{0, 0, 0}, {dimen, dimen, dimen}};
+	int64_t trig[3][3];
+	projectTriangle(trian, trig);
 
 	/* Add triangle to the octree */
 	int64_t errorvec = (int64_t)(0);
@@ -358,7 +509,8 @@ static void print_depth(int height, int maxDepth)
 }
 #endif
 
-InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int height)
+InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int height,
+                                  NodeAllocators *mem)
 {
 	int i;
 	const int vertdiff[8][3] = {
@@ -391,16 +543,16 @@ InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int
 			if (subp->isIntersecting()) {
 				if (!node->has_child(i)) {
 					if (height == 1)
-						node = addLeafChild(node, i, count, createLeaf(0));
+						node = addLeafChild(node, i, count, createLeaf(0, mem), mem);
 					else
-						node = addInternalChild(node, i, count, createInternal(0));
+						node = addInternalChild(node, i, count, createInternal(0, mem), mem);
 				}
 				Node *chd = node->get_child(count);
 
 				if (node->is_child_leaf(i))
-					node->set_child(count, (Node *)updateCell(&chd->leaf, subp));
+					node->set_child(count, (Node *)updateCell(&chd->leaf, subp, mem));
 				else
-					node->set_child(count, (Node *)addTriangle(&chd->internal, subp, height - 1));
+					node->set_child(count, (Node *)addTriangle(&chd->internal, subp, height - 1, mem));
 			}
 		}
 
@@ -413,7 +565,7 @@ InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int
 	return node;
 }
 
-LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p)
+LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p, NodeAllocators *mem)
 {
 	int i;
 
@@ -445,7 +597,7 @@ LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p)
 
 	if (newc > oldc) {
 		// New offsets added, update this node
-		node = updateEdgeOffsetsNormals(node, oldc, newc, offs, a, b, c);
+		node = updateEdgeOffsetsNormals(node, oldc, newc, offs, a, b, c, mem);
 	}
 
 	return node;
@@ -2051,6 +2203,13 @@ void Octree::writeOut()
 	int numVertices = 0;
 	int numEdges = 0;
 
+#if PARALLEL == 1
+	if (maxDepth <= PARALLEL_OUTPUT_MAX_DEPTH && omp_get_max_threads() > 1) {
+		writeOutParallel();
+		return;
+	}
+#endif
+
 	countIntersection(root, maxDepth, numQuads, numVertices, numEdges);
 
 	dc_printf("Vertices counted: %d Polys counted: %d \n", numVertices, numQuads);
@@ -2068,6 +2227,70 @@ void Octree::writeOut()
 	dc_printf("Vertices written: %d Quads written: %d \n", offset, actualQuads);
 }
 
+/* Same output as writeOut(), but the vertices and quads of each child of
+   the root are generated in parallel into buffers, which are then added
+   to the output mesh in order. Only the quads between the children are
+   generated on a single thread. */
+void Octree::writeOutParallel()
+{
+	InternalNode *node = &root->internal;
+	Node *chd[8];
+	int numQuads[8] = {0}, numVertices[8] = {0}, numEdges[8] = {0};
+	int offsets[9];
+	std::vector<int> quads[8];
+	int len = dimen >> 1;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		chd[i] = node->has_child(i) ? node->get_child(node->get_child_count(i)) : NULL;
+	}
+
+#pragma omp parallel for schedule(dynamic)
+	for (i = 0; i < 8; i++) {
+		if (chd[i]) {
+			countIntersection(chd[i], maxDepth - 1, numQuads[i], numVertices[i], numEdges[i]);
+		}
+	}
+
+	/* vertices of each child start where the previous child's end */
+	int totQuads = 0;
+	offsets[0] = 0;
+	for (i = 0; i < 8; i++) {
+		offsets[i + 1] = offsets[i] + numVertices[i];
+		totQuads += numQuads[i];
+	}
+
+	dc_printf("Vertices counted: %d Polys counted: %d \n", offsets[8], totQuads);
+	output_mesh = alloc_output(offsets[8], totQuads);
+
+	float (*co)[3] = new float[offsets[8] > 0 ? offsets[8] : 1][3];
+
+#pragma omp parallel for schedule(dynamic)
+	for (i = 0; i < 8; i++) {
+		if (chd[i]) {
+			int st[3] = {vertmap[i][0] * len, vertmap[i][1] * len, vertmap[i][2] * len};
+			int offset = offsets[i];
+
+			generateMinimizer(chd[i], st, len, maxDepth - 1, offset, co);
+			cellProcContour(chd[i], node->is_child_leaf(i), maxDepth - 1, &quads[i]);
+		}
+	}
+
+	for (i = 0; i < offsets[8]; i++) {
+		add_vert(output_mesh, co[i]);
+	}
+	delete [] co;
+
+	for (i = 0; i < 8; i++) {
+		for (size_t j = 0; j < quads[i].size(); j += 4) {
+			add_quad(output_mesh, &quads[i][j]);
+		}
+		std::vector<int>().swap(quads[i]);
+	}
+
+	cellProcContourShared(root, chd, maxDepth, NULL);
+}
+
 void Octree::countIntersection(Node *node, int height, int& nedge, int& ncell, int& nface)
 {
 	if (height > 0) {
@@ -2257,7 +2480,8 @@ void Octree::computeMinimizer(const LeafNode *leaf, int st[3], int len,
 	}
 }
 
-void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int& offset)
+void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int& offset,
+                               float (*co)[3])
 {
 	int i, j;
 
@@ -2290,7 +2514,14 @@ void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int&
 		}
 
 		for (j = 0; j < mult; j++) {
-			add_vert(output_mesh, rvalue);
+			if (co) {
+				co[offset + j][0] = rvalue[0];
+				co[offset + j][1] = rvalue[1];
+				co[offset + j][2] = rvalue[2];
+			}
+			else {
+				add_vert(output_mesh, rvalue);
+			}
 		}
 
 		// Store the index
@@ -2310,14 +2541,15 @@ void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int&
 				nst[2] = st[2] + vertmap[i][2] * len;
 
 				generateMinimizer(node->internal.get_child(count),
-				                  nst, len, height - 1, offset);
+				                  nst, len, height - 1, offset, co);
 				count++;
 			}
 		}
 	}
 }
 
-void Octree::processEdgeWrite(Node *node[4], int depth[4], int maxdep, int dir)
+void Octree::processEdgeWrite(Node *node[4], int depth[4], int maxdep, int dir,
+                              std::vector<int> *quads)
 {
 	//int color = 0;
 
@@ -2369,7 +2601,12 @@ void Octree::processEdgeWrite(Node *node[4], int depth[4], int maxdep, int dir)
 						ind[3] = getMinimizerIndex((LeafNode *)(node[2]));
 					}
 
-					add_quad(output_mesh, ind);
+					if (quads) {
+						quads->insert(quads->end(), ind, ind + 4);
+					}
+					else {
+						add_quad(output_mesh, ind);
+					}
 				}
 			}
 			return;
@@ -2381,13 +2618,14 @@ void Octree::processEdgeWrite(Node *node[4], int depth[4], int maxdep, int dir)
 }
 
 
-void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxdep, int dir)
+void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxdep, int dir,
+                             std::vector<int> *quads)
 {
 	if (!(node[0] && node[1] && node[2] && node[3])) {
 		return;
 	}
 	if (leaf[0] && leaf[1] && leaf[2] && leaf[3]) {
-		processEdgeWrite(node, depth, maxdep, dir);
+		processEdgeWrite(node, depth, maxdep, dir, quads);
 	}
 	else {
 		int i, j;
@@ -2423,13 +2661,14 @@ void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxde
 				}
 			}
 
-			edgeProcContour(ne, le, de, maxdep - 1, edgeProcEdgeMask[dir][i][4]);
+			edgeProcContour(ne, le, de, maxdep - 1, edgeProcEdgeMask[dir][i][4], quads);
 		}
 
 	}
 }
 
-void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxdep, int dir)
+void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxdep, int dir,
+                             std::vector<int> *quads)
 {
 	if (!(node[0] && node[1])) {
 		return;
@@ -2465,7 +2704,7 @@ void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxde
 					df[j] = depth[j] - 1;
 				}
 			}
-			faceProcContour(nf, lf, df, maxdep - 1, faceProcFaceMask[dir][i][2]);
+			faceProcContour(nf, lf, df, maxdep - 1, faceProcFaceMask[dir][i][2], quads);
 		}
 
 		// 4 edge calls
@@ -2492,13 +2731,13 @@ void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxde
 				}
 			}
 
-			edgeProcContour(ne, le, de, maxdep - 1, faceProcEdgeMask[dir][i][5]);
+			edgeProcContour(ne, le, de, maxdep - 1, faceProcEdgeMask[dir][i][5], quads);
 		}
 	}
 }
 
 
-void Octree::cellProcContour(Node *node, int leaf, int depth)
+void Octree::cellProcContour(Node *node, int leaf, int depth, std::vector<int> *quads)
 {
 	if (node == NULL) {
 		return;
@@ -2516,41 +2755,48 @@ void Octree::cellProcContour(Node *node, int leaf, int depth)
 
 		// 8 Cell calls
 		for (i = 0; i < 8; i++) {
-			cellProcContour(chd[i], node->internal.is_child_leaf(i), depth - 1);
+			cellProcContour(chd[i], node->internal.is_child_leaf(i), depth - 1, quads);
 		}
 
-		// 12 face calls
-		Node *nf[2];
-		int lf[2];
-		int df[2] = {depth - 1, depth - 1};
-		for (i = 0; i < 12; i++) {
-			int c[2] = {cellProcFaceMask[i][0], cellProcFaceMask[i][1]};
+		cellProcContourShared(node, chd, depth, quads);
+	}
+}
 
-			lf[0] = node->internal.is_child_leaf(c[0]);
-			lf[1] = node->internal.is_child_leaf(c[1]);
+/* Contour the faces and edges shared by the children of an internal node */
+void Octree::cellProcContourShared(Node *node, Node *chd[8], int depth, std::vector<int> *quads)
+{
+	int i;
 
-			nf[0] = chd[c[0]];
-			nf[1] = chd[c[1]];
+	// 12 face calls
+	Node *nf[2];
+	int lf[2];
+	int df[2] = {depth - 1, depth - 1};
+	for (i = 0; i < 12; i++) {
+		int c[2] = {cellProcFaceMask[i][0], cellProcFaceMask[i][1]};
 
-			faceProcContour(nf, lf, df, depth - 1, cellProcFaceMask[i][2]);
-		}
+		lf[0] = node->internal.is_child_leaf(c[0]);
+		lf[1] = node->internal.is_child_leaf(c[1]);
 
-		// 6 edge calls
-		Node *ne[4];
-		int le[4];
-		int de[4] = {depth - 1, depth - 1, depth - 1, depth - 1};
-		for (i = 0; i < 6; i++) {
-			int c[4] = {cellProcEdgeMask[i][0], cellProcEdgeMask[i][1], cellProcEdgeMask[i][2], cellProcEdgeMask[i][3]};
+		nf[0] = chd[c[0]];
+		nf[1] = chd[c[1]];
 
-			for (int j = 0; j < 4; j++) {
-				le[j] = node->internal.is_child_leaf(c[j]);
-				ne[j] = chd[c[j]];
-			}
+		faceProcContour(nf, lf, df, depth - 1, cellProcFaceMask[i][2], quads);
+	}
 
-			edgeProcContour(ne, le, de, depth - 1, cellProcEdgeMask[i][4]);
+	// 6 edge calls
+	Node *ne[4];
+	int le[4];
+	int de[4] = {depth - 1, depth - 1, depth - 1, depth - 1};
+	for (i = 0; i < 6; i++) {
+		int c[4] = {cellProcEdgeMask[i][0], cellProcEdgeMask[i][1], cellProcEdgeMask[i][2], cellProcEdgeMask[i][3]};
+
+		for (int j = 0; j < 4; j++) {
+			le[j] = node->internal.is_child_leaf(c[j]);
+			ne[j] = chd[c[j]];
 		}
-	}
 
+		edgeProcContour(ne, le, de, depth - 1, cellProcEdgeMask[i][4], quads);
+	}
 }
 
 void Octree::processEdgeParity(LeafNode *node[4], int depth[4], int maxdep, int dir)
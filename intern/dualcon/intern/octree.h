@@ -27,6 +27,7 @@
 #include <cstring>
 #include <stdio.h>
 #include <math.h>
+#include <vector>
 #include "GeoCommon.h"
 #include "Projections.h"
 #include "ModelReader.h"
@@ -223,6 +224,19 @@ struct PathList {
 };
 
 
+/**
+ * Allocators for all node sizes. The allocators are not thread safe,
+ * subtrees that are built in parallel each use their own set.
+ */
+struct NodeAllocators {
+	VirtualMemoryAllocator *alloc[9];
+	VirtualMemoryAllocator *leafalloc[4];
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("DUALCON:NodeAllocators")
+#endif
+};
+
 /**
  * Class for building and processing an octree
  */
@@ -235,6 +249,9 @@ class Octree
 	VirtualMemoryAllocator *alloc[9];
 	VirtualMemoryAllocator *leafalloc[4];
 
+	/// Allocators for the subtrees of the root, only used when building in parallel
+	NodeAllocators *octantalloc[8];
+
 	/// Root node
 	Node *root;
 
@@ -277,6 +294,9 @@ class Octree
 
 	DualConMode mode;
 
+	/// Print the time taken by each phase
+	int use_timings;
+
  public:
 	/**
 	 * Construtor
@@ -336,13 +356,16 @@ class Octree
 	 * Add triangles to the tree
 	 */
 	void addAllTriangles();
+	void addAllTrianglesParallel();
+	void projectTriangle(Triangle *trian, int64_t trig[3][3]) const;
 	void addTriangle(Triangle *trian, int triind);
-	InternalNode *addTriangle(InternalNode *node, CubeTriangleIsect *p, int height);
+	InternalNode *addTriangle(InternalNode *node, CubeTriangleIsect *p, int height,
+	                          NodeAllocators *mem = NULL);
 
 	/**
 	 * Method to update minimizer in a cell: update edge intersections instead
 	 */
-	LeafNode *updateCell(LeafNode *node, CubeTriangleIsect *p);
+	LeafNode *updateCell(LeafNode *node, CubeTriangleIsect *p, NodeAllocators *mem = NULL);
 
 	/* Routines to detect and patch holes */
 	int numRings;
@@ -419,19 +442,25 @@ class Octree
 	 * Write out polygon file
 	 */
 	void writeOut();
+	void writeOutParallel();
 
 	void countIntersection(Node *node, int height, int& nedge, int& ncell, int& nface);
-	void generateMinimizer(Node *node, int st[3], int len, int height, int& offset);
+	/**
+	 * When 'co' is given, vertices are written to it instead of the output mesh
+	 */
+	void generateMinimizer(Node *node, int st[3], int len, int height, int& offset,
+	                       float (*co)[3] = NULL);
 	void computeMinimizer(const LeafNode * leaf, int st[3], int len,
 	                      float rvalue[3]) const;
 	/**
-	 * Traversal functions to generate polygon model
-	 * op: 0 for counting, 1 for writing OBJ, 2 for writing OFF, 3 for writing PLY
+	 * Traversal functions to generate polygon model.
+	 * When 'quads' is given, quads are appended to it instead of the output mesh
 	 */
-	void cellProcContour(Node *node, int leaf, int depth);
-	void faceProcContour(Node * node[2], int leaf[2], int depth[2], int maxdep, int dir);
-	void edgeProcContour(Node * node[4], int leaf[4], int depth[4], int maxdep, int dir);
-	void processEdgeWrite(Node * node[4], int depths[4], int maxdep, int dir);
+	void cellProcContour(Node *node, int leaf, int depth, std::vector<int> *quads = NULL);
+	void cellProcContourShared(Node *node, Node *chd[8], int depth, std::vector<int> *quads);
+	void faceProcContour(Node * node[2], int leaf[2], int depth[2], int maxdep, int dir, std::vector<int> *quads);
+	void edgeProcContour(Node * node[4], int leaf[4], int depth[4], int maxdep, int dir, std::vector<int> *quads);
+	void processEdgeWrite(Node * node[4], int depths[4], int maxdep, int dir, std::vector<int> *quads);
 
 	/* output callbacks/data */
 	DualConAllocOutput alloc_output;
@@ -1143,17 +1172,18 @@ class Octree
 
 
 	/// Update method
-	LeafNode *updateEdgeOffsetsNormals(LeafNode *leaf, int oldlen, int newlen, float offs[3], float a[3], float b[3], float c[3])
+	LeafNode *updateEdgeOffsetsNormals(LeafNode *leaf, int oldlen, int newlen, float offs[3], float a[3], float b[3], float c[3],
+	                                   NodeAllocators *mem = NULL)
 	{
 		// First, create a new leaf node
-		LeafNode *nleaf = createLeaf(newlen);
+		LeafNode *nleaf = createLeaf(newlen, mem);
 		*nleaf = *leaf;
 
 		// Next, fill in the offsets
 		setEdgeOffsetsNormals(nleaf, offs, a, b, c, newlen);
 
 		// Finally, delete the old leaf
-		removeLeaf(oldlen, leaf);
+		removeLeaf(oldlen, leaf, mem);
 
 		return nleaf;
 	}
@@ -1306,20 +1336,22 @@ class Octree
 		return rnode;
 	}
 
-	/// Allocate a node
-	InternalNode *createInternal(int length)
+	/// Allocate a node, from 'mem' when given
+	InternalNode *createInternal(int length, NodeAllocators *mem = NULL)
 	{
-		InternalNode *inode = (InternalNode *)alloc[length]->allocate();
+		VirtualMemoryAllocator *a = mem ? mem->alloc[length] : alloc[length];
+		InternalNode *inode = (InternalNode *)a->allocate();
 		inode->has_child_bitfield = 0;
 		inode->child_is_leaf_bitfield = 0;
 		return inode;
 	}
 
-	LeafNode *createLeaf(int length)
+	LeafNode *createLeaf(int length, NodeAllocators *mem = NULL)
 	{
 		assert(length <= 3);
 
-		LeafNode *lnode = (LeafNode *)leafalloc[length]->allocate();
+		VirtualMemoryAllocator *a = mem ? mem->leafalloc[length] : leafalloc[length];
+		LeafNode *lnode = (LeafNode *)a->allocate();
 		lnode->edge_parity = 0;
 		lnode->primary_edge_intersections = 0;
 		lnode->signs = 0;
@@ -1327,23 +1359,25 @@ class Octree
 		return lnode;
 	}
 
-	void removeInternal(int num, InternalNode *node)
+	void removeInternal(int num, InternalNode *node, NodeAllocators *mem = NULL)
 	{
-		alloc[num]->deallocate(node);
+		VirtualMemoryAllocator *a = mem ? mem->alloc[num] : alloc[num];
+		a->deallocate(node);
 	}
 
-	void removeLeaf(int num, LeafNode *leaf)
+	void removeLeaf(int num, LeafNode *leaf, NodeAllocators *mem = NULL)
 	{
 		assert(num >= 0 && num <= 3);
-		leafalloc[num]->deallocate(leaf);
+		VirtualMemoryAllocator *a = mem ? mem->leafalloc[num] : leafalloc[num];
+		a->deallocate(leaf);
 	}
 
 	/// Add a leaf (by creating a new par node with the leaf added)
 	InternalNode *addLeafChild(InternalNode *par, int index, int count,
-							   LeafNode *leaf)
+							   LeafNode *leaf, NodeAllocators *mem = NULL)
 	{
 		int num = par->get_num_children() + 1;
-		InternalNode *npar = createInternal(num);
+		InternalNode *npar = createInternal(num, mem);
 		*npar = *par;
 
 		if (num == 1) {
@@ -1360,15 +1394,15 @@ class Octree
 			}
 		}
 
-		removeInternal(num - 1, par);
+		removeInternal(num - 1, par, mem);
 		return npar;
 	}
 
 	InternalNode *addInternalChild(InternalNode *par, int index, int count,
-								   InternalNode *node)
+								   InternalNode *node, NodeAllocators *mem = NULL)
 	{
 		int num = par->get_num_children() + 1;
-		InternalNode *npar = createInternal(num);
+		InternalNode *npar = createInternal(num, mem);
 		*npar = *par;
 
 		if (num == 1) {
@@ -1385,7 +1419,7 @@ class Octree
 			}
 		}
 
-		removeInternal(num - 1, par);
+		removeInternal(num - 1, par, mem);
 		return npar;
 	}
 
@@ -80,6 +80,7 @@ public:
 	explicit MEM_CacheLimiterHandle(T * data_,MEM_CacheLimiter<T> *parent_) :
 		data(data_),
 		refcount(0),
+		data_size(0),
 		parent(parent_)
 	{ }
 
@@ -130,6 +131,8 @@ private:
 
 	T * data;
 	int refcount;
+	/* size of data as last measured by the parent, included in its total */
+	size_t data_size;
 	typename std::list<MEM_CacheLimiterHandle<T> *, MEM_Allocator<MEM_CacheLimiterHandle<T> *> >::iterator me;
 	MEM_CacheLimiter<T> * parent;
 };
@@ -142,7 +145,10 @@ public:
 	typedef bool   (*MEM_CacheLimiter_ItemDestroyable_Func) (void *item);
 
 	MEM_CacheLimiter(MEM_CacheLimiter_DataSize_Func data_size_func)
-		: data_size_func(data_size_func) {
+		: data_size_func(data_size_func),
+		  item_priority_func(NULL),
+		  item_destroyable_func(NULL),
+		  total_size(0) {
 	}
 
 	~MEM_CacheLimiter() {
@@ -156,37 +162,46 @@ public:
 		iterator it = queue.end();
 		--it;
 		queue.back()->me = it;
+		update_size(queue.back());
 		return queue.back();
 	}
 
 	void unmanage(MEM_CacheLimiterHandle<T> *handle) {
+		total_size -= handle->data_size;
 		queue.erase(handle->me);
 		delete handle;
 	}
 
+	/* Sizes are measured on insert and touch, and summed as we go,
+	 * so this doesn't need to visit every element.
+	 */
 	size_t get_memory_in_use() {
-		size_t size = 0;
 		if (data_size_func) {
-			for (iterator it = queue.begin(); it != queue.end(); it++) {
-				size += data_size_func((*it)->get()->get_data());
-			}
+			return total_size;
 		}
 		else {
-			size = MEM_get_memory_in_use();
+			return MEM_get_memory_in_use();
 		}
-		return size;
 	}
 
 	void enforce_limits() {
 		size_t max = MEM_CacheLimiter_get_maximum();
-		bool is_disabled = MEM_CacheLimiter_is_disabled();
-		size_t mem_in_use, cur_size;
 
-		if (is_disabled) {
+		if (max == 0) {
 			return;
 		}
 
-		if (max == 0) {
+		enforce_limits(max);
+	}
+
+	/* Unlike the global maximum, a max of zero here means everything
+	 * that can be destroyed is.
+	 */
+	void enforce_limits(size_t max) {
+		bool is_disabled = MEM_CacheLimiter_is_disabled();
+		size_t mem_in_use;
+
+		if (is_disabled) {
 			return;
 		}
 
@@ -196,31 +211,41 @@ public:
 			return;
 		}
 
-		while (!queue.empty() && mem_in_use > max) {
-			MEM_CacheElementPtr elem = get_least_priority_destroyable_element();
+		if (!item_priority_func) {
+			/* queue is sorted from least to most recently used */
+			iterator it = queue.begin();
 
-			if (!elem)
-				break;
+			while (it != queue.end() && mem_in_use > max) {
+				MEM_CacheElementPtr elem = *it++;
 
-			if (data_size_func) {
-				cur_size = data_size_func(elem->get()->get_data());
-			}
-			else {
-				cur_size = mem_in_use;
+				if (can_destroy_element(elem)) {
+					elem->destroy_if_possible();
+					mem_in_use = get_memory_in_use();
+				}
 			}
+		}
+		else {
+			/* Priorities don't change while freeing, so evaluate them once
+			 * instead of searching the whole queue for every freed element.
+			 */
+			MEM_CachePriorityQueue priority_queue;
 
-			if (elem->destroy_if_possible()) {
-				if (data_size_func) {
-					mem_in_use -= cur_size;
-				}
-				else {
-					mem_in_use -= cur_size - MEM_get_memory_in_use();
-				}
+			get_destroyable_elements_by_priority(priority_queue);
+
+			while (!priority_queue.empty() && mem_in_use > max) {
+				MEM_CacheElementPtr elem = priority_queue.top().elem;
+
+				priority_queue.pop();
+				elem->destroy_if_possible();
+				mem_in_use = get_memory_in_use();
 			}
 		}
 	}
 
 	void touch(MEM_CacheLimiterHandle<T> * handle) {
+		/* data may have changed since it was inserted */
+		update_size(handle);
+
 		/* If we're using custom priority callback re-arranging the queue
 		 * doesn't make much sense because we'll iterate it all to get
 		 * least priority element anyway.
@@ -247,6 +272,26 @@ private:
 	typedef std::list<MEM_CacheElementPtr, MEM_Allocator<MEM_CacheElementPtr> > MEM_CacheQueue;
 	typedef typename MEM_CacheQueue::iterator iterator;
 
+	struct MEM_CachePriorityElement {
+		MEM_CachePriorityElement(MEM_CacheElementPtr elem_, int priority_, int index_)
+			: elem(elem_), priority(priority_), index(index_) {
+		}
+
+		/* inverted, so the top of the queue is the lowest priority,
+		 * elements with equal priority are freed in queue order */
+		bool operator<(const MEM_CachePriorityElement &other) const {
+			if (priority != other.priority)
+				return priority > other.priority;
+			return index > other.index;
+		}
+
+		MEM_CacheElementPtr elem;
+		int priority;
+		int index;
+	};
+	typedef std::priority_queue<MEM_CachePriorityElement,
+	                            std::vector<MEM_CachePriorityElement> > MEM_CachePriorityQueue;
+
 	/* Check whether element can be destroyed when enforcing cache limits */
 	bool can_destroy_element(MEM_CacheElementPtr &elem) {
 		if (!elem->can_destroy()) {
@@ -260,52 +305,39 @@ private:
 		return true;
 	}
 
-	MEM_CacheElementPtr get_least_priority_destroyable_element(void) {
-		if (queue.empty())
-			return NULL;
-
-		MEM_CacheElementPtr best_match_elem = NULL;
-
-		if (!item_priority_func) {
-			for (iterator it = queue.begin(); it != queue.end(); it++) {
-				MEM_CacheElementPtr elem = *it;
-				if (!can_destroy_element(elem))
-					continue;
-				best_match_elem = elem;
-				break;
-			}
+	void update_size(MEM_CacheElementPtr elem) {
+		if (data_size_func && elem->get()) {
+			total_size -= elem->data_size;
+			elem->data_size = data_size_func(elem->get()->get_data());
+			total_size += elem->data_size;
 		}
-		else {
-			int best_match_priority = 0;
-			iterator it;
-			int i;
+	}
 
-			for (it = queue.begin(), i = 0; it != queue.end(); it++, i++) {
-				MEM_CacheElementPtr elem = *it;
+	void get_destroyable_elements_by_priority(MEM_CachePriorityQueue &priority_queue) {
+		iterator it;
+		int i;
 
-				if (!can_destroy_element(elem))
-					continue;
+		for (it = queue.begin(), i = 0; it != queue.end(); it++, i++) {
+			MEM_CacheElementPtr elem = *it;
 
-				/* by default 0 means highest priority element */
-				/* casting a size type to int is questionable,
-				   but unlikely to cause problems */
-				int priority = -((int)(queue.size()) - i - 1);
-				priority = item_priority_func(elem->get()->get_data(), priority);
+			if (!can_destroy_element(elem))
+				continue;
 
-				if (priority < best_match_priority || best_match_elem == NULL) {
-					best_match_priority = priority;
-					best_match_elem = elem;
-				}
-			}
-		}
+			/* by default 0 means highest priority element */
+			/* casting a size type to int is questionable,
+			   but unlikely to cause problems */
+			int priority = -((int)(queue.size()) - i - 1);
+			priority = item_priority_func(elem->get()->get_data(), priority);
 
-		return best_match_elem;
+			priority_queue.push(MEM_CachePriorityElement(elem, priority, i));
+		}
 	}
 
 	MEM_CacheQueue queue;
 	MEM_CacheLimiter_DataSize_Func data_size_func;
 	MEM_CacheLimiter_ItemPriority_Func item_priority_func;
 	MEM_CacheLimiter_ItemDestroyable_Func item_destroyable_func;
+	size_t total_size;
 };
 
 #endif  // __MEM_CACHELIMITER_H__
@@ -95,6 +95,15 @@ MEM_CacheLimiterHandleC *MEM_CacheLimiter_insert(MEM_CacheLimiterC *This, void *
 
 void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This);
 
+/**
+ * Free objects until this limiter uses no more than max bytes,
+ * for callers that split the global maximum between several limiters.
+ *
+ * @param This "This" pointer, max memory limit for this limiter
+ */
+
+void MEM_CacheLimiter_enforce_limits_ex(MEM_CacheLimiterC *This, size_t max);
+
 /**
  * Unmanage object previously inserted object.
  * Does _not_ delete managed object!
@@ -107,6 +116,7 @@ void MEM_CacheLimiter_unmanage(MEM_CacheLimiterHandleC *handle);
 
 /**
  * Raise priority of object (put it at the tail of the deletion chain)
+ * and measure its size again, in case the object changed since it was inserted.
  *
  * @param handle of object
  */
@@ -155,6 +155,8 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
         col.label(text="Object:")
         col.prop(md, "object", text="")
 
+        layout.prop(md, "solver")
+
     def BUILD(self, layout, ob, md):
         split = layout.split()
 
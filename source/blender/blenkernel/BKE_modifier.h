@@ -100,7 +100,17 @@ typedef enum {
 	eModifierTypeFlag_NoUserAdd = (1 << 8),
 
 	/* For modifiers that use CD_PREVIEW_MCOL for preview. */
-	eModifierTypeFlag_UsesPreview = (1 << 9)
+	eModifierTypeFlag_UsesPreview = (1 << 9),
+
+	/* Expensive modifiers, the stack result after them is kept so that
+	 * changes further down the stack don't have to evaluate them again.
+	 * Implies eModifierTypeFlag_Checkpoint. */
+	eModifierTypeFlag_CacheResult = (1 << 10),
+
+	/* Modifiers that can be skipped when resuming from a checkpoint further down
+	 * the stack: no side effects, and all settings are plain values in the DNA
+	 * struct (see modifier_checkpoint_hash for the pointers it leaves out). */
+	eModifierTypeFlag_Checkpoint = (1 << 11),
 } ModifierTypeFlag;
 
 typedef void (*ObjectWalkFunc)(void *userData, struct Object *ob, struct Object **obpoin);
@@ -361,6 +371,7 @@ struct Object *modifiers_isDeformedByCurve(struct Object *ob);
 bool          modifiers_usesArmature(struct Object *ob, struct bArmature *arm);
 bool          modifiers_isCorrectableDeformed(struct Scene *scene, struct Object *ob);
 void          modifier_freeTemporaryData(struct ModifierData *md);
+void          modifier_freeCheckpoint(struct ModifierData *md);
 bool          modifiers_isPreview(struct Object *ob);
 
 typedef struct CDMaskLink {
@@ -368,6 +379,16 @@ typedef struct CDMaskLink {
 	CustomDataMask mask;
 } CDMaskLink;
 
+/* Result of the modifier stack up to and including a modifier with
+ * eModifierTypeFlag_CacheResult, hash covers the input mesh and the settings
+ * of every modifier up to this one (see mesh_calc_modifiers).
+ */
+typedef struct ModifierCheckpoint {
+	struct DerivedMesh *dm;
+	uint64_t hash;
+	CustomDataMask append_mask;
+} ModifierCheckpoint;
+
 /* Calculates and returns a linked list of CustomDataMasks indicating the
  * data required by each modifier in the stack pointed to by md for correct
  * evaluation, assuming the data indicated by dataMask is required at the
@@ -177,7 +177,9 @@ struct ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra,
 struct ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown);
 struct ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra, struct Sequence *seq);
 struct ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context, float cfra, int chan_shown, struct ListBase *seqbasep);
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context, float cfra, int chan_shown);
+void BKE_sequencer_prefetch_stop(void);
+int BKE_sequencer_prefetch_frames_ready(struct Scene *scene, int cfra);
+void BKE_sequencer_anim_readahead_stop(struct Scene *scene);
 
 /* **********************************************************************
  * sequencer.c
@@ -237,6 +239,7 @@ bool BKE_sequencer_input_have_to_preprocess(const SeqRenderData *context, struct
 struct SeqIndexBuildContext *BKE_sequencer_proxy_rebuild_context(struct Main *bmain, struct Scene *scene, struct Sequence *seq);
 void BKE_sequencer_proxy_rebuild(struct SeqIndexBuildContext *context, short *stop, short *do_update, float *progress);
 void BKE_sequencer_proxy_rebuild_finish(struct SeqIndexBuildContext *context, bool stop);
+bool BKE_sequencer_proxy_rebuild_supports_threads(struct SeqIndexBuildContext *context);
 
 /* **********************************************************************
  * seqcache.c
@@ -43,6 +43,7 @@ struct ColorBand;
 struct EnvMap;
 struct FreestyleLineStyle;
 struct HaloRen;
+struct ImagePool;
 struct Lamp;
 struct LampRen;
 struct Main;
@@ -133,6 +134,9 @@ struct OceanTex *BKE_copy_oceantex(struct OceanTex *ot);
 	
 bool    BKE_texture_dependsOnTime(const struct Tex *texture);
 
+void BKE_texture_get_value_ex(
+        struct Scene *scene, struct Tex *texture, float *tex_co, struct TexResult *texres,
+        struct ImagePool *pool, bool use_color_management);
 void BKE_texture_get_value(struct Scene *scene, struct Tex *texture, float *tex_co, struct TexResult *texres, bool use_color_management);
 
 #ifdef __cplusplus
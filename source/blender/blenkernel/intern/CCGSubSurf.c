@@ -30,6 +30,11 @@
 #include "BLI_sys_types.h" // for intptr_t support
 
 #include "BLI_utildefines.h" /* for BLI_assert */
+#include "BLI_ghash.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+
+#include "atomic_ops.h"
 
 #include "BKE_ccg.h"
 #include "CCGSubSurf.h"
@@ -442,6 +447,10 @@ struct CCGSubSurf {
 	int lenTempArrays;
 	CCGVert **tempVerts;
 	CCGEdge **tempEdges;
+
+	/* precomputed weights for syncs that keep the topology */
+	int useStencils;
+	CCGStencilTable *stencils;
 };
 
 #define CCGSUBSURF_alloc(ss, nb)            ((ss)->allocatorIFC.alloc((ss)->allocator, nb))
@@ -895,6 +904,9 @@ CCGSubSurf *ccgSubSurf_new(CCGMeshIFC *ifc, int subdivLevels, CCGAllocatorIFC *a
 		ss->tempVerts = NULL;
 		ss->tempEdges = NULL;
 
+		ss->useStencils = 0;
+		ss->stencils = NULL;
+
 		return ss;
 	}
 }
@@ -916,6 +928,7 @@ void ccgSubSurf_free(CCGSubSurf *ss)
 	CCGSUBSURF_free(ss, ss->r);
 	CCGSUBSURF_free(ss, ss->q);
 	if (ss->defaultEdgeUserData) CCGSUBSURF_free(ss, ss->defaultEdgeUserData);
+	ccgSubSurf_freeStencils(ss->stencils);
 
 	_ehash_free(ss->fMap, (EHEntryFreeFP) _face_free, ss);
 	_ehash_free(ss->eMap, (EHEntryFreeFP) _edge_free, ss);
@@ -1038,6 +1051,15 @@ void ccgSubSurf_setNumLayers(CCGSubSurf *ss, int numLayers)
 	ss->meshIFC.numLayers = numLayers;
 }
 
+void ccgSubSurf_setUseStencils(CCGSubSurf *ss, int useStencils)
+{
+	ss->useStencils = useStencils;
+	if (!useStencils) {
+		ccgSubSurf_freeStencils(ss->stencils);
+		ss->stencils = NULL;
+	}
+}
+
 /***/
 
 CCGError ccgSubSurf_initFullSync(CCGSubSurf *ss)
@@ -1430,20 +1452,81 @@ CCGError ccgSubSurf_processSync(CCGSubSurf *ss)
 #define FACE_calcIFNo(f, lvl, S, x, y, no)  _face_calcIFNo(f, lvl, S, x, y, no, subdivLevels, vertDataSize)
 #define FACE_getIENo(f, lvl, S, x)          _face_getIENo(f, lvl, S, x, subdivLevels, vertDataSize, normalDataOffset)
 
-static void ccgSubSurf__calcVertNormals(CCGSubSurf *ss,
-                                        CCGVert **effectedV, CCGEdge **effectedE, CCGFace **effectedF,
-                                        int numEffectedV, int numEffectedE, int numEffectedF)
+/* Threading
+ *
+ * The loops over effected elements run on the task scheduler, so syncs of
+ * several objects from threaded updates share one set of worker threads.
+ * Elements are handed out in batches, so the scheduler lock is taken once per
+ * batch and scratch memory is allocated per batch instead of per element. */
+
+/* amount of work (about the number of points written) to run threaded */
+#define CCG_TASK_LIMIT 1000000
+/* amount of work in a single batch */
+#define CCG_TASK_BATCH_WORK 16384
+
+typedef void (*CCGTaskBatchFunc)(void *userdata, int start, int end);
+
+typedef struct CCGTaskBatches {
+	void *userdata;
+	CCGTaskBatchFunc func;
+	int num, batchSize;
+} CCGTaskBatches;
+
+/* data for the per level loops */
+typedef struct CCGSubSurfCalcData {
+	CCGSubSurf *ss;
+	CCGVert **effectedV;
+	CCGEdge **effectedE;
+	CCGFace **effectedF;
+	int lvl;
+} CCGSubSurfCalcData;
+
+static void ccg_task_batch(void *userdata, int batch)
 {
-	int i, ptrIdx;
+	CCGTaskBatches *batches = userdata;
+	int start = batch * batches->batchSize;
+	int end = min_ii(start + batches->batchSize, batches->num);
+
+	batches->func(batches->userdata, start, end);
+}
+
+/* call func for [0, num) split in batches, workPerItem is used to size the batches */
+static void ccg_task_parallel_batches(int num, int workPerItem, bool use_threading,
+                                      void *userdata, CCGTaskBatchFunc func)
+{
+	CCGTaskBatches batches;
+	int numBatches;
+
+	if (num == 0)
+		return;
+
+	batches.userdata = userdata;
+	batches.func = func;
+	batches.num = num;
+	batches.batchSize = max_ii(1, CCG_TASK_BATCH_WORK / max_ii(1, workPerItem));
+	numBatches = (num + batches.batchSize - 1) / batches.batchSize;
+
+	if (!use_threading || numBatches == 1) {
+		func(userdata, 0, num);
+	}
+	else {
+		BLI_task_parallel_range_ex(0, numBatches, &batches, ccg_task_batch, 1);
+	}
+}
+
+static void ccgSubSurf__calcVertNormals_faces(void *userdata, int start, int end)
+{
+	CCGSubSurfCalcData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	CCGFace **effectedF = data->effectedF;
 	int subdivLevels = ss->subdivLevels;
 	int lvl = ss->subdivLevels;
-	int edgeSize = ccg_edgesize(lvl);
 	int gridSize = ccg_gridsize(lvl);
 	int normalDataOffset = ss->normalDataOffset;
 	int vertDataSize = ss->meshIFC.vertDataSize;
+	int ptrIdx;
 
-#pragma omp parallel for private(ptrIdx) if (numEffectedF * edgeSize * edgeSize * 4 >= CCG_OMP_LIMIT)
-	for (ptrIdx = 0; ptrIdx < numEffectedF; ptrIdx++) {
+	for (ptrIdx = start; ptrIdx < end; ptrIdx++) {
 		CCGFace *f = (CCGFace *) effectedF[ptrIdx];
 		int S, x, y;
 		float no[3];
@@ -1522,6 +1605,63 @@ static void ccgSubSurf__calcVertNormals(CCGSubSurf *ss,
 			}
 		}
 	}
+}
+
+static void ccgSubSurf__calcVertNormals_normalizeFaces(void *userdata, int start, int end)
+{
+	CCGSubSurfCalcData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	CCGFace **effectedF = data->effectedF;
+	int subdivLevels = ss->subdivLevels;
+	int lvl = ss->subdivLevels;
+	int gridSize = ccg_gridsize(lvl);
+	int normalDataOffset = ss->normalDataOffset;
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	int ptrIdx;
+
+	for (ptrIdx = start; ptrIdx < end; ptrIdx++) {
+		CCGFace *f = (CCGFace *) effectedF[ptrIdx];
+		int S, x, y;
+
+		for (S = 0; S < f->numVerts; S++) {
+			NormCopy(FACE_getIFNo(f, lvl, (S + 1) % f->numVerts, 0, gridSize - 1),
+			         FACE_getIFNo(f, lvl, S, gridSize - 1, 0));
+		}
+
+		for (S = 0; S < f->numVerts; S++) {
+			for (y = 0; y < gridSize; y++) {
+				for (x = 0; x < gridSize; x++) {
+					float *no = FACE_getIFNo(f, lvl, S, x, y);
+					Normalize(no);
+				}
+			}
+
+			VertDataCopy((float *)((byte *)FACE_getCenterData(f) + normalDataOffset),
+			             FACE_getIFNo(f, lvl, S, 0, 0), ss);
+
+			for (x = 1; x < gridSize - 1; x++)
+				NormCopy(FACE_getIENo(f, lvl, S, x),
+				         FACE_getIFNo(f, lvl, S, x, 0));
+		}
+	}
+}
+
+static void ccgSubSurf__calcVertNormals(CCGSubSurf *ss,
+                                        CCGVert **effectedV, CCGEdge **effectedE, CCGFace **effectedF,
+                                        int numEffectedV, int numEffectedE, int numEffectedF)
+{
+	int i, ptrIdx;
+	int subdivLevels = ss->subdivLevels;
+	int lvl = ss->subdivLevels;
+	int edgeSize = ccg_edgesize(lvl);
+	int gridSize = ccg_gridsize(lvl);
+	int normalDataOffset = ss->normalDataOffset;
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	CCGSubSurfCalcData data = {ss, effectedV, effectedE, effectedF, lvl};
+
+	ccg_task_parallel_batches(numEffectedF, 4 * edgeSize * edgeSize,
+	                          numEffectedF * edgeSize * edgeSize * 4 >= CCG_TASK_LIMIT,
+	                          &data, ccgSubSurf__calcVertNormals_faces);
 	/* XXX can I reduce the number of normalisations here? */
 	for (ptrIdx = 0; ptrIdx < numEffectedV; ptrIdx++) {
 		CCGVert *v = (CCGVert *) effectedV[ptrIdx];
@@ -1576,32 +1716,9 @@ static void ccgSubSurf__calcVertNormals(CCGSubSurf *ss,
 		}
 	}
 
-#pragma omp parallel for private(ptrIdx) if (numEffectedF * edgeSize * edgeSize * 4 >= CCG_OMP_LIMIT)
-	for (ptrIdx = 0; ptrIdx < numEffectedF; ptrIdx++) {
-		CCGFace *f = (CCGFace *) effectedF[ptrIdx];
-		int S, x, y;
-
-		for (S = 0; S < f->numVerts; S++) {
-			NormCopy(FACE_getIFNo(f, lvl, (S + 1) % f->numVerts, 0, gridSize - 1),
-			         FACE_getIFNo(f, lvl, S, gridSize - 1, 0));
-		}
-
-		for (S = 0; S < f->numVerts; S++) {
-			for (y = 0; y < gridSize; y++) {
-				for (x = 0; x < gridSize; x++) {
-					float *no = FACE_getIFNo(f, lvl, S, x, y);
-					Normalize(no);
-				}
-			}
-
-			VertDataCopy((float *)((byte *)FACE_getCenterData(f) + normalDataOffset),
-			             FACE_getIFNo(f, lvl, S, 0, 0), ss);
-
-			for (x = 1; x < gridSize - 1; x++)
-				NormCopy(FACE_getIENo(f, lvl, S, x),
-				         FACE_getIFNo(f, lvl, S, x, 0));
-		}
-	}
+	ccg_task_parallel_batches(numEffectedF, 4 * edgeSize * edgeSize,
+	                          numEffectedF * edgeSize * edgeSize * 4 >= CCG_TASK_LIMIT,
+	                          &data, ccgSubSurf__calcVertNormals_normalizeFaces);
 
 	for (ptrIdx = 0; ptrIdx < numEffectedE; ptrIdx++) {
 		CCGEdge *e = (CCGEdge *) effectedE[ptrIdx];
@@ -1635,20 +1752,90 @@ static void ccgSubSurf__calcVertNormals(CCGSubSurf *ss,
 #define FACE_getIECo(f, lvl, S, x)      _face_getIECo(f, lvl, S, x, subdivLevels, vertDataSize)
 #define FACE_getIFCo(f, lvl, S, x, y)   _face_getIFCo(f, lvl, S, x, y, subdivLevels, vertDataSize)
 
-static void ccgSubSurf__calcSubdivLevel(CCGSubSurf *ss,
-                                        CCGVert **effectedV, CCGEdge **effectedE, CCGFace **effectedF,
-                                        int numEffectedV, int numEffectedE, int numEffectedF, int curLvl)
+static void ccgSubSurf__copyDownLevel_edges(void *userdata, int start, int end)
+{
+	CCGSubSurfCalcData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	CCGEdge **effectedE = data->effectedE;
+	int lvl = data->lvl;
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	int edgeSize = ccg_edgesize(lvl);
+	int i;
+
+	for (i = start; i < end; i++) {
+		CCGEdge *e = effectedE[i];
+		VertDataCopy(EDGE_getCo(e, lvl, 0), VERT_getCo(e->v0, lvl), ss);
+		VertDataCopy(EDGE_getCo(e, lvl, edgeSize - 1), VERT_getCo(e->v1, lvl), ss);
+	}
+}
+
+static void ccgSubSurf__copyDownLevel_faces(void *userdata, int start, int end)
 {
+	CCGSubSurfCalcData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	CCGFace **effectedF = data->effectedF;
+	int lvl = data->lvl;
 	int subdivLevels = ss->subdivLevels;
-	int edgeSize = ccg_edgesize(curLvl);
-	int gridSize = ccg_gridsize(curLvl);
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	int gridSize = ccg_gridsize(lvl);
+	int cornerIdx = gridSize - 1;
+	int i;
+
+	for (i = start; i < end; i++) {
+		CCGFace *f = effectedF[i];
+		int S, x;
+
+		for (S = 0; S < f->numVerts; S++) {
+			CCGEdge *e = FACE_getEdges(f)[S];
+			CCGEdge *prevE = FACE_getEdges(f)[(S + f->numVerts - 1) % f->numVerts];
+
+			VertDataCopy(FACE_getIFCo(f, lvl, S, 0, 0), (float *)FACE_getCenterData(f), ss);
+			VertDataCopy(FACE_getIECo(f, lvl, S, 0), (float *)FACE_getCenterData(f), ss);
+			VertDataCopy(FACE_getIFCo(f, lvl, S, cornerIdx, cornerIdx), VERT_getCo(FACE_getVerts(f)[S], lvl), ss);
+			VertDataCopy(FACE_getIECo(f, lvl, S, cornerIdx), EDGE_getCo(FACE_getEdges(f)[S], lvl, cornerIdx), ss);
+			for (x = 1; x < gridSize - 1; x++) {
+				float *co = FACE_getIECo(f, lvl, S, x);
+				VertDataCopy(FACE_getIFCo(f, lvl, S, x, 0), co, ss);
+				VertDataCopy(FACE_getIFCo(f, lvl, (S + 1) % f->numVerts, 0, x), co, ss);
+			}
+			for (x = 0; x < gridSize - 1; x++) {
+				int eI = gridSize - 1 - x;
+				VertDataCopy(FACE_getIFCo(f, lvl, S, cornerIdx, x), _edge_getCoVert(e, FACE_getVerts(f)[S], lvl, eI, vertDataSize), ss);
+				VertDataCopy(FACE_getIFCo(f, lvl, S, x, cornerIdx), _edge_getCoVert(prevE, FACE_getVerts(f)[S], lvl, eI, vertDataSize), ss);
+			}
+		}
+	}
+}
+
+/* copy down the points shared between elements at level lvl:
+ * edge end points and the borders of the face grids */
+static void ccgSubSurf__copyDownLevel(CCGSubSurf *ss,
+                                      CCGEdge **effectedE, CCGFace **effectedF,
+                                      int numEffectedE, int numEffectedF, int lvl)
+{
+	int edgeSize = ccg_edgesize(lvl);
+	bool use_threading = (numEffectedF * edgeSize * edgeSize * 4 >= CCG_TASK_LIMIT);
+	CCGSubSurfCalcData data = {ss, NULL, effectedE, effectedF, lvl};
+
+	ccg_task_parallel_batches(numEffectedE, 2, use_threading,
+	                          &data, ccgSubSurf__copyDownLevel_edges);
+	ccg_task_parallel_batches(numEffectedF, 4 * edgeSize, use_threading,
+	                          &data, ccgSubSurf__copyDownLevel_faces);
+}
+
+static void ccgSubSurf__calcSubdivLevel_faceMidpoints(void *userdata, int start, int end)
+{
+	CCGSubSurfCalcData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	CCGFace **effectedF = data->effectedF;
+	int subdivLevels = ss->subdivLevels;
+	int curLvl = data->lvl;
 	int nextLvl = curLvl + 1;
-	int ptrIdx, cornerIdx, i;
+	int gridSize = ccg_gridsize(curLvl);
 	int vertDataSize = ss->meshIFC.vertDataSize;
-	float *q = ss->q, *r = ss->r;
+	int ptrIdx;
 
-#pragma omp parallel for private(ptrIdx) if (numEffectedF * edgeSize * edgeSize * 4 >= CCG_OMP_LIMIT)
-	for (ptrIdx = 0; ptrIdx < numEffectedF; ptrIdx++) {
+	for (ptrIdx = start; ptrIdx < end; ptrIdx++) {
 		CCGFace *f = (CCGFace *) effectedF[ptrIdx];
 		int S, x, y;
 
@@ -1723,6 +1910,134 @@ static void ccgSubSurf__calcSubdivLevel(CCGSubSurf *ss,
 			}
 		}
 	}
+}
+
+static void ccgSubSurf__calcSubdivLevel_faceShift(void *userdata, int start, int end)
+{
+	CCGSubSurfCalcData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	CCGFace **effectedF = data->effectedF;
+	int subdivLevels = ss->subdivLevels;
+	int curLvl = data->lvl;
+	int nextLvl = curLvl + 1;
+	int gridSize = ccg_gridsize(curLvl);
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	int ptrIdx;
+	float *q, *r;
+
+	/* scratch of this batch */
+	q = MEM_mallocN(ss->meshIFC.vertDataSize, "CCGSubsurf q");
+	r = MEM_mallocN(ss->meshIFC.vertDataSize, "CCGSubsurf r");
+
+	for (ptrIdx = start; ptrIdx < end; ptrIdx++) {
+		CCGFace *f = (CCGFace *) effectedF[ptrIdx];
+		int S, x, y;
+
+		/* interior center point shift
+		 * - old face center point (shifting)
+		 * - old interior edge points
+		 * - new interior face midpoints
+		 */
+		VertDataZero(q, ss);
+		for (S = 0; S < f->numVerts; S++) {
+			VertDataAdd(q, FACE_getIFCo(f, nextLvl, S, 1, 1), ss);
+		}
+		VertDataMulN(q, 1.0f / f->numVerts, ss);
+		VertDataZero(r, ss);
+		for (S = 0; S < f->numVerts; S++) {
+			VertDataAdd(r, FACE_getIECo(f, curLvl, S, 1), ss);
+		}
+		VertDataMulN(r, 1.0f / f->numVerts, ss);
+
+		VertDataMulN((float *)FACE_getCenterData(f), f->numVerts - 2.0f, ss);
+		VertDataAdd((float *)FACE_getCenterData(f), q, ss);
+		VertDataAdd((float *)FACE_getCenterData(f), r, ss);
+		VertDataMulN((float *)FACE_getCenterData(f), 1.0f / f->numVerts, ss);
+
+		for (S = 0; S < f->numVerts; S++) {
+			/* interior face shift
+			 * - old interior face point (shifting)
+			 * - new interior edge midpoints
+			 * - new interior face midpoints
+			 */
+			for (x = 1; x < gridSize - 1; x++) {
+				for (y = 1; y < gridSize - 1; y++) {
+					int fx = x * 2;
+					int fy = y * 2;
+					const float *co = FACE_getIFCo(f, curLvl, S, x, y);
+					float *nCo = FACE_getIFCo(f, nextLvl, S, fx, fy);
+					
+					VertDataAvg4(q,
+					             FACE_getIFCo(f, nextLvl, S, fx - 1, fy - 1),
+					             FACE_getIFCo(f, nextLvl, S, fx + 1, fy - 1),
+					             FACE_getIFCo(f, nextLvl, S, fx + 1, fy + 1),
+					             FACE_getIFCo(f, nextLvl, S, fx - 1, fy + 1),
+					             ss);
+
+					VertDataAvg4(r,
+					             FACE_getIFCo(f, nextLvl, S, fx - 1, fy + 0),
+					             FACE_getIFCo(f, nextLvl, S, fx + 1, fy + 0),
+					             FACE_getIFCo(f, nextLvl, S, fx + 0, fy - 1),
+					             FACE_getIFCo(f, nextLvl, S, fx + 0, fy + 1),
+					             ss);
+
+					VertDataCopy(nCo, co, ss);
+					VertDataSub(nCo, q, ss);
+					VertDataMulN(nCo, 0.25f, ss);
+					VertDataAdd(nCo, r, ss);
+				}
+			}
+
+			/* interior edge interior shift
+			 * - old interior edge point (shifting)
+			 * - new interior edge midpoints
+			 * - new interior face midpoints
+			 */
+			for (x = 1; x < gridSize - 1; x++) {
+				int fx = x * 2;
+				const float *co = FACE_getIECo(f, curLvl, S, x);
+				float *nCo = FACE_getIECo(f, nextLvl, S, fx);
+				
+				VertDataAvg4(q,
+				             FACE_getIFCo(f, nextLvl, (S + 1) % f->numVerts, 1, fx - 1),
+				             FACE_getIFCo(f, nextLvl, (S + 1) % f->numVerts, 1, fx + 1),
+				             FACE_getIFCo(f, nextLvl, S, fx + 1, +1),
+				             FACE_getIFCo(f, nextLvl, S, fx - 1, +1), ss);
+
+				VertDataAvg4(r,
+				             FACE_getIECo(f, nextLvl, S, fx - 1),
+				             FACE_getIECo(f, nextLvl, S, fx + 1),
+				             FACE_getIFCo(f, nextLvl, (S + 1) % f->numVerts, 1, fx),
+				             FACE_getIFCo(f, nextLvl, S, fx, 1),
+				             ss);
+
+				VertDataCopy(nCo, co, ss);
+				VertDataSub(nCo, q, ss);
+				VertDataMulN(nCo, 0.25f, ss);
+				VertDataAdd(nCo, r, ss);
+			}
+		}
+	}
+
+	MEM_freeN(q);
+	MEM_freeN(r);
+}
+
+static void ccgSubSurf__calcSubdivLevel(CCGSubSurf *ss,
+                                        CCGVert **effectedV, CCGEdge **effectedE, CCGFace **effectedF,
+                                        int numEffectedV, int numEffectedE, int numEffectedF, int curLvl)
+{
+	int subdivLevels = ss->subdivLevels;
+	int edgeSize = ccg_edgesize(curLvl);
+	int nextLvl = curLvl + 1;
+	int ptrIdx;
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	float *q = ss->q, *r = ss->r;
+	bool use_threading = (numEffectedF * edgeSize * edgeSize * 4 >= CCG_TASK_LIMIT);
+	CCGSubSurfCalcData data = {ss, effectedV, effectedE, effectedF, curLvl};
+
+	ccg_task_parallel_batches(numEffectedF, 4 * edgeSize * edgeSize, use_threading,
+	                          &data, ccgSubSurf__calcSubdivLevel_faceMidpoints);
 
 	/* exterior edge midpoints
 	 * - old exterior edge points
@@ -1994,208 +2309,34 @@ static void ccgSubSurf__calcSubdivLevel(CCGSubSurf *ss,
 		}
 	}
 
-#pragma omp parallel private(ptrIdx) if (numEffectedF * edgeSize * edgeSize * 4 >= CCG_OMP_LIMIT)
-	{
-		float *q, *r;
+	ccg_task_parallel_batches(numEffectedF, 4 * edgeSize * edgeSize, use_threading,
+	                          &data, ccgSubSurf__calcSubdivLevel_faceShift);
 
-#pragma omp critical
-		{
-			q = MEM_mallocN(ss->meshIFC.vertDataSize, "CCGSubsurf q");
-			r = MEM_mallocN(ss->meshIFC.vertDataSize, "CCGSubsurf r");
-		}
-
-#pragma omp for schedule(static)
-		for (ptrIdx = 0; ptrIdx < numEffectedF; ptrIdx++) {
-			CCGFace *f = (CCGFace *) effectedF[ptrIdx];
-			int S, x, y;
+	ccgSubSurf__copyDownLevel(ss, effectedE, effectedF, numEffectedE, numEffectedF, nextLvl);
+}
 
-			/* interior center point shift
-			 * - old face center point (shifting)
-			 * - old interior edge points
-			 * - new interior face midpoints
-			 */
-			VertDataZero(q, ss);
-			for (S = 0; S < f->numVerts; S++) {
-				VertDataAdd(q, FACE_getIFCo(f, nextLvl, S, 1, 1), ss);
-			}
-			VertDataMulN(q, 1.0f / f->numVerts, ss);
-			VertDataZero(r, ss);
-			for (S = 0; S < f->numVerts; S++) {
-				VertDataAdd(r, FACE_getIECo(f, curLvl, S, 1), ss);
-			}
-			VertDataMulN(r, 1.0f / f->numVerts, ss);
-
-			VertDataMulN((float *)FACE_getCenterData(f), f->numVerts - 2.0f, ss);
-			VertDataAdd((float *)FACE_getCenterData(f), q, ss);
-			VertDataAdd((float *)FACE_getCenterData(f), r, ss);
-			VertDataMulN((float *)FACE_getCenterData(f), 1.0f / f->numVerts, ss);
-
-			for (S = 0; S < f->numVerts; S++) {
-				/* interior face shift
-				 * - old interior face point (shifting)
-				 * - new interior edge midpoints
-				 * - new interior face midpoints
-				 */
-				for (x = 1; x < gridSize - 1; x++) {
-					for (y = 1; y < gridSize - 1; y++) {
-						int fx = x * 2;
-						int fy = y * 2;
-						const float *co = FACE_getIFCo(f, curLvl, S, x, y);
-						float *nCo = FACE_getIFCo(f, nextLvl, S, fx, fy);
-						
-						VertDataAvg4(q,
-						             FACE_getIFCo(f, nextLvl, S, fx - 1, fy - 1),
-						             FACE_getIFCo(f, nextLvl, S, fx + 1, fy - 1),
-						             FACE_getIFCo(f, nextLvl, S, fx + 1, fy + 1),
-						             FACE_getIFCo(f, nextLvl, S, fx - 1, fy + 1),
-						             ss);
-
-						VertDataAvg4(r,
-						             FACE_getIFCo(f, nextLvl, S, fx - 1, fy + 0),
-						             FACE_getIFCo(f, nextLvl, S, fx + 1, fy + 0),
-						             FACE_getIFCo(f, nextLvl, S, fx + 0, fy - 1),
-						             FACE_getIFCo(f, nextLvl, S, fx + 0, fy + 1),
-						             ss);
-
-						VertDataCopy(nCo, co, ss);
-						VertDataSub(nCo, q, ss);
-						VertDataMulN(nCo, 0.25f, ss);
-						VertDataAdd(nCo, r, ss);
-					}
-				}
 
-				/* interior edge interior shift
-				 * - old interior edge point (shifting)
-				 * - new interior edge midpoints
-				 * - new interior face midpoints
-				 */
-				for (x = 1; x < gridSize - 1; x++) {
-					int fx = x * 2;
-					const float *co = FACE_getIECo(f, curLvl, S, x);
-					float *nCo = FACE_getIECo(f, nextLvl, S, fx);
-					
-					VertDataAvg4(q,
-					             FACE_getIFCo(f, nextLvl, (S + 1) % f->numVerts, 1, fx - 1),
-					             FACE_getIFCo(f, nextLvl, (S + 1) % f->numVerts, 1, fx + 1),
-					             FACE_getIFCo(f, nextLvl, S, fx + 1, +1),
-					             FACE_getIFCo(f, nextLvl, S, fx - 1, +1), ss);
+static void ccgSubSurf__subdivide(CCGSubSurf *ss,
+                                  CCGVert **effectedV, CCGEdge **effectedE, CCGFace **effectedF,
+                                  int numEffectedV, int numEffectedE, int numEffectedF)
+{
+	int subdivLevels = ss->subdivLevels;
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	int i, ptrIdx;
+	int curLvl, nextLvl;
+	void *q = ss->q, *r = ss->r;
 
-					VertDataAvg4(r,
-					             FACE_getIECo(f, nextLvl, S, fx - 1),
-					             FACE_getIECo(f, nextLvl, S, fx + 1),
-					             FACE_getIFCo(f, nextLvl, (S + 1) % f->numVerts, 1, fx),
-					             FACE_getIFCo(f, nextLvl, S, fx, 1),
-					             ss);
+	curLvl = 0;
+	nextLvl = curLvl + 1;
 
-					VertDataCopy(nCo, co, ss);
-					VertDataSub(nCo, q, ss);
-					VertDataMulN(nCo, 0.25f, ss);
-					VertDataAdd(nCo, r, ss);
-				}
-			}
-		}
-
-#pragma omp critical
-		{
-			MEM_freeN(q);
-			MEM_freeN(r);
-		}
-	}
-
-	/* copy down */
-	edgeSize = ccg_edgesize(nextLvl);
-	gridSize = ccg_gridsize(nextLvl);
-	cornerIdx = gridSize - 1;
-
-#pragma omp parallel for private(i) if (numEffectedF * edgeSize * edgeSize * 4 >= CCG_OMP_LIMIT)
-	for (i = 0; i < numEffectedE; i++) {
-		CCGEdge *e = effectedE[i];
-		VertDataCopy(EDGE_getCo(e, nextLvl, 0), VERT_getCo(e->v0, nextLvl), ss);
-		VertDataCopy(EDGE_getCo(e, nextLvl, edgeSize - 1), VERT_getCo(e->v1, nextLvl), ss);
-	}
-
-#pragma omp parallel for private(i) if (numEffectedF * edgeSize * edgeSize * 4 >= CCG_OMP_LIMIT)
-	for (i = 0; i < numEffectedF; i++) {
-		CCGFace *f = effectedF[i];
-		int S, x;
-
-		for (S = 0; S < f->numVerts; S++) {
-			CCGEdge *e = FACE_getEdges(f)[S];
-			CCGEdge *prevE = FACE_getEdges(f)[(S + f->numVerts - 1) % f->numVerts];
-
-			VertDataCopy(FACE_getIFCo(f, nextLvl, S, 0, 0), (float *)FACE_getCenterData(f), ss);
-			VertDataCopy(FACE_getIECo(f, nextLvl, S, 0), (float *)FACE_getCenterData(f), ss);
-			VertDataCopy(FACE_getIFCo(f, nextLvl, S, cornerIdx, cornerIdx), VERT_getCo(FACE_getVerts(f)[S], nextLvl), ss);
-			VertDataCopy(FACE_getIECo(f, nextLvl, S, cornerIdx), EDGE_getCo(FACE_getEdges(f)[S], nextLvl, cornerIdx), ss);
-			for (x = 1; x < gridSize - 1; x++) {
-				float *co = FACE_getIECo(f, nextLvl, S, x);
-				VertDataCopy(FACE_getIFCo(f, nextLvl, S, x, 0), co, ss);
-				VertDataCopy(FACE_getIFCo(f, nextLvl, (S + 1) % f->numVerts, 0, x), co, ss);
-			}
-			for (x = 0; x < gridSize - 1; x++) {
-				int eI = gridSize - 1 - x;
-				VertDataCopy(FACE_getIFCo(f, nextLvl, S, cornerIdx, x), _edge_getCoVert(e, FACE_getVerts(f)[S], nextLvl, eI, vertDataSize), ss);
-				VertDataCopy(FACE_getIFCo(f, nextLvl, S, x, cornerIdx), _edge_getCoVert(prevE, FACE_getVerts(f)[S], nextLvl, eI, vertDataSize), ss);
-			}
-		}
-	}
-}
-
-
-static void ccgSubSurf__sync(CCGSubSurf *ss)
-{
-	CCGVert **effectedV;
-	CCGEdge **effectedE;
-	CCGFace **effectedF;
-	int numEffectedV, numEffectedE, numEffectedF;
-	int subdivLevels = ss->subdivLevels;
-	int vertDataSize = ss->meshIFC.vertDataSize;
-	int i, j, ptrIdx, S;
-	int curLvl, nextLvl;
-	void *q = ss->q, *r = ss->r;
-
-	effectedV = MEM_mallocN(sizeof(*effectedV) * ss->vMap->numEntries, "CCGSubsurf effectedV");
-	effectedE = MEM_mallocN(sizeof(*effectedE) * ss->eMap->numEntries, "CCGSubsurf effectedE");
-	effectedF = MEM_mallocN(sizeof(*effectedF) * ss->fMap->numEntries, "CCGSubsurf effectedF");
-	numEffectedV = numEffectedE = numEffectedF = 0;
-	for (i = 0; i < ss->vMap->curSize; i++) {
-		CCGVert *v = (CCGVert *) ss->vMap->buckets[i];
-		for (; v; v = v->next) {
-			if (v->flags & Vert_eEffected) {
-				effectedV[numEffectedV++] = v;
-
-				for (j = 0; j < v->numEdges; j++) {
-					CCGEdge *e = v->edges[j];
-					if (!(e->flags & Edge_eEffected)) {
-						effectedE[numEffectedE++] = e;
-						e->flags |= Edge_eEffected;
-					}
-				}
-
-				for (j = 0; j < v->numFaces; j++) {
-					CCGFace *f = v->faces[j];
-					if (!(f->flags & Face_eEffected)) {
-						effectedF[numEffectedF++] = f;
-						f->flags |= Face_eEffected;
-					}
-				}
-			}
-		}
-	}
-
-	curLvl = 0;
-	nextLvl = curLvl + 1;
-
-	for (ptrIdx = 0; ptrIdx < numEffectedF; ptrIdx++) {
-		CCGFace *f = effectedF[ptrIdx];
-		void *co = FACE_getCenterData(f);
-		VertDataZero(co, ss);
-		for (i = 0; i < f->numVerts; i++) {
-			VertDataAdd(co, VERT_getCo(FACE_getVerts(f)[i], curLvl), ss);
+	for (ptrIdx = 0; ptrIdx < numEffectedF; ptrIdx++) {
+		CCGFace *f = effectedF[ptrIdx];
+		void *co = FACE_getCenterData(f);
+		VertDataZero(co, ss);
+		for (i = 0; i < f->numVerts; i++) {
+			VertDataAdd(co, VERT_getCo(FACE_getVerts(f)[i], curLvl), ss);
 		}
 		VertDataMulN(co, 1.0f / f->numVerts, ss);
-
-		f->flags = 0;
 	}
 	for (ptrIdx = 0; ptrIdx < numEffectedE; ptrIdx++) {
 		CCGEdge *e = effectedE[ptrIdx];
@@ -2358,6 +2499,689 @@ static void ccgSubSurf__sync(CCGSubSurf *ss)
 		/* vert flags cleared later */
 	}
 
+	ccgSubSurf__copyDownLevel(ss, effectedE, effectedF, numEffectedE, numEffectedF, nextLvl);
+
+	for (curLvl = 1; curLvl < subdivLevels; curLvl++) {
+		ccgSubSurf__calcSubdivLevel(ss,
+		                            effectedV, effectedE, effectedF,
+		                            numEffectedV, numEffectedE, numEffectedF, curLvl);
+	}
+}
+
+/* Stencils
+ *
+ * As long as the topology does not change, every subdivided point is a fixed
+ * linear combination of the level 0 vertex data around it. For meshes that
+ * are deformed every frame (armatures, shape keys, ...) the weights of these
+ * combinations are found once by probing the regular subdivision, after that
+ * a sync only evaluates a sparse matrix-vector product straight into the top
+ * level.
+ *
+ * Only the top level is written by the stencils, lower levels keep stale data.
+ * The derived mesh only reads the top level, multires which needs the lower
+ * levels never enables stencils.
+ */
+
+/* Tables which need more weights than this are not built, the regular
+ * subdivision is used for them. Points of regular quad meshes depend on up to
+ * 16 level 0 verts, so this is 64 MB for about a million subdivided points. */
+#define CCG_STENCIL_MAX_WEIGHTS (1 << 24)
+
+typedef enum {
+	eStencilState_Pending = 0,
+	eStencilState_Built,
+	eStencilState_Failed
+} StencilState;
+
+struct CCGStencilTable {
+	uint64_t topologyHash, dataHash;
+	StencilState state;
+
+	int numElements;
+	int maxSupport, maxPoints;
+
+	/* per element (verts, then edges, then faces) range in support,
+	 * which holds indices of the level 0 verts the element depends on */
+	int *supportStart;
+	int *support;
+	/* per element offset in weights, one row of support weights per point */
+	size_t *weightStart;
+	float *weights;
+};
+
+/* all elements of the mesh, in the order of the sync */
+typedef struct StencilElements {
+	CCGVert **verts;
+	CCGEdge **edges;
+	CCGFace **faces;
+	int numVerts, numEdges, numFaces;
+} StencilElements;
+
+static void ccgStencil_freeArrays(CCGStencilTable *table)
+{
+	MEM_SAFE_FREE(table->supportStart);
+	MEM_SAFE_FREE(table->support);
+	MEM_SAFE_FREE(table->weightStart);
+	MEM_SAFE_FREE(table->weights);
+}
+
+void ccgSubSurf_freeStencils(CCGStencilTable *stencils)
+{
+	if (stencils) {
+		ccgStencil_freeArrays(stencils);
+		MEM_freeN(stencils);
+	}
+}
+
+CCGStencilTable *ccgSubSurf_takeStencils(CCGSubSurf *ss)
+{
+	CCGStencilTable *stencils = ss->stencils;
+	ss->stencils = NULL;
+	return stencils;
+}
+
+void ccgSubSurf_setStencils(CCGSubSurf *ss, CCGStencilTable *stencils)
+{
+	if (ss->stencils != stencils) {
+		ccgSubSurf_freeStencils(ss->stencils);
+		ss->stencils = stencils;
+	}
+}
+
+static uint64_t ccgStencil_hashCombine(uint64_t hash, uint64_t value)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+
+	value *= m;
+	value ^= value >> 47;
+	value *= m;
+
+	hash ^= value;
+	hash *= m;
+	return hash;
+}
+
+static uint64_t ccgStencil_hashFloat(uint64_t hash, float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return ccgStencil_hashCombine(hash, bits);
+}
+
+static uint64_t ccgStencil_topologyHash(CCGSubSurf *ss, const StencilElements *elems)
+{
+	uint64_t hash = 0;
+	int i, j;
+
+	hash = ccgStencil_hashCombine(hash, ss->subdivLevels);
+	hash = ccgStencil_hashCombine(hash, ss->meshIFC.simpleSubdiv);
+	hash = ccgStencil_hashCombine(hash, ss->meshIFC.numLayers);
+	hash = ccgStencil_hashCombine(hash, ss->meshIFC.vertDataSize);
+
+	for (i = 0; i < elems->numVerts; i++) {
+		CCGVert *v = elems->verts[i];
+		hash = ccgStencil_hashCombine(hash, (uint64_t)(intptr_t)v->vHDL);
+		hash = ccgStencil_hashCombine(hash, VERT_seam(v));
+		hash = ccgStencil_hashCombine(hash, v->numEdges);
+		hash = ccgStencil_hashCombine(hash, v->numFaces);
+	}
+	for (i = 0; i < elems->numEdges; i++) {
+		CCGEdge *e = elems->edges[i];
+		hash = ccgStencil_hashCombine(hash, (uint64_t)(intptr_t)e->eHDL);
+		hash = ccgStencil_hashCombine(hash, (uint64_t)(intptr_t)e->v0->vHDL);
+		hash = ccgStencil_hashCombine(hash, (uint64_t)(intptr_t)e->v1->vHDL);
+		hash = ccgStencil_hashFloat(hash, e->crease);
+		hash = ccgStencil_hashCombine(hash, e->numFaces);
+	}
+	for (i = 0; i < elems->numFaces; i++) {
+		CCGFace *f = elems->faces[i];
+		hash = ccgStencil_hashCombine(hash, (uint64_t)(intptr_t)f->fHDL);
+		hash = ccgStencil_hashCombine(hash, f->numVerts);
+		for (j = 0; j < f->numVerts; j++)
+			hash = ccgStencil_hashCombine(hash, (uint64_t)(intptr_t)FACE_getVerts(f)[j]->vHDL);
+	}
+
+	return hash;
+}
+
+static uint64_t ccgStencil_dataHash(CCGSubSurf *ss, const StencilElements *elems)
+{
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	uint64_t hash = 0;
+	int i, j;
+
+	for (i = 0; i < elems->numVerts; i++) {
+		const float *co = VERT_getCo(elems->verts[i], 0);
+		for (j = 0; j < ss->meshIFC.numLayers; j++)
+			hash = ccgStencil_hashFloat(hash, co[j]);
+	}
+
+	return hash;
+}
+
+/* top level points owned by an element, the points shared with
+ * neighbors are filled in by ccgSubSurf__copyDownLevel */
+static int ccgStencil_elementPoints(CCGSubSurf *ss, const StencilElements *elems, int index, float **points)
+{
+	int subdivLevels = ss->subdivLevels;
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	int numPoints = 0;
+
+	if (index < elems->numVerts) {
+		points[numPoints++] = VERT_getCo(elems->verts[index], subdivLevels);
+	}
+	else if (index < elems->numVerts + elems->numEdges) {
+		CCGEdge *e = elems->edges[index - elems->numVerts];
+		int edgeSize = ccg_edgesize(subdivLevels);
+		int x;
+
+		for (x = 1; x < edgeSize - 1; x++)
+			points[numPoints++] = EDGE_getCo(e, subdivLevels, x);
+	}
+	else {
+		CCGFace *f = elems->faces[index - elems->numVerts - elems->numEdges];
+		int gridSize = ccg_gridsize(subdivLevels);
+		int S, x, y;
+
+		points[numPoints++] = (float *)FACE_getCenterData(f);
+		for (S = 0; S < f->numVerts; S++) {
+			for (x = 1; x < gridSize - 1; x++)
+				points[numPoints++] = FACE_getIECo(f, subdivLevels, S, x);
+			for (y = 1; y < gridSize - 1; y++)
+				for (x = 1; x < gridSize - 1; x++)
+					points[numPoints++] = FACE_getIFCo(f, subdivLevels, S, x, y);
+		}
+	}
+
+	return numPoints;
+}
+
+/* add the verts sharing an edge or a face with v (and v itself) to ring,
+ * stamp is used to skip duplicates */
+static int ccgStencil_addRing(GHash *vertIndex, CCGVert *v, int *ring, int len, int *stamp, int tag)
+{
+	int i, j;
+
+#define ADD_VERT(_v) \
+	{ \
+		int _index = GET_INT_FROM_POINTER(BLI_ghash_lookup(vertIndex, _v)); \
+		if (stamp[_index] != tag) { \
+			stamp[_index] = tag; \
+			ring[len++] = _index; \
+		} \
+	} (void)0
+
+	ADD_VERT(v);
+	for (i = 0; i < v->numEdges; i++) {
+		ADD_VERT(_edge_getOtherVert(v->edges[i], v));
+	}
+	for (i = 0; i < v->numFaces; i++) {
+		CCGFace *f = v->faces[i];
+		for (j = 0; j < f->numVerts; j++) {
+			ADD_VERT(FACE_getVerts(f)[j]);
+		}
+	}
+
+#undef ADD_VERT
+
+	return len;
+}
+
+/* Find which level 0 verts every element depends on: the ring of a vert,
+ * the rings of both verts of an edge and the rings of all corners of a face.
+ * Verts are colored so that no support contains two verts of the same
+ * color, which lets the probing find the weights of numLayers colors per
+ * subdivision. Returns the number of colors. */
+static int ccgStencil_buildSupport(CCGStencilTable *table, const StencilElements *elems, int *colors)
+{
+	int numVerts = elems->numVerts;
+	int numElements = table->numElements;
+	GHash *vertIndex;
+	int *ringStart, *ring, *stamp, *queue, *colorStamp;
+	int i, j, k, index, len, maxLen, numColors = 0;
+
+	vertIndex = BLI_ghash_ptr_new_ex("CCGStencil vertIndex", numVerts);
+	for (i = 0; i < numVerts; i++)
+		BLI_ghash_insert(vertIndex, elems->verts[i], SET_INT_IN_POINTER(i));
+
+	stamp = MEM_mallocN(sizeof(*stamp) * numVerts, "CCGStencil stamp");
+	for (i = 0; i < numVerts; i++)
+		stamp[i] = -1;
+
+	/* one ring per vert */
+	maxLen = 0;
+	for (i = 0; i < numVerts; i++) {
+		CCGVert *v = elems->verts[i];
+		maxLen += 1 + v->numEdges;
+		for (j = 0; j < v->numFaces; j++)
+			maxLen += v->faces[j]->numVerts;
+	}
+
+	ringStart = MEM_mallocN(sizeof(*ringStart) * (numVerts + 1), "CCGStencil ringStart");
+	ring = MEM_mallocN(sizeof(*ring) * maxLen, "CCGStencil ring");
+	len = 0;
+	for (i = 0; i < numVerts; i++) {
+		ringStart[i] = len;
+		len = ccgStencil_addRing(vertIndex, elems->verts[i], ring, len, stamp, i);
+	}
+	ringStart[numVerts] = len;
+
+	/* greedy coloring, verts within three ring steps can end up in the same support */
+	queue = MEM_mallocN(sizeof(*queue) * numVerts, "CCGStencil queue");
+	colorStamp = MEM_mallocN(sizeof(*colorStamp) * numVerts, "CCGStencil colorStamp");
+	for (i = 0; i < numVerts; i++) {
+		stamp[i] = -1;
+		colors[i] = -1;
+		colorStamp[i] = -1;
+	}
+
+	for (i = 0; i < numVerts; i++) {
+		int head = 0, tail = 0, step, color;
+
+		stamp[i] = i;
+		queue[tail++] = i;
+		for (step = 0; step < 3; step++) {
+			int stepEnd = tail;
+			for (; head < stepEnd; head++) {
+				int cur = queue[head];
+				for (k = ringStart[cur]; k < ringStart[cur + 1]; k++) {
+					int other = ring[k];
+					if (stamp[other] != i) {
+						stamp[other] = i;
+						queue[tail++] = other;
+						if (colors[other] != -1)
+							colorStamp[colors[other]] = i;
+					}
+				}
+			}
+		}
+
+		for (color = 0; colorStamp[color] == i; color++) {
+			/* pass */
+		}
+		colors[i] = color;
+		numColors = max_ii(numColors, color + 1);
+	}
+
+	MEM_freeN(queue);
+	MEM_freeN(colorStamp);
+
+	/* supports of all elements */
+	maxLen = 0;
+	for (index = 0; index < numElements; index++) {
+		if (index < numVerts) {
+			maxLen += ringStart[index + 1] - ringStart[index];
+		}
+		else {
+			CCGVert **verts;
+			int numCorners;
+			CCGVert *edgeVerts[2];
+
+			if (index < numVerts + elems->numEdges) {
+				CCGEdge *e = elems->edges[index - numVerts];
+				edgeVerts[0] = e->v0;
+				edgeVerts[1] = e->v1;
+				verts = edgeVerts;
+				numCorners = 2;
+			}
+			else {
+				CCGFace *f = elems->faces[index - numVerts - elems->numEdges];
+				verts = FACE_getVerts(f);
+				numCorners = f->numVerts;
+			}
+
+			/* upper bound, corner rings overlap */
+			for (j = 0; j < numCorners; j++) {
+				CCGVert *v = verts[j];
+				maxLen += 1 + v->numEdges;
+				for (k = 0; k < v->numFaces; k++)
+					maxLen += v->faces[k]->numVerts;
+			}
+		}
+	}
+
+	for (i = 0; i < numVerts; i++)
+		stamp[i] = -1;
+
+	table->supportStart = MEM_mallocN(sizeof(*table->supportStart) * (numElements + 1), "CCGStencil supportStart");
+	table->support = MEM_mallocN(sizeof(*table->support) * maxLen, "CCGStencil support");
+	table->maxSupport = 0;
+	len = 0;
+	for (index = 0; index < numElements; index++) {
+		table->supportStart[index] = len;
+
+		if (index < numVerts) {
+			for (k = ringStart[index]; k < ringStart[index + 1]; k++)
+				table->support[len++] = ring[k];
+		}
+		else if (index < numVerts + elems->numEdges) {
+			CCGEdge *e = elems->edges[index - numVerts];
+			len = ccgStencil_addRing(vertIndex, e->v0, table->support, len, stamp, index);
+			len = ccgStencil_addRing(vertIndex, e->v1, table->support, len, stamp, index);
+		}
+		else {
+			CCGFace *f = elems->faces[index - numVerts - elems->numEdges];
+			for (j = 0; j < f->numVerts; j++)
+				len = ccgStencil_addRing(vertIndex, FACE_getVerts(f)[j], table->support, len, stamp, index);
+		}
+
+		table->maxSupport = max_ii(table->maxSupport, len - table->supportStart[index]);
+	}
+	table->supportStart[numElements] = len;
+
+	BLI_ghash_free(vertIndex, NULL, NULL);
+	MEM_freeN(ringStart);
+	MEM_freeN(ring);
+	MEM_freeN(stamp);
+
+	return numColors;
+}
+
+typedef struct StencilTaskData {
+	CCGSubSurf *ss;
+	const CCGStencilTable *table;
+	const StencilElements *elems;
+
+	/* building */
+	const int *colors;
+	int pass;
+
+	/* evaluation */
+	int verify;
+	uint32_t numFailed;
+} StencilTaskData;
+
+/* copy the results of one probing pass to the weights */
+static void ccgStencil_extractWeights(void *userdata, int start, int end)
+{
+	StencilTaskData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	const CCGStencilTable *table = data->table;
+	int numLayers = ss->meshIFC.numLayers;
+	int firstColor = data->pass * numLayers;
+	float **points;
+	int index;
+
+	/* scratch of this batch */
+	points = MEM_mallocN(sizeof(*points) * table->maxPoints, "CCGStencil points");
+
+	for (index = start; index < end; index++) {
+		const int *support = &table->support[table->supportStart[index]];
+		int len = table->supportStart[index + 1] - table->supportStart[index];
+		float *weights = &table->weights[table->weightStart[index]];
+		int numPoints = ccgStencil_elementPoints(ss, data->elems, index, points);
+		int j, p;
+
+		for (j = 0; j < len; j++) {
+			int color = data->colors[support[j]];
+
+			if (color / numLayers == data->pass) {
+				for (p = 0; p < numPoints; p++)
+					weights[p * len + j] = points[p][color - firstColor];
+			}
+		}
+	}
+
+	MEM_freeN(points);
+}
+
+/* Fill in the weights by subdividing indicator data: in every pass each layer
+ * is one for the verts of one color and zero elsewhere. Returns zero when the
+ * table would be too large, the control data is left untouched then. */
+static int ccgStencil_build(CCGSubSurf *ss, CCGStencilTable *table, const StencilElements *elems)
+{
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	int numLayers = ss->meshIFC.numLayers;
+	int numVerts = elems->numVerts;
+	int numElements = table->numElements;
+	StencilTaskData data = {ss, table, elems};
+	int *colors;
+	float *control;
+	size_t numWeights;
+	int i, index, pass, numColors, numPasses;
+
+	colors = MEM_mallocN(sizeof(*colors) * numVerts, "CCGStencil colors");
+	numColors = ccgStencil_buildSupport(table, elems, colors);
+
+	table->weightStart = MEM_mallocN(sizeof(*table->weightStart) * (numElements + 1), "CCGStencil weightStart");
+	table->maxPoints = 0;
+	numWeights = 0;
+	for (index = 0; index < numElements; index++) {
+		int numPoints;
+
+		if (index < numVerts) {
+			numPoints = 1;
+		}
+		else if (index < numVerts + elems->numEdges) {
+			numPoints = ccg_edgesize(ss->subdivLevels) - 2;
+		}
+		else {
+			CCGFace *f = elems->faces[index - numVerts - elems->numEdges];
+			int inner = ccg_gridsize(ss->subdivLevels) - 2;
+			numPoints = 1 + f->numVerts * (inner + inner * inner);
+		}
+
+		table->maxPoints = max_ii(table->maxPoints, numPoints);
+		table->weightStart[index] = numWeights;
+		numWeights += (size_t)numPoints * (table->supportStart[index + 1] - table->supportStart[index]);
+	}
+	table->weightStart[numElements] = numWeights;
+
+	if (numWeights > CCG_STENCIL_MAX_WEIGHTS) {
+		MEM_freeN(colors);
+		return 0;
+	}
+
+	table->weights = MEM_callocN(sizeof(*table->weights) * numWeights, "CCGStencil weights");
+
+	control = MEM_mallocN(sizeof(*control) * numLayers * numVerts, "CCGStencil control");
+	for (i = 0; i < numVerts; i++)
+		memcpy(&control[i * numLayers], VERT_getCo(elems->verts[i], 0), sizeof(float) * numLayers);
+
+	data.colors = colors;
+	numPasses = (numColors + numLayers - 1) / numLayers;
+	for (pass = 0; pass < numPasses; pass++) {
+		int firstColor = pass * numLayers;
+
+		for (i = 0; i < numVerts; i++) {
+			float *co = VERT_getCo(elems->verts[i], 0);
+			int c;
+
+			for (c = 0; c < numLayers; c++)
+				co[c] = (colors[i] == firstColor + c) ? 1.0f : 0.0f;
+		}
+
+		ccgSubSurf__subdivide(ss,
+		                      elems->verts, elems->edges, elems->faces,
+		                      elems->numVerts, elems->numEdges, elems->numFaces);
+
+		data.pass = pass;
+		ccg_task_parallel_batches(numElements, (int)(numWeights / numElements) + 1,
+		                          numWeights >= CCG_TASK_LIMIT,
+		                          &data, ccgStencil_extractWeights);
+	}
+
+	for (i = 0; i < numVerts; i++)
+		memcpy(VERT_getCo(elems->verts[i], 0), &control[i * numLayers], sizeof(float) * numLayers);
+
+	MEM_freeN(control);
+	MEM_freeN(colors);
+
+	return 1;
+}
+
+static void ccgStencil_evaluateElements(void *userdata, int start, int end)
+{
+	StencilTaskData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	const CCGStencilTable *table = data->table;
+	const StencilElements *elems = data->elems;
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	int numLayers = ss->meshIFC.numLayers;
+	unsigned int numFailed = 0;
+	float **points, *gather;
+	int index;
+
+	/* scratch of this batch */
+	points = MEM_mallocN(sizeof(*points) * table->maxPoints, "CCGStencil points");
+	gather = MEM_mallocN(sizeof(*gather) * numLayers * table->maxSupport, "CCGStencil gather");
+
+	for (index = start; index < end; index++) {
+		const int *support = &table->support[table->supportStart[index]];
+		int len = table->supportStart[index + 1] - table->supportStart[index];
+		const float *weights = &table->weights[table->weightStart[index]];
+		int numPoints = ccgStencil_elementPoints(ss, elems, index, points);
+		float tolerance = 0.0f;
+		int j, p, c;
+
+		/* one contiguous row per layer so the sums below vectorize */
+		for (j = 0; j < len; j++) {
+			const float *co = VERT_getCo(elems->verts[support[j]], 0);
+			for (c = 0; c < numLayers; c++) {
+				gather[c * len + j] = co[c];
+				tolerance = max_ff(tolerance, fabsf(co[c]));
+			}
+		}
+		tolerance = 1e-4f * (1.0f + tolerance);
+
+		for (p = 0; p < numPoints; p++, weights += len) {
+			for (c = 0; c < numLayers; c++) {
+				const float *row = &gather[c * len];
+				float sum = 0.0f;
+
+				for (j = 0; j < len; j++)
+					sum += weights[j] * row[j];
+
+				if (!data->verify)
+					points[p][c] = sum;
+				else if (fabsf(points[p][c] - sum) > tolerance)
+					numFailed++;
+			}
+		}
+	}
+
+	MEM_freeN(points);
+	MEM_freeN(gather);
+
+	if (numFailed)
+		atomic_add_uint32(&data->numFailed, numFailed);
+}
+
+/* Write the owned top level points of all elements, or when verify is set
+ * compare them against the current data. Returns the number of mismatches. */
+static int ccgStencil_evaluate(CCGSubSurf *ss, const CCGStencilTable *table, const StencilElements *elems, int verify)
+{
+	StencilTaskData data = {ss, table, elems};
+	size_t numWeights = table->weightStart[table->numElements];
+
+	data.verify = verify;
+	ccg_task_parallel_batches(table->numElements, (int)(numWeights / table->numElements) + 1,
+	                          numWeights >= CCG_TASK_LIMIT,
+	                          &data, ccgStencil_evaluateElements);
+
+	return (int)data.numFailed;
+}
+
+/* Sync of the whole mesh. A new topology is subdivided regularly first, only
+ * when it comes back with different data (an animated mesh) the table is
+ * built, after which the following syncs evaluate the stencils. */
+static void ccgSubSurf__stencilSync(CCGSubSurf *ss, const StencilElements *elems)
+{
+	CCGStencilTable *table = ss->stencils;
+	uint64_t topologyHash = ccgStencil_topologyHash(ss, elems);
+	int build = 0;
+
+	if (table && table->topologyHash == topologyHash) {
+		if (table->state == eStencilState_Built) {
+			ccgStencil_evaluate(ss, table, elems, 0);
+			ccgSubSurf__copyDownLevel(ss, elems->edges, elems->faces, elems->numEdges, elems->numFaces,
+			                          ss->subdivLevels);
+			return;
+		}
+		else if (table->state == eStencilState_Pending) {
+			uint64_t dataHash = ccgStencil_dataHash(ss, elems);
+
+			if (dataHash != table->dataHash) {
+				table->dataHash = dataHash;
+				build = 1;
+			}
+		}
+	}
+	else {
+		ccgSubSurf_freeStencils(table);
+		table = ss->stencils = MEM_callocN(sizeof(*table), "CCGStencilTable");
+		table->topologyHash = topologyHash;
+		table->dataHash = ccgStencil_dataHash(ss, elems);
+		table->state = eStencilState_Pending;
+		table->numElements = elems->numVerts + elems->numEdges + elems->numFaces;
+	}
+
+	if (build) {
+		table->state = ccgStencil_build(ss, table, elems) ? eStencilState_Built : eStencilState_Failed;
+	}
+
+	ccgSubSurf__subdivide(ss,
+	                      elems->verts, elems->edges, elems->faces,
+	                      elems->numVerts, elems->numEdges, elems->numFaces);
+
+	if (build) {
+		/* probing relies on the subdivision being linear in the vertex data,
+		 * keep using the regular path when the weights do not reproduce it */
+		if (table->state == eStencilState_Built && ccgStencil_evaluate(ss, table, elems, 1) != 0)
+			table->state = eStencilState_Failed;
+
+		if (table->state == eStencilState_Failed)
+			ccgStencil_freeArrays(table);
+	}
+}
+
+static void ccgSubSurf__sync(CCGSubSurf *ss)
+{
+	CCGVert **effectedV;
+	CCGEdge **effectedE;
+	CCGFace **effectedF;
+	int numEffectedV, numEffectedE, numEffectedF;
+	int i, j, ptrIdx;
+
+	effectedV = MEM_mallocN(sizeof(*effectedV) * ss->vMap->numEntries, "CCGSubsurf effectedV");
+	effectedE = MEM_mallocN(sizeof(*effectedE) * ss->eMap->numEntries, "CCGSubsurf effectedE");
+	effectedF = MEM_mallocN(sizeof(*effectedF) * ss->fMap->numEntries, "CCGSubsurf effectedF");
+	numEffectedV = numEffectedE = numEffectedF = 0;
+	for (i = 0; i < ss->vMap->curSize; i++) {
+		CCGVert *v = (CCGVert *) ss->vMap->buckets[i];
+		for (; v; v = v->next) {
+			if (v->flags & Vert_eEffected) {
+				effectedV[numEffectedV++] = v;
+
+				for (j = 0; j < v->numEdges; j++) {
+					CCGEdge *e = v->edges[j];
+					if (!(e->flags & Edge_eEffected)) {
+						effectedE[numEffectedE++] = e;
+						e->flags |= Edge_eEffected;
+					}
+				}
+
+				for (j = 0; j < v->numFaces; j++) {
+					CCGFace *f = v->faces[j];
+					if (!(f->flags & Face_eEffected)) {
+						effectedF[numEffectedF++] = f;
+						f->flags |= Face_eEffected;
+					}
+				}
+			}
+		}
+	}
+
+	if (ss->useStencils && numEffectedV && numEffectedV == ss->vMap->numEntries) {
+		StencilElements elems = {effectedV, effectedE, effectedF, numEffectedV, numEffectedE, numEffectedF};
+		ccgSubSurf__stencilSync(ss, &elems);
+	}
+	else {
+		ccgSubSurf__subdivide(ss,
+		                      effectedV, effectedE, effectedF,
+		                      numEffectedV, numEffectedE, numEffectedF);
+	}
+
 	if (ss->useAgeCounts) {
 		for (i = 0; i < numEffectedV; i++) {
 			CCGVert *v = effectedV[i];
@@ -2378,33 +3202,6 @@ static void ccgSubSurf__sync(CCGSubSurf *ss)
 		}
 	}
 
-	for (i = 0; i < numEffectedE; i++) {
-		CCGEdge *e = effectedE[i];
-		VertDataCopy(EDGE_getCo(e, nextLvl, 0), VERT_getCo(e->v0, nextLvl), ss);
-		VertDataCopy(EDGE_getCo(e, nextLvl, 2), VERT_getCo(e->v1, nextLvl), ss);
-	}
-	for (i = 0; i < numEffectedF; i++) {
-		CCGFace *f = effectedF[i];
-		for (S = 0; S < f->numVerts; S++) {
-			CCGEdge *e = FACE_getEdges(f)[S];
-			CCGEdge *prevE = FACE_getEdges(f)[(S + f->numVerts - 1) % f->numVerts];
-
-			VertDataCopy(FACE_getIFCo(f, nextLvl, S, 0, 0), (float *)FACE_getCenterData(f), ss);
-			VertDataCopy(FACE_getIECo(f, nextLvl, S, 0), (float *)FACE_getCenterData(f), ss);
-			VertDataCopy(FACE_getIFCo(f, nextLvl, S, 1, 1), VERT_getCo(FACE_getVerts(f)[S], nextLvl), ss);
-			VertDataCopy(FACE_getIECo(f, nextLvl, S, 1), EDGE_getCo(FACE_getEdges(f)[S], nextLvl, 1), ss);
-
-			VertDataCopy(FACE_getIFCo(f, nextLvl, S, 1, 0), _edge_getCoVert(e, FACE_getVerts(f)[S], nextLvl, 1, vertDataSize), ss);
-			VertDataCopy(FACE_getIFCo(f, nextLvl, S, 0, 1), _edge_getCoVert(prevE, FACE_getVerts(f)[S], nextLvl, 1, vertDataSize), ss);
-		}
-	}
-
-	for (curLvl = 1; curLvl < subdivLevels; curLvl++) {
-		ccgSubSurf__calcSubdivLevel(ss,
-		                            effectedV, effectedE, effectedF,
-		                            numEffectedV, numEffectedE, numEffectedF, curLvl);
-	}
-
 	if (ss->calcVertNormals)
 		ccgSubSurf__calcVertNormals(ss,
 		                            effectedV, effectedE, effectedF,
@@ -2418,6 +3215,10 @@ static void ccgSubSurf__sync(CCGSubSurf *ss)
 		CCGEdge *e = effectedE[ptrIdx];
 		e->flags = 0;
 	}
+	for (ptrIdx = 0; ptrIdx < numEffectedF; ptrIdx++) {
+		CCGFace *f = effectedF[ptrIdx];
+		f->flags = 0;
+	}
 
 	MEM_freeN(effectedF);
 	MEM_freeN(effectedE);
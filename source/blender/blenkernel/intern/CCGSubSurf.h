@@ -34,6 +34,7 @@ typedef struct CCGSubSurf CCGSubSurf;
 typedef struct CCGVert CCGVert;
 typedef struct CCGEdge CCGEdge;
 typedef struct CCGFace CCGFace;
+typedef struct CCGStencilTable CCGStencilTable;
 
 typedef struct CCGMeshIFC {
 	int			vertUserSize, edgeUserSize, faceUserSize;
@@ -103,6 +104,11 @@ void		ccgSubSurf_setAllocMask				(CCGSubSurf *ss, int allocMask, int maskOffset)
 
 void		ccgSubSurf_setNumLayers				(CCGSubSurf *ss, int numLayers);
 
+void		ccgSubSurf_setUseStencils			(CCGSubSurf *ss, int useStencils);
+CCGStencilTable*	ccgSubSurf_takeStencils		(CCGSubSurf *ss);
+void		ccgSubSurf_setStencils				(CCGSubSurf *ss, CCGStencilTable *stencils);
+void		ccgSubSurf_freeStencils				(CCGStencilTable *stencils);
+
 /***/
 
 int			ccgSubSurf_getNumVerts				(const CCGSubSurf *ss);
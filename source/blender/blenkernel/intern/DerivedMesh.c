@@ -1461,6 +1461,277 @@ static void dm_ensure_display_normals(DerivedMesh *dm)
 		CDDM_calc_normals_mapping_ex(dm, (dm->dirty & DM_DIRTY_NORMALS) ? false : true);
 	}
 }
+/* -------------------------------------------------------------------- */
+/* Modifier stack checkpoints
+ *
+ * Modifiers flagged with eModifierTypeFlag_CacheResult keep a copy of the
+ * stack result after them, tagged with a hash of everything that went into
+ * it: the input mesh, the deformed coordinates and the settings of every
+ * modifier up to that point. When only a modifier further down the stack
+ * changes, evaluation resumes from the last checkpoint with a matching hash.
+ *
+ * Only used for the regular viewport evaluation of the object, and only up
+ * to the first modifier without eModifierTypeFlag_Checkpoint or whose result
+ * depends on something that isn't hashed (time, other datablocks).
+ */
+
+/* checkpoints kept per modifier stack, the ones furthest down are kept */
+#define MESH_CHECKPOINT_MAX 2
+
+/* MurmurHash64A mixing, 8 bytes at a time */
+static uint64_t checkpoint_hash_data(uint64_t hash, const void *data, size_t size)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const unsigned char *p = data;
+	uint64_t k;
+
+	hash ^= size * m;
+
+	for (; size >= 8; size -= 8, p += 8) {
+		memcpy(&k, p, sizeof(k));
+		k *= m;
+		k ^= k >> 47;
+		k *= m;
+		hash ^= k;
+		hash *= m;
+	}
+
+	if (size) {
+		k = 0;
+		memcpy(&k, p, size);
+		hash ^= k;
+		hash *= m;
+	}
+
+	hash ^= hash >> 47;
+	hash *= m;
+	hash ^= hash >> 47;
+
+	return hash;
+}
+
+static uint64_t checkpoint_hash_customdata(uint64_t hash, const CustomData *data, int totelem)
+{
+	int i, j;
+
+	for (i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+
+		hash = checkpoint_hash_data(hash, &layer->type, sizeof(layer->type));
+		hash = checkpoint_hash_data(hash, &layer->active, sizeof(layer->active));
+		hash = checkpoint_hash_data(hash, &layer->active_rnd, sizeof(layer->active_rnd));
+		hash = checkpoint_hash_data(hash, layer->name, strlen(layer->name));
+
+		if (layer->type == CD_MDEFORMVERT) {
+			/* weights are stored behind a pointer */
+			const MDeformVert *dvert = layer->data;
+
+			for (j = 0; j < totelem; j++) {
+				hash = checkpoint_hash_data(hash, &dvert[j].totweight, sizeof(dvert[j].totweight));
+				if (dvert[j].totweight)
+					hash = checkpoint_hash_data(hash, dvert[j].dw, sizeof(*dvert[j].dw) * dvert[j].totweight);
+			}
+		}
+		else {
+			hash = checkpoint_hash_data(hash, layer->data, (size_t)CustomData_sizeof(layer->type) * totelem);
+		}
+	}
+
+	return hash;
+}
+
+/* hash of the mesh data and object state the stack starts from */
+static uint64_t mesh_checkpoint_input_hash(Scene *scene, Object *ob, Mesh *me,
+                                           float (*deformedVerts)[3], int numVerts,
+                                           CustomDataMask dataMask, int needMapping)
+{
+	bDeformGroup *dg;
+	uint64_t hash = 0;
+	const int simplify = (scene->r.mode & R_SIMPLIFY) ? scene->r.simplify_subsurf : -1;
+
+	hash = checkpoint_hash_data(hash, &dataMask, sizeof(dataMask));
+	hash = checkpoint_hash_data(hash, &needMapping, sizeof(needMapping));
+	hash = checkpoint_hash_data(hash, &simplify, sizeof(simplify));
+	hash = checkpoint_hash_data(hash, &me->flag, sizeof(me->flag));
+	hash = checkpoint_hash_data(hash, &ob->totcol, sizeof(ob->totcol));
+
+	/* vertex groups are looked up by name */
+	for (dg = ob->defbase.first; dg; dg = dg->next)
+		hash = checkpoint_hash_data(hash, dg->name, strlen(dg->name));
+
+	hash = checkpoint_hash_customdata(hash, &me->vdata, me->totvert);
+	hash = checkpoint_hash_customdata(hash, &me->edata, me->totedge);
+	hash = checkpoint_hash_customdata(hash, &me->ldata, me->totloop);
+	hash = checkpoint_hash_customdata(hash, &me->pdata, me->totpoly);
+
+	if (deformedVerts)
+		hash = checkpoint_hash_data(hash, deformedVerts, sizeof(*deformedVerts) * numVerts);
+
+	return hash;
+}
+
+static void modifier_checkpoint_idlink_cb(void *userData, Object *UNUSED(ob), ID **idpoin)
+{
+	if (*idpoin)
+		*((bool *)userData) = true;
+}
+
+/* can the result of this modifier be checkpointed, given its input is? */
+static bool modifier_checkpoint_supported(Object *ob, ModifierData *md)
+{
+	ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	bool has_links = false;
+
+	if (!(mti->flags & (eModifierTypeFlag_Checkpoint | eModifierTypeFlag_CacheResult)))
+		return false;
+	if (mti->dependsOnTime && mti->dependsOnTime(md))
+		return false;
+
+	if (mti->foreachIDLink) {
+		mti->foreachIDLink(md, ob, modifier_checkpoint_idlink_cb, &has_links);
+	}
+	else if (mti->foreachObjectLink) {
+		mti->foreachObjectLink(md, ob, (ObjectWalkFunc)modifier_checkpoint_idlink_cb, &has_links);
+	}
+
+	return !has_links;
+}
+
+/* settings of checkpointed modifiers, pointers and runtime data are at the end
+ * of their structs and left out, object links are NULL (see modifier_checkpoint_supported) */
+static size_t modifier_checkpoint_settings_end(ModifierData *md)
+{
+	switch ((ModifierType)md->type) {
+		case eModifierType_Subsurf:
+			return offsetof(SubsurfModifierData, emCache);
+		case eModifierType_Decimate:
+			return offsetof(DecimateModifierData, face_count);
+		case eModifierType_Mirror:
+			return offsetof(MirrorModifierData, mirror_ob);
+		default:
+			return (size_t)modifierType_getInfo(md->type)->structSize;
+	}
+}
+
+static uint64_t modifier_checkpoint_hash(uint64_t hash, ModifierData *md, CustomDataMask mask)
+{
+	size_t size = modifier_checkpoint_settings_end(md) - sizeof(ModifierData);
+
+	hash = checkpoint_hash_data(hash, &md->type, sizeof(md->type));
+	hash = checkpoint_hash_data(hash, &mask, sizeof(mask));
+	hash = checkpoint_hash_data(hash, ((char *)md) + sizeof(ModifierData), size);
+
+	return hash;
+}
+
+/* skip the same modifiers as the main loop of mesh_calc_modifiers */
+static bool mesh_checkpoint_skip(Scene *scene, ModifierData *md, int required_mode, int needMapping, bool has_dm)
+{
+	ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+	if (!modifier_isEnabled(scene, md, required_mode)) return true;
+	if ((mti->flags & eModifierTypeFlag_RequiresOriginalData) && has_dm) return true;
+	if (needMapping && !modifier_supportsMapping(md)) return true;
+
+	return false;
+}
+
+/* check there is something worth hashing the input mesh for */
+static bool mesh_checkpoints_used(Scene *scene, Object *ob, ModifierData *md, CDMaskLink *curr,
+                                  int required_mode, int needMapping)
+{
+	bool has_dm = false;
+
+	/* orco meshes are evaluated alongside the stack, these aren't kept */
+	for (; curr; curr = curr->next) {
+		if (curr->mask & (CD_MASK_ORCO | CD_MASK_CLOTH_ORCO))
+			return false;
+	}
+
+	for (; md && md->next; md = md->next) {
+		ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+		if (mesh_checkpoint_skip(scene, md, required_mode, needMapping, has_dm))
+			continue;
+		if (!modifier_checkpoint_supported(ob, md))
+			break;
+		if (mti->flags & eModifierTypeFlag_CacheResult)
+			return true;
+
+		has_dm |= (mti->type != eModifierTypeType_OnlyDeform);
+	}
+
+	return false;
+}
+
+/* find the last modifier with a valid checkpoint, r_hash is updated to the hash at that modifier */
+static ModifierData *mesh_checkpoint_find(Scene *scene, Object *ob, ModifierData *md, CDMaskLink *curr,
+                                          int required_mode, int needMapping, uint64_t *r_hash)
+{
+	ModifierData *found = NULL;
+	uint64_t hash = *r_hash;
+	bool has_dm = false;
+
+	for (; md && md->next; md = md->next, curr = curr->next) {
+		ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+		if (mesh_checkpoint_skip(scene, md, required_mode, needMapping, has_dm))
+			continue;
+		if (!modifier_checkpoint_supported(ob, md))
+			break;
+
+		hash = modifier_checkpoint_hash(hash, md, curr->mask);
+
+		if (md->checkpoint && md->checkpoint->hash == hash) {
+			found = md;
+			*r_hash = hash;
+		}
+
+		has_dm |= (mti->type != eModifierTypeType_OnlyDeform);
+	}
+
+	return found;
+}
+
+static void mesh_checkpoint_store(ModifierData *firstmd, ModifierData *md, DerivedMesh *dm,
+                                  uint64_t hash, CustomDataMask append_mask)
+{
+	ModifierData *prevmd;
+	int tot;
+
+	/* errors are only reported when modifiers run, don't hide them by skipping */
+	for (prevmd = firstmd; prevmd != md->next; prevmd = prevmd->next) {
+		if (prevmd->error) {
+			modifier_freeCheckpoint(md);
+			return;
+		}
+	}
+
+	if (md->checkpoint && md->checkpoint->hash == hash)
+		return;
+
+	modifier_freeCheckpoint(md);
+
+	md->checkpoint = MEM_mallocN(sizeof(*md->checkpoint), "ModifierCheckpoint");
+	md->checkpoint->dm = CDDM_copy(dm);
+	md->checkpoint->hash = hash;
+	md->checkpoint->append_mask = append_mask;
+
+	/* only the last few checkpoints of a stack are kept, each one is a full mesh copy */
+	for (prevmd = md->prev, tot = 1; prevmd; prevmd = prevmd->prev) {
+		if (prevmd->checkpoint && ++tot > MESH_CHECKPOINT_MAX) {
+			modifier_freeCheckpoint(prevmd);
+		}
+	}
+}
+
+/* checkpoints from md on can't match anymore until the stack changes back */
+static void mesh_checkpoint_free_from(ModifierData *md)
+{
+	for (; md; md = md->next)
+		modifier_freeCheckpoint(md);
+}
+
 /* new value for useDeform -1  (hack for the gameengine):
  * - apply only the modifier stack of the object, skipping the virtual modifiers,
  * - don't apply the key
@@ -1503,6 +1774,13 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 	const bool do_loop_normals = (me->flag & ME_AUTOSMOOTH);
 	const float loop_normals_split_angle = me->smoothresh;
 
+	/* Checkpoints are only kept for the regular (cached) viewport evaluation */
+	bool use_checkpoints = (useCache && !useRenderParams && useDeform > 0 && index < 0 &&
+	                        !sculpt_mode && !build_shapekey_layers && !do_init_wmcol &&
+	                        !CustomData_has_layer(&me->ldata, CD_MDISPS) &&
+	                        !CustomData_has_layer(&me->ldata, CD_GRID_PAINT_MASK));
+	uint64_t checkpoint_hash = 0;
+
 	VirtualModifierData virtualModifierData;
 
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
@@ -1609,6 +1887,35 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 	orcodm = NULL;
 	clothorcodm = NULL;
 
+	if (use_checkpoints) {
+		use_checkpoints = mesh_checkpoints_used(scene, ob, md, curr, required_mode, needMapping);
+	}
+
+	if (use_checkpoints) {
+		ModifierData *resumemd;
+
+		checkpoint_hash = mesh_checkpoint_input_hash(scene, ob, me, deformedVerts, numVerts, dataMask, needMapping);
+		resumemd = mesh_checkpoint_find(scene, ob, md, curr, required_mode, needMapping, &checkpoint_hash);
+
+		/* resume from the checkpoint, modifiers up to it don't need to run again */
+		if (resumemd) {
+			dm = CDDM_copy(resumemd->checkpoint->dm);
+			append_mask = resumemd->checkpoint->append_mask;
+
+			if (deformedVerts) {
+				if (deformedVerts != inputVertexCos)
+					MEM_freeN(deformedVerts);
+				deformedVerts = NULL;
+			}
+
+			for (; md != resumemd; md = md->next, curr = curr->next) {
+				/* pass */
+			}
+			md = md->next;
+			curr = curr->next;
+		}
+	}
+
 	for (; md; md = md->next, curr = curr->next) {
 		ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
@@ -1653,6 +1960,16 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 		if (needMapping && !modifier_supportsMapping(md)) continue;
 		if (useDeform < 0 && mti->dependsOnTime && mti->dependsOnTime(md)) continue;
 
+		if (use_checkpoints) {
+			if (modifier_checkpoint_supported(ob, md)) {
+				checkpoint_hash = modifier_checkpoint_hash(checkpoint_hash, md, curr->mask);
+			}
+			else {
+				mesh_checkpoint_free_from(md);
+				use_checkpoints = false;
+			}
+		}
+
 		/* add an orco layer if needed by this modifier */
 		if (mti->requiredDataMask)
 			mask = mti->requiredDataMask(ob, md);
@@ -1838,6 +2155,10 @@ static void mesh_calc_modifiers(Scene *scene, Object *ob, float (*inputVertexCos
 				DM_update_weight_mcol(ob, dm, draw_flag, NULL, 0, NULL);
 				append_mask |= CD_MASK_PREVIEW_MLOOPCOL;
 			}
+
+			/* keep a copy of the result, unless this is the last modifier anyway */
+			if (use_checkpoints && (mti->flags & eModifierTypeFlag_CacheResult) && md->next)
+				mesh_checkpoint_store(firstmd, md, dm, checkpoint_hash, append_mask);
 		}
 
 		isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
@@ -39,6 +39,7 @@
 
 #include "BLI_math.h"
 #include "BLI_blenlib.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_anim_types.h"
@@ -808,6 +809,193 @@ static void pchan_bone_deform(bPoseChannel *pchan, bPoseChanDeform *pdef_info, f
 	(*contrib) += weight;
 }
 
+typedef struct ArmatureUserdata {
+	Object *armOb;
+	DerivedMesh *dm;
+	float (*vertexCos)[3];
+	float (*defMats)[3][3];
+	float (*prevCos)[3];
+	bPoseChanDeform *pdef_info_array;
+	bPoseChannel **defnrToPC;
+	int *defnrToPCIndex;
+	MDeformVert *dverts;
+	int target_totvert;
+	int defbase_tot;
+	int armature_def_nr;
+	bool use_dverts;
+	bool use_envelope;
+	bool use_quaternion;
+	bool invert_vgroup;
+	float premat[4][4];
+	float postmat[4][4];
+} ArmatureUserdata;
+
+static void armature_vert_task(void *userdata, int i)
+{
+	ArmatureUserdata *data = userdata;
+	Object *armOb = data->armOb;
+	DerivedMesh *dm = data->dm;
+	float (*vertexCos)[3] = data->vertexCos;
+	float (*defMats)[3][3] = data->defMats;
+	float (*prevCos)[3] = data->prevCos;
+	bPoseChanDeform *pdef_info_array = data->pdef_info_array;
+	bPoseChanDeform *pdef_info;
+	bPoseChannel *pchan, **defnrToPC = data->defnrToPC;
+	int *defnrToPCIndex = data->defnrToPCIndex;
+	MDeformVert *dverts = data->dverts;
+	const int target_totvert = data->target_totvert;
+	const int defbase_tot = data->defbase_tot;
+	const int armature_def_nr = data->armature_def_nr;
+	const bool use_dverts = data->use_dverts;
+	const bool use_envelope = data->use_envelope;
+	const bool use_quaternion = data->use_quaternion;
+	const bool invert_vgroup = data->invert_vgroup;
+	float (*premat)[4] = data->premat;
+	float (*postmat)[4] = data->postmat;
+	MDeformVert *dvert;
+	DualQuat sumdq, *dq = NULL;
+	float *co, dco[3];
+	float sumvec[3], summat[3][3];
+	float *vec = NULL, (*smat)[3] = NULL;
+	float contrib = 0.0f;
+	float armature_weight = 1.0f; /* default to 1 if no overall def group */
+	float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
+
+	if (use_quaternion) {
+		memset(&sumdq, 0, sizeof(DualQuat));
+		dq = &sumdq;
+	}
+	else {
+		sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
+		vec = sumvec;
+
+		if (defMats) {
+			zero_m3(summat);
+			smat = summat;
+		}
+	}
+
+	if (use_dverts || armature_def_nr != -1) {
+		if (dm)
+			dvert = dm->getVertData(dm, i, CD_MDEFORMVERT);
+		else if (dverts && i < target_totvert)
+			dvert = dverts + i;
+		else
+			dvert = NULL;
+	}
+	else
+		dvert = NULL;
+
+	if (armature_def_nr != -1 && dvert) {
+		armature_weight = defvert_find_weight(dvert, armature_def_nr);
+
+		if (invert_vgroup)
+			armature_weight = 1.0f - armature_weight;
+
+		/* hackish: the blending factor can be used for blending with prevCos too */
+		if (prevCos) {
+			prevco_weight = armature_weight;
+			armature_weight = 1.0f;
+		}
+	}
+
+	/* check if there's any  point in calculating for this vert */
+	if (armature_weight == 0.0f)
+		return;
+
+	/* get the coord we work on */
+	co = prevCos ? prevCos[i] : vertexCos[i];
+
+	/* Apply the object's matrix */
+	mul_m4_v3(premat, co);
+
+	if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
+		MDeformWeight *dw = dvert->dw;
+		int deformed = 0;
+		unsigned int j;
+
+		for (j = dvert->totweight; j != 0; j--, dw++) {
+			const int index = dw->def_nr;
+			if (index >= 0 && index < defbase_tot && (pchan = defnrToPC[index])) {
+				float weight = dw->weight;
+				Bone *bone = pchan->bone;
+				pdef_info = pdef_info_array + defnrToPCIndex[index];
+
+				deformed = 1;
+
+				if (bone && bone->flag & BONE_MULT_VG_ENV) {
+					weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
+					                             bone->rad_head, bone->rad_tail, bone->dist);
+				}
+				pchan_bone_deform(pchan, pdef_info, weight, vec, dq, smat, co, &contrib);
+			}
+		}
+		/* if there are vertexgroups but not groups with bones
+		 * (like for softbody groups) */
+		if (deformed == 0 && use_envelope) {
+			pdef_info = pdef_info_array;
+			for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
+				if (!(pchan->bone->flag & BONE_NO_DEFORM))
+					contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
+			}
+		}
+	}
+	else if (use_envelope) {
+		pdef_info = pdef_info_array;
+		for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
+			if (!(pchan->bone->flag & BONE_NO_DEFORM))
+				contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
+		}
+	}
+
+	/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+	if (contrib > 0.0001f) {
+		if (use_quaternion) {
+			normalize_dq(dq, contrib);
+
+			if (armature_weight != 1.0f) {
+				copy_v3_v3(dco, co);
+				mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
+				sub_v3_v3(dco, co);
+				mul_v3_fl(dco, armature_weight);
+				add_v3_v3(co, dco);
+			}
+			else
+				mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
+
+			smat = summat;
+		}
+		else {
+			mul_v3_fl(vec, armature_weight / contrib);
+			add_v3_v3v3(co, vec, co);
+		}
+
+		if (defMats) {
+			float pre[3][3], post[3][3], tmpmat[3][3];
+
+			copy_m3_m4(pre, premat);
+			copy_m3_m4(post, postmat);
+			copy_m3_m3(tmpmat, defMats[i]);
+
+			if (!use_quaternion) /* quaternion already is scale corrected */
+				mul_m3_fl(smat, armature_weight / contrib);
+
+			mul_m3_series(defMats[i], post, smat, pre, tmpmat);
+		}
+	}
+
+	/* always, check above code */
+	mul_m4_v3(postmat, co);
+
+	/* interpolate with previous modifier position using weight group */
+	if (prevCos) {
+		float mw = 1.0f - prevco_weight;
+		vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
+		vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
+		vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
+	}
+}
+
 void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
                            float (*defMats)[3][3], int numVerts, int deformflag,
                            float (*prevCos)[3], const char *defgrp_name)
@@ -829,6 +1017,7 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 	bool use_dverts = false;
 	int armature_def_nr;
 	int totchan;
+	ArmatureUserdata data;
 
 	if (arm->edbo) return;
 
@@ -912,149 +1101,28 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 		}
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		MDeformVert *dvert;
-		DualQuat sumdq, *dq = NULL;
-		float *co, dco[3];
-		float sumvec[3], summat[3][3];
-		float *vec = NULL, (*smat)[3] = NULL;
-		float contrib = 0.0f;
-		float armature_weight = 1.0f; /* default to 1 if no overall def group */
-		float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
-
-		if (use_quaternion) {
-			memset(&sumdq, 0, sizeof(DualQuat));
-			dq = &sumdq;
-		}
-		else {
-			sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
-			vec = sumvec;
-
-			if (defMats) {
-				zero_m3(summat);
-				smat = summat;
-			}
-		}
-
-		if (use_dverts || armature_def_nr != -1) {
-			if (dm)
-				dvert = dm->getVertData(dm, i, CD_MDEFORMVERT);
-			else if (dverts && i < target_totvert)
-				dvert = dverts + i;
-			else
-				dvert = NULL;
-		}
-		else
-			dvert = NULL;
-
-		if (armature_def_nr != -1 && dvert) {
-			armature_weight = defvert_find_weight(dvert, armature_def_nr);
-
-			if (invert_vgroup)
-				armature_weight = 1.0f - armature_weight;
-
-			/* hackish: the blending factor can be used for blending with prevCos too */
-			if (prevCos) {
-				prevco_weight = armature_weight;
-				armature_weight = 1.0f;
-			}
-		}
-
-		/* check if there's any  point in calculating for this vert */
-		if (armature_weight == 0.0f)
-			continue;
-
-		/* get the coord we work on */
-		co = prevCos ? prevCos[i] : vertexCos[i];
-
-		/* Apply the object's matrix */
-		mul_m4_v3(premat, co);
-
-		if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
-			MDeformWeight *dw = dvert->dw;
-			int deformed = 0;
-			unsigned int j;
-
-			for (j = dvert->totweight; j != 0; j--, dw++) {
-				const int index = dw->def_nr;
-				if (index >= 0 && index < defbase_tot && (pchan = defnrToPC[index])) {
-					float weight = dw->weight;
-					Bone *bone = pchan->bone;
-					pdef_info = pdef_info_array + defnrToPCIndex[index];
-
-					deformed = 1;
-
-					if (bone && bone->flag & BONE_MULT_VG_ENV) {
-						weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
-						                             bone->rad_head, bone->rad_tail, bone->dist);
-					}
-					pchan_bone_deform(pchan, pdef_info, weight, vec, dq, smat, co, &contrib);
-				}
-			}
-			/* if there are vertexgroups but not groups with bones
-			 * (like for softbody groups) */
-			if (deformed == 0 && use_envelope) {
-				pdef_info = pdef_info_array;
-				for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-					if (!(pchan->bone->flag & BONE_NO_DEFORM))
-						contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-				}
-			}
-		}
-		else if (use_envelope) {
-			pdef_info = pdef_info_array;
-			for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-				if (!(pchan->bone->flag & BONE_NO_DEFORM))
-					contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-			}
-		}
-
-		/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
-		if (contrib > 0.0001f) {
-			if (use_quaternion) {
-				normalize_dq(dq, contrib);
-
-				if (armature_weight != 1.0f) {
-					copy_v3_v3(dco, co);
-					mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
-					sub_v3_v3(dco, co);
-					mul_v3_fl(dco, armature_weight);
-					add_v3_v3(co, dco);
-				}
-				else
-					mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
-
-				smat = summat;
-			}
-			else {
-				mul_v3_fl(vec, armature_weight / contrib);
-				add_v3_v3v3(co, vec, co);
-			}
-
-			if (defMats) {
-				float pre[3][3], post[3][3], tmpmat[3][3];
-
-				copy_m3_m4(pre, premat);
-				copy_m3_m4(post, postmat);
-				copy_m3_m3(tmpmat, defMats[i]);
-
-				if (!use_quaternion) /* quaternion already is scale corrected */
-					mul_m3_fl(smat, armature_weight / contrib);
-
-				mul_m3_series(defMats[i], post, smat, pre, tmpmat);
-			}
-		}
-
-		/* always, check above code */
-		mul_m4_v3(postmat, co);
-
-		/* interpolate with previous modifier position using weight group */
-		if (prevCos) {
-			float mw = 1.0f - prevco_weight;
-			vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
-			vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
-			vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
-		}
+	data.armOb = armOb;
+	data.dm = dm;
+	data.vertexCos = vertexCos;
+	data.defMats = defMats;
+	data.prevCos = prevCos;
+	data.pdef_info_array = pdef_info_array;
+	data.defnrToPC = defnrToPC;
+	data.defnrToPCIndex = defnrToPCIndex;
+	data.dverts = dverts;
+	data.target_totvert = target_totvert;
+	data.defbase_tot = defbase_tot;
+	data.armature_def_nr = armature_def_nr;
+	data.use_dverts = use_dverts;
+	data.use_envelope = use_envelope != 0;
+	data.use_quaternion = use_quaternion != 0;
+	data.invert_vgroup = invert_vgroup != 0;
+	copy_m4_m4(data.premat, premat);
+	copy_m4_m4(data.postmat, postmat);
+
+	/* bone deform data is only read from here on, each vertex is independent */
+	if (numVerts > 0) {
+		BLI_task_parallel_range(0, numVerts, &data, armature_vert_task);
 	}
 
 	if (dualquats)
@@ -40,6 +40,7 @@
 #include "BLI_listbase.h"
 #include "BLI_bitmap.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -723,12 +724,73 @@ static bool calc_curve_deform(Scene *scene, Object *par, float co[3],
 	return 0;
 }
 
+typedef struct CurveDeformUserdata {
+	Scene *scene;
+	Object *cuOb;
+	CurveDeform *cd;
+	float (*vertexCos)[3];
+	MDeformVert *dvert;
+	int defgrp_index;
+	short defaxis;
+	/* coordinates are already in 'cd->curvespace' from the bounds pass */
+	bool in_curvespace;
+} CurveDeformUserdata;
+
+static void curve_deform_vert_task(void *userdata, int a)
+{
+	CurveDeformUserdata *data = userdata;
+	CurveDeform *cd = data->cd;
+	float *co = data->vertexCos[a];
+
+	if (data->dvert) {
+		const float weight = defvert_find_weight(&data->dvert[a], data->defgrp_index);
+		float vec[3];
+
+		if (weight > 0.0f) {
+			if (!data->in_curvespace) {
+				mul_m4_v3(cd->curvespace, co);
+			}
+			copy_v3_v3(vec, co);
+			calc_curve_deform(data->scene, data->cuOb, vec, data->defaxis, cd, NULL);
+			interp_v3_v3v3(co, co, vec, weight);
+			mul_m4_v3(cd->objectspace, co);
+		}
+	}
+	else {
+		if (!data->in_curvespace) {
+			mul_m4_v3(cd->curvespace, co);
+		}
+		calc_curve_deform(data->scene, data->cuOb, co, data->defaxis, cd, NULL);
+		mul_m4_v3(cd->objectspace, co);
+	}
+}
+
+static void curve_deform_verts_do(CurveDeformUserdata *data, int numVerts)
+{
+	if (numVerts <= 0) {
+		return;
+	}
+
+	/* the curve cache may still have to be built on first use (cyclic dependencies),
+	 * only go threaded once the path exists */
+	if (data->cuOb->curve_cache && data->cuOb->curve_cache->path) {
+		BLI_task_parallel_range(0, numVerts, data, curve_deform_vert_task);
+	}
+	else {
+		int a;
+		for (a = 0; a < numVerts; a++) {
+			curve_deform_vert_task(data, a);
+		}
+	}
+}
+
 void curve_deform_verts(Scene *scene, Object *cuOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
                         int numVerts, const char *vgroup, short defaxis)
 {
 	Curve *cu;
 	int a;
 	CurveDeform cd;
+	CurveDeformUserdata data;
 	MDeformVert *dvert = NULL;
 	int defgrp_index = -1;
 	const bool is_neg_axis = (defaxis > 2);
@@ -771,26 +833,24 @@ void curve_deform_verts(Scene *scene, Object *cuOb, Object *target, DerivedMesh
 		}
 	}
 
-	if (dvert) {
-		MDeformVert *dvert_iter;
-		float vec[3];
+	data.scene = scene;
+	data.cuOb = cuOb;
+	data.cd = &cd;
+	data.vertexCos = vertexCos;
+	data.dvert = dvert;
+	data.defgrp_index = defgrp_index;
+	data.defaxis = defaxis;
+	data.in_curvespace = false;
 
-		if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
-			for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
-				const float weight = defvert_find_weight(dvert_iter, defgrp_index);
+	if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
+		curve_deform_verts_do(&data, numVerts);
+	}
+	else {
+		/* set mesh min/max bounds */
+		INIT_MINMAX(cd.dmin, cd.dmax);
 
-				if (weight > 0.0f) {
-					mul_m4_v3(cd.curvespace, vertexCos[a]);
-					copy_v3_v3(vec, vertexCos[a]);
-					calc_curve_deform(scene, cuOb, vec, defaxis, &cd, NULL);
-					interp_v3_v3v3(vertexCos[a], vertexCos[a], vec, weight);
-					mul_m4_v3(cd.objectspace, vertexCos[a]);
-				}
-			}
-		}
-		else {
-			/* set mesh min/max bounds */
-			INIT_MINMAX(cd.dmin, cd.dmax);
+		if (dvert) {
+			MDeformVert *dvert_iter;
 
 			for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
 				if (defvert_find_weight(dvert_iter, defgrp_index) > 0.0f) {
@@ -798,43 +858,17 @@ void curve_deform_verts(Scene *scene, Object *cuOb, Object *target, DerivedMesh
 					minmax_v3v3_v3(cd.dmin, cd.dmax, vertexCos[a]);
 				}
 			}
-
-			for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
-				const float weight = defvert_find_weight(dvert_iter, defgrp_index);
-
-				if (weight > 0.0f) {
-					/* already in 'cd.curvespace', prev for loop */
-					copy_v3_v3(vec, vertexCos[a]);
-					calc_curve_deform(scene, cuOb, vec, defaxis, &cd, NULL);
-					interp_v3_v3v3(vertexCos[a], vertexCos[a], vec, weight);
-					mul_m4_v3(cd.objectspace, vertexCos[a]);
-				}
-			}
-		}
-	}
-	else {
-		if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
-			for (a = 0; a < numVerts; a++) {
-				mul_m4_v3(cd.curvespace, vertexCos[a]);
-				calc_curve_deform(scene, cuOb, vertexCos[a], defaxis, &cd, NULL);
-				mul_m4_v3(cd.objectspace, vertexCos[a]);
-			}
 		}
 		else {
-			/* set mesh min max bounds */
-			INIT_MINMAX(cd.dmin, cd.dmax);
-				
 			for (a = 0; a < numVerts; a++) {
 				mul_m4_v3(cd.curvespace, vertexCos[a]);
 				minmax_v3v3_v3(cd.dmin, cd.dmax, vertexCos[a]);
 			}
-	
-			for (a = 0; a < numVerts; a++) {
-				/* already in 'cd.curvespace', prev for loop */
-				calc_curve_deform(scene, cuOb, vertexCos[a], defaxis, &cd, NULL);
-				mul_m4_v3(cd.objectspace, vertexCos[a]);
-			}
 		}
+
+		/* already in 'cd.curvespace', prev for loop */
+		data.in_curvespace = true;
+		curve_deform_verts_do(&data, numVerts);
 	}
 }
 
@@ -873,11 +907,37 @@ void curve_deform_vector(Scene *scene, Object *cuOb, Object *target,
 
 }
 
+typedef struct LatticeDeformUserdata {
+	LatticeDeformData *lattice_deform_data;
+	float (*vertexCos)[3];
+	DerivedMesh *dm;
+	MDeformVert *dvert;
+	int defgrp_index;
+	float fac;
+} LatticeDeformUserdata;
+
+static void lattice_deform_vert_task(void *userdata, int index)
+{
+	LatticeDeformUserdata *data = userdata;
+
+	if (data->defgrp_index != -1) {
+		MDeformVert *dvert = data->dm ? data->dm->getVertData(data->dm, index, CD_MDEFORMVERT) :
+		                                data->dvert + index;
+		const float weight = defvert_find_weight(dvert, data->defgrp_index);
+
+		if (weight > 0.0f)
+			calc_latt_deform(data->lattice_deform_data, data->vertexCos[index], weight * data->fac);
+	}
+	else {
+		calc_latt_deform(data->lattice_deform_data, data->vertexCos[index], data->fac);
+	}
+}
+
 void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
                           float (*vertexCos)[3], int numVerts, const char *vgroup, float fac)
 {
 	LatticeDeformData *lattice_deform_data;
-	int a;
+	LatticeDeformUserdata data;
 	bool use_vgroups;
 
 	if (laOb->type != OB_LATTICE)
@@ -903,29 +963,28 @@ void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
 		use_vgroups = false;
 	}
 	
+	data.lattice_deform_data = lattice_deform_data;
+	data.vertexCos = vertexCos;
+	data.dm = dm;
+	data.dvert = NULL;
+	data.defgrp_index = -1;
+	data.fac = fac;
+
+	/* the lattice is only read from here on, each vertex is independent */
 	if (vgroup && vgroup[0] && use_vgroups) {
 		Mesh *me = target->data;
 		const int defgrp_index = defgroup_name_index(target, vgroup);
-		float weight;
 
-		if (defgrp_index >= 0 && (me->dvert || dm)) {
-			MDeformVert *dvert = me->dvert;
-			
-			for (a = 0; a < numVerts; a++, dvert++) {
-				if (dm) dvert = dm->getVertData(dm, a, CD_MDEFORMVERT);
-
-				weight = defvert_find_weight(dvert, defgrp_index);
-
-				if (weight > 0.0f)
-					calc_latt_deform(lattice_deform_data, vertexCos[a], weight * fac);
-			}
+		if (defgrp_index >= 0 && (me->dvert || dm) && numVerts > 0) {
+			data.dvert = me->dvert;
+			data.defgrp_index = defgrp_index;
+			BLI_task_parallel_range(0, numVerts, &data, lattice_deform_vert_task);
 		}
 	}
-	else {
-		for (a = 0; a < numVerts; a++) {
-			calc_latt_deform(lattice_deform_data, vertexCos[a], fac);
-		}
+	else if (numVerts > 0) {
+		BLI_task_parallel_range(0, numVerts, &data, lattice_deform_vert_task);
 	}
+
 	end_latt_deform(lattice_deform_data);
 }
 
@@ -46,6 +46,7 @@
 #include "BLI_linklist.h"
 #include "BLI_linklist_stack.h"
 #include "BLI_alloca.h"
+#include "BLI_task.h"
 
 #include "BKE_customdata.h"
 #include "BKE_mesh.h"
@@ -105,7 +106,6 @@ void BKE_mesh_calc_normals_mapping_ex(
 	float (*pnors)[3] = r_polyNors, (*fnors)[3] = r_faceNors;
 	int i;
 	MFace *mf;
-	MPoly *mp;
 
 	if (numPolys == 0) {
 		if (only_face_normals == false) {
@@ -131,10 +131,7 @@ void BKE_mesh_calc_normals_mapping_ex(
 	}
 	else {
 		/* only calc poly normals */
-		mp = mpolys;
-		for (i = 0; i < numPolys; i++, mp++) {
-			BKE_mesh_calc_poly_normal(mp, mloop + mp->loopstart, mverts, pnors[i]);
-		}
+		BKE_mesh_calc_normals_poly(mverts, numVerts, mloop, mpolys, numLoops, numPolys, pnors, true);
 	}
 
 	if (origIndexFace &&
@@ -161,8 +158,68 @@ void BKE_mesh_calc_normals_mapping_ex(
 	
 }
 
-static void mesh_calc_normals_poly_accum(MPoly *mp, MLoop *ml,
-                                         MVert *mvert, float polyno[3], float (*tnorms)[3])
+/* Number of polys (or verts) handled by a single task. */
+#define MESH_NORMALS_TASK_BATCH 1024
+
+typedef struct MeshCalcNormalsData {
+	MVert *mverts;
+	MLoop *mloop;
+	MPoly *mpolys;
+	float (*pnors)[3];
+	/* angle weighted poly normal of each loop, summed into the vertex normals */
+	float (*lnors_weighted)[3];
+	float (*vnors)[3];
+	int totelem;
+} MeshCalcNormalsData;
+
+typedef void (*MeshCalcNormalsBatchFunc)(MeshCalcNormalsData *data, const int start, const int end);
+
+typedef struct MeshCalcNormalsBatches {
+	MeshCalcNormalsData *data;
+	MeshCalcNormalsBatchFunc func;
+} MeshCalcNormalsBatches;
+
+static void mesh_calc_normals_batch_task(void *userdata, int batch)
+{
+	MeshCalcNormalsBatches *batches = userdata;
+	const int start = batch * MESH_NORMALS_TASK_BATCH;
+	const int end = min_ii(start + MESH_NORMALS_TASK_BATCH, batches->data->totelem);
+
+	batches->func(batches->data, start, end);
+}
+
+/* Run \a func over [0, totelem) in batches, threaded when there is enough work. */
+static void mesh_calc_normals_parallel(MeshCalcNormalsData *data, const int totelem, MeshCalcNormalsBatchFunc func)
+{
+	const int totbatch = (totelem + MESH_NORMALS_TASK_BATCH - 1) / MESH_NORMALS_TASK_BATCH;
+	MeshCalcNormalsBatches batches;
+
+	data->totelem = totelem;
+
+	if (totelem <= BKE_MESH_OMP_LIMIT || totbatch < 2) {
+		func(data, 0, totelem);
+		return;
+	}
+
+	batches.data = data;
+	batches.func = func;
+	BLI_task_parallel_range_ex(0, totbatch, &batches, mesh_calc_normals_batch_task, 2);
+}
+
+static void mesh_calc_normals_poly_faces(MeshCalcNormalsData *data, const int start, const int end)
+{
+	int i;
+
+	for (i = start; i < end; i++) {
+		MPoly *mp = &data->mpolys[i];
+		BKE_mesh_calc_poly_normal(mp, data->mloop + mp->loopstart, data->mverts, data->pnors[i]);
+	}
+}
+
+/* in a function of its own, so the alloca'd edge vectors are released for each poly */
+static void mesh_calc_normals_poly_accum(
+        const MPoly *mp, const MLoop *ml,
+        const MVert *mvert, float polyno[3], float (*lnors_weighted)[3])
 {
 	const int nverts = mp->totloop;
 	float (*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)nverts);
@@ -193,7 +250,7 @@ static void mesh_calc_normals_poly_accum(MPoly *mp, MLoop *ml,
 		}
 	}
 
-	/* accumulate angle weighted face normal */
+	/* angle weighted face normal of each corner */
 	/* inline version of #accumulate_vertex_normals_poly */
 	{
 		const float *prev_edge = edgevecbuf[nverts - 1];
@@ -205,54 +262,34 @@ static void mesh_calc_normals_poly_accum(MPoly *mp, MLoop *ml,
 			 * this vertex */
 			const float fac = saacos(-dot_v3v3(cur_edge, prev_edge));
 
-			/* accumulate */
-			madd_v3_v3fl(tnorms[ml[i].v], polyno, fac);
+			mul_v3_v3fl(lnors_weighted[i], polyno, fac);
 			prev_edge = cur_edge;
 		}
 	}
-
 }
 
-void BKE_mesh_calc_normals_poly(MVert *mverts, int numVerts, MLoop *mloop, MPoly *mpolys,
-                                int UNUSED(numLoops), int numPolys, float (*r_polynors)[3],
-                                const bool only_face_normals)
+static void mesh_calc_normals_poly_prepare(MeshCalcNormalsData *data, const int start, const int end)
 {
-	float (*pnors)[3] = r_polynors;
-	float (*tnorms)[3];
-	int i;
-	MPoly *mp;
+	int p;
 
-	if (only_face_normals) {
-		BLI_assert(pnors != NULL);
+	for (p = start; p < end; p++) {
+		const MPoly *mp = &data->mpolys[p];
+		float tpnor[3];  /* temp poly normal */
 
-#pragma omp parallel for if (numPolys > BKE_MESH_OMP_LIMIT)
-		for (i = 0; i < numPolys; i++) {
-			BKE_mesh_calc_poly_normal(&mpolys[i], mloop + mpolys[i].loopstart, mverts, pnors[i]);
-		}
-		return;
+		mesh_calc_normals_poly_accum(mp, data->mloop + mp->loopstart, data->mverts,
+		                             data->pnors ? data->pnors[p] : tpnor,
+		                             data->lnors_weighted + mp->loopstart);
 	}
+}
 
-	/* first go through and calculate normals for all the polys */
-	tnorms = MEM_callocN(sizeof(*tnorms) * (size_t)numVerts, __func__);
-
-	if (pnors) {
-		mp = mpolys;
-		for (i = 0; i < numPolys; i++, mp++) {
-			mesh_calc_normals_poly_accum(mp, mloop + mp->loopstart, mverts, pnors[i], tnorms);
-		}
-	}
-	else {
-		float tpnor[3];  /* temp poly normal */
-		mp = mpolys;
-		for (i = 0; i < numPolys; i++, mp++) {
-			mesh_calc_normals_poly_accum(mp, mloop + mp->loopstart, mverts, tpnor, tnorms);
-		}
-	}
+static void mesh_calc_normals_poly_finalize(MeshCalcNormalsData *data, const int start, const int end)
+{
+	int i;
 
 	/* following Mesh convention; we use vertex coordinate itself for normal in this case */
-	for (i = 0; i < numVerts; i++) {
-		MVert *mv = &mverts[i];
-		float *no = tnorms[i];
+	for (i = start; i < end; i++) {
+		MVert *mv = &data->mverts[i];
+		float *no = data->vnors[i];
 
 		if (UNLIKELY(normalize_v3(no) == 0.0f)) {
 			normalize_v3_v3(no, mv->co);
@@ -260,8 +297,46 @@ void BKE_mesh_calc_normals_poly(MVert *mverts, int numVerts, MLoop *mloop, MPoly
 
 		normal_float_to_short_v3(mv->no, no);
 	}
+}
 
-	MEM_freeN(tnorms);
+void BKE_mesh_calc_normals_poly(MVert *mverts, int numVerts, MLoop *mloop, MPoly *mpolys,
+                                int numLoops, int numPolys, float (*r_polynors)[3],
+                                const bool only_face_normals)
+{
+	MeshCalcNormalsData data;
+	int i;
+
+	data.mverts = mverts;
+	data.mloop = mloop;
+	data.mpolys = mpolys;
+	data.pnors = r_polynors;
+	data.lnors_weighted = NULL;
+	data.vnors = NULL;
+
+	if (only_face_normals) {
+		BLI_assert(r_polynors != NULL);
+
+		mesh_calc_normals_parallel(&data, numPolys, mesh_calc_normals_poly_faces);
+		return;
+	}
+
+	/* first go through and calculate normals for all the polys,
+	 * along with the weighted normal of each of their corners */
+	data.lnors_weighted = MEM_mallocN(sizeof(*data.lnors_weighted) * (size_t)numLoops, __func__);
+	data.vnors = MEM_callocN(sizeof(*data.vnors) * (size_t)numVerts, __func__);
+
+	mesh_calc_normals_parallel(&data, numPolys, mesh_calc_normals_poly_prepare);
+
+	/* gather the corners into their verts, serial so no atomics are needed,
+	 * all the expensive work was done per poly above */
+	for (i = 0; i < numLoops; i++) {
+		add_v3_v3(data.vnors[mloop[i].v], data.lnors_weighted[i]);
+	}
+
+	mesh_calc_normals_parallel(&data, numVerts, mesh_calc_normals_poly_finalize);
+
+	MEM_freeN(data.lnors_weighted);
+	MEM_freeN(data.vnors);
 }
 
 void BKE_mesh_calc_normals(Mesh *mesh)
@@ -1378,217 +1453,300 @@ void BKE_mesh_loops_to_tessdata(CustomData *fdata, CustomData *ldata, CustomData
 	}
 }
 
-/**
- * Recreate tessellation.
- *
- * \param do_face_nor_copy controls whether the normals from the poly are copied to the tessellated faces.
- *
- * \return number of tessellation faces.
- */
-int BKE_mesh_recalc_tessellation(CustomData *fdata, CustomData *ldata, CustomData *pdata,
-                                 MVert *mvert, int totface, int totloop, int totpoly, const bool do_face_nor_cpy)
-{
-	/* use this to avoid locking pthread for _every_ polygon
-	 * and calling the fill function */
-
+/* use this to avoid locking pthread for _every_ polygon
+ * and calling the fill function */
 #define USE_TESSFACE_SPEEDUP
 #define USE_TESSFACE_QUADS  /* NEEDS FURTHER TESTING */
 
 /* We abuse MFace->edcode to tag quad faces. See below for details. */
 #define TESSFACE_IS_QUAD 1
 
-	const int looptris_tot = poly_to_tri_count(totpoly, totloop);
+/* Number of polys tessellated by a single task. */
+#define TESSELLATION_TASK_BATCH 1024
 
-	MPoly *mp, *mpoly;
-	MLoop *ml, *mloop;
-	MFace *mface, *mf;
-	MemArena *arena = NULL;
+typedef struct MeshTessellationData {
+	MVert *mvert;
+	MLoop *mloop;
+	MPoly *mpoly;
+	int totpoly;
+	/* index of the first tessellation face of each poly */
+	const int *poly_face_offset;
+	MFace *mface;
 	int *mface_to_poly_map;
 	unsigned int (*lindices)[4];
-	int poly_index, mface_index;
-	unsigned int j;
+} MeshTessellationData;
 
-	mpoly = CustomData_get_layer(pdata, CD_MPOLY);
-	mloop = CustomData_get_layer(ldata, CD_MLOOP);
+/* Number of tessellation faces a poly is split into, must match #mesh_recalc_tessellation_poly. */
+BLI_INLINE int mesh_tessellation_poly_face_count(const MPoly *mp)
+{
+	if (mp->totloop < 3) {
+		return 0;
+	}
+#ifdef USE_TESSFACE_SPEEDUP
+#ifdef USE_TESSFACE_QUADS
+	else if (mp->totloop == 4) {
+		return 1;
+	}
+#endif
+#endif
+	return mp->totloop - 2;
+}
 
-	/* allocate the length of totfaces, avoid many small reallocs,
-	 * if all faces are tri's it will be correct, quads == 2x allocs */
-	/* take care. we are _not_ calloc'ing so be sure to initialize each field */
-	mface_to_poly_map = MEM_mallocN(sizeof(*mface_to_poly_map) * (size_t)looptris_tot, __func__);
-	mface             = MEM_mallocN(sizeof(*mface) *             (size_t)looptris_tot, __func__);
-	lindices          = MEM_mallocN(sizeof(*lindices) *          (size_t)looptris_tot, __func__);
+static void mesh_recalc_tessellation_poly(
+        MeshTessellationData *data, const int poly_index, MemArena **r_arena)
+{
+	MVert *mvert = data->mvert;
+	MLoop *ml, *mloop = data->mloop;
+	MPoly *mp = &data->mpoly[poly_index];
+	MFace *mf, *mface = data->mface;
+	int *mface_to_poly_map = data->mface_to_poly_map;
+	unsigned int (*lindices)[4] = data->lindices;
+	int mface_index = data->poly_face_offset[poly_index];
+	const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
+	const unsigned int mp_totloop = (unsigned int)mp->totloop;
+	unsigned int l1, l2, l3, l4;
+	unsigned int *lidx;
+	unsigned int j;
 
-	mface_index = 0;
-	mp = mpoly;
-	for (poly_index = 0; poly_index < totpoly; poly_index++, mp++) {
-		const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
-		const unsigned int mp_totloop = (unsigned int)mp->totloop;
-		unsigned int l1, l2, l3, l4;
-		unsigned int *lidx;
-		if (mp_totloop < 3) {
-			/* do nothing */
-		}
+	if (mp_totloop < 3) {
+		/* do nothing */
+	}
 
 #ifdef USE_TESSFACE_SPEEDUP
 
 #define ML_TO_MF(i1, i2, i3)                                                  \
-		mface_to_poly_map[mface_index] = poly_index;                          \
-		mf = &mface[mface_index];                                             \
-		lidx = lindices[mface_index];                                         \
-		/* set loop indices, transformed to vert indices later */             \
-		l1 = mp_loopstart + i1;                                               \
-		l2 = mp_loopstart + i2;                                               \
-		l3 = mp_loopstart + i3;                                               \
-		mf->v1 = mloop[l1].v;                                                 \
-		mf->v2 = mloop[l2].v;                                                 \
-		mf->v3 = mloop[l3].v;                                                 \
-		mf->v4 = 0;                                                           \
-		lidx[0] = l1;                                                         \
-		lidx[1] = l2;                                                         \
-		lidx[2] = l3;                                                         \
-		lidx[3] = 0;                                                          \
-		mf->mat_nr = mp->mat_nr;                                              \
-		mf->flag = mp->flag;                                                  \
-		mf->edcode = 0;                                                       \
-		(void)0
+	mface_to_poly_map[mface_index] = poly_index;                              \
+	mf = &mface[mface_index];                                                 \
+	lidx = lindices[mface_index];                                             \
+	/* set loop indices, transformed to vert indices later */                 \
+	l1 = mp_loopstart + i1;                                                   \
+	l2 = mp_loopstart + i2;                                                   \
+	l3 = mp_loopstart + i3;                                                   \
+	mf->v1 = mloop[l1].v;                                                     \
+	mf->v2 = mloop[l2].v;                                                     \
+	mf->v3 = mloop[l3].v;                                                     \
+	mf->v4 = 0;                                                               \
+	lidx[0] = l1;                                                             \
+	lidx[1] = l2;                                                             \
+	lidx[2] = l3;                                                             \
+	lidx[3] = 0;                                                              \
+	mf->mat_nr = mp->mat_nr;                                                  \
+	mf->flag = mp->flag;                                                      \
+	mf->edcode = 0;                                                           \
+	(void)0
 
 /* ALMOST IDENTICAL TO DEFINE ABOVE (see EXCEPTION) */
 #define ML_TO_MF_QUAD()                                                       \
-		mface_to_poly_map[mface_index] = poly_index;                          \
-		mf = &mface[mface_index];                                             \
-		lidx = lindices[mface_index];                                         \
-		/* set loop indices, transformed to vert indices later */             \
-		l1 = mp_loopstart + 0; /* EXCEPTION */                                \
-		l2 = mp_loopstart + 1; /* EXCEPTION */                                \
-		l3 = mp_loopstart + 2; /* EXCEPTION */                                \
-		l4 = mp_loopstart + 3; /* EXCEPTION */                                \
-		mf->v1 = mloop[l1].v;                                                 \
-		mf->v2 = mloop[l2].v;                                                 \
-		mf->v3 = mloop[l3].v;                                                 \
-		mf->v4 = mloop[l4].v;                                                 \
-		lidx[0] = l1;                                                         \
-		lidx[1] = l2;                                                         \
-		lidx[2] = l3;                                                         \
-		lidx[3] = l4;                                                         \
-		mf->mat_nr = mp->mat_nr;                                              \
-		mf->flag = mp->flag;                                                  \
-		mf->edcode = TESSFACE_IS_QUAD;                                        \
-		(void)0
-
-
-		else if (mp_totloop == 3) {
-			ML_TO_MF(0, 1, 2);
-			mface_index++;
-		}
-		else if (mp_totloop == 4) {
+	mface_to_poly_map[mface_index] = poly_index;                              \
+	mf = &mface[mface_index];                                                 \
+	lidx = lindices[mface_index];                                             \
+	/* set loop indices, transformed to vert indices later */                 \
+	l1 = mp_loopstart + 0; /* EXCEPTION */                                    \
+	l2 = mp_loopstart + 1; /* EXCEPTION */                                    \
+	l3 = mp_loopstart + 2; /* EXCEPTION */                                    \
+	l4 = mp_loopstart + 3; /* EXCEPTION */                                    \
+	mf->v1 = mloop[l1].v;                                                     \
+	mf->v2 = mloop[l2].v;                                                     \
+	mf->v3 = mloop[l3].v;                                                     \
+	mf->v4 = mloop[l4].v;                                                     \
+	lidx[0] = l1;                                                             \
+	lidx[1] = l2;                                                             \
+	lidx[2] = l3;                                                             \
+	lidx[3] = l4;                                                             \
+	mf->mat_nr = mp->mat_nr;                                                  \
+	mf->flag = mp->flag;                                                      \
+	mf->edcode = TESSFACE_IS_QUAD;                                            \
+	(void)0
+
+
+	else if (mp_totloop == 3) {
+		ML_TO_MF(0, 1, 2);
+		mface_index++;
+	}
+	else if (mp_totloop == 4) {
 #ifdef USE_TESSFACE_QUADS
-			ML_TO_MF_QUAD();
-			mface_index++;
+		ML_TO_MF_QUAD();
+		mface_index++;
 #else
-			ML_TO_MF(0, 1, 2);
-			mface_index++;
-			ML_TO_MF(0, 2, 3);
-			mface_index++;
+		ML_TO_MF(0, 1, 2);
+		mface_index++;
+		ML_TO_MF(0, 2, 3);
+		mface_index++;
 #endif
-		}
+	}
 #endif /* USE_TESSFACE_SPEEDUP */
-		else {
-			const float *co_curr, *co_prev;
+	else {
+		const float *co_curr, *co_prev;
 
-			float normal[3];
+		float normal[3];
 
-			float axis_mat[3][3];
-			float (*projverts)[2];
-			unsigned int (*tris)[3];
+		float axis_mat[3][3];
+		float (*projverts)[2];
+		unsigned int (*tris)[3];
 
-			const unsigned int totfilltri = mp_totloop - 2;
+		const unsigned int totfilltri = mp_totloop - 2;
 
-			if (UNLIKELY(arena == NULL)) {
-				arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
-			}
+		MemArena *arena = *r_arena;
 
-			tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
-			projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
+		if (UNLIKELY(arena == NULL)) {
+			arena = *r_arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+		}
 
-			zero_v3(normal);
+		tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
+		projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
 
-			/* calc normal */
-			ml = mloop + mp_loopstart;
-			co_prev = mvert[ml[mp_totloop - 1].v].co;
-			for (j = 0; j < mp_totloop; j++, ml++) {
-				co_curr = mvert[ml->v].co;
-				add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
-				co_prev = co_curr;
-			}
-			if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
-				normal[2] = 1.0f;
-			}
+		zero_v3(normal);
 
-			/* project verts to 2d */
-			axis_dominant_v3_to_m3(axis_mat, normal);
+		/* calc normal */
+		ml = mloop + mp_loopstart;
+		co_prev = mvert[ml[mp_totloop - 1].v].co;
+		for (j = 0; j < mp_totloop; j++, ml++) {
+			co_curr = mvert[ml->v].co;
+			add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
+			co_prev = co_curr;
+		}
+		if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
+			normal[2] = 1.0f;
+		}
 
-			ml = mloop + mp_loopstart;
-			for (j = 0; j < mp_totloop; j++, ml++) {
-				mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
-			}
+		/* project verts to 2d */
+		axis_dominant_v3_to_m3(axis_mat, normal);
 
-			BLI_polyfill_calc_arena((const float (*)[2])projverts, mp_totloop, -1, tris, arena);
+		ml = mloop + mp_loopstart;
+		for (j = 0; j < mp_totloop; j++, ml++) {
+			mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
+		}
 
-			/* apply fill */
-			for (j = 0; j < totfilltri; j++) {
-				unsigned int *tri = tris[j];
-				lidx = lindices[mface_index];
+		BLI_polyfill_calc_arena((const float (*)[2])projverts, mp_totloop, -1, tris, arena);
 
-				mface_to_poly_map[mface_index] = poly_index;
-				mf = &mface[mface_index];
+		/* apply fill */
+		for (j = 0; j < totfilltri; j++) {
+			unsigned int *tri = tris[j];
+			lidx = lindices[mface_index];
 
-				/* set loop indices, transformed to vert indices later */
-				l1 = mp_loopstart + tri[0];
-				l2 = mp_loopstart + tri[1];
-				l3 = mp_loopstart + tri[2];
+			mface_to_poly_map[mface_index] = poly_index;
+			mf = &mface[mface_index];
 
-				/* sort loop indices to ensure winding is correct */
-				if (l1 > l2) SWAP(unsigned int, l1, l2);
-				if (l2 > l3) SWAP(unsigned int, l2, l3);
-				if (l1 > l2) SWAP(unsigned int, l1, l2);
+			/* set loop indices, transformed to vert indices later */
+			l1 = mp_loopstart + tri[0];
+			l2 = mp_loopstart + tri[1];
+			l3 = mp_loopstart + tri[2];
 
-				mf->v1 = mloop[l1].v;
-				mf->v2 = mloop[l2].v;
-				mf->v3 = mloop[l3].v;
-				mf->v4 = 0;
+			/* sort loop indices to ensure winding is correct */
+			if (l1 > l2) SWAP(unsigned int, l1, l2);
+			if (l2 > l3) SWAP(unsigned int, l2, l3);
+			if (l1 > l2) SWAP(unsigned int, l1, l2);
 
-				lidx[0] = l1;
-				lidx[1] = l2;
-				lidx[2] = l3;
-				lidx[3] = 0;
+			mf->v1 = mloop[l1].v;
+			mf->v2 = mloop[l2].v;
+			mf->v3 = mloop[l3].v;
+			mf->v4 = 0;
 
-				mf->mat_nr = mp->mat_nr;
-				mf->flag = mp->flag;
-				mf->edcode = 0;
+			lidx[0] = l1;
+			lidx[1] = l2;
+			lidx[2] = l3;
+			lidx[3] = 0;
 
-				mface_index++;
-			}
+			mf->mat_nr = mp->mat_nr;
+			mf->flag = mp->flag;
+			mf->edcode = 0;
 
-			BLI_memarena_clear(arena);
+			mface_index++;
 		}
+
+		BLI_memarena_clear(arena);
+	}
+
+	BLI_assert(mface_index == data->poly_face_offset[poly_index] + mesh_tessellation_poly_face_count(mp));
+
+#undef ML_TO_MF
+#undef ML_TO_MF_QUAD
+}
+
+static void mesh_recalc_tessellation_task(void *userdata, int batch)
+{
+	MeshTessellationData *data = userdata;
+	const int start = batch * TESSELLATION_TASK_BATCH;
+	const int end = min_ii(start + TESSELLATION_TASK_BATCH, data->totpoly);
+	MemArena *arena = NULL;
+	int poly_index;
+
+	for (poly_index = start; poly_index < end; poly_index++) {
+		mesh_recalc_tessellation_poly(data, poly_index, &arena);
 	}
 
 	if (arena) {
 		BLI_memarena_free(arena);
-		arena = NULL;
+	}
+}
+
+/**
+ * Recreate tessellation.
+ *
+ * \param do_face_nor_copy controls whether the normals from the poly are copied to the tessellated faces.
+ *
+ * \return number of tessellation faces.
+ *
+ * Each poly knows where its faces start from a prefix sum of the face counts,
+ * so the polys are tessellated in parallel.
+ */
+int BKE_mesh_recalc_tessellation(CustomData *fdata, CustomData *ldata, CustomData *pdata,
+                                 MVert *mvert, int totface, int UNUSED(totloop), int totpoly, const bool do_face_nor_cpy)
+{
+	MeshTessellationData data;
+	MPoly *mp, *mpoly;
+	MLoop *mloop;
+	MFace *mface, *mf;
+	int *mface_to_poly_map;
+	int *poly_face_offset;
+	unsigned int (*lindices)[4];
+	int poly_index, mface_index;
+
+	mpoly = CustomData_get_layer(pdata, CD_MPOLY);
+	mloop = CustomData_get_layer(ldata, CD_MLOOP);
+
+	/* count the faces first, so each poly knows where to write its own */
+	poly_face_offset = MEM_mallocN(sizeof(*poly_face_offset) * (size_t)max_ii(totpoly, 1), __func__);
+	mface_index = 0;
+	mp = mpoly;
+	for (poly_index = 0; poly_index < totpoly; poly_index++, mp++) {
+		poly_face_offset[poly_index] = mface_index;
+		mface_index += mesh_tessellation_poly_face_count(mp);
 	}
 
 	CustomData_free(fdata, totface);
 	totface = mface_index;
 
-	BLI_assert(totface <= looptris_tot);
-
-	/* not essential but without this we store over-alloc'd memory in the CustomData layers */
-	if (LIKELY(looptris_tot != totface)) {
-		mface = MEM_reallocN(mface, sizeof(*mface) * (size_t)totface);
-		mface_to_poly_map = MEM_reallocN(mface_to_poly_map, sizeof(*mface_to_poly_map) * (size_t)totface);
+	/* take care. we are _not_ calloc'ing so be sure to initialize each field */
+	mface_to_poly_map = MEM_mallocN(sizeof(*mface_to_poly_map) * (size_t)totface, __func__);
+	mface             = MEM_mallocN(sizeof(*mface) *             (size_t)totface, __func__);
+	lindices          = MEM_mallocN(sizeof(*lindices) *          (size_t)totface, __func__);
+
+	data.mvert = mvert;
+	data.mloop = mloop;
+	data.mpoly = mpoly;
+	data.totpoly = totpoly;
+	data.poly_face_offset = poly_face_offset;
+	data.mface = mface;
+	data.mface_to_poly_map = mface_to_poly_map;
+	data.lindices = lindices;
+
+	if (totpoly > 0) {
+		const int totbatch = (totpoly + TESSELLATION_TASK_BATCH - 1) / TESSELLATION_TASK_BATCH;
+
+		if (totpoly <= BKE_MESH_OMP_LIMIT || totbatch < 2) {
+			int batch;
+			for (batch = 0; batch < totbatch; batch++) {
+				mesh_recalc_tessellation_task(&data, batch);
+			}
+		}
+		else {
+			BLI_task_parallel_range_ex(0, totbatch, &data, mesh_recalc_tessellation_task, 2);
+		}
 	}
 
+	MEM_freeN(poly_face_offset);
+
 	CustomData_add_layer(fdata, CD_MFACE, CD_ASSIGN, mface, totface);
 
 	/* CD_ORIGINDEX will contain an array of indices from tessfaces to the polygons
@@ -1634,14 +1792,11 @@ int BKE_mesh_recalc_tessellation(CustomData *fdata, CustomData *ldata, CustomDat
 	MEM_freeN(lindices);
 
 	return totface;
+}
 
 #undef USE_TESSFACE_SPEEDUP
 #undef USE_TESSFACE_QUADS
-
-#undef ML_TO_MF
-#undef ML_TO_MF_QUAD
-
-}
+#undef TESSFACE_IS_QUAD
 
 #ifdef USE_BMESH_SAVE_AS_COMPAT
 
@@ -139,6 +139,7 @@ void modifier_free(ModifierData *md)
 
 	if (mti->freeData) mti->freeData(md);
 	if (md->error) MEM_freeN(md->error);
+	modifier_freeCheckpoint(md);
 
 	MEM_freeN(md);
 }
@@ -663,6 +664,15 @@ bool modifiers_isPreview(Object *ob)
 	return false;
 }
 
+void modifier_freeCheckpoint(ModifierData *md)
+{
+	if (md->checkpoint) {
+		md->checkpoint->dm->release(md->checkpoint->dm);
+		MEM_freeN(md->checkpoint);
+		md->checkpoint = NULL;
+	}
+}
+
 void modifier_freeTemporaryData(ModifierData *md)
 {
 	if (md->type == eModifierType_Armature) {
@@ -39,6 +39,7 @@
 #include "IMB_imbuf_types.h"
 
 #include "BLI_listbase.h"
+#include "BLI_threads.h"
 
 #include "BKE_sequencer.h"
 
@@ -67,7 +68,11 @@ typedef struct SeqPreprocessCache {
 static struct MovieCache *moviecache = NULL;
 static struct SeqPreprocessCache *preprocess_cache = NULL;
 
+/* strips of a stack can be rendered from several threads, see seq_render_strip_stack_inputs() */
+static ThreadMutex cache_lock = BLI_MUTEX_INITIALIZER;
+
 static void preprocessed_cache_destruct(void);
+static void preprocessed_cache_free_elems(void);
 
 static bool seq_cmp_render_data(const SeqRenderData *a, const SeqRenderData *b)
 {
@@ -118,20 +123,32 @@ static bool seqcache_hashcmp(const void *a_, const void *b_)
 
 void BKE_sequencer_cache_destruct(void)
 {
+	BKE_sequencer_prefetch_stop();
+
+	BLI_mutex_lock(&cache_lock);
+
 	if (moviecache)
 		IMB_moviecache_free(moviecache);
 
 	preprocessed_cache_destruct();
+
+	BLI_mutex_unlock(&cache_lock);
 }
 
 void BKE_sequencer_cache_cleanup(void)
 {
+	BKE_sequencer_prefetch_stop();
+
+	BLI_mutex_lock(&cache_lock);
+
 	if (moviecache) {
 		IMB_moviecache_free(moviecache);
 		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
 	}
 
-	BKE_sequencer_preprocessed_cache_cleanup();
+	preprocessed_cache_free_elems();
+
+	BLI_mutex_unlock(&cache_lock);
 }
 
 static bool seqcache_key_check_seq(ImBuf *UNUSED(ibuf), void *userkey, void *userdata)
@@ -144,13 +161,19 @@ static bool seqcache_key_check_seq(ImBuf *UNUSED(ibuf), void *userkey, void *use
 
 void BKE_sequencer_cache_cleanup_sequence(Sequence *seq)
 {
+	BKE_sequencer_prefetch_stop();
+
+	BLI_mutex_lock(&cache_lock);
 	if (moviecache)
 		IMB_moviecache_cleanup(moviecache, seqcache_key_check_seq, seq);
+	BLI_mutex_unlock(&cache_lock);
 }
 
 struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context, Sequence *seq, float cfra, seq_stripelem_ibuf_t type)
 {
-	if (moviecache && seq) {
+	ImBuf *ibuf = NULL;
+
+	if (seq) {
 		SeqCacheKey key;
 
 		key.seq = seq;
@@ -158,10 +181,13 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context, Sequence *se
 		key.cfra = cfra - seq->start;
 		key.type = type;
 
-		return IMB_moviecache_get(moviecache, &key);
+		BLI_mutex_lock(&cache_lock);
+		if (moviecache)
+			ibuf = IMB_moviecache_get(moviecache, &key);
+		BLI_mutex_unlock(&cache_lock);
 	}
 
-	return NULL;
+	return ibuf;
 }
 
 void BKE_sequencer_cache_put(const SeqRenderData *context, Sequence *seq, float cfra, seq_stripelem_ibuf_t type, ImBuf *i)
@@ -172,19 +198,23 @@ void BKE_sequencer_cache_put(const SeqRenderData *context, Sequence *seq, float
 		return;
 	}
 
-	if (!moviecache) {
-		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
-	}
-
 	key.seq = seq;
 	key.context = *context;
 	key.cfra = cfra - seq->start;
 	key.type = type;
 
+	BLI_mutex_lock(&cache_lock);
+
+	if (!moviecache) {
+		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
+	}
+
 	IMB_moviecache_put(moviecache, &key, i);
+
+	BLI_mutex_unlock(&cache_lock);
 }
 
-void BKE_sequencer_preprocessed_cache_cleanup(void)
+static void preprocessed_cache_free_elems(void)
 {
 	SeqPreprocessCacheElem *elem;
 
@@ -199,12 +229,19 @@ void BKE_sequencer_preprocessed_cache_cleanup(void)
 	BLI_listbase_clear(&preprocess_cache->elems);
 }
 
+void BKE_sequencer_preprocessed_cache_cleanup(void)
+{
+	BLI_mutex_lock(&cache_lock);
+	preprocessed_cache_free_elems();
+	BLI_mutex_unlock(&cache_lock);
+}
+
 static void preprocessed_cache_destruct(void)
 {
 	if (!preprocess_cache)
 		return;
 
-	BKE_sequencer_preprocessed_cache_cleanup();
+	preprocessed_cache_free_elems();
 
 	MEM_freeN(preprocess_cache);
 	preprocess_cache = NULL;
@@ -213,40 +250,44 @@ static void preprocessed_cache_destruct(void)
 ImBuf *BKE_sequencer_preprocessed_cache_get(const SeqRenderData *context, Sequence *seq, float cfra, seq_stripelem_ibuf_t type)
 {
 	SeqPreprocessCacheElem *elem;
+	ImBuf *ibuf = NULL;
 
-	if (!preprocess_cache)
-		return NULL;
-
-	if (preprocess_cache->cfra != cfra)
-		return NULL;
+	BLI_mutex_lock(&cache_lock);
 
-	for (elem = preprocess_cache->elems.first; elem; elem = elem->next) {
-		if (elem->seq != seq)
-			continue;
+	if (preprocess_cache && preprocess_cache->cfra == cfra) {
+		for (elem = preprocess_cache->elems.first; elem; elem = elem->next) {
+			if (elem->seq != seq)
+				continue;
 
-		if (elem->type != type)
-			continue;
+			if (elem->type != type)
+				continue;
 
-		if (seq_cmp_render_data(&elem->context, context) != 0)
-			continue;
+			if (seq_cmp_render_data(&elem->context, context) != 0)
+				continue;
 
-		IMB_refImBuf(elem->ibuf);
-		return elem->ibuf;
+			IMB_refImBuf(elem->ibuf);
+			ibuf = elem->ibuf;
+			break;
+		}
 	}
 
-	return NULL;
+	BLI_mutex_unlock(&cache_lock);
+
+	return ibuf;
 }
 
 void BKE_sequencer_preprocessed_cache_put(const SeqRenderData *context, Sequence *seq, float cfra, seq_stripelem_ibuf_t type, ImBuf *ibuf)
 {
 	SeqPreprocessCacheElem *elem;
 
+	BLI_mutex_lock(&cache_lock);
+
 	if (!preprocess_cache) {
 		preprocess_cache = MEM_callocN(sizeof(SeqPreprocessCache), "sequencer preprocessed cache");
 	}
 	else {
 		if (preprocess_cache->cfra != cfra)
-			BKE_sequencer_preprocessed_cache_cleanup();
+			preprocessed_cache_free_elems();
 	}
 
 	elem = MEM_callocN(sizeof(SeqPreprocessCacheElem), "sequencer preprocessed cache element");
@@ -261,22 +302,29 @@ void BKE_sequencer_preprocessed_cache_put(const SeqRenderData *context, Sequence
 	IMB_refImBuf(ibuf);
 
 	BLI_addtail(&preprocess_cache->elems, elem);
+
+	BLI_mutex_unlock(&cache_lock);
 }
 
 void BKE_sequencer_preprocessed_cache_cleanup_sequence(Sequence *seq)
 {
 	SeqPreprocessCacheElem *elem, *elem_next;
 
-	if (!preprocess_cache)
-		return;
+	BKE_sequencer_prefetch_stop();
 
-	for (elem = preprocess_cache->elems.first; elem; elem = elem_next) {
-		elem_next = elem->next;
+	BLI_mutex_lock(&cache_lock);
 
-		if (elem->seq == seq) {
-			IMB_freeImBuf(elem->ibuf);
+	if (preprocess_cache) {
+		for (elem = preprocess_cache->elems.first; elem; elem = elem_next) {
+			elem_next = elem->next;
 
-			BLI_freelinkN(&preprocess_cache->elems, elem);
+			if (elem->seq == seq) {
+				IMB_freeImBuf(elem->ibuf);
+
+				BLI_freelinkN(&preprocess_cache->elems, elem);
+			}
 		}
 	}
+
+	BLI_mutex_unlock(&cache_lock);
 }
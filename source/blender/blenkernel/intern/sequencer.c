@@ -50,6 +50,7 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utf8.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -177,6 +178,9 @@ static void seq_free_strip(Strip *strip)
 /* only give option to skip cache locally (static func) */
 static void BKE_sequence_free_ex(Scene *scene, Sequence *seq, const bool do_cache)
 {
+	/* the prefetch worker may be rendering this strip */
+	BKE_sequencer_prefetch_stop();
+
 	if (seq->strip)
 		seq_free_strip(seq->strip);
 
@@ -896,6 +900,8 @@ void BKE_sequencer_sort(Scene *scene)
 	if (ed == NULL)
 		return;
 
+	BKE_sequencer_prefetch_stop();
+
 	BLI_listbase_clear(&seqbase);
 	BLI_listbase_clear(&effbase);
 
@@ -1630,6 +1636,13 @@ void BKE_sequencer_proxy_rebuild_finish(SeqIndexBuildContext *context, bool stop
 	MEM_freeN(context);
 }
 
+/* movies are indexed from a file and decoder of their own, other strips
+ * are rendered through the sequencer, which can't run from several threads */
+bool BKE_sequencer_proxy_rebuild_supports_threads(SeqIndexBuildContext *context)
+{
+	return context->seq->type == SEQ_TYPE_MOVIE;
+}
+
 /*********************** color balance *************************/
 
 static StripColorBalance calc_cb(StripColorBalance *cb_)
@@ -2944,9 +2957,118 @@ static ImBuf *seq_render_strip_stack_apply_effect(const SeqRenderData *context,
 	return out;
 }
 
+typedef struct RenderStripTask {
+	const SeqRenderData *context;
+	Sequence *seq;
+	float cfra;
+	ImBuf *ibuf;
+} RenderStripTask;
+
+static void seq_render_strip_task(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	RenderStripTask *task = taskdata;
+
+	task->ibuf = seq_render_strip(task->context, task->seq, task->cfra);
+}
+
+/* image and movie strips only read their own files, so they can be loaded and
+ * preprocessed at the same time, other types render inputs or whole scenes */
+static bool seq_render_strip_is_independent(Sequence *seq)
+{
+	SequenceModifierData *smd;
+
+	if (!ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE)) {
+		return false;
+	}
+
+	/* a mask strip is rendered by the modifier, it may be another input of the stack */
+	for (smd = seq->modifiers.first; smd; smd = smd->next) {
+		if (smd->mask_input_type == SEQUENCE_MASK_INPUT_STRIP && smd->mask_sequence) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Render the strips blending the stack will need in parallel, one task per strip.
+ * Follows the same early out logic as seq_render_strip_stack(), strips which
+ * aren't rendered here are left NULL in ibuf_arr and rendered when blending. */
+static void seq_render_strip_stack_inputs(const SeqRenderData *context, Sequence **seq_arr, int count,
+                                          float cfra, ImBuf **ibuf_arr)
+{
+	RenderStripTask tasks[MAXSEQ + 1];
+	int task_index[MAXSEQ + 1];
+	int tot_task = 0;
+	int i;
+
+	for (i = count - 1; i >= 0; i--) {
+		Sequence *seq = seq_arr[i];
+		ImBuf *ibuf_comp;
+		int early_out;
+
+		ibuf_comp = BKE_sequencer_cache_get(context, seq, cfra, SEQ_STRIPELEM_IBUF_COMP);
+		if (ibuf_comp) {
+			IMB_freeImBuf(ibuf_comp);
+			break;
+		}
+
+		if (seq->blend_mode == SEQ_BLEND_REPLACE) {
+			early_out = EARLY_NO_INPUT;
+		}
+		else {
+			early_out = seq_get_early_out_for_blend_mode(seq);
+		}
+
+		if (early_out != EARLY_USE_INPUT_1 && seq_render_strip_is_independent(seq)) {
+			tasks[tot_task].context = context;
+			tasks[tot_task].seq = seq;
+			tasks[tot_task].cfra = cfra;
+			tasks[tot_task].ibuf = NULL;
+			task_index[tot_task] = i;
+			tot_task++;
+		}
+
+		if (ELEM(early_out, EARLY_NO_INPUT, EARLY_USE_INPUT_2)) {
+			break;
+		}
+	}
+
+	if (tot_task > 1) {
+		TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+		TaskPool *task_pool = BLI_task_pool_create(task_scheduler, NULL);
+
+		for (i = 0; i < tot_task; i++) {
+			BLI_task_pool_push(task_pool, seq_render_strip_task, &tasks[i], false, TASK_PRIORITY_LOW);
+		}
+
+		BLI_task_pool_work_and_wait(task_pool);
+		BLI_task_pool_free(task_pool);
+
+		for (i = 0; i < tot_task; i++) {
+			ibuf_arr[task_index[i]] = tasks[i].ibuf;
+		}
+	}
+}
+
+/* takes the strip rendered by seq_render_strip_stack_inputs(), or renders it now */
+static ImBuf *seq_render_strip_stack_input(const SeqRenderData *context, Sequence **seq_arr,
+                                           ImBuf **ibuf_arr, int index, float cfra)
+{
+	ImBuf *ibuf = ibuf_arr[index];
+
+	if (ibuf) {
+		ibuf_arr[index] = NULL;
+		return ibuf;
+	}
+
+	return seq_render_strip(context, seq_arr[index], cfra);
+}
+
 static ImBuf *seq_render_strip_stack(const SeqRenderData *context, ListBase *seqbasep, float cfra, int chanshown)
 {
 	Sequence *seq_arr[MAXSEQ + 1];
+	ImBuf *ibuf_arr[MAXSEQ + 1] = {NULL};
 	int count;
 	int i;
 	ImBuf *out = NULL;
@@ -3016,6 +3138,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context, ListBase *seq
 		return out;
 	}
 
+	seq_render_strip_stack_inputs(context, seq_arr, count, cfra, ibuf_arr);
+
 	for (i = count - 1; i >= 0; i--) {
 		int early_out;
 		Sequence *seq = seq_arr[i];
@@ -3026,7 +3150,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context, ListBase *seq
 			break;
 		}
 		if (seq->blend_mode == SEQ_BLEND_REPLACE) {
-			out = seq_render_strip(context, seq, cfra);
+			out = seq_render_strip_stack_input(context, seq_arr, ibuf_arr, i, cfra);
 			break;
 		}
 
@@ -3035,7 +3159,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context, ListBase *seq
 		switch (early_out) {
 			case EARLY_NO_INPUT:
 			case EARLY_USE_INPUT_2:
-				out = seq_render_strip(context, seq, cfra);
+				out = seq_render_strip_stack_input(context, seq_arr, ibuf_arr, i, cfra);
 				break;
 			case EARLY_USE_INPUT_1:
 				if (i == 0) {
@@ -3045,7 +3169,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context, ListBase *seq
 			case EARLY_DO_EFFECT:
 				if (i == 0) {
 					ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-					ImBuf *ibuf2 = seq_render_strip(context, seq, cfra);
+					ImBuf *ibuf2 = seq_render_strip_stack_input(context, seq_arr, ibuf_arr, i, cfra);
 
 					out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
 
@@ -3069,7 +3193,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context, ListBase *seq
 
 		if (seq_get_early_out_for_blend_mode(seq) == EARLY_DO_EFFECT) {
 			ImBuf *ibuf1 = out;
-			ImBuf *ibuf2 = seq_render_strip(context, seq, cfra);
+			ImBuf *ibuf2 = seq_render_strip_stack_input(context, seq_arr, ibuf_arr, i, cfra);
 
 			out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
 
@@ -3080,6 +3204,13 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context, ListBase *seq
 		BKE_sequencer_cache_put(context, seq_arr[i], cfra, SEQ_STRIPELEM_IBUF_COMP, out);
 	}
 
+	/* inputs blending didn't end up using */
+	for (i = 0; i < count; i++) {
+		if (ibuf_arr[i]) {
+			IMB_freeImBuf(ibuf_arr[i]);
+		}
+	}
+
 	return out;
 }
 
@@ -3088,7 +3219,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context, ListBase *seq
  * you have to free after usage!
  */
 
-ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int chanshown)
+static ImBuf *seq_give_ibuf(const SeqRenderData *context, float cfra, int chanshown)
 {
 	Editing *ed = BKE_sequencer_editing_get(context->scene, false);
 	ListBase *seqbasep;
@@ -3107,6 +3238,13 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
 	return seq_render_strip_stack(context, seqbasep, cfra, chanshown);
 }
 
+ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int chanshown)
+{
+	BKE_sequencer_prefetch_stop();
+
+	return seq_give_ibuf(context, cfra, chanshown);
+}
+
 ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context, float cfra, int chanshown, ListBase *seqbasep)
 {
 	return seq_render_strip_stack(context, seqbasep, cfra, chanshown);
@@ -3115,159 +3253,314 @@ ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context, float cfra,
 
 ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra, Sequence *seq)
 {
+	BKE_sequencer_prefetch_stop();
+
 	return seq_render_strip(context, seq, cfra);
 }
 
-/* *********************** threading api ******************* */
-
-static ListBase running_threads;
-static ListBase prefetch_wait;
-static ListBase prefetch_done;
+/* *********************** prefetching ******************* */
 
-static pthread_mutex_t queue_lock          = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t wakeup_lock         = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t wakeup_cond          = PTHREAD_COND_INITIALIZER;
+/* During playback frames after the current one are rendered on a background
+ * thread, so they are already in the sequencer cache when they are displayed.
+ *
+ * Strip rendering is not thread safe (movie decoders, preprocess cache, effect
+ * data), so the worker and the main thread take turns with seq_render_lock and
+ * everything that changes or frees strip data stops the worker first, see
+ * BKE_sequencer_prefetch_stop().
+ */
 
-//static pthread_mutex_t prefetch_ready_lock = PTHREAD_MUTEX_INITIALIZER;
-//static pthread_cond_t  prefetch_ready_cond = PTHREAD_COND_INITIALIZER;
+typedef struct SeqPrefetch {
+	SeqRenderData context;
+	int chanshown;
 
-static pthread_mutex_t frame_done_lock     = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t frame_done_cond      = PTHREAD_COND_INITIALIZER;
+	int cfra;        /* frame displayed by the main thread */
+	int frame_next;  /* next frame for the worker to render */
+	int frame_last;  /* last frame the worker may render */
+	size_t frame_size;
 
-static volatile bool seq_thread_shutdown = true; 
-static volatile int seq_last_given_monoton_cfra = 0;
-static int monoton_cfra = 0;
+	pthread_t thread;
+	bool running;
+	bool stop;
+} SeqPrefetch;
 
-typedef struct PrefetchThread {
-	struct PrefetchThread *next, *prev;
-	
-	Scene *scene;
-	struct PrefetchQueueElem *current;
-	pthread_t pthread;
-	int running;
-	
-} PrefetchThread;
+static SeqPrefetch prefetch;
+static ThreadMutex prefetch_lock = BLI_MUTEX_INITIALIZER;
+static ThreadCondition prefetch_cond = PTHREAD_COND_INITIALIZER;
+static ThreadMutex seq_render_lock = BLI_MUTEX_INITIALIZER;
 
-typedef struct PrefetchQueueElem {
-	struct PrefetchQueueElem *next, *prev;
-	
-	int rectx;
-	int recty;
-	float cfra;
-	int chanshown;
-	int preview_render_size;
+/* scene strips render with OpenGL or the render pipeline, neither can run from the worker */
+static bool seq_prefetch_fcurves_animate_strips(ListBase *fcurves)
+{
+	FCurve *fcu;
 
-	int monoton_cfra;
+	for (fcu = fcurves->first; fcu; fcu = fcu->next) {
+		if (fcu->rna_path && STRPREFIX(fcu->rna_path, "sequence_editor.sequences_all[")) {
+			return true;
+		}
+	}
 
-	ImBuf *ibuf;
-} PrefetchQueueElem;
+	return false;
+}
 
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context, float cfra, int chanshown)
+/* The worker renders frames ahead with the strip settings of the current frame,
+ * animation isn't evaluated for them (the main thread writes the animated values
+ * on frame change too), so prefetching is only done when no strip is animated. */
+static bool seq_prefetch_strips_are_animated(Scene *scene)
 {
-	PrefetchQueueElem *e;
-	if (seq_thread_shutdown) {
-		return;
+	AnimData *adt = scene->adt;
+	NlaTrack *nlt;
+	NlaStrip *strip;
+
+	if (adt == NULL) {
+		return false;
 	}
 
-	e = MEM_callocN(sizeof(PrefetchQueueElem), "prefetch_queue_elem");
-	e->rectx = context->rectx;
-	e->recty = context->recty;
-	e->cfra = cfra;
-	e->chanshown = chanshown;
-	e->preview_render_size = context->preview_render_size;
-	e->monoton_cfra = monoton_cfra++;
+	if (adt->action && seq_prefetch_fcurves_animate_strips(&adt->action->curves)) {
+		return true;
+	}
+	if (seq_prefetch_fcurves_animate_strips(&adt->drivers)) {
+		return true;
+	}
+	for (nlt = adt->nla_tracks.first; nlt; nlt = nlt->next) {
+		for (strip = nlt->strips.first; strip; strip = strip->next) {
+			if (strip->act && seq_prefetch_fcurves_animate_strips(&strip->act->curves)) {
+				return true;
+			}
+		}
+	}
 
-	pthread_mutex_lock(&queue_lock);
-	BLI_addtail(&prefetch_wait, e);
-	pthread_mutex_unlock(&queue_lock);
-	
-	pthread_mutex_lock(&wakeup_lock);
-	pthread_cond_signal(&wakeup_cond);
-	pthread_mutex_unlock(&wakeup_lock);
+	return false;
 }
 
-ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown)
+static bool seq_prefetch_is_supported(Scene *scene)
 {
-	PrefetchQueueElem *e = NULL;
-	bool found_something = false;
+	Editing *ed = BKE_sequencer_editing_get(scene, false);
+	Sequence *seq;
+	bool supported = true;
 
-	if (seq_thread_shutdown) {
-		return BKE_sequencer_give_ibuf(context, cfra, chanshown);
+	if (ed == NULL || seq_prefetch_strips_are_animated(scene)) {
+		return false;
 	}
 
-	while (!e) {
-		bool success = false;
-		pthread_mutex_lock(&queue_lock);
+	SEQ_BEGIN (ed, seq)
+	{
+		SequenceModifierData *smd;
 
-		for (e = prefetch_done.first; e; e = e->next) {
-			if (cfra == e->cfra &&
-			    chanshown == e->chanshown &&
-			    context->rectx == e->rectx &&
-			    context->recty == e->recty &&
-			    context->preview_render_size == e->preview_render_size)
-			{
-				success = true;
-				found_something = true;
-				break;
-			}
+		if (seq->type == SEQ_TYPE_SCENE) {
+			supported = false;
+			break;
 		}
 
-		if (!e) {
-			for (e = prefetch_wait.first; e; e = e->next) {
-				if (cfra == e->cfra &&
-				    chanshown == e->chanshown &&
-				    context->rectx == e->rectx &&
-				    context->recty == e->recty &&
-				    context->preview_render_size == e->preview_render_size)
-				{
-					found_something = true;
-					break;
-				}
+		/* animated masks are evaluated for the frame, like strips */
+		if (seq->type == SEQ_TYPE_MASK && seq->mask && seq->mask->adt) {
+			supported = false;
+			break;
+		}
+		for (smd = seq->modifiers.first; smd; smd = smd->next) {
+			if (smd->mask_id && smd->mask_id->adt) {
+				supported = false;
 			}
 		}
+		if (!supported) {
+			break;
+		}
+	}
+	SEQ_END
 
-		if (!e) {
-			PrefetchThread *tslot;
+	return supported;
+}
 
-			for (tslot = running_threads.first;
-			     tslot;
-			     tslot = tslot->next)
-			{
-				if (tslot->current &&
-				    cfra == tslot->current->cfra &&
-				    chanshown == tslot->current->chanshown &&
-				    context->rectx == tslot->current->rectx &&
-				    context->recty == tslot->current->recty &&
-				    context->preview_render_size == tslot->current->preview_render_size)
-				{
-					found_something = true;
-					break;
-				}
-			}
+/* limit prefetching to half of the cache, so prefetched frames don't push out the ones ahead of them */
+static int seq_prefetch_frames_max(size_t frame_size)
+{
+	size_t budget = ((size_t)U.memcachelimit * 1024 * 1024) / 2;
+	int frames = U.prefetchframes;
+
+	if (frame_size && U.memcachelimit && budget / frame_size < (size_t)frames) {
+		frames = (int)(budget / frame_size);
+	}
+
+	return frames;
+}
+
+static bool seq_prefetch_context_equals(const SeqRenderData *a, const SeqRenderData *b)
+{
+	return ((a->scene == b->scene) &&
+	        (a->bmain == b->bmain) &&
+	        (a->rectx == b->rectx) &&
+	        (a->recty == b->recty) &&
+	        (a->preview_render_size == b->preview_render_size) &&
+	        (a->motion_blur_samples == b->motion_blur_samples) &&
+	        (a->motion_blur_shutter == b->motion_blur_shutter));
+}
+
+static void *seq_prefetch_thread(void *UNUSED(data))
+{
+	BLI_mutex_lock(&prefetch_lock);
+
+	while (!prefetch.stop) {
+		SeqRenderData context;
+		ImBuf *ibuf;
+		int cfra, chanshown;
+
+		if (prefetch.frame_next > prefetch.frame_last) {
+			BLI_condition_wait(&prefetch_cond, &prefetch_lock);
+			continue;
 		}
 
-		/* e->ibuf is unrefed by render thread on next round. */
+		context = prefetch.context;
+		chanshown = prefetch.chanshown;
+		cfra = prefetch.frame_next;
+		BLI_mutex_unlock(&prefetch_lock);
 
-		if (e) {
-			seq_last_given_monoton_cfra = e->monoton_cfra;
+		BLI_mutex_lock(&seq_render_lock);
+		ibuf = seq_give_ibuf(&context, cfra, chanshown);
+		BLI_mutex_unlock(&seq_render_lock);
+
+		/* the cache holds its own reference */
+		if (ibuf) {
+			IMB_freeImBuf(ibuf);
 		}
 
-		pthread_mutex_unlock(&queue_lock);
+		BLI_mutex_lock(&prefetch_lock);
 
-		if (!success) {
-			e = NULL;
+		/* the main thread may have moved the window meanwhile */
+		if (prefetch.frame_next == cfra) {
+			prefetch.frame_next++;
+		}
+	}
 
-			if (!found_something) {
-				fprintf(stderr, "SEQ-THREAD: Requested frame not in queue ???\n");
-				break;
-			}
-			pthread_mutex_lock(&frame_done_lock);
-			pthread_cond_wait(&frame_done_cond, &frame_done_lock);
-			pthread_mutex_unlock(&frame_done_lock);
+	BLI_mutex_unlock(&prefetch_lock);
+
+	return NULL;
+}
+
+/* Stop the prefetch worker, needed before strip data or strip lists it might be using change.
+ * Does nothing when called from a thread other than the main one, the worker
+ * itself only calls this indirectly while rendering. Renders on other threads
+ * don't overlap the worker, it's stopped when they start and doesn't run while
+ * G.is_rendering is set. */
+void BKE_sequencer_prefetch_stop(void)
+{
+	if (!prefetch.running || !BLI_thread_is_main()) {
+		return;
+	}
+
+	BLI_mutex_lock(&prefetch_lock);
+	prefetch.stop = true;
+	BLI_condition_notify_one(&prefetch_cond);
+	BLI_mutex_unlock(&prefetch_lock);
+
+	pthread_join(prefetch.thread, NULL);
+	BLI_end_threaded_malloc();
+
+	prefetch.running = false;
+	prefetch.stop = false;
+}
+
+static void seq_prefetch_start(const SeqRenderData *context, int cfra, int chanshown)
+{
+	prefetch.context = *context;
+	prefetch.chanshown = chanshown;
+	prefetch.cfra = cfra;
+	prefetch.frame_next = cfra + 1;
+	prefetch.frame_last = cfra;
+	prefetch.frame_size = 0;
+	prefetch.stop = false;
+
+	BLI_begin_threaded_malloc();
+	if (pthread_create(&prefetch.thread, NULL, seq_prefetch_thread, NULL) == 0) {
+		prefetch.running = true;
+	}
+	else {
+		BLI_end_threaded_malloc();
+	}
+}
+
+/* Number of frames after cfra rendered ahead by the worker, for drawing. */
+int BKE_sequencer_prefetch_frames_ready(Scene *scene, int cfra)
+{
+	int frames = 0;
+
+	if (!prefetch.running) {
+		return 0;
+	}
+
+	BLI_mutex_lock(&prefetch_lock);
+	if (prefetch.context.scene == scene && prefetch.cfra == cfra) {
+		frames = max_ii(prefetch.frame_next - cfra - 1, 0);
+	}
+	BLI_mutex_unlock(&prefetch_lock);
+
+	return frames;
+}
+
+/* Like BKE_sequencer_give_ibuf(), but keeps a background thread rendering the frames after cfra.
+ * Only meant for playback from the main thread, the worker stops on any other sequencer access. */
+ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown)
+{
+	Scene *scene = context->scene;
+	const int frame = (int)cfra;
+	ImBuf *ibuf;
+
+	/* the render job renders the sequencer without seq_render_lock */
+	if (U.prefetchframes <= 0 || context->skip_cache || G.is_rendering || !seq_prefetch_is_supported(scene)) {
+		return BKE_sequencer_give_ibuf(context, cfra, chanshown);
+	}
+
+	if (prefetch.running &&
+	    (!seq_prefetch_context_equals(&prefetch.context, context) || prefetch.chanshown != chanshown))
+	{
+		BKE_sequencer_prefetch_stop();
+	}
+
+	BLI_mutex_lock(&seq_render_lock);
+	ibuf = seq_give_ibuf(context, cfra, chanshown);
+	BLI_mutex_unlock(&seq_render_lock);
+
+	if (!prefetch.running) {
+		seq_prefetch_start(context, frame, chanshown);
+	}
+
+	BLI_mutex_lock(&prefetch_lock);
+
+	/* jumped back (looping) or past the prefetched frames, start over from here */
+	if (frame < prefetch.cfra || frame >= prefetch.frame_next) {
+		prefetch.frame_next = frame + 1;
+	}
+	prefetch.cfra = frame;
+
+	if (ibuf) {
+		prefetch.frame_size = (size_t)ibuf->x * (size_t)ibuf->y * (ibuf->rect_float ? 4 * sizeof(float) : 4);
+	}
+	prefetch.frame_last = min_ii(frame + seq_prefetch_frames_max(prefetch.frame_size), PEFRA);
+
+	BLI_condition_notify_one(&prefetch_cond);
+	BLI_mutex_unlock(&prefetch_lock);
+
+	return ibuf;
+}
+
+/* Stop movie strips decoding ahead, once playback ended they would only hold frames. */
+void BKE_sequencer_anim_readahead_stop(Scene *scene)
+{
+	Editing *ed = BKE_sequencer_editing_get(scene, false);
+	Sequence *seq;
+
+	if (ed == NULL) {
+		return;
+	}
+
+	/* the prefetch worker may be reading the movies */
+	BKE_sequencer_prefetch_stop();
+
+	SEQ_BEGIN (ed, seq)
+	{
+		if (seq->anim) {
+			IMB_anim_readahead_stop(seq->anim);
 		}
 	}
-	
-	return e ? e->ibuf : NULL;
+	SEQ_END
 }
 
 /* Functions to free imbuf and anim data on changes */
@@ -3329,6 +3622,9 @@ static void sequence_invalidate_cache(Scene *scene, Sequence *seq, bool invalida
 {
 	Editing *ed = scene->ed;
 
+	/* the worker may be rendering the strip */
+	BKE_sequencer_prefetch_stop();
+
 	/* invalidate cache for current sequence */
 	if (invalidate_self) {
 		if (seq->anim) {
@@ -3452,6 +3748,8 @@ void BKE_sequencer_update_changed_seq_and_deps(Scene *scene, Sequence *changed_s
 	Sequence *seq;
 	
 	if (ed == NULL) return;
+
+	BKE_sequencer_prefetch_stop();
 	
 	for (seq = ed->seqbase.first; seq; seq = seq->next)
 		update_changed_seq_recurs(scene, seq, changed_seq, len_change, ibuf_change);
@@ -4310,6 +4608,8 @@ Sequence *BKE_sequence_alloc(ListBase *lb, int cfra, int machine)
 {
 	Sequence *seq;
 
+	BKE_sequencer_prefetch_stop();
+
 	seq = MEM_callocN(sizeof(Sequence), "addseq");
 	BLI_addtail(lb, seq);
 
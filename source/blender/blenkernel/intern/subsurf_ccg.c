@@ -3952,6 +3952,7 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 
 		if (useIncremental && (flags & SUBSURF_IS_FINAL_CALC)) {
 			smd->mCache = ss = _getSubSurf(smd->mCache, levels, 3, useSimple | useAging | CCG_CALC_NORMALS);
+			ccgSubSurf_setUseStencils(ss, 1);
 
 			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple);
 
@@ -3961,8 +3962,12 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 		}
 		else {
 			CCGFlags ccg_flags = useSimple | CCG_USE_ARENA | CCG_CALC_NORMALS;
+			CCGStencilTable *stencils = NULL;
 			
 			if (smd->mCache && (flags & SUBSURF_IS_FINAL_CALC)) {
+				/* the stencils outlive the cache, as long as the topology
+				 * does not change the next evaluation can use them */
+				stencils = ccgSubSurf_takeStencils(smd->mCache);
 				ccgSubSurf_free(smd->mCache);
 				smd->mCache = NULL;
 			}
@@ -3971,6 +3976,13 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 				ccg_flags |= CCG_ALLOC_MASK;
 
 			ss = _getSubSurf(NULL, levels, 3, ccg_flags);
+			if ((flags & SUBSURF_IS_FINAL_CALC) && !(flags & SUBSURF_ALLOC_PAINT_MASK)) {
+				ccgSubSurf_setUseStencils(ss, 1);
+				ccgSubSurf_setStencils(ss, stencils);
+			}
+			else {
+				ccgSubSurf_freeStencils(stencils);
+			}
 			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple);
 
 			result = getCCGDerivedMesh(ss, drawInteriorEdges, useSubsurfUv, dm);
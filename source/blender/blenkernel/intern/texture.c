@@ -1614,7 +1614,10 @@ bool BKE_texture_dependsOnTime(const struct Tex *texture)
 
 /* ------------------------------------------------------------------------- */
 
-void BKE_texture_get_value(Scene *scene, Tex *texture, float *tex_co, TexResult *texres, bool use_color_management)
+/* pool is optional, it has to be used when sampling from several threads at once */
+void BKE_texture_get_value_ex(
+        Scene *scene, Tex *texture, float *tex_co, TexResult *texres,
+        struct ImagePool *pool, bool use_color_management)
 {
 	int result_type;
 	bool do_color_manage = false;
@@ -1624,7 +1627,7 @@ void BKE_texture_get_value(Scene *scene, Tex *texture, float *tex_co, TexResult
 	}
 
 	/* no node textures for now */
-	result_type = multitex_ext_safe(texture, tex_co, texres, NULL, do_color_manage);
+	result_type = multitex_ext_safe(texture, tex_co, texres, pool, do_color_manage);
 
 	/* if the texture gave an RGB value, we assume it didn't give a valid
 	 * intensity, since this is in the context of modifiers don't use perceptual color conversion.
@@ -1637,3 +1640,8 @@ void BKE_texture_get_value(Scene *scene, Tex *texture, float *tex_co, TexResult
 		copy_v3_fl(&texres->tr, texres->tin);
 	}
 }
+
+void BKE_texture_get_value(Scene *scene, Tex *texture, float *tex_co, TexResult *texres, bool use_color_management)
+{
+	BKE_texture_get_value_ex(scene, texture, tex_co, texres, NULL, use_color_management);
+}
@@ -235,6 +235,20 @@ void BLI_heap_remove(Heap *heap, HeapNode *node)
 	BLI_heap_popmin(heap);
 }
 
+void BLI_heap_node_value_update(Heap *heap, HeapNode *node, float value)
+{
+	const float value_prev = node->value;
+
+	node->value = value;
+
+	if (value < value_prev) {
+		heap_up(heap, node->index);
+	}
+	else if (value > value_prev) {
+		heap_down(heap, node->index);
+	}
+}
+
 float BLI_heap_node_value(HeapNode *node)
 {
 	return node->value;
@@ -29,6 +29,7 @@
 
 #include "BLI_math.h"
 #include "BLI_kdtree.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_strict_flags.h"
 
@@ -511,3 +512,208 @@ int BLI_kdtree_range_search__normal(
 
 	return (int)found;
 }
+
+/**
+ * Calls \a search_cb for each point within \a range of \a co, without allocating.
+ * The search stops as soon as \a search_cb returns false.
+ */
+static void kdtree_range_search_cb(
+        const KDTree *tree, const float co[3], float range,
+        bool (*search_cb)(void *user_data, int index, const float co[3], float dist_sq), void *user_data)
+{
+	const KDTreeNode *node;
+	const KDTreeNode **stack, *defaultstack[KD_STACK_INIT];
+	float range_sq = range * range, dist_sq;
+	unsigned int totstack, cur = 0;
+
+	if (UNLIKELY(!tree->root))
+		return;
+
+	stack = defaultstack;
+	totstack = KD_STACK_INIT;
+
+	stack[cur++] = tree->root;
+
+	while (cur--) {
+		node = stack[cur];
+
+		if (co[node->d] + range < node->co[node->d]) {
+			if (node->left)
+				stack[cur++] = node->left;
+		}
+		else if (co[node->d] - range > node->co[node->d]) {
+			if (node->right)
+				stack[cur++] = node->right;
+		}
+		else {
+			dist_sq = len_squared_v3v3(node->co, co);
+			if (dist_sq <= range_sq) {
+				if (search_cb(user_data, node->index, node->co, dist_sq) == false) {
+					break;
+				}
+			}
+
+			if (node->left)
+				stack[cur++] = node->left;
+			if (node->right)
+				stack[cur++] = node->right;
+		}
+
+		if (UNLIKELY(cur + 3 > totstack)) {
+			stack = (const KDTreeNode **)realloc_nodes((KDTreeNode **)stack, &totstack, defaultstack != stack);
+		}
+	}
+
+	if (stack != defaultstack)
+		MEM_freeN(stack);
+}
+
+/* -------------------------------------------------------------------- */
+/* Finding duplicates */
+
+/* Nodes handled by a single task while flagging points that have neighbors. */
+#define KD_DUPLICATES_BATCH 1024u
+
+typedef struct DeDuplicateParams {
+	/* Static */
+	const KDTree *tree;
+	float range;
+	int *duplicates;
+	/* Per search, only used while claiming duplicates */
+	int search;
+	int found;
+	/* Per node, set when any other point is within range */
+	bool *has_neighbor;
+} DeDuplicateParams;
+
+typedef struct NeighborSearch {
+	int search;
+	bool found;
+} NeighborSearch;
+
+static bool deduplicate_has_neighbor_cb(void *user_data, int index, const float UNUSED(co[3]), float UNUSED(dist_sq))
+{
+	NeighborSearch *ns = user_data;
+
+	if (index != ns->search) {
+		ns->found = true;
+		return false;
+	}
+	return true;
+}
+
+static void deduplicate_has_neighbor_task(void *userdata, int batch)
+{
+	DeDuplicateParams *p = userdata;
+	const KDTree *tree = p->tree;
+	const unsigned int start = (unsigned int)batch * KD_DUPLICATES_BATCH;
+	const unsigned int end = MIN2(start + KD_DUPLICATES_BATCH, tree->totnode);
+	unsigned int i;
+
+	for (i = start; i < end; i++) {
+		const KDTreeNode *node = &tree->nodes[i];
+		NeighborSearch ns = {node->index, false};
+
+		kdtree_range_search_cb(tree, node->co, p->range, deduplicate_has_neighbor_cb, &ns);
+		p->has_neighbor[i] = ns.found;
+	}
+}
+
+static bool deduplicate_claim_cb(void *user_data, int index, const float UNUSED(co[3]), float UNUSED(dist_sq))
+{
+	DeDuplicateParams *p = user_data;
+
+	if (p->duplicates[index] == -1 && index != p->search) {
+		p->duplicates[index] = p->search;
+		p->found++;
+	}
+	return true;
+}
+
+static void deduplicate_claim(DeDuplicateParams *p, const KDTreeNode *node)
+{
+	p->search = node->index;
+	kdtree_range_search_cb(p->tree, node->co, p->range, deduplicate_claim_cb, p);
+}
+
+/**
+ * Find duplicate points within \a range, in parallel.
+ *
+ * \param duplicates: An array of int's the length of the number of points in the tree,
+ * point indices must be in the range [0, totnode).
+ * Values initialized to -1 are free to be merged, values set to their own index are
+ * preferred targets which can't become duplicates, they claim their neighbors first.
+ * On return each duplicate is set to the index of the point it merges into.
+ * \param use_index_order: Claim duplicates in index order, otherwise in tree order
+ * (faster, but the chosen targets depend on the tree layout).
+ *
+ * \return The number of duplicates found.
+ *
+ * Points without any neighbor are flagged in parallel first,
+ * only points that have neighbors take part in the (serial) claiming.
+ */
+int BLI_kdtree_calc_duplicates_fast(
+        const KDTree *tree, const float range, bool use_index_order,
+        int *duplicates)
+{
+	DeDuplicateParams p;
+	const unsigned int totnode = tree->totnode;
+	const int totbatch = (int)((totnode + KD_DUPLICATES_BATCH - 1) / KD_DUPLICATES_BATCH);
+	unsigned int *order = NULL;
+	unsigned int i;
+
+#ifdef DEBUG
+	BLI_assert(tree->is_balanced == true);
+#endif
+
+	if (totnode == 0) {
+		return 0;
+	}
+
+	p.tree = tree;
+	p.range = range;
+	p.duplicates = duplicates;
+	p.search = -1;
+	p.found = 0;
+	p.has_neighbor = MEM_mallocN(sizeof(*p.has_neighbor) * totnode, __func__);
+
+	BLI_task_parallel_range_ex(0, totbatch, &p, deduplicate_has_neighbor_task, 2);
+
+	if (use_index_order) {
+		order = MEM_mallocN(sizeof(*order) * totnode, __func__);
+		for (i = 0; i < totnode; i++) {
+			order[tree->nodes[i].index] = i;
+		}
+	}
+
+	/* preferred targets claim their neighbors first */
+	for (i = 0; i < totnode; i++) {
+		const unsigned int node_index = order ? order[i] : i;
+		const KDTreeNode *node = &tree->nodes[node_index];
+
+		if (p.has_neighbor[node_index] && duplicates[node->index] == node->index) {
+			deduplicate_claim(&p, node);
+		}
+	}
+
+	for (i = 0; i < totnode; i++) {
+		const unsigned int node_index = order ? order[i] : i;
+		const KDTreeNode *node = &tree->nodes[node_index];
+
+		if (p.has_neighbor[node_index] && duplicates[node->index] == -1) {
+			const int found_prev = p.found;
+			deduplicate_claim(&p, node);
+			if (p.found != found_prev) {
+				/* prevent chains of doubles */
+				duplicates[node->index] = node->index;
+			}
+		}
+	}
+
+	if (order) {
+		MEM_freeN(order);
+	}
+	MEM_freeN(p.has_neighbor);
+
+	return p.found;
+}
@@ -122,6 +122,7 @@ static pthread_mutex_t _nodes_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _movieclip_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _colormanage_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _fftw_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t _thread_levels_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t mainid;
 static int thread_levels = 0;  /* threads can be invoked inside threads */
 static int num_threads_override = 0;
@@ -147,6 +148,34 @@ static void BLI_unlock_malloc_thread(void)
 	BLI_spin_unlock(&_malloc_lock);
 }
 
+/* Threads and task pools can be started from inside other threads (image
+ * processing from a task), so the level count is changed under a lock.
+ * Returns true when this enabled the malloc lock. */
+static bool threaded_malloc_begin(void)
+{
+	bool first;
+
+	pthread_mutex_lock(&_thread_levels_lock);
+	first = (thread_levels == 0);
+	if (first) {
+		MEM_set_lock_callback(BLI_lock_malloc_thread, BLI_unlock_malloc_thread);
+	}
+	thread_levels++;
+	pthread_mutex_unlock(&_thread_levels_lock);
+
+	return first;
+}
+
+static void threaded_malloc_end(void)
+{
+	pthread_mutex_lock(&_thread_levels_lock);
+	thread_levels--;
+	if (thread_levels == 0) {
+		MEM_set_lock_callback(NULL, NULL);
+	}
+	pthread_mutex_unlock(&_thread_levels_lock);
+}
+
 void BLI_threadapi_init(void)
 {
 	mainid = pthread_self();
@@ -198,9 +227,7 @@ void BLI_init_threads(ListBase *threadbase, void *(*do_thread)(void *), int tot)
 		}
 	}
 	
-	if (thread_levels == 0) {
-		MEM_set_lock_callback(BLI_lock_malloc_thread, BLI_unlock_malloc_thread);
-
+	if (threaded_malloc_begin()) {
 #ifdef USE_APPLE_OMP_FIX
 		/* workaround for Apple gcc 4.2.1 omp vs background thread bug,
 		 * we copy gomp thread local storage pointer to setting it again
@@ -208,8 +235,6 @@ void BLI_init_threads(ListBase *threadbase, void *(*do_thread)(void *), int tot)
 		thread_tls_data = pthread_getspecific(gomp_tls_key);
 #endif
 	}
-
-	thread_levels++;
 }
 
 /* amount of available threads */
@@ -328,9 +353,7 @@ void BLI_end_threads(ListBase *threadbase)
 		BLI_freelistN(threadbase);
 	}
 
-	thread_levels--;
-	if (thread_levels == 0)
-		MEM_set_lock_callback(NULL, NULL);
+	threaded_malloc_end();
 }
 
 /* System Information */
@@ -794,22 +817,11 @@ void BLI_thread_queue_wait_finish(ThreadQueue *queue)
 
 void BLI_begin_threaded_malloc(void)
 {
-	/* Used for debug only */
-	/* BLI_assert(thread_levels >= 0); */
-
-	if (thread_levels == 0) {
-		MEM_set_lock_callback(BLI_lock_malloc_thread, BLI_unlock_malloc_thread);
-	}
-	thread_levels++;
+	threaded_malloc_begin();
 }
 
 void BLI_end_threaded_malloc(void)
 {
-	/* Used for debug only */
-	/* BLI_assert(thread_levels >= 0); */
-
-	thread_levels--;
-	if (thread_levels == 0)
-		MEM_set_lock_callback(NULL, NULL);
+	threaded_malloc_end();
 }
 
@@ -4598,6 +4598,7 @@ static void direct_link_modifiers(FileData *fd, ListBase *lb)
 	for (md=lb->first; md; md=md->next) {
 		md->error = NULL;
 		md->scene = NULL;
+		md->checkpoint = NULL;
 		
 		/* if modifiers disappear, or for upward compatibility */
 		if (NULL == modifierType_getInfo(md->type))
@@ -435,14 +435,20 @@ void BM_mesh_bm_from_me(BMesh *bm, Mesh *me,
 
 		/* Copy Custom Data */
 		CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
-
-		if (calc_face_normal) {
-			BM_face_normal_update(f);
-		}
 	}
 
 	bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP); /* added in order, clear dirty flag */
 
+	if (calc_face_normal) {
+		/* only reads the face verts, so this can run once all faces exist */
+		BM_mesh_elem_table_ensure(bm, BM_FACE);
+
+#pragma omp parallel for schedule(static) if (bm->totface >= BM_OMP_LIMIT)
+		for (i = 0; i < bm->totface; i++) {
+			BM_face_normal_update(bm->ftable[i]);
+		}
+	}
+
 	if (me->mselect && me->totselect != 0) {
 
 		BMVert **vert_array = MEM_mallocN(sizeof(BMVert *) * bm->totvert, "VSelConv");
@@ -31,6 +31,7 @@
 #include "BLI_math.h"
 #include "BLI_array.h"
 #include "BLI_alloca.h"
+#include "BLI_kdtree.h"
 #include "BLI_stackdefines.h"
 
 #include "BKE_customdata.h"
@@ -236,17 +237,6 @@ void bmo_weld_verts_exec(BMesh *bm, BMOperator *op)
 	BMO_mesh_delete_oflag_context(bm, ELE_DEL, DEL_ONLYTAGGED);
 }
 
-static int vergaverco(const void *e1, const void *e2)
-{
-	const BMVert *v1 = *(void **)e1, *v2 = *(void **)e2;
-	float x1 = v1->co[0] + v1->co[1] + v1->co[2];
-	float x2 = v2->co[0] + v2->co[1] + v2->co[2];
-
-	if      (x1 > x2) return  1;
-	else if (x1 < x2) return -1;
-	else return 0;
-}
-
 // #define VERT_TESTED	1 // UNUSED
 #define VERT_DOUBLE	2
 #define VERT_TARGET	4
@@ -524,12 +514,12 @@ static void bmesh_find_doubles_common(BMesh *bm, BMOperator *op,
 {
 	BMVert  **verts;
 	int       verts_len;
+	int *duplicates;
+	KDTree *tree;
 
-	int i, j, keepvert = 0;
+	int i, keepvert = 0;
 
 	const float dist  = BMO_slot_float_get(op->slots_in, "dist");
-	const float dist_sq = dist * dist;
-	const float dist3 = (M_SQRT3 + 0.00005f) * dist;   /* Just above sqrt(3) */
 
 	/* Test whether keep_verts arg exists and is non-empty */
 	if (BMO_slot_exists(op->slots_in, "keep_verts")) {
@@ -537,61 +527,52 @@ static void bmesh_find_doubles_common(BMesh *bm, BMOperator *op,
 		keepvert = BMO_iter_new(&oiter, op->slots_in, "keep_verts", BM_VERT) != NULL;
 	}
 
-	/* get the verts as an array we can sort */
+	/* get the verts as an array we can index */
 	verts = BMO_slot_as_arrayN(op->slots_in, "verts", &verts_len);
 
-	/* sort by vertex coordinates added together */
-	qsort(verts, verts_len, sizeof(BMVert *), vergaverco);
-
 	/* Flag keep_verts */
 	if (keepvert) {
 		BMO_slot_buffer_flag_enable(bm, op->slots_in, "keep_verts", BM_VERT, VERT_KEEP);
 	}
 
+	if (verts_len == 0) {
+		MEM_freeN(verts);
+		return;
+	}
+
+	tree = BLI_kdtree_new((unsigned int)verts_len);
+	duplicates = MEM_mallocN(sizeof(*duplicates) * (size_t)verts_len, __func__);
+
 	for (i = 0; i < verts_len; i++) {
-		BMVert *v_check = verts[i];
+		BLI_kdtree_insert(tree, i, verts[i]->co);
+		/* keep verts are never merged away, they are the targets */
+		duplicates[i] = (keepvert && BMO_elem_flag_test(bm, verts[i], VERT_KEEP)) ? i : -1;
+	}
 
-		if (BMO_elem_flag_test(bm, v_check, VERT_DOUBLE | VERT_TARGET)) {
-			continue;
-		}
+	BLI_kdtree_balance(tree);
 
-		for (j = i + 1; j < verts_len; j++) {
-			BMVert *v_other = verts[j];
+	if (BLI_kdtree_calc_duplicates_fast(tree, dist, true, duplicates)) {
+		for (i = 0; i < verts_len; i++) {
+			const int i_target = duplicates[i];
 
-			/* a match has already been found, (we could check which is best, for now don't) */
-			if (BMO_elem_flag_test(bm, v_other, VERT_DOUBLE | VERT_TARGET)) {
+			if (i_target == -1 || i_target == i) {
 				continue;
 			}
 
-			/* Compare sort values of the verts using 3x tolerance (allowing for the tolerance
-			 * on each of the three axes). This avoids the more expensive length comparison
-			 * for most vertex pairs. */
-			if ((v_other->co[0] + v_other->co[1] + v_other->co[2]) -
-			    (v_check->co[0] + v_check->co[1] + v_check->co[2]) > dist3)
-			{
-				break;
-			}
-
-			if (keepvert) {
-				if (BMO_elem_flag_test(bm, v_other, VERT_KEEP) == BMO_elem_flag_test(bm, v_check, VERT_KEEP))
-					continue;
+			/* with keep verts, only merge into them (not between the other verts) */
+			if (keepvert && !BMO_elem_flag_test(bm, verts[i_target], VERT_KEEP)) {
+				continue;
 			}
 
-			if (compare_len_squared_v3v3(v_check->co, v_other->co, dist_sq)) {
-
-				/* If one vert is marked as keep, make sure it will be the target */
-				if (BMO_elem_flag_test(bm, v_other, VERT_KEEP)) {
-					SWAP(BMVert *, v_check, v_other);
-				}
+			BMO_elem_flag_enable(bm, verts[i], VERT_DOUBLE);
+			BMO_elem_flag_enable(bm, verts[i_target], VERT_TARGET);
 
-				BMO_elem_flag_enable(bm, v_other, VERT_DOUBLE);
-				BMO_elem_flag_enable(bm, v_check, VERT_TARGET);
-
-				BMO_slot_map_elem_insert(optarget, optarget_slot, v_other, v_check);
-			}
+			BMO_slot_map_elem_insert(optarget, optarget_slot, verts[i], verts[i_target]);
 		}
 	}
 
+	MEM_freeN(duplicates);
+	BLI_kdtree_free(tree);
 	MEM_freeN(verts);
 }
 
@@ -65,52 +65,62 @@ typedef enum CD_UseFlag {
  * ********************** */
 
 /**
- * \param vquadrics must be calloc'd
+ * Sum the quadrics of the faces and boundary edges using \a v.
+ *
+ * Each vertex only writes to its own quadric so this can run on many vertices at once,
+ * the summing order only depends on the topology (not the number of threads).
  */
-static void bm_decim_build_quadrics(BMesh *bm, Quadric *vquadrics)
+static void bm_decim_build_quadrics_vert(BMVert *v, Quadric *q_vert)
 {
 	BMIter iter;
-	BMFace *f;
+	BMLoop *l;
 	BMEdge *e;
 
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		BMLoop *l_first;
-		BMLoop *l_iter;
-
+	BM_ITER_ELEM (l, &iter, v, BM_LOOPS_OF_VERT) {
+		const BMFace *f = l->f;
 		const float *co = BM_FACE_FIRST_LOOP(f)->v->co;
 		const float *no = f->no;
 		const float offset = -dot_v3v3(no, co);
 		Quadric q;
 
 		BLI_quadric_from_v3_dist(&q, no, offset);
-
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			BLI_quadric_add_qu_qu(&vquadrics[BM_elem_index_get(l_iter->v)], &q);
-		} while ((l_iter = l_iter->next) != l_first);
+		BLI_quadric_add_qu_qu(q_vert, &q);
 	}
 
 	/* boundary edges */
-	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+	BM_ITER_ELEM (e, &iter, v, BM_EDGES_OF_VERT) {
 		if (UNLIKELY(BM_edge_is_boundary(e))) {
 			float edge_vector[3];
 			float edge_cross[3];
 			sub_v3_v3v3(edge_vector, e->v2->co, e->v1->co);
-			f = e->l->f;
-			cross_v3_v3v3(edge_cross, edge_vector, f->no);
+			cross_v3_v3v3(edge_cross, edge_vector, e->l->f->no);
 
 			if (normalize_v3(edge_cross) > FLT_EPSILON) {
 				Quadric q;
 				BLI_quadric_from_v3_dist(&q, edge_cross, -dot_v3v3(edge_cross, e->v1->co));
 				BLI_quadric_mul(&q, BOUNDARY_PRESERVE_WEIGHT);
 
-				BLI_quadric_add_qu_qu(&vquadrics[BM_elem_index_get(e->v1)], &q);
-				BLI_quadric_add_qu_qu(&vquadrics[BM_elem_index_get(e->v2)], &q);
+				BLI_quadric_add_qu_qu(q_vert, &q);
 			}
 		}
 	}
 }
 
+/**
+ * \param vquadrics must be calloc'd
+ */
+static void bm_decim_build_quadrics(BMesh *bm, Quadric *vquadrics)
+{
+	int i;
+
+	BM_mesh_elem_table_ensure(bm, BM_VERT);
+
+#pragma omp parallel for schedule(static) if (bm->totvert >= BM_OMP_LIMIT)
+	for (i = 0; i < bm->totvert; i++) {
+		bm_decim_build_quadrics_vert(bm->vtable[i], &vquadrics[i]);
+	}
+}
+
 
 static void bm_decim_calc_target_co(BMEdge *e, float optimize_co[3],
                                     const Quadric *vquadrics)
@@ -183,18 +193,20 @@ static bool bm_edge_collapse_is_degenerate_flip(BMEdge *e, const float optimize_
 	return false;
 }
 
-static void bm_decim_build_edge_cost_single(BMEdge *e,
-                                            const Quadric *vquadrics, const float *vweights,
-                                            Heap *eheap, HeapNode **eheap_table)
+/**
+ * Calculate the collapse cost of \a e, without touching the heap
+ * (so this can run on many edges at once).
+ *
+ * \return false when the edge can't be collapsed.
+ */
+static bool bm_decim_calc_edge_cost(BMEdge *e,
+                                    const Quadric *vquadrics, const float *vweights,
+                                    float *r_cost)
 {
 	const Quadric *q1, *q2;
 	float optimize_co[3];
 	float cost;
 
-	if (eheap_table[BM_elem_index_get(e)]) {
-		BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
-	}
-
 	/* check we can collapse, some edges we better not touch */
 	if (BM_edge_is_boundary(e)) {
 		if (e->l->f->len == 3) {
@@ -202,8 +214,7 @@ static void bm_decim_build_edge_cost_single(BMEdge *e,
 		}
 		else {
 			/* only collapse tri's */
-			eheap_table[BM_elem_index_get(e)] = NULL;
-			return;
+			return false;
 		}
 	}
 	else if (BM_edge_is_manifold(e)) {
@@ -212,13 +223,11 @@ static void bm_decim_build_edge_cost_single(BMEdge *e,
 		}
 		else {
 			/* only collapse tri's */
-			eheap_table[BM_elem_index_get(e)] = NULL;
-			return;
+			return false;
 		}
 	}
 	else {
-		eheap_table[BM_elem_index_get(e)] = NULL;
-		return;
+		return false;
 	}
 
 	if (vweights) {
@@ -226,8 +235,7 @@ static void bm_decim_build_edge_cost_single(BMEdge *e,
 		    (vweights[BM_elem_index_get(e->v2)] >= BM_MESH_DECIM_WEIGHT_MAX))
 		{
 			/* skip collapsing this edge */
-			eheap_table[BM_elem_index_get(e)] = NULL;
-			return;
+			return false;
 		}
 	}
 	/* end sanity check */
@@ -251,8 +259,30 @@ static void bm_decim_build_edge_cost_single(BMEdge *e,
 
 	/* note, 'cost' shouldn't be negative but happens sometimes with small values.
 	 * this can cause faces that make up a flat surface to over-collapse, see [#37121] */
-	cost = fabsf(cost);
-	eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, cost, e);
+	*r_cost = fabsf(cost);
+	return true;
+}
+
+static void bm_decim_build_edge_cost_single(BMEdge *e,
+                                            const Quadric *vquadrics, const float *vweights,
+                                            Heap *eheap, HeapNode **eheap_table)
+{
+	const int e_index = BM_elem_index_get(e);
+	float cost;
+
+	if (bm_decim_calc_edge_cost(e, vquadrics, vweights, &cost)) {
+		if (eheap_table[e_index]) {
+			/* re-order in place, avoids freeing and allocating a node */
+			BLI_heap_node_value_update(eheap, eheap_table[e_index], cost);
+		}
+		else {
+			eheap_table[e_index] = BLI_heap_insert(eheap, cost, e);
+		}
+	}
+	else if (eheap_table[e_index]) {
+		BLI_heap_remove(eheap, eheap_table[e_index]);
+		eheap_table[e_index] = NULL;
+	}
 }
 
 
@@ -269,14 +299,26 @@ static void bm_decim_build_edge_cost(BMesh *bm,
                                      const Quadric *vquadrics, const float *vweights,
                                      Heap *eheap, HeapNode **eheap_table)
 {
-	BMIter iter;
-	BMEdge *e;
-	unsigned int i;
+	/* negative when the edge can't be collapsed */
+	float *ecost = MEM_mallocN(sizeof(*ecost) * bm->totedge, __func__);
+	int i;
+
+	BM_mesh_elem_table_ensure(bm, BM_EDGE);
 
-	BM_ITER_MESH_INDEX (e, &iter, bm, BM_EDGES_OF_MESH, i) {
-		eheap_table[i] = NULL;  /* keep sanity check happy */
-		bm_decim_build_edge_cost_single(e, vquadrics, vweights, eheap, eheap_table);
+	/* calculating the cost is the expensive part, do it on all edges at once */
+#pragma omp parallel for schedule(static) if (bm->totedge >= BM_OMP_LIMIT)
+	for (i = 0; i < bm->totedge; i++) {
+		if (!bm_decim_calc_edge_cost(bm->etable[i], vquadrics, vweights, &ecost[i])) {
+			ecost[i] = -1.0f;
+		}
 	}
+
+	/* fill the heap in edge order, so the result doesn't depend on the number of threads */
+	for (i = 0; i < bm->totedge; i++) {
+		eheap_table[i] = (ecost[i] >= 0.0f) ? BLI_heap_insert(eheap, ecost[i], bm->etable[i]) : NULL;
+	}
+
+	MEM_freeN(ecost);
 }
 
 #ifdef USE_TRIANGULATE
@@ -993,6 +1035,9 @@ void BM_mesh_decimate_collapse(BMesh *bm, const float factor, float *vweights, c
 #endif
 
 
+	/* the quadric and edge cost tables are index aligned */
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE);
+
 	/* alloc vars */
 	vquadrics = MEM_callocN(sizeof(Quadric) * bm->totvert, __func__);
 	/* since some edges may be degenerate, we might be over allocing a little here */
@@ -23,7 +23,8 @@
  *
  * Cut meshes along intersections.
  *
- * Boolean-like modeling operation (without calculating inside/outside).
+ * Boolean-like modeling operation,
+ * optionally removing the inside/outside parts to give a boolean result.
  *
  * Supported:
  * - Concave faces.
@@ -48,6 +49,7 @@
 #include "BLI_array.h"
 
 #include "BLI_kdopbvh.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "bmesh_intersect.h"  /* own include */
@@ -74,6 +76,9 @@
 /* use accelerated overlap check */
 #define USE_BVH
 
+/* Number of overlapping triangle pairs tested by a single task. */
+#define ISECT_PAIR_TASK_BATCH 1024u
+
 
 static void tri_v3_scale(
         float v1[3], float v2[3], float v3[3],
@@ -772,17 +777,331 @@ static void bm_isect_tri_tri(
 	}
 }
 
+#ifdef USE_BVH
+
+/**
+ * Quick rejection test, false when \a t_cos is entirely on one side of the plane of \a p_cos.
+ *
+ * \note This is conservative, degenerate triangles are never rejected.
+ */
+static bool isect_tri_plane_test(const float *t_cos[3], const float *p_cos[3], const float eps)
+{
+	float p_nor[3];
+	float side[3];
+	float p_dot;
+	unsigned int i;
+
+	normal_tri_v3(p_nor, UNPACK3(p_cos));
+	p_dot = dot_v3v3(p_nor, p_cos[0]);
+
+	for (i = 0; i < 3; i++) {
+		side[i] = dot_v3v3(p_nor, t_cos[i]) - p_dot;
+	}
+
+	return !(((side[0] > eps) && (side[1] > eps) && (side[2] > eps)) ||
+	         ((side[0] < -eps) && (side[1] < -eps) && (side[2] < -eps)));
+}
+
+struct ISectOverlapData {
+	BMLoop *(*looptris)[3];
+	const BVHTreeOverlap *overlap;
+	unsigned int overlap_tot;
+	float eps_margin;
+	/* pairs which may intersect, only these are passed to #bm_isect_tri_tri */
+	bool *overlap_test;
+};
+
+/**
+ * Filter the overlapping pairs, this only reads coordinates
+ * so it runs in parallel before the (serial) edits of #bm_isect_tri_tri.
+ */
+static void bm_isect_overlap_test_task(void *userdata, int batch)
+{
+	struct ISectOverlapData *data = userdata;
+	const unsigned int start = (unsigned int)batch * ISECT_PAIR_TASK_BATCH;
+	const unsigned int end = MIN2(start + ISECT_PAIR_TASK_BATCH, data->overlap_tot);
+	unsigned int i;
+
+	for (i = start; i < end; i++) {
+		BMLoop **a = data->looptris[data->overlap[i].indexA];
+		BMLoop **b = data->looptris[data->overlap[i].indexB];
+		const float *a_cos[3] = {UNPACK3_EX(, a, ->v->co)};
+		const float *b_cos[3] = {UNPACK3_EX(, b, ->v->co)};
+
+		data->overlap_test[i] = (isect_tri_plane_test(a_cos, b_cos, data->eps_margin) &&
+		                         isect_tri_plane_test(b_cos, a_cos, data->eps_margin));
+	}
+}
+
+static void bm_isect_overlap_test(struct ISectOverlapData *data)
+{
+	const int totbatch = (int)((data->overlap_tot + ISECT_PAIR_TASK_BATCH - 1) / ISECT_PAIR_TASK_BATCH);
+
+	if (totbatch < 2) {
+		if (totbatch == 1) {
+			bm_isect_overlap_test_task(data, 0);
+		}
+	}
+	else {
+		BLI_task_parallel_range_ex(0, totbatch, data, bm_isect_overlap_test_task, 2);
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/* Boolean (remove faces inside/outside the other side) */
+
+struct RaycastData {
+	const float (*looptri_coords)[3][3];
+	unsigned int num_isect;
+};
+
+static void raycast_callback(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *UNUSED(hit))
+{
+	struct RaycastData *raycast_data = userdata;
+	const float (*tri_cos)[3] = raycast_data->looptri_coords[index];
+	float dist;
+
+	/* 'hit' is left untouched so every triangle along the ray is visited */
+	if (isect_ray_tri_epsilon_v3(ray->origin, ray->direction, UNPACK3(tri_cos), &dist, NULL, 0.0f)) {
+		if (dist >= 0.0f) {
+			raycast_data->num_isect++;
+		}
+	}
+}
+
+struct ISectBooleanData {
+	BMFace **ftable;
+	const int *groups_array;
+	const int (*group_index)[2];
+	BVHTree *tree_a, *tree_b;
+	const float (*looptri_coords)[3][3];
+	/* per group: side from 'test_fn', -1 to skip */
+	const int *group_side;
+	bool *group_inside;
+};
+
+/**
+ * Check if a group of faces is inside the other side,
+ * counting intersections of a ray cast from its largest face.
+ */
+static void bm_isect_boolean_group_task(void *userdata, int group)
+{
+	struct ISectBooleanData *data = userdata;
+	const int *faces = &data->groups_array[data->group_index[group][0]];
+	const int faces_len = data->group_index[group][1];
+	struct RaycastData raycast_data = {data->looptri_coords, 0};
+	BVHTreeRayHit hit;
+	BMFace *f_best = NULL;
+	float area_best = -1.0f;
+	float co[3], dir[3];
+	int i;
+
+	if (data->group_side[group] == -1) {
+		return;
+	}
+
+	for (i = 0; i < faces_len; i++) {
+		BMFace *f = data->ftable[faces[i]];
+		const float area = BM_face_calc_area(f);
+		if (area > area_best) {
+			area_best = area;
+			f_best = f;
+		}
+	}
+
+	BM_face_calc_center_mean(f_best, co);
+	if (UNLIKELY(BM_face_calc_normal(f_best, dir) == 0.0f)) {
+		dir[2] = 1.0f;
+	}
+
+	hit.index = -1;
+	hit.dist = FLT_MAX;
+
+	BLI_bvhtree_ray_cast(
+	        (data->group_side[group] == 0) ? data->tree_b : data->tree_a,
+	        co, dir, 0.0f, &hit, raycast_callback, &raycast_data);
+
+	data->group_inside[group] = (raycast_data.num_isect % 2) == 1;
+}
+
+struct ISectBooleanStep {
+	GSet *wire_edges;
+	int (*test_fn)(BMFace *f, void *user_data);
+	void *user_data;
+};
+
+/* walk over edges which aren't part of the intersection */
+static bool bm_isect_boolean_edge_step_cb(BMElem *ele, void *user_data)
+{
+	struct ISectBooleanStep *step = user_data;
+	BMEdge *e = (BMEdge *)ele;
+	BMLoop *l_iter;
+	int side;
+
+	if (BLI_gset_haskey(step->wire_edges, e) || (e->l == NULL)) {
+		return false;
+	}
+
+	side = step->test_fn(e->l->f, step->user_data);
+	l_iter = e->l->radial_next;
+	while (l_iter != e->l) {
+		if (step->test_fn(l_iter->f, step->user_data) != side) {
+			return false;
+		}
+		l_iter = l_iter->radial_next;
+	}
+
+	return true;
+}
+
+/**
+ * Remove the faces on the wrong side of the intersection,
+ * each region bounded by the intersection is classified as a whole.
+ */
+static bool bm_isect_boolean(
+        BMesh *bm, struct ISectState *s,
+        BVHTree *tree_a, BVHTree *tree_b, const float (*looptri_coords)[3][3],
+        int (*test_fn)(BMFace *f, void *user_data), void *user_data,
+        const int boolean_mode)
+{
+	struct ISectBooleanData data;
+	struct ISectBooleanStep step = {s->wire_edges, test_fn, user_data};
+	int *groups_array;
+	int (*group_index)[2];
+	int *group_side;
+	bool *group_inside;
+	int group_tot;
+	int i;
+	bool has_edit = false;
+
+	if (bm->totface == 0) {
+		return false;
+	}
+
+	BM_mesh_elem_table_ensure(bm, BM_FACE);
+
+	groups_array = MEM_mallocN(sizeof(*groups_array) * (size_t)bm->totface, __func__);
+	group_tot = BM_mesh_calc_face_groups(
+	        bm, groups_array, &group_index,
+	        bm_isect_boolean_edge_step_cb, &step,
+	        0, BM_EDGE);
+
+	group_side = MEM_mallocN(sizeof(*group_side) * (size_t)group_tot, __func__);
+	group_inside = MEM_callocN(sizeof(*group_inside) * (size_t)group_tot, __func__);
+
+	for (i = 0; i < group_tot; i++) {
+		BMFace *f = bm->ftable[groups_array[group_index[i][0]]];
+		group_side[i] = test_fn(f, user_data);
+	}
+
+	data.ftable = bm->ftable;
+	data.groups_array = groups_array;
+	data.group_index = (const int (*)[2])group_index;
+	data.tree_a = tree_a;
+	data.tree_b = tree_b;
+	data.looptri_coords = looptri_coords;
+	data.group_side = group_side;
+	data.group_inside = group_inside;
+
+	if (group_tot > 1) {
+		BLI_task_parallel_range(0, group_tot, &data, bm_isect_boolean_group_task);
+	}
+	else if (group_tot == 1) {
+		bm_isect_boolean_group_task(&data, 0);
+	}
+
+	BM_mesh_elem_hflag_disable_all(bm, BM_VERT | BM_EDGE, BM_ELEM_TAG, false);
+
+	for (i = 0; i < group_tot; i++) {
+		const int side = group_side[i];
+		const bool is_inside = group_inside[i];
+		const int *faces = &groups_array[group_index[i][0]];
+		const int faces_len = group_index[i][1];
+		bool do_remove, do_flip;
+		int j;
+
+		if (side == -1) {
+			continue;
+		}
+
+		switch (boolean_mode) {
+			case BMESH_ISECT_BOOLEAN_ISECT:
+				do_remove = !is_inside;
+				do_flip = false;
+				break;
+			case BMESH_ISECT_BOOLEAN_UNION:
+				do_remove = is_inside;
+				do_flip = false;
+				break;
+			default:  /* BMESH_ISECT_BOOLEAN_DIFFERENCE */
+				do_remove = (side == 0) ? is_inside : !is_inside;
+				do_flip = (side == 1);
+				break;
+		}
+
+		for (j = 0; j < faces_len; j++) {
+			BMFace *f = bm->ftable[faces[j]];
+
+			if (do_remove) {
+				BMLoop *l_iter, *l_first;
+				l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+				do {
+					BM_elem_flag_enable(l_iter->v, BM_ELEM_TAG);
+					BM_elem_flag_enable(l_iter->e, BM_ELEM_TAG);
+				} while ((l_iter = l_iter->next) != l_first);
+
+				BM_face_kill(bm, f);
+				has_edit = true;
+			}
+			else if (do_flip) {
+				BM_face_normal_flip(bm, f);
+				has_edit = true;
+			}
+		}
+	}
+
+	/* remove geometry left loose by the removed faces */
+	if (has_edit) {
+		BMIter iter;
+		BMEdge *e, *e_next;
+		BMVert *v, *v_next;
+
+		BM_ITER_MESH_MUTABLE (e, e_next, &iter, bm, BM_EDGES_OF_MESH) {
+			if (BM_elem_flag_test(e, BM_ELEM_TAG) && (e->l == NULL)) {
+				BLI_gset_remove(s->wire_edges, e, NULL);
+				BM_edge_kill(bm, e);
+			}
+		}
+		BM_ITER_MESH_MUTABLE (v, v_next, &iter, bm, BM_VERTS_OF_MESH) {
+			if (BM_elem_flag_test(v, BM_ELEM_TAG) && (v->e == NULL)) {
+				BM_vert_kill(bm, v);
+			}
+		}
+	}
+
+	MEM_freeN(groups_array);
+	MEM_freeN(group_index);
+	MEM_freeN(group_side);
+	MEM_freeN(group_inside);
+
+	return has_edit;
+}
+
+#endif  /* USE_BVH */
+
 /**
  * Intersect tessellated faces
  * leaving the resulting edges tagged.
  *
  * \param test_fn Return value: -1: skip, 0: tree_a, 1: tree_b (use_self == false)
+ * \param boolean_mode Remove the faces inside or outside the other side,
+ * see BMESH_ISECT_BOOLEAN_*, ignores \a use_separate when used.
  */
 bool BM_mesh_intersect(
         BMesh *bm,
         struct BMLoop *(*looptris)[3], const int looptris_tot,
         int (*test_fn)(BMFace *f, void *user_data), void *user_data,
-        const bool use_self, const bool use_separate,
+        const bool use_self, const bool use_separate, const int boolean_mode,
         const float eps)
 {
 	struct ISectState s;
@@ -793,10 +1112,15 @@ bool BM_mesh_intersect(
 	BVHTree *tree_a, *tree_b;
 	unsigned int tree_overlap_tot;
 	BVHTreeOverlap *overlap;
+	/* triangle coordinates for the boolean ray-casts, the mesh is edited before they run */
+	float (*looptri_coords)[3][3] = NULL;
 #else
 	int i_a, i_b;
 #endif
 
+	/* boolean needs two sides to check for inside/outside */
+	BLI_assert((boolean_mode == BMESH_ISECT_BOOLEAN_NONE) || (use_self == false));
+
 	s.bm = bm;
 
 	s.edgetri_cache = BLI_ghash_new(BLI_ghashutil_inthash_v4_p, BLI_ghashutil_inthash_v4_cmp, __func__);
@@ -846,6 +1170,10 @@ bool BM_mesh_intersect(
 #endif
 
 #ifdef USE_BVH
+	if (boolean_mode != BMESH_ISECT_BOOLEAN_NONE) {
+		looptri_coords = MEM_mallocN(sizeof(*looptri_coords) * (size_t)looptris_tot, __func__);
+	}
+
 	{
 		int i;
 		tree_a = BLI_bvhtree_new(looptris_tot, s.epsilon.eps_margin, 8, 8);
@@ -858,6 +1186,9 @@ bool BM_mesh_intersect(
 				};
 
 				BLI_bvhtree_insert(tree_a, i, (float *)t_cos, 3);
+				if (looptri_coords) {
+					memcpy(looptri_coords[i], t_cos, sizeof(*looptri_coords));
+				}
 			}
 		}
 		BLI_bvhtree_balance(tree_a);
@@ -875,6 +1206,9 @@ bool BM_mesh_intersect(
 				};
 
 				BLI_bvhtree_insert(tree_b, i, (float *)t_cos, 3);
+				if (looptri_coords) {
+					memcpy(looptri_coords[i], t_cos, sizeof(*looptri_coords));
+				}
 			}
 		}
 		BLI_bvhtree_balance(tree_b);
@@ -886,9 +1220,21 @@ bool BM_mesh_intersect(
 	overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot);
 
 	if (overlap) {
+		struct ISectOverlapData overlap_data;
 		unsigned int i;
 
+		overlap_data.looptris = looptris;
+		overlap_data.overlap = overlap;
+		overlap_data.overlap_tot = tree_overlap_tot;
+		overlap_data.eps_margin = s.epsilon.eps_margin;
+		overlap_data.overlap_test = MEM_mallocN(sizeof(bool) * tree_overlap_tot, __func__);
+
+		bm_isect_overlap_test(&overlap_data);
+
 		for (i = 0; i < tree_overlap_tot; i++) {
+			if (overlap_data.overlap_test[i] == false) {
+				continue;
+			}
 #ifdef USE_DUMP
 			printf("  ((%d, %d), (\n",
 			       overlap[i].indexA,
@@ -904,11 +1250,15 @@ bool BM_mesh_intersect(
 			printf(")),\n");
 #endif
 		}
+		MEM_freeN(overlap_data.overlap_test);
 		MEM_freeN(overlap);
 	}
-	BLI_bvhtree_free(tree_a);
-	if (tree_a != tree_b) {
-		BLI_bvhtree_free(tree_b);
+
+	if (boolean_mode == BMESH_ISECT_BOOLEAN_NONE) {
+		BLI_bvhtree_free(tree_a);
+		if (tree_a != tree_b) {
+			BLI_bvhtree_free(tree_b);
+		}
 	}
 
 #else
@@ -1270,8 +1620,25 @@ bool BM_mesh_intersect(
 #endif  /* USE_NET */
 
 
+#ifdef USE_BVH
+	if (boolean_mode != BMESH_ISECT_BOOLEAN_NONE) {
+		/* the trees are kept for the inside/outside checks */
+		bm_isect_boolean(
+		        bm, &s, tree_a, tree_b, (const float (*)[3][3])looptri_coords,
+		        test_fn, user_data, boolean_mode);
+
+		BLI_bvhtree_free(tree_a);
+		if (tree_a != tree_b) {
+			BLI_bvhtree_free(tree_b);
+		}
+		MEM_freeN(looptri_coords);
+	}
+#else
+	BLI_assert(boolean_mode == BMESH_ISECT_BOOLEAN_NONE);
+#endif  /* USE_BVH */
+
 #ifdef USE_SEPARATE
-	if (use_separate) {
+	if (use_separate && (boolean_mode == BMESH_ISECT_BOOLEAN_NONE)) {
 		GSetIterator gs_iter;
 
 		BM_mesh_elem_hflag_disable_all(bm, BM_EDGE, BM_ELEM_TAG, false);
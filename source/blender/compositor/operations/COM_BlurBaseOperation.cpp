@@ -21,6 +21,7 @@
  */
 
 #include "COM_BlurBaseOperation.h"
+#include "COM_FastGaussianBlurOperation.h"
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
 
@@ -151,6 +152,94 @@ float *BlurBaseOperation::make_dist_fac_inverse(float rad, int size, int falloff
 	return dist_fac_invert;
 }
 
+bool BlurBaseOperation::use_fast_blur(int size) const
+{
+	if (size < MIN_FAST_BLUR_RADIUS) {
+		return false;
+	}
+	return ELEM(this->m_data.filtertype, R_FILTER_GAUSS, R_FILTER_BOX);
+}
+
+void BlurBaseOperation::fast_blur(MemoryBuffer *buffer, float radx, float rady, unsigned int xy)
+{
+	if (this->m_data.filtertype == R_FILTER_BOX) {
+		if (xy & 1) {
+			box_blur(buffer, min_ii((int)radx, MAX_GAUSSTAB_RADIUS), 1);
+		}
+		if (xy & 2) {
+			box_blur(buffer, min_ii((int)rady, MAX_GAUSSTAB_RADIUS), 2);
+		}
+	}
+	else {
+		/* RE_filter_value() evaluates exp(-(1.6 * x / rad)^2) for the gaussian,
+		 * which is a normal distribution with sigma = rad / (1.6 * sqrt(2)).
+		 * The recursive filter does not truncate the tail at the radius, the
+		 * difference is not visible at the sizes this is used for. */
+		const float fac = 1.0f / (1.6f * (float)M_SQRT2);
+		for (int c = 0; c < COM_NUMBER_OF_CHANNELS; c++) {
+			if (xy & 1) {
+				FastGaussianBlurOperation::IIR_gauss(buffer, radx * fac, c, 1);
+			}
+			if (xy & 2) {
+				FastGaussianBlurOperation::IIR_gauss(buffer, rady * fac, c, 2);
+			}
+		}
+	}
+}
+
+/* running sum over a line of pixels, the window is clipped at the borders
+ * the same way the direct convolution skips pixels outside of the buffer */
+static void box_blur_line(float *line, int len, int stride, int radius, double *prefix)
+{
+	int i, c;
+
+	for (c = 0; c < COM_NUMBER_OF_CHANNELS; c++) {
+		prefix[c] = 0.0;
+	}
+	for (i = 0; i < len; i++) {
+		const float *pixel = line + i * stride;
+		double *prev = prefix + i * COM_NUMBER_OF_CHANNELS;
+		for (c = 0; c < COM_NUMBER_OF_CHANNELS; c++) {
+			prev[c + COM_NUMBER_OF_CHANNELS] = prev[c] + (double)pixel[c];
+		}
+	}
+	for (i = 0; i < len; i++) {
+		const int start = max_ii(i - radius, 0);
+		const int end = min_ii(i + radius + 1, len);
+		const double fac = 1.0 / (double)(end - start);
+		float *pixel = line + i * stride;
+		for (c = 0; c < COM_NUMBER_OF_CHANNELS; c++) {
+			pixel[c] = (float)((prefix[end * COM_NUMBER_OF_CHANNELS + c] -
+			                    prefix[start * COM_NUMBER_OF_CHANNELS + c]) * fac);
+		}
+	}
+}
+
+void BlurBaseOperation::box_blur(MemoryBuffer *buffer, int radius, unsigned int xy)
+{
+	const int width = buffer->getWidth();
+	const int height = buffer->getHeight();
+	float *data = buffer->getBuffer();
+	double *prefix;
+
+	if (radius < 1) {
+		return;
+	}
+
+	prefix = (double *)MEM_mallocN(sizeof(double) * COM_NUMBER_OF_CHANNELS * (max_ii(width, height) + 1), __func__);
+	if (xy & 1) {
+		for (int y = 0; y < height; y++) {
+			box_blur_line(data + y * width * COM_NUMBER_OF_CHANNELS, width, COM_NUMBER_OF_CHANNELS, radius, prefix);
+		}
+	}
+	if (xy & 2) {
+		for (int x = 0; x < width; x++) {
+			box_blur_line(data + x * COM_NUMBER_OF_CHANNELS, height, width * COM_NUMBER_OF_CHANNELS, radius, prefix);
+		}
+	}
+	MEM_freeN(prefix);
+}
+
 void BlurBaseOperation::deinitExecution()
 {
 	this->m_inputProgram = NULL;
@@ -27,6 +27,10 @@
 
 #define MAX_GAUSSTAB_RADIUS 30000
 
+/* From this radius on, blurs with a gaussian or box filter are computed with
+ * a recursive gaussian or running box sum instead of direct convolution. */
+#define MIN_FAST_BLUR_RADIUS 32
+
 #ifdef __SSE2__
 #  include <emmintrin.h>
 #endif
@@ -43,6 +47,18 @@ protected:
 #endif
 	float *make_dist_fac_inverse(float rad, int size, int falloff);
 
+	/**
+	 * @brief check if a blur of the given size can use #fast_blur
+	 */
+	bool use_fast_blur(int size) const;
+
+	/**
+	 * @brief blur the whole buffer with a cost per pixel independent of the radius
+	 * @param xy: 1 for horizontal, 2 for vertical, 3 for both directions
+	 */
+	void fast_blur(MemoryBuffer *buffer, float radx, float rady, unsigned int xy);
+	static void box_blur(MemoryBuffer *buffer, int radius, unsigned int xy);
+
 	void updateSize();
 
 	/**
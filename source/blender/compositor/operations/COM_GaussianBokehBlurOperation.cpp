@@ -30,6 +30,14 @@ extern "C" {
 GaussianBokehBlurOperation::GaussianBokehBlurOperation() : BlurBaseOperation(COM_DT_COLOR)
 {
 	this->m_gausstab = NULL;
+	this->m_fastbuffer = NULL;
+}
+
+bool GaussianBokehBlurOperation::use_fast_gauss() const
+{
+	/* a radial gaussian is separable, other filters are not */
+	return ((this->m_data.filtertype == R_FILTER_GAUSS) &&
+	        (max_ii(this->m_radx, this->m_rady) >= MIN_FAST_BLUR_RADIUS));
 }
 
 void *GaussianBokehBlurOperation::initializeTileData(rcti *rect)
@@ -39,6 +47,13 @@ void *GaussianBokehBlurOperation::initializeTileData(rcti *rect)
 		updateGauss();
 	}
 	void *buffer = getInputOperation(0)->initializeTileData(NULL);
+	if (use_fast_gauss()) {
+		if (this->m_fastbuffer == NULL) {
+			this->m_fastbuffer = ((MemoryBuffer *)buffer)->duplicate();
+			fast_blur(this->m_fastbuffer, this->m_radxf, this->m_radyf, 3);
+		}
+		buffer = this->m_fastbuffer;
+	}
 	unlockMutex();
 	return buffer;
 }
@@ -77,6 +92,8 @@ void GaussianBokehBlurOperation::updateGauss()
 	
 		this->m_radx = ceil(radxf);
 		this->m_rady = ceil(radyf);
+		this->m_radxf = radxf;
+		this->m_radyf = radyf;
 		
 		int ddwidth = 2 * this->m_radx + 1;
 		int ddheight = 2 * this->m_rady + 1;
@@ -116,6 +133,11 @@ void GaussianBokehBlurOperation::updateGauss()
 
 void GaussianBokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 {
+	if (this->m_fastbuffer) {
+		((MemoryBuffer *)data)->read(output, x, y);
+		return;
+	}
+
 	float tempColor[4];
 	tempColor[0] = 0;
 	tempColor[1] = 0;
@@ -162,6 +184,10 @@ void GaussianBokehBlurOperation::deinitExecution()
 		MEM_freeN(this->m_gausstab);
 		this->m_gausstab = NULL;
 	}
+	if (this->m_fastbuffer) {
+		delete this->m_fastbuffer;
+		this->m_fastbuffer = NULL;
+	}
 
 	deinitMutex();
 }
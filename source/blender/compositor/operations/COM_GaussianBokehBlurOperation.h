@@ -30,7 +30,11 @@ class GaussianBokehBlurOperation : public BlurBaseOperation {
 private:
 	float *m_gausstab;
 	int m_radx, m_rady;
+	float m_radxf, m_radyf;
+	/* whole blurred image when the gaussian is large enough for #fast_blur */
+	MemoryBuffer *m_fastbuffer;
 	void updateGauss();
+	bool use_fast_gauss() const;
 
 public:
 	GaussianBokehBlurOperation();
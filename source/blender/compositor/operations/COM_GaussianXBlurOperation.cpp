@@ -36,6 +36,7 @@ GaussianXBlurOperation::GaussianXBlurOperation() : BlurBaseOperation(COM_DT_COLO
 	this->m_gausstab_sse = NULL;
 #endif
 	this->m_filtersize = 0;
+	this->m_fastbuffer = NULL;
 }
 
 void *GaussianXBlurOperation::initializeTileData(rcti *rect)
@@ -45,6 +46,14 @@ void *GaussianXBlurOperation::initializeTileData(rcti *rect)
 		updateGauss();
 	}
 	void *buffer = getInputOperation(0)->initializeTileData(NULL);
+	if (use_fast_blur(this->m_filtersize)) {
+		if (this->m_fastbuffer == NULL) {
+			float rad = max_ff(m_size * m_data.sizex, 0.0f);
+			this->m_fastbuffer = ((MemoryBuffer *)buffer)->duplicate();
+			fast_blur(this->m_fastbuffer, rad, rad, 1);
+		}
+		buffer = this->m_fastbuffer;
+	}
 	unlockMutex();
 	return buffer;
 }
@@ -87,6 +96,11 @@ void GaussianXBlurOperation::updateGauss()
 
 void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *data)
 {
+	if (this->m_fastbuffer) {
+		((MemoryBuffer *)data)->read(output, x, y);
+		return;
+	}
+
 	float color_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 	float multiplier_accum = 0.0f;
 	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
@@ -165,6 +179,10 @@ void GaussianXBlurOperation::deinitExecution()
 		this->m_gausstab_sse = NULL;
 	}
 #endif
+	if (this->m_fastbuffer) {
+		delete this->m_fastbuffer;
+		this->m_fastbuffer = NULL;
+	}
 
 	deinitMutex();
 }
@@ -185,7 +203,7 @@ bool GaussianXBlurOperation::determineDependingAreaOfInterest(rcti *input, ReadB
 		}
 	}
 	{
-		if (this->m_sizeavailable && this->m_gausstab != NULL) {
+		if (this->m_sizeavailable && this->m_gausstab != NULL && !use_fast_blur(this->m_filtersize)) {
 			newInput.xmax = input->xmax + this->m_filtersize + 1;
 			newInput.xmin = input->xmin - this->m_filtersize - 1;
 			newInput.ymax = input->ymax;
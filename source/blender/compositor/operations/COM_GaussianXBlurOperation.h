@@ -32,6 +32,8 @@ private:
 	__m128 *m_gausstab_sse;
 #endif
 	int m_filtersize;
+	/* whole blurred image when the radius is large enough for #fast_blur */
+	MemoryBuffer *m_fastbuffer;
 	void updateGauss();
 public:
 	GaussianXBlurOperation();
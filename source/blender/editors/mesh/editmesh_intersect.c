@@ -124,7 +124,7 @@ static int edbm_intersect_exec(bContext *C, wmOperator *op)
 	        bm,
 	        em->looptris, em->tottri,
 	        test_fn, NULL,
-	        use_self, use_separate,
+	        use_self, use_separate, BMESH_ISECT_BOOLEAN_NONE,
 	        eps);
 
 
@@ -963,6 +963,9 @@ static int screen_render_invoke(bContext *C, wmOperator *op, const wmEvent *even
 	 */
 	op->customdata = scene;
 
+	/* the job renders the sequencer from its own thread, which can't stop the prefetch worker */
+	BKE_sequencer_prefetch_stop();
+
 	WM_jobs_start(CTX_wm_manager(C), wm_job);
 
 	WM_cursor_wait(0);
@@ -60,6 +60,7 @@
 #include "ED_gpencil.h"
 #include "ED_markers.h"
 #include "ED_mask.h"
+#include "ED_screen.h"
 #include "ED_sequencer.h"
 #include "ED_space_api.h"
 
@@ -825,6 +826,17 @@ static void UNUSED_FUNCTION(set_special_seq_update) (int val)
 	}
 }
 
+/* render ahead only during playback, and not with the overlay,
+ * which would stop prefetching to render a frame elsewhere */
+static bool sequencer_use_prefetch(Main *bmain, Scene *scene)
+{
+	if (U.prefetchframes == 0 || ED_screen_animation_playing(bmain->wm.first) == NULL) {
+		return false;
+	}
+
+	return !(scene->ed && (scene->ed->over_flag & SEQ_EDIT_OVERLAY_SHOW));
+}
+
 ImBuf *sequencer_ibuf_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, int cfra, int frame_ofs)
 {
 	SeqRenderData context;
@@ -861,10 +873,10 @@ ImBuf *sequencer_ibuf_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, int
 
 	if (special_seq_update)
 		ibuf = BKE_sequencer_give_ibuf_direct(&context, cfra + frame_ofs, special_seq_update);
-	else if (!U.prefetchframes) // XXX || (G.f & G_PLAYANIM) == 0) {
-		ibuf = BKE_sequencer_give_ibuf(&context, cfra + frame_ofs, sseq->chanshown);
-	else
+	else if (sequencer_use_prefetch(bmain, scene))
 		ibuf = BKE_sequencer_give_ibuf_threaded(&context, cfra + frame_ofs, sseq->chanshown);
+	else
+		ibuf = BKE_sequencer_give_ibuf(&context, cfra + frame_ofs, sseq->chanshown);
 
 	/* restore state so real rendering would be canceled (if needed) */
 	G.is_break = is_break;
@@ -1431,6 +1443,25 @@ static void seq_draw_sfra_efra(Scene *scene, View2D *v2d)
 	glDisable(GL_BLEND);
 }
 
+/* band along the bottom of the view over the frames rendered ahead by prefetching */
+static void seq_draw_prefetch_frames(Scene *scene, ARegion *ar)
+{
+	View2D *v2d = &ar->v2d;
+	const int frames = BKE_sequencer_prefetch_frames_ready(scene, scene->r.cfra);
+	float height;
+
+	if (frames == 0) {
+		return;
+	}
+
+	height = 4.0f * BLI_rctf_size_y(&v2d->cur) / (float)ar->winy;
+
+	glEnable(GL_BLEND);
+	glColor4ub(255, 255, 0, 96);
+	glRectf((float)scene->r.cfra, v2d->cur.ymin, (float)(scene->r.cfra + frames + 1), v2d->cur.ymin + height);
+	glDisable(GL_BLEND);
+}
+
 /* Draw Timeline/Strip Editor Mode for Sequencer */
 void draw_timeline_seq(const bContext *C, ARegion *ar)
 {
@@ -1469,6 +1500,7 @@ void draw_timeline_seq(const bContext *C, ARegion *ar)
 	ED_region_draw_cb_draw(C, ar, REGION_DRAW_PRE_VIEW);
 	
 	seq_draw_sfra_efra(scene, v2d);
+	seq_draw_prefetch_frames(scene, ar);
 
 	/* sequence strips (if there is data available to be drawn) */
 	if (ed) {
@@ -37,6 +37,8 @@
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BLF_translation.h"
 
@@ -135,16 +137,114 @@ static void proxy_freejob(void *pjv)
 	MEM_freeN(pj);
 }
 
+/* movie strips are rebuilt by several threads at once, each thread takes
+ * the next movie from the queue when it's done with the previous one */
+typedef struct ProxyQueue {
+	LinkData *link;
+	int tot, done;
+	SpinLock spin;
+
+	short *stop;
+	short *do_update;
+	float *progress;
+} ProxyQueue;
+
+static struct SeqIndexBuildContext *proxy_queue_next(ProxyQueue *queue, bool finished)
+{
+	struct SeqIndexBuildContext *context = NULL;
+
+	BLI_spin_lock(&queue->spin);
+	if (finished) {
+		queue->done++;
+
+		/* strips finish in any order, so progress is counted in whole strips */
+		*queue->do_update = true;
+		*queue->progress = (float)queue->done / queue->tot;
+	}
+
+	while (queue->link && !*queue->stop) {
+		LinkData *link = queue->link;
+
+		queue->link = link->next;
+
+		if (link->data && BKE_sequencer_proxy_rebuild_supports_threads(link->data)) {
+			context = link->data;
+			break;
+		}
+	}
+	BLI_spin_unlock(&queue->spin);
+
+	return context;
+}
+
+static void proxy_task_func(TaskPool *pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	ProxyQueue *queue = (ProxyQueue *)BLI_task_pool_userdata(pool);
+	struct SeqIndexBuildContext *context;
+	float progress = 0.0f;
+
+	for (context = proxy_queue_next(queue, false); context; context = proxy_queue_next(queue, true)) {
+		BKE_sequencer_proxy_rebuild(context, queue->stop, queue->do_update, &progress);
+	}
+}
+
+static void proxy_rebuild_threaded(ProxyJob *pj, short *stop, short *do_update, float *progress)
+{
+	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+	TaskPool *task_pool;
+	ProxyQueue queue;
+	LinkData *link;
+	int i, tot_thread = BLI_task_scheduler_num_threads(task_scheduler);
+
+	queue.link = pj->queue.first;
+	queue.tot = 0;
+	queue.done = 0;
+	queue.stop = stop;
+	queue.do_update = do_update;
+	queue.progress = progress;
+
+	for (link = pj->queue.first; link; link = link->next) {
+		if (link->data && BKE_sequencer_proxy_rebuild_supports_threads(link->data)) {
+			queue.tot++;
+		}
+	}
+
+	if (queue.tot == 0) {
+		return;
+	}
+
+	BLI_spin_init(&queue.spin);
+
+	task_pool = BLI_task_pool_create(task_scheduler, &queue);
+
+	for (i = 0; i < min_ii(tot_thread, queue.tot); i++) {
+		BLI_task_pool_push(task_pool, proxy_task_func, NULL, false, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	BLI_spin_end(&queue.spin);
+}
+
 /* only this runs inside thread */
 static void proxy_startjob(void *pjv, short *stop, short *do_update, float *progress)
 {
 	ProxyJob *pj = pjv;
 	LinkData *link;
 
+	proxy_rebuild_threaded(pj, stop, do_update, progress);
+
 	for (link = pj->queue.first; link; link = link->next) {
 		struct SeqIndexBuildContext *context = link->data;
 
-		BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+		if (*stop) {
+			break;
+		}
+
+		if (context && !BKE_sequencer_proxy_rebuild_supports_threads(context)) {
+			BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+		}
 	}
 
 	if (*stop) {
@@ -1937,6 +2037,9 @@ static int sequencer_cut_exec(bContext *C, wmOperator *op)
 	cut_frame = RNA_int_get(op->ptr, "frame");
 	cut_hard = RNA_enum_get(op->ptr, "type");
 	cut_side = RNA_enum_get(op->ptr, "side");
+
+	/* the prefetch worker walks the strip lists changed below */
+	BKE_sequencer_prefetch_stop();
 	
 	if (cut_hard == SEQ_CUT_HARD) {
 		changed = cut_seq_list(scene, ed->seqbasep, cut_frame, cut_seq_hard);
@@ -2049,6 +2152,8 @@ static int sequencer_add_duplicate_exec(bContext *C, wmOperator *UNUSED(op))
 	if (ed == NULL)
 		return OPERATOR_CANCELLED;
 
+	BKE_sequencer_prefetch_stop();
+
 	BKE_sequence_base_dupli_recursive(scene, NULL, &nseqbase, ed->seqbasep, SEQ_DUPE_CONTEXT);
 
 	if (nseqbase.first) {
@@ -2093,6 +2198,8 @@ static int sequencer_delete_exec(bContext *C, wmOperator *UNUSED(op))
 	MetaStack *ms;
 	bool nothingSelected = true;
 
+	BKE_sequencer_prefetch_stop();
+
 	seq = BKE_sequencer_active_get(scene);
 	if (seq && seq->flag & SELECT) { /* avoid a loop since this is likely to be selected */
 		nothingSelected = false;
@@ -2240,6 +2347,8 @@ static int sequencer_separate_images_exec(bContext *C, wmOperator *op)
 	int start_ofs, cfra, frame_end;
 	int step = RNA_int_get(op->ptr, "length");
 
+	BKE_sequencer_prefetch_stop();
+
 	seq = ed->seqbasep->first; /* poll checks this is valid */
 
 	while (seq) {
@@ -2339,6 +2448,8 @@ static int sequencer_meta_toggle_exec(bContext *C, wmOperator *UNUSED(op))
 	Sequence *last_seq = BKE_sequencer_active_get(scene);
 	MetaStack *ms;
 
+	BKE_sequencer_prefetch_stop();
+
 	if (last_seq && last_seq->type == SEQ_TYPE_META && last_seq->flag & SELECT) {
 		/* Enter Metastrip */
 		ms = MEM_mallocN(sizeof(MetaStack), "metastack");
@@ -2430,6 +2541,8 @@ static int sequencer_meta_make_exec(bContext *C, wmOperator *op)
 		return OPERATOR_CANCELLED;
 	}
 
+	BKE_sequencer_prefetch_stop();
+
 	/* remove all selected from main list, and put in meta */
 
 	seqm = BKE_sequence_alloc(ed->seqbasep, 1, 1); /* channel number set later */
@@ -2503,6 +2616,8 @@ static int sequencer_meta_separate_exec(bContext *C, wmOperator *UNUSED(op))
 	if (last_seq == NULL || last_seq->type != SEQ_TYPE_META)
 		return OPERATOR_CANCELLED;
 
+	BKE_sequencer_prefetch_stop();
+
 	for (seq = last_seq->seqbase.first; seq != NULL; seq = seq->next) {
 		BKE_sequence_invalidate_cache(scene, seq);
 	}
@@ -3124,6 +3239,9 @@ static int sequencer_copy_exec(bContext *C, wmOperator *op)
 		return OPERATOR_CANCELLED;
 	}
 
+	/* copied strips are added to the edit temporarily */
+	BKE_sequencer_prefetch_stop();
+
 	BKE_sequence_base_dupli_recursive(scene, NULL, &nseqbase, ed->seqbasep, SEQ_DUPE_UNIQUE_NAME);
 
 	/* To make sure the copied strips have unique names between each other add
@@ -3188,6 +3306,8 @@ static int sequencer_paste_exec(bContext *C, wmOperator *UNUSED(op))
 	int ofs;
 	Sequence *iseq, *iseq_first;
 
+	BKE_sequencer_prefetch_stop();
+
 	ED_sequencer_deselect_all(scene);
 	ofs = scene->r.cfra - seqbase_clipboard_frame;
 
@@ -3256,6 +3376,8 @@ static int sequencer_swap_data_exec(bContext *C, wmOperator *op)
 		return OPERATOR_CANCELLED;
 	}
 
+	BKE_sequencer_prefetch_stop();
+
 	if (BKE_sequence_swap(seq_act, seq_other, &error_msg) == 0) {
 		BKE_report(op->reports, RPT_ERROR, error_msg);
 		return OPERATOR_CANCELLED;
@@ -3459,6 +3581,8 @@ static int sequencer_change_effect_type_exec(bContext *C, wmOperator *op)
 		return OPERATOR_CANCELLED;
 	}
 
+	BKE_sequencer_prefetch_stop();
+
 	/* can someone explain the logic behind only allowing to increase this,
 	 * copied from 2.4x - campbell */
 	if (BKE_sequence_effect_get_num_inputs(seq->type) <
@@ -3513,6 +3637,8 @@ static int sequencer_change_path_exec(bContext *C, wmOperator *op)
 	Sequence *seq = BKE_sequencer_active_get(scene);
 	const bool is_relative_path = RNA_boolean_get(op->ptr, "relative_path");
 
+	BKE_sequencer_prefetch_stop();
+
 	if (seq->type == SEQ_TYPE_IMAGE) {
 		char directory[FILE_MAX];
 		const int len = RNA_property_collection_length(op->ptr, RNA_struct_find_property(op->ptr, "files"));
@@ -269,6 +269,7 @@ bool IMB_anim_get_fps(struct anim *anim,
 struct anim *IMB_open_anim(const char *name, int ib_flags, int streamindex, char colorspace[IM_MAX_SPACE]);
 void IMB_close_anim(struct anim *anim);
 void IMB_close_anim_proxies(struct anim *anim);
+void IMB_anim_readahead_stop(struct anim *anim);
 
 
 /**
@@ -76,6 +76,7 @@
 #  include <libavformat/avformat.h>
 #  include <libavcodec/avcodec.h>
 #  include <libswscale/swscale.h>
+#  include "BLI_threads.h"
 #endif
 
 #ifdef WITH_REDCODE
@@ -108,6 +109,13 @@
 #  define LITTLE_LONG ENDIAN_NOP
 #endif
 
+/* frames an ffmpeg anim decodes ahead during sequential playback */
+#define FFMPEG_READAHEAD_FRAMES 4
+
+/* decoding threads per ffmpeg anim, several movies may be decoded at once
+ * and every frame thread adds a frame of latency when seeking */
+#define FFMPEG_CODEC_THREADS_MAX 4
+
 /* anim.curtype, runtime only */
 #define ANIM_NONE       0
 #define ANIM_SEQUENCE   (1 << 0)
@@ -179,6 +187,22 @@ struct anim {
 	int64_t last_pts;
 	int64_t next_pts;
 	AVPacket next_packet;
+
+	/* decoder state above is only used with decode_lock held, frames
+	 * decoded ahead by readahead_thread are kept in readahead_frames,
+	 * starting at readahead_position, guarded by readahead_lock */
+	ThreadMutex decode_lock;
+	ThreadMutex readahead_lock;
+	ThreadCondition readahead_cond;
+	pthread_t readahead_thread;
+	struct ImBuf *readahead_frames[FFMPEG_READAHEAD_FRAMES];
+	int readahead_position;
+	int readahead_count;
+	int readahead_tc;
+	int readahead_last_request;
+	bool readahead_active;
+	bool readahead_running;
+	bool readahead_stop;
 #endif
 
 #ifdef WITH_REDCODE
@@ -128,4 +128,11 @@ struct anim_index *IMB_anim_open_index(
 int IMB_proxy_size_to_array_index(IMB_Proxy_Size pr_size);
 int IMB_timecode_to_array_index(IMB_Timecode_Type tc);
 
+#ifdef WITH_FFMPEG
+/* avcodec_open2() and avcodec_close() behind a lock shared by movie playback
+ * and proxy building, which can run from several threads at once */
+int IMB_ffmpeg_codec_open(AVCodecContext *pCodecCtx, AVCodec *pCodec);
+void IMB_ffmpeg_codec_close(AVCodecContext *pCodecCtx);
+#endif
+
 #endif
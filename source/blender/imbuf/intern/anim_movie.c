@@ -67,6 +67,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_string.h"
 #include "BLI_path_util.h"
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -264,14 +265,44 @@ void IMB_close_anim(struct anim *anim)
 	IMB_free_anim(anim);
 }
 
+#ifdef WITH_FFMPEG
+static void ffmpeg_readahead_stop(struct anim *anim);
+#endif
+
 void IMB_close_anim_proxies(struct anim *anim)
 {
 	if (anim == NULL)
 		return;
 
+#ifdef WITH_FFMPEG
+	/* readahead uses the timecode indices */
+	if (anim->pCodecCtx) {
+		ffmpeg_readahead_stop(anim);
+	}
+#endif
+
 	IMB_free_indices(anim);
 }
 
+/* Stop decoding frames ahead, for when sequential playback ended. */
+void IMB_anim_readahead_stop(struct anim *anim)
+{
+	int i;
+
+	if (anim == NULL)
+		return;
+
+#ifdef WITH_FFMPEG
+	if (anim->pCodecCtx) {
+		ffmpeg_readahead_stop(anim);
+	}
+#endif
+
+	for (i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
+		IMB_anim_readahead_stop(anim->proxy_anim[i]);
+	}
+}
+
 struct anim *IMB_open_anim(const char *name, int ib_flags, int streamindex, char colorspace[IM_MAX_SPACE])
 {
 	struct anim *anim;
@@ -458,6 +489,28 @@ static ImBuf *avi_fetchibuf(struct anim *anim, int position)
 
 #ifdef WITH_FFMPEG
 
+/* opening and closing codecs isn't thread safe in ffmpeg without a lock manager,
+ * and movies can be decoded from several threads (sequencer strips, proxies) */
+static ThreadMutex ffmpeg_codec_lock = BLI_MUTEX_INITIALIZER;
+
+int IMB_ffmpeg_codec_open(AVCodecContext *pCodecCtx, AVCodec *pCodec)
+{
+	int ret;
+
+	BLI_mutex_lock(&ffmpeg_codec_lock);
+	ret = avcodec_open2(pCodecCtx, pCodec, NULL);
+	BLI_mutex_unlock(&ffmpeg_codec_lock);
+
+	return ret;
+}
+
+void IMB_ffmpeg_codec_close(AVCodecContext *pCodecCtx)
+{
+	BLI_mutex_lock(&ffmpeg_codec_lock);
+	avcodec_close(pCodecCtx);
+	BLI_mutex_unlock(&ffmpeg_codec_lock);
+}
+
 static int startffmpeg(struct anim *anim)
 {
 	int i, videoStream;
@@ -522,7 +575,13 @@ static int startffmpeg(struct anim *anim)
 
 	pCodecCtx->workaround_bugs = 1;
 
-	if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
+#ifdef FF_THREAD_FRAME
+	/* let ffmpeg decode on multiple threads too */
+	pCodecCtx->thread_count = MIN2(BLI_system_thread_count(), FFMPEG_CODEC_THREADS_MAX);
+	pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+#endif
+
+	if (IMB_ffmpeg_codec_open(pCodecCtx, pCodec) < 0) {
 		avformat_close_input(&pFormatCtx);
 		return -1;
 	}
@@ -575,7 +634,7 @@ static int startffmpeg(struct anim *anim)
 	{
 		fprintf(stderr,
 		        "ffmpeg has changed alloc scheme ... ARGHHH!\n");
-		avcodec_close(anim->pCodecCtx);
+		IMB_ffmpeg_codec_close(anim->pCodecCtx);
 		avformat_close_input(&anim->pFormatCtx);
 		av_free(anim->pFrameRGB);
 		av_free(anim->pFrameDeinterlaced);
@@ -616,7 +675,7 @@ static int startffmpeg(struct anim *anim)
 	if (!anim->img_convert_ctx) {
 		fprintf(stderr,
 		        "Can't transform color space??? Bailing out...\n");
-		avcodec_close(anim->pCodecCtx);
+		IMB_ffmpeg_codec_close(anim->pCodecCtx);
 		avformat_close_input(&anim->pFormatCtx);
 		av_free(anim->pFrameRGB);
 		av_free(anim->pFrameDeinterlaced);
@@ -643,6 +702,15 @@ static int startffmpeg(struct anim *anim)
 		fprintf(stderr, "Warning: Could not set libswscale colorspace details.\n");
 	}
 #endif
+
+	BLI_mutex_init(&anim->decode_lock);
+	BLI_mutex_init(&anim->readahead_lock);
+	BLI_condition_init(&anim->readahead_cond);
+	anim->readahead_count = 0;
+	anim->readahead_last_request = -2;
+	anim->readahead_active = false;
+	anim->readahead_running = false;
+	anim->readahead_stop = false;
 		
 	return (0);
 }
@@ -1137,12 +1205,208 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	return anim->last_frame;
 }
 
+/* Readahead: during sequential playback a thread keeps decoding the frames after
+ * the last one requested, so decoding and the colorspace conversion of the next
+ * frames overlap with the caller using the current one. Random access (scrubbing,
+ * thumbnails) decodes on the calling thread only, as before. */
+
+static void ffmpeg_readahead_clear(struct anim *anim)
+{
+	int i;
+
+	for (i = 0; i < anim->readahead_count; i++) {
+		IMB_freeImBuf(anim->readahead_frames[i]);
+	}
+	anim->readahead_count = 0;
+}
+
+/* drop the frames before position, the next frame to decode stays the same */
+static void ffmpeg_readahead_skip_to(struct anim *anim, int position)
+{
+	int skip = position - anim->readahead_position;
+	int i;
+
+	for (i = 0; i < skip; i++) {
+		IMB_freeImBuf(anim->readahead_frames[i]);
+	}
+
+	anim->readahead_count -= skip;
+	memmove(anim->readahead_frames, anim->readahead_frames + skip,
+	        sizeof(*anim->readahead_frames) * anim->readahead_count);
+	anim->readahead_position = position;
+}
+
+/* hand the first frame to the caller, the next frame to decode stays the same */
+static ImBuf *ffmpeg_readahead_take_first(struct anim *anim)
+{
+	ImBuf *ibuf = anim->readahead_frames[0];
+
+	anim->readahead_count--;
+	memmove(anim->readahead_frames, anim->readahead_frames + 1,
+	        sizeof(*anim->readahead_frames) * anim->readahead_count);
+	anim->readahead_position++;
+
+	return ibuf;
+}
+
+/* still the frame readahead wants next, call with readahead_lock held */
+static bool ffmpeg_readahead_wants(struct anim *anim, int position, int tc)
+{
+	return (anim->readahead_active && !anim->readahead_stop &&
+	        anim->readahead_tc == tc &&
+	        anim->readahead_position + anim->readahead_count == position);
+}
+
+static void *ffmpeg_readahead_thread(void *anim_v)
+{
+	struct anim *anim = anim_v;
+
+	BLI_mutex_lock(&anim->readahead_lock);
+
+	while (!anim->readahead_stop) {
+		ImBuf *ibuf = NULL;
+		int position, tc;
+
+		if (!anim->readahead_active || anim->readahead_count == FFMPEG_READAHEAD_FRAMES) {
+			BLI_condition_wait(&anim->readahead_cond, &anim->readahead_lock);
+			continue;
+		}
+
+		position = anim->readahead_position + anim->readahead_count;
+		tc = anim->readahead_tc;
+		BLI_mutex_unlock(&anim->readahead_lock);
+
+		BLI_mutex_lock(&anim->decode_lock);
+
+		/* the caller may have started decoding elsewhere while we waited for the decoder */
+		BLI_mutex_lock(&anim->readahead_lock);
+		if (ffmpeg_readahead_wants(anim, position, tc)) {
+			BLI_mutex_unlock(&anim->readahead_lock);
+
+			if (position < anim->duration) {
+				ibuf = ffmpeg_fetchibuf(anim, position, tc);
+			}
+			BLI_mutex_unlock(&anim->decode_lock);
+
+			BLI_mutex_lock(&anim->readahead_lock);
+			if (ffmpeg_readahead_wants(anim, position, tc)) {
+				if (ibuf) {
+					anim->readahead_frames[anim->readahead_count++] = ibuf;
+					ibuf = NULL;
+				}
+				else {
+					/* end of the movie */
+					anim->readahead_active = false;
+				}
+			}
+		}
+		else {
+			BLI_mutex_unlock(&anim->decode_lock);
+		}
+
+		if (ibuf) {
+			IMB_freeImBuf(ibuf);
+		}
+
+		BLI_condition_notify_all(&anim->readahead_cond);
+	}
+
+	BLI_mutex_unlock(&anim->readahead_lock);
+
+	return NULL;
+}
+
+static void ffmpeg_readahead_stop(struct anim *anim)
+{
+	if (!anim->readahead_running) {
+		return;
+	}
+
+	BLI_mutex_lock(&anim->readahead_lock);
+	anim->readahead_stop = true;
+	BLI_condition_notify_all(&anim->readahead_cond);
+	BLI_mutex_unlock(&anim->readahead_lock);
+
+	pthread_join(anim->readahead_thread, NULL);
+	BLI_end_threaded_malloc();
+
+	anim->readahead_running = false;
+	anim->readahead_stop = false;
+	anim->readahead_active = false;
+	ffmpeg_readahead_clear(anim);
+}
+
+static ImBuf *ffmpeg_fetchibuf_readahead(struct anim *anim, int position,
+                                         IMB_Timecode_Type tc)
+{
+	ImBuf *ibuf = NULL;
+	bool sequential;
+
+	BLI_mutex_lock(&anim->readahead_lock);
+
+	if (anim->readahead_active && anim->readahead_tc == (int)tc &&
+	    position >= anim->readahead_position &&
+	    position <= anim->readahead_position + anim->readahead_count)
+	{
+		/* decoded already, or the next frame to decode: wait for it */
+		ffmpeg_readahead_skip_to(anim, position);
+		BLI_condition_notify_all(&anim->readahead_cond);
+
+		while (anim->readahead_active && anim->readahead_count == 0) {
+			BLI_condition_wait(&anim->readahead_cond, &anim->readahead_lock);
+		}
+
+		if (anim->readahead_active) {
+			/* the caller owns the frame and may change its pixels */
+			ibuf = ffmpeg_readahead_take_first(anim);
+			BLI_condition_notify_all(&anim->readahead_cond);
+		}
+	}
+
+	sequential = (position == anim->readahead_last_request + 1);
+	anim->readahead_last_request = position;
+
+	BLI_mutex_unlock(&anim->readahead_lock);
+
+	if (ibuf) {
+		return ibuf;
+	}
+
+	/* sequential access stopped, don't keep the thread and its frames around */
+	ffmpeg_readahead_stop(anim);
+
+	BLI_mutex_lock(&anim->decode_lock);
+	ibuf = ffmpeg_fetchibuf(anim, position, tc);
+	BLI_mutex_unlock(&anim->decode_lock);
+
+	if (ibuf && sequential) {
+		anim->readahead_position = position + 1;
+		anim->readahead_count = 0;
+		anim->readahead_tc = (int)tc;
+		anim->readahead_active = true;
+
+		BLI_begin_threaded_malloc();
+		if (pthread_create(&anim->readahead_thread, NULL, ffmpeg_readahead_thread, anim) == 0) {
+			anim->readahead_running = true;
+		}
+		else {
+			/* keep decoding on the calling thread */
+			BLI_end_threaded_malloc();
+			anim->readahead_active = false;
+		}
+	}
+
+	return ibuf;
+}
+
 static void free_anim_ffmpeg(struct anim *anim)
 {
 	if (anim == NULL) return;
 
 	if (anim->pCodecCtx) {
-		avcodec_close(anim->pCodecCtx);
+		ffmpeg_readahead_stop(anim);
+
+		IMB_ffmpeg_codec_close(anim->pCodecCtx);
 		avformat_close_input(&anim->pFormatCtx);
 		av_free(anim->pFrameRGB);
 		av_free(anim->pFrame);
@@ -1156,6 +1420,10 @@ static void free_anim_ffmpeg(struct anim *anim)
 		if (anim->next_packet.stream_index != -1) {
 			av_free_packet(&anim->next_packet);
 		}
+
+		BLI_mutex_end(&anim->decode_lock);
+		BLI_mutex_end(&anim->readahead_lock);
+		BLI_condition_end(&anim->readahead_cond);
 	}
 	anim->duration = 0;
 }
@@ -1385,9 +1653,8 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim, int position,
 #endif
 #ifdef WITH_FFMPEG
 		case ANIM_FFMPEG:
-			ibuf = ffmpeg_fetchibuf(anim, position, tc);
-			if (ibuf)
-				anim->curposition = position;
+			/* curposition is the decoder's, set when fetching */
+			ibuf = ffmpeg_fetchibuf_readahead(anim, position, tc);
 			filter_y = 0; /* done internally */
 			break;
 #endif
@@ -1401,7 +1668,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim, int position,
 
 	if (ibuf) {
 		if (filter_y) IMB_filtery(ibuf);
-		BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, anim->curposition + 1);
+		BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, position + 1);
 		
 	}
 	return(ibuf);
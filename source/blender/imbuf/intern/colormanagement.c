@@ -1226,8 +1226,19 @@ const char *IMB_colormanagement_get_rect_colorspace(ImBuf *ibuf)
 
 /*********************** Threaded display buffer transform routines *************************/
 
+/* Byte buffers only have 256 values per channel, so when the display transform
+ * handles every channel on its own (no channel mixing in color space, view or
+ * look) it's fully described by one table per channel. */
+typedef struct DisplayBufferByteLUT {
+	float table[4][256];
+} DisplayBufferByteLUT;
+
+/* smaller buffers are cheaper to transform directly than to compute the tables */
+#define DISPLAY_BUFFER_BYTE_LUT_MIN_PIXELS (64 * 64)
+
 typedef struct DisplayBufferThread {
 	ColormanageProcessor *cm_processor;
+	const DisplayBufferByteLUT *byte_lut;
 
 	const float *buffer;
 	unsigned char *byte_buffer;
@@ -1250,6 +1261,7 @@ typedef struct DisplayBufferThread {
 typedef struct DisplayBufferInitData {
 	ImBuf *ibuf;
 	ColormanageProcessor *cm_processor;
+	const DisplayBufferByteLUT *byte_lut;
 	const float *buffer;
 	unsigned char *byte_buffer;
 
@@ -1278,6 +1290,7 @@ static void display_buffer_init_handle(void *handle_v, int start_line, int tot_l
 	memset(handle, 0, sizeof(DisplayBufferThread));
 
 	handle->cm_processor = init_data->cm_processor;
+	handle->byte_lut = init_data->byte_lut;
 
 	if (init_data->buffer)
 		handle->buffer = init_data->buffer + offset;
@@ -1381,6 +1394,38 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
 	}
 }
 
+static void display_buffer_apply_processor(DisplayBufferThread *handle, int height,
+                                           float *linear_buffer, bool predivide)
+{
+	if (handle->is_data) {
+		/* special case for data buffers - no color space conversions,
+		 * only generate byte buffers
+		 */
+	}
+	else {
+		/* apply processor */
+		IMB_colormanagement_processor_apply(handle->cm_processor, linear_buffer, handle->width, height,
+		                                    handle->channels, predivide);
+	}
+}
+
+/* same result as display_buffer_apply_get_linear_buffer() followed by
+ * display_buffer_apply_processor() for byte buffers, using the tables */
+static void display_buffer_apply_byte_lut(DisplayBufferThread *handle, int height, float *linear_buffer)
+{
+	const DisplayBufferByteLUT *lut = handle->byte_lut;
+	const unsigned char *cp = handle->byte_buffer;
+	float *fp = linear_buffer;
+	int channels = handle->channels;
+	int i, c;
+
+	for (i = 0; i < handle->width * height; i++, fp += channels, cp += channels) {
+		for (c = 0; c < channels; c++) {
+			fp[c] = lut->table[c][cp[c]];
+		}
+	}
+}
+
 static void *do_display_buffer_apply_thread(void *handle_v)
 {
 	DisplayBufferThread *handle = (DisplayBufferThread *) handle_v;
@@ -1391,7 +1436,6 @@ static void *do_display_buffer_apply_thread(void *handle_v)
 	int width = handle->width;
 	int height = handle->tot_line;
 	float dither = handle->dither;
-	bool is_data = handle->is_data;
 
 	if (cm_processor == NULL) {
 		if (display_buffer_byte) {
@@ -1409,19 +1453,17 @@ static void *do_display_buffer_apply_thread(void *handle_v)
 		float *linear_buffer = MEM_mallocN(channels * width * height * sizeof(float),
 		                                   "color conversion linear buffer");
 
-		display_buffer_apply_get_linear_buffer(handle, height, linear_buffer, &is_straight_alpha);
-
-		predivide = is_straight_alpha == false;
-
-		if (is_data) {
-			/* special case for data buffers - no color space conversions,
-			 * only generate byte buffers
-			 */
+		if (handle->byte_lut) {
+			display_buffer_apply_byte_lut(handle, height, linear_buffer);
+			is_straight_alpha = true;
+			predivide = false;
 		}
 		else {
-			/* apply processor */
-			IMB_colormanagement_processor_apply(cm_processor, linear_buffer, width, height, channels,
-			                                    predivide);
+			display_buffer_apply_get_linear_buffer(handle, height, linear_buffer, &is_straight_alpha);
+
+			predivide = is_straight_alpha == false;
+
+			display_buffer_apply_processor(handle, height, linear_buffer, predivide);
 		}
 
 		/* copy result to output buffers */
@@ -1454,13 +1496,86 @@ static void *do_display_buffer_apply_thread(void *handle_v)
 	return NULL;
 }
 
+/* Run the byte buffer transform on a ramp where all channels have the same
+ * value to fill in the tables. A second set of pixels with different values
+ * per channel has to match the tables exactly, otherwise the transform mixes
+ * channels and NULL is returned so every pixel is transformed as usual. */
+static DisplayBufferByteLUT *display_buffer_byte_lut_create(DisplayBufferInitData *init_data)
+{
+	ImBuf *ibuf = init_data->ibuf;
+	DisplayBufferThread handle;
+	DisplayBufferByteLUT *lut;
+	unsigned char *probe_buffer;
+	float *linear_buffer, *fp;
+	int channels = ibuf->channels;
+	int width = 2 * 256;
+	bool is_straight_alpha;
+	int i, c;
+
+	if (!ELEM(channels, 3, 4)) {
+		return NULL;
+	}
+
+	probe_buffer = MEM_mallocN(channels * width * sizeof(unsigned char), "display byte lut probe buffer");
+	linear_buffer = MEM_mallocN(channels * width * sizeof(float), "display byte lut linear buffer");
+
+	for (i = 0; i < 256; i++) {
+		for (c = 0; c < channels; c++) {
+			probe_buffer[i * channels + c] = i;
+			probe_buffer[(256 + i) * channels + c] = (i * (2 * c + 1) * 37 + c * 101) & 255;
+		}
+	}
+
+	memset(&handle, 0, sizeof(handle));
+	handle.cm_processor = init_data->cm_processor;
+	handle.byte_buffer = probe_buffer;
+	handle.width = width;
+	handle.tot_line = 1;
+	handle.channels = channels;
+	handle.is_data = (ibuf->colormanage_flag & IMB_COLORMANAGE_IS_DATA) != 0;
+	handle.byte_colorspace = init_data->byte_colorspace;
+
+	display_buffer_apply_get_linear_buffer(&handle, 1, linear_buffer, &is_straight_alpha);
+	BLI_assert(is_straight_alpha);
+	display_buffer_apply_processor(&handle, 1, linear_buffer, false);
+
+	lut = MEM_mallocN(sizeof(DisplayBufferByteLUT), "display byte lut");
+
+	for (i = 0, fp = linear_buffer; i < 256; i++, fp += channels) {
+		for (c = 0; c < channels; c++) {
+			lut->table[c][i] = fp[c];
+		}
+	}
+
+	for (i = 256; i < width; i++, fp += channels) {
+		for (c = 0; c < channels; c++) {
+			if (fp[c] != lut->table[c][probe_buffer[i * channels + c]]) {
+				MEM_freeN(lut);
+				lut = NULL;
+				break;
+			}
+		}
+
+		if (lut == NULL) {
+			break;
+		}
+	}
+
+	MEM_freeN(probe_buffer);
+	MEM_freeN(linear_buffer);
+
+	return lut;
+}
+
 static void display_buffer_apply_threaded(ImBuf *ibuf, float *buffer, unsigned char *byte_buffer, float *display_buffer,
                                           unsigned char *display_buffer_byte, ColormanageProcessor *cm_processor)
 {
 	DisplayBufferInitData init_data;
+	DisplayBufferByteLUT *byte_lut = NULL;
 
 	init_data.ibuf = ibuf;
 	init_data.cm_processor = cm_processor;
+	init_data.byte_lut = NULL;
 	init_data.buffer = buffer;
 	init_data.byte_buffer = byte_buffer;
 	init_data.display_buffer = display_buffer;
@@ -1484,8 +1599,18 @@ static void display_buffer_apply_threaded(ImBuf *ibuf, float *buffer, unsigned c
 		init_data.float_colorspace = NULL;
 	}
 
+	if (buffer == NULL && byte_buffer && cm_processor &&
+	    (size_t)ibuf->x * ibuf->y > DISPLAY_BUFFER_BYTE_LUT_MIN_PIXELS)
+	{
+		byte_lut = display_buffer_byte_lut_create(&init_data);
+		init_data.byte_lut = byte_lut;
+	}
+
 	IMB_processor_apply_threaded(ibuf->y, sizeof(DisplayBufferThread), &init_data,
 	                             display_buffer_init_handle, do_display_buffer_apply_thread);
+
+	if (byte_lut)
+		MEM_freeN(byte_lut);
 }
 
 static bool is_ibuf_rect_in_display_space(ImBuf *ibuf, const ColorManagedViewSettings *view_settings,
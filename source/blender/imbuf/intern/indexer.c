@@ -35,6 +35,8 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_fileops.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "IMB_indexer.h"
 #include "IMB_anim.h"
@@ -536,6 +538,10 @@ static struct proxy_output_ctx *alloc_proxy_output_ffmpeg(
 		rv->c->flags |= CODEC_FLAG_GLOBAL_HEADER;
 	}
 
+	/* the proxy sizes are encoded in parallel already, as tasks that share
+	 * the threads with the other movies being indexed */
+	rv->c->thread_count = 1;
+
 	if (avio_open(&rv->of->pb, fname, AVIO_FLAG_WRITE) < 0) {
 		fprintf(stderr, "Couldn't open outputfile! "
 		        "Proxy not built!\n");
@@ -543,7 +549,7 @@ static struct proxy_output_ctx *alloc_proxy_output_ffmpeg(
 		return 0;
 	}
 
-	avcodec_open2(rv->c, rv->codec, NULL);
+	IMB_ffmpeg_codec_open(rv->c, rv->codec);
 
 	rv->orig_height = av_get_cropped_height_from_codec(st->codec);
 
@@ -658,7 +664,7 @@ static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx,
 
 	av_write_trailer(ctx->of);
 	
-	avcodec_close(ctx->c);
+	IMB_ffmpeg_codec_close(ctx->c);
 	
 	if (ctx->of->oformat) {
 		if (!(ctx->of->oformat->flags & AVFMT_NOFILE)) {
@@ -705,6 +711,11 @@ typedef struct FFmpegIndexBuilderContext {
 	struct proxy_output_ctx *proxy_ctx[IMB_PROXY_MAX_SLOT];
 	anim_index_builder *indexer[IMB_TC_MAX_SLOT];
 
+	/* decoded frames are copied into proxy_frame and scaled and encoded for
+	 * every proxy size in parallel, while the next frame is being decoded */
+	TaskPool *proxy_task_pool;
+	AVFrame *proxy_frame;
+
 	IMB_Timecode_Type tcs_in_use;
 	IMB_Proxy_Size proxy_sizes_in_use;
 
@@ -780,7 +791,11 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim, IMB_Tim
 
 	context->iCodecCtx->workaround_bugs = 1;
 
-	if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
+	/* several movies may be indexed at once, one decoder per task keeps
+	 * the total number of threads at the number of cores */
+	context->iCodecCtx->thread_count = 1;
+
+	if (IMB_ffmpeg_codec_open(context->iCodecCtx, context->iCodec) < 0) {
 		avformat_close_input(&context->iFormatCtx);
 		MEM_freeN(context);
 		return NULL;
@@ -832,12 +847,50 @@ static void index_rebuild_ffmpeg_finish(FFmpegIndexBuilderContext *context, int
 		}
 	}
 
-	avcodec_close(context->iCodecCtx);
+	IMB_ffmpeg_codec_close(context->iCodecCtx);
 	avformat_close_input(&context->iFormatCtx);
 
 	MEM_freeN(context);
 }
 
+static void index_rebuild_ffmpeg_proxy_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	FFmpegIndexBuilderContext *context = BLI_task_pool_userdata(pool);
+	struct proxy_output_ctx *ctx = taskdata;
+
+	add_to_proxy_output_ffmpeg(ctx, context->proxy_frame);
+}
+
+static void index_rebuild_ffmpeg_proxy_frame(FFmpegIndexBuilderContext *context, AVFrame *in_frame)
+{
+	AVCodecContext *codec_ctx = context->iCodecCtx;
+	int i;
+
+	/* the previous frame is still read by the encoders */
+	BLI_task_pool_work_and_wait(context->proxy_task_pool);
+
+	if (context->proxy_sizes_in_use == 0) {
+		return;
+	}
+
+	if (context->proxy_frame == NULL) {
+		context->proxy_frame = avcodec_alloc_frame();
+		avpicture_alloc((AVPicture *) context->proxy_frame, codec_ctx->pix_fmt,
+		                codec_ctx->width, codec_ctx->height);
+	}
+
+	/* the decoder reuses in_frame for the next frame */
+	av_picture_copy((AVPicture *) context->proxy_frame, (const AVPicture *) in_frame,
+	                codec_ctx->pix_fmt, codec_ctx->width, codec_ctx->height);
+
+	for (i = 0; i < context->num_proxy_sizes; i++) {
+		if (context->proxy_ctx[i]) {
+			BLI_task_pool_push(context->proxy_task_pool, index_rebuild_ffmpeg_proxy_task,
+			                   context->proxy_ctx[i], false, TASK_PRIORITY_LOW);
+		}
+	}
+}
+
 static void index_rebuild_ffmpeg_proc_decoded_frame(
 	FFmpegIndexBuilderContext *context, 
 	AVPacket * curr_packet,
@@ -848,9 +901,7 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(
 	unsigned long long s_dts = context->seek_pos_dts;
 	unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
 
-	for (i = 0; i < context->num_proxy_sizes; i++) {
-		add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
-	}
+	index_rebuild_ffmpeg_proxy_frame(context, in_frame);
 
 	if (!context->start_pts_set) {
 		context->start_pts = pts;
@@ -903,6 +954,8 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 
 	in_frame = avcodec_alloc_frame();
 
+	context->proxy_task_pool = BLI_task_pool_create(BLI_task_scheduler_get(), context);
+
 	stream_size = avio_size(context->iFormatCtx->pb);
 
 	context->frame_rate = av_q2d(av_get_r_frame_rate_compat(context->iStream));
@@ -969,6 +1022,16 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 		} while (frame_finished);
 	}
 
+	BLI_task_pool_work_and_wait(context->proxy_task_pool);
+	BLI_task_pool_free(context->proxy_task_pool);
+	context->proxy_task_pool = NULL;
+
+	if (context->proxy_frame) {
+		avpicture_free((AVPicture *) context->proxy_frame);
+		av_free(context->proxy_frame);
+		context->proxy_frame = NULL;
+	}
+
 	av_free(in_frame);
 
 	return 1;
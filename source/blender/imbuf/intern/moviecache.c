@@ -45,6 +45,8 @@
 
 #include "IMB_moviecache.h"
 
+#include "atomic_ops.h"
+
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
 
@@ -58,8 +60,20 @@
 #  define PRINT(format, ...)
 #endif
 
-static MEM_CacheLimiterC *limitor = NULL;
-static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
+/* Items are spread over several limiters by key hash, each with its own lock,
+ * so threads reading and writing different frames don't wait on each other.
+ * The memory used by all shards is summed to keep one global budget. */
+#define LIMITOR_SHARDS 8
+
+typedef struct MovieCacheLimitor {
+	MEM_CacheLimiterC *limitor;
+	ThreadMutex lock;
+	size_t mem_in_use;  /* this shard's part of limitor_mem_in_use, only changed with lock held */
+} MovieCacheLimitor;
+
+static MovieCacheLimitor limitors[LIMITOR_SHARDS];
+static bool limitors_init = false;
+static size_t limitor_mem_in_use = 0;  /* sum of all shards, use atomic ops */
 
 typedef struct MovieCache {
 	char name[64];
@@ -82,7 +96,9 @@ typedef struct MovieCache {
 	void *last_userkey;
 
 	int totseg, *points, proxy, render_flags;  /* for visual statistics optimization */
-	int pad;
+	/* points are out of date, set by item destructors which can run from several shards at once,
+	 * the points themselves are only freed by the cache's user */
+	uint32_t points_invalid;
 } MovieCache;
 
 typedef struct MovieCacheKey {
@@ -95,6 +111,7 @@ typedef struct MovieCacheItem {
 	ImBuf *ibuf;
 	MEM_CacheLimiterHandleC *c_handle;
 	void *priority_data;
+	int limitor_shard;
 } MovieCacheItem;
 
 static unsigned int moviecache_hashhash(const void *keyv)
@@ -121,6 +138,44 @@ static void moviecache_keyfree(void *val)
 	BLI_mempool_free(key->cache_owner->keys_pool, key);
 }
 
+/* call with shard->lock held, after anything that changes the shard's memory use */
+static void limitor_shard_update_mem(MovieCacheLimitor *shard)
+{
+	size_t mem_in_use = MEM_CacheLimiter_get_memory_in_use(shard->limitor);
+
+	if (mem_in_use > shard->mem_in_use) {
+		atomic_add_z(&limitor_mem_in_use, mem_in_use - shard->mem_in_use);
+	}
+	else if (mem_in_use < shard->mem_in_use) {
+		atomic_sub_z(&limitor_mem_in_use, shard->mem_in_use - mem_in_use);
+	}
+
+	shard->mem_in_use = mem_in_use;
+}
+
+/* call with shard->lock held, frees items of this shard until all shards fit the global maximum,
+ * or the shard fits its share of it */
+static void limitor_shard_enforce_limits(MovieCacheLimitor *shard)
+{
+	size_t max = MEM_CacheLimiter_get_maximum();
+	size_t mem_in_use_other, shard_max;
+
+	if (max == 0) {
+		return;
+	}
+
+	/* other shards may change while this one is freed, so this is approximate */
+	mem_in_use_other = atomic_add_z(&limitor_mem_in_use, 0) - shard->mem_in_use;
+
+	/* a shard may use what the others leave, but always keeps its share of the
+	 * maximum, shards above their share free items when they are used next */
+	shard_max = (mem_in_use_other < max) ? max - mem_in_use_other : 0;
+	shard_max = MAX2(shard_max, max / LIMITOR_SHARDS);
+
+	MEM_CacheLimiter_enforce_limits_ex(shard->limitor, shard_max);
+	limitor_shard_update_mem(shard);
+}
+
 static void moviecache_valfree(void *val)
 {
 	MovieCacheItem *item = (MovieCacheItem *)val;
@@ -129,7 +184,13 @@ static void moviecache_valfree(void *val)
 	PRINT("%s: cache '%s' free item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
 	if (item->ibuf) {
+		MovieCacheLimitor *shard = &limitors[item->limitor_shard];
+
+		BLI_mutex_lock(&shard->lock);
 		MEM_CacheLimiter_unmanage(item->c_handle);
+		limitor_shard_update_mem(shard);
+		BLI_mutex_unlock(&shard->lock);
+
 		IMB_freeImBuf(item->ibuf);
 	}
 
@@ -187,10 +248,7 @@ static void IMB_moviecache_destructor(void *p)
 		item->c_handle = NULL;
 
 		/* force cached segments to be updated */
-		if (cache->points) {
-			MEM_freeN(cache->points);
-			cache->points = NULL;
-		}
+		atomic_cas_uint32(&cache->points_invalid, 0, 1);
 	}
 }
 
@@ -284,16 +342,36 @@ static bool get_item_destroyable(void *item_v)
 
 void IMB_moviecache_init(void)
 {
-	limitor = new_MEM_CacheLimiter(IMB_moviecache_destructor, get_item_size);
+	int i;
+
+	for (i = 0; i < LIMITOR_SHARDS; i++) {
+		MovieCacheLimitor *shard = &limitors[i];
+
+		shard->limitor = new_MEM_CacheLimiter(IMB_moviecache_destructor, get_item_size);
+		shard->mem_in_use = 0;
+		BLI_mutex_init(&shard->lock);
+
+		MEM_CacheLimiter_ItemPriority_Func_set(shard->limitor, get_item_priority);
+		MEM_CacheLimiter_ItemDestroyable_Func_set(shard->limitor, get_item_destroyable);
+	}
 
-	MEM_CacheLimiter_ItemPriority_Func_set(limitor, get_item_priority);
-	MEM_CacheLimiter_ItemDestroyable_Func_set(limitor, get_item_destroyable);
+	limitor_mem_in_use = 0;
+	limitors_init = true;
 }
 
 void IMB_moviecache_destruct(void)
 {
-	if (limitor)
-		delete_MEM_CacheLimiter(limitor);
+	int i;
+
+	if (!limitors_init)
+		return;
+
+	for (i = 0; i < LIMITOR_SHARDS; i++) {
+		delete_MEM_CacheLimiter(limitors[i].limitor);
+		BLI_mutex_end(&limitors[i].lock);
+	}
+
+	limitors_init = false;
 }
 
 MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP hashfp, GHashCmpFP cmpfp)
@@ -335,12 +413,13 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache, MovieCacheGe
 	cache->prioritydeleterfp = prioritydeleterfp;
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
 	MovieCacheKey *key;
 	MovieCacheItem *item;
+	MovieCacheLimitor *shard;
 
-	if (!limitor)
+	if (!limitors_init)
 		IMB_moviecache_init();
 
 	IMB_refImBuf(ibuf);
@@ -358,6 +437,7 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 	item->cache_owner = cache;
 	item->c_handle = NULL;
 	item->priority_data = NULL;
+	item->limitor_shard = (int)(cache->hashfp(userkey) % LIMITOR_SHARDS);
 
 	if (cache->getprioritydatafp) {
 		item->priority_data = cache->getprioritydatafp(userkey);
@@ -370,17 +450,18 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 		memcpy(cache->last_userkey, userkey, cache->keysize);
 	}
 
-	if (need_lock)
-		BLI_mutex_lock(&limitor_lock);
+	shard = &limitors[item->limitor_shard];
+
+	BLI_mutex_lock(&shard->lock);
 
-	item->c_handle = MEM_CacheLimiter_insert(limitor, item);
+	item->c_handle = MEM_CacheLimiter_insert(shard->limitor, item);
+	limitor_shard_update_mem(shard);
 
 	MEM_CacheLimiter_ref(item->c_handle);
-	MEM_CacheLimiter_enforce_limits(limitor);
+	limitor_shard_enforce_limits(shard);
 	MEM_CacheLimiter_unref(item->c_handle);
 
-	if (need_lock)
-		BLI_mutex_unlock(&limitor_lock);
+	BLI_mutex_unlock(&shard->lock);
 
 	/* cache limiter can't remove unused keys which points to destoryed values */
 	check_unused_keys(cache);
@@ -391,11 +472,6 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 	}
 }
 
-void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
-{
-	do_moviecache_put(cache, userkey, ibuf, true);
-}
-
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
 	size_t mem_in_use, mem_limit, elem_size;
@@ -404,16 +480,14 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
 	elem_size = IMB_get_size_in_memory(ibuf);
 	mem_limit = MEM_CacheLimiter_get_maximum();
 
-	BLI_mutex_lock(&limitor_lock);
-	mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+	/* other threads may put items before this one, the check is only approximate */
+	mem_in_use = atomic_add_z(&limitor_mem_in_use, 0);
 
 	if (mem_in_use + elem_size <= mem_limit) {
-		do_moviecache_put(cache, userkey, ibuf, false);
+		IMB_moviecache_put(cache, userkey, ibuf);
 		result = true;
 	}
 
-	BLI_mutex_unlock(&limitor_lock);
-
 	return result;
 }
 
@@ -428,9 +502,12 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 
 	if (item) {
 		if (item->ibuf) {
-			BLI_mutex_lock(&limitor_lock);
+			MovieCacheLimitor *shard = &limitors[item->limitor_shard];
+
+			BLI_mutex_lock(&shard->lock);
 			MEM_CacheLimiter_touch(item->c_handle);
-			BLI_mutex_unlock(&limitor_lock);
+			limitor_shard_update_mem(shard);
+			BLI_mutex_unlock(&shard->lock);
 
 			IMB_refImBuf(item->ibuf);
 
@@ -504,7 +581,9 @@ void IMB_moviecache_get_cache_segments(MovieCache *cache, int proxy, int render_
 	if (!cache->getdatafp)
 		return;
 
-	if (cache->proxy != proxy || cache->render_flags != render_flags) {
+	if (atomic_cas_uint32(&cache->points_invalid, 1, 0) == 1 ||
+	    cache->proxy != proxy || cache->render_flags != render_flags)
+	{
 		if (cache->points)
 			MEM_freeN(cache->points);
 
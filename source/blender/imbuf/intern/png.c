@@ -32,10 +32,13 @@
  */
 
 #include "png.h"
+#include "zlib.h"
 
 #include "BLI_utildefines.h"
 #include "BLI_fileops.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_global.h"
 
@@ -121,6 +124,225 @@ BLI_INLINE unsigned short ftoshort(float val)
 	return FTOUSHORT(val);
 }
 
+/* Large images are deflated in chunks of rows on all threads instead of by libpng.
+ * Each chunk ends with a sync flush so the chunks join into one zlib stream, and
+ * starts with the end of the previous one as dictionary so little ratio is lost. */
+#define PNG_CHUNKED_MIN_SIZE (1 << 22)
+#define PNG_CHUNKED_CHUNK_SIZE (1 << 20)
+#define PNG_CHUNKED_DICT_SIZE 32768
+
+typedef struct PNGDeflateChunk {
+	unsigned char *data;
+	size_t size;
+	size_t size_in;  /* filtered bytes, for combining the checksums */
+	uLong adler;
+	bool ok;
+} PNGDeflateChunk;
+
+typedef struct PNGDeflateData {
+	const unsigned char *pixels;  /* bottom to top, as stored in the ImBuf */
+	size_t rowbytes;
+	int height;
+	int bpp;                      /* bytes per pixel, for the filter */
+	int swap;                     /* 16 bit samples are big endian in the file */
+	int compression;
+	int rows_per_chunk;
+	PNGDeflateChunk *chunks;
+	int totchunk;
+} PNGDeflateData;
+
+BLI_INLINE unsigned char png_paeth_predictor(int a, int b, int c)
+{
+	const int p = a + b - c;
+	const int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+
+	if (pa <= pb && pa <= pc) return (unsigned char)a;
+	else if (pb <= pc) return (unsigned char)b;
+	return (unsigned char)c;
+}
+
+/* Filters a row from the top of the file, the first byte is the filter type.
+ * Like libpng all filters are tried and the one with the smallest sum of
+ * absolute differences is used, r_try is scratch memory of the same size. */
+static void png_filter_row(const PNGDeflateData *data, const int row,
+                           unsigned char *r_filtered, unsigned char *r_try)
+{
+	const unsigned char *raw = data->pixels + (size_t)(data->height - 1 - row) * data->rowbytes;
+	const unsigned char *prior = (row > 0) ? raw + data->rowbytes : NULL;
+	const size_t bpp = (size_t)data->bpp;
+	const int swap = data->swap;
+	unsigned int sum, sum_best = UINT_MAX;
+	int filter;
+	size_t k;
+
+	for (filter = PNG_FILTER_VALUE_NONE; filter <= PNG_FILTER_VALUE_PAETH; filter++) {
+		r_try[0] = (unsigned char)filter;
+		sum = 0;
+
+		for (k = 0; k < data->rowbytes; k++) {
+			const int x = raw[k ^ swap];
+			const int a = (k >= bpp) ? raw[(k - bpp) ^ swap] : 0;
+			const int b = prior ? prior[k ^ swap] : 0;
+			const int c = (k >= bpp && prior) ? prior[(k - bpp) ^ swap] : 0;
+			int pred;
+
+			switch (filter) {
+				case PNG_FILTER_VALUE_SUB:   pred = a; break;
+				case PNG_FILTER_VALUE_UP:    pred = b; break;
+				case PNG_FILTER_VALUE_AVG:   pred = (a + b) >> 1; break;
+				case PNG_FILTER_VALUE_PAETH: pred = png_paeth_predictor(a, b, c); break;
+				default:                     pred = 0; break;
+			}
+
+			r_try[k + 1] = (unsigned char)(x - pred);
+			sum += (unsigned int)abs((signed char)r_try[k + 1]);
+		}
+
+		if (sum < sum_best) {
+			sum_best = sum;
+			memcpy(r_filtered, r_try, data->rowbytes + 1);
+		}
+	}
+}
+
+static void png_deflate_chunk_task(void *userdata, int index)
+{
+	const PNGDeflateData *data = userdata;
+	PNGDeflateChunk *chunk = &data->chunks[index];
+	const size_t filtered_rowbytes = data->rowbytes + 1;
+	const int row_start = index * data->rows_per_chunk;
+	const int row_end = min_ii(row_start + data->rows_per_chunk, data->height);
+	const bool is_last = (index == data->totchunk - 1);
+	unsigned char *filtered, *filter_try;
+	z_stream stream = {NULL};
+	int row;
+
+	chunk->size_in = (size_t)(row_end - row_start) * filtered_rowbytes;
+	filtered = MEM_mallocN(chunk->size_in, "png filtered rows");
+	filter_try = MEM_mallocN(filtered_rowbytes, "png filter row");
+
+	for (row = row_start; row < row_end; row++) {
+		png_filter_row(data, row, filtered + (size_t)(row - row_start) * filtered_rowbytes, filter_try);
+	}
+	chunk->adler = adler32(adler32(0L, Z_NULL, 0), filtered, (uInt)chunk->size_in);
+
+	if (deflateInit2(&stream, data->compression, Z_DEFLATED, -MAX_WBITS, 8, Z_FILTERED) != Z_OK) {
+		MEM_freeN(filtered);
+		MEM_freeN(filter_try);
+		return;
+	}
+
+	if (row_start > 0) {
+		/* filter the end of the previous chunk again, that is cheaper than waiting for it */
+		const int dict_rows = min_ii(row_start, (int)((PNG_CHUNKED_DICT_SIZE + filtered_rowbytes - 1) / filtered_rowbytes));
+		const size_t dict_size = (size_t)dict_rows * filtered_rowbytes;
+		unsigned char *dict = MEM_mallocN(dict_size, "png dictionary rows");
+		const size_t dict_used = MIN2(dict_size, PNG_CHUNKED_DICT_SIZE);
+
+		for (row = row_start - dict_rows; row < row_start; row++) {
+			png_filter_row(data, row, dict + (size_t)(row - (row_start - dict_rows)) * filtered_rowbytes, filter_try);
+		}
+		deflateSetDictionary(&stream, dict + dict_size - dict_used, (uInt)dict_used);
+		MEM_freeN(dict);
+	}
+
+	/* the sync flush marker isn't included in the bound */
+	chunk->size = deflateBound(&stream, (uLong)chunk->size_in) + 16;
+	chunk->data = MEM_mallocN(chunk->size, "png deflated rows");
+
+	stream.next_in = filtered;
+	stream.avail_in = (uInt)chunk->size_in;
+	stream.next_out = chunk->data;
+	stream.avail_out = (uInt)chunk->size;
+
+	if (is_last) {
+		chunk->ok = (deflate(&stream, Z_FINISH) == Z_STREAM_END);
+	}
+	else {
+		chunk->ok = (deflate(&stream, Z_SYNC_FLUSH) == Z_OK && stream.avail_in == 0 && stream.avail_out != 0);
+	}
+	chunk->size -= stream.avail_out;
+
+	deflateEnd(&stream);
+	MEM_freeN(filtered);
+	MEM_freeN(filter_try);
+}
+
+/* writes the image data as IDAT chunks and ends the file, pixels are stored
+ * bottom to top, returns false if the data could not be compressed */
+static bool imb_savepng_chunked(png_structp png_ptr, const unsigned char *pixels, const bool is_16bit,
+                                const int width, const int height, const int channels, const int compression)
+{
+	PNGDeflateData data;
+	const int bytes_per_sample = is_16bit ? 2 : 1;
+	uLong adler = adler32(0L, Z_NULL, 0);
+	unsigned char header[2], trailer[4];
+	bool ok = true;
+	int i;
+
+	data.pixels = pixels;
+	data.bpp = channels * bytes_per_sample;
+	data.rowbytes = (size_t)width * data.bpp;
+	data.height = height;
+#ifdef __LITTLE_ENDIAN__
+	data.swap = is_16bit ? 1 : 0;
+#else
+	data.swap = 0;
+#endif
+	data.compression = compression;
+	data.rows_per_chunk = max_ii(1, (int)(PNG_CHUNKED_CHUNK_SIZE / (data.rowbytes + 1)));
+	data.totchunk = (height + data.rows_per_chunk - 1) / data.rows_per_chunk;
+	data.chunks = MEM_callocN(sizeof(*data.chunks) * data.totchunk, "png deflate chunks");
+
+	BLI_task_parallel_range_ex(0, data.totchunk, &data, png_deflate_chunk_task, 2);
+
+	for (i = 0; i < data.totchunk; i++) {
+		ok = ok && data.chunks[i].ok;
+	}
+
+	if (ok) {
+		/* zlib header without a preset dictionary, FLEVEL is only informative */
+		header[0] = 0x78;
+		header[1] = (unsigned char)((compression < 2 ? 0 : compression < 6 ? 1 : compression == 6 ? 2 : 3) << 6);
+		header[1] += (unsigned char)((31 - ((header[0] << 8) + header[1]) % 31) % 31);
+
+		for (i = 0; i < data.totchunk; i++) {
+			const PNGDeflateChunk *chunk = &data.chunks[i];
+			const bool is_first = (i == 0), is_last = (i == data.totchunk - 1);
+
+			adler = adler32_combine(adler, chunk->adler, (z_off_t)chunk->size_in);
+
+			png_write_chunk_start(png_ptr, (png_bytep)"IDAT",
+			                      (png_uint_32)(chunk->size + (is_first ? sizeof(header) : 0) + (is_last ? sizeof(trailer) : 0)));
+			if (is_first) {
+				png_write_chunk_data(png_ptr, header, sizeof(header));
+			}
+			png_write_chunk_data(png_ptr, chunk->data, chunk->size);
+			if (is_last) {
+				trailer[0] = (unsigned char)(adler >> 24);
+				trailer[1] = (unsigned char)(adler >> 16);
+				trailer[2] = (unsigned char)(adler >> 8);
+				trailer[3] = (unsigned char)adler;
+				png_write_chunk_data(png_ptr, trailer, sizeof(trailer));
+			}
+			png_write_chunk_end(png_ptr);
+		}
+
+		/* png_write_end() only accepts IDAT written by libpng, all text was written with the header */
+		png_write_chunk(png_ptr, (png_bytep)"IEND", NULL, 0);
+		png_write_flush(png_ptr);
+	}
+
+	for (i = 0; i < data.totchunk; i++) {
+		if (data.chunks[i].data) {
+			MEM_freeN(data.chunks[i].data);
+		}
+	}
+	MEM_freeN(data.chunks);
+
+	return ok;
+}
+
 int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
 {
 	png_structp png_ptr;
@@ -132,6 +354,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
 	float *from_float, from_straight[4];
 	png_bytepp row_pointers = NULL;
 	int i, bytesperpixel, color_type = PNG_COLOR_TYPE_GRAY;
+	int ok = 1;
 	FILE *fp = NULL;
 
 	bool is_16bit  = (ibuf->ftype & PNG_16BIT) != 0;
@@ -431,6 +654,30 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
 	/* write the file header information */
 	png_write_info(png_ptr, info_ptr);
 
+	if ((size_t)ibuf->x * ibuf->y * bytesperpixel * (is_16bit ? 2 : 1) >= PNG_CHUNKED_MIN_SIZE &&
+	    BLI_system_thread_count() > 1)
+	{
+		if (!imb_savepng_chunked(png_ptr, is_16bit ? (unsigned char *)pixels16 : pixels, is_16bit,
+		                         ibuf->x, ibuf->y, bytesperpixel, compression))
+		{
+			printf("imb_savepng: Cannot compress image data for file: '%s'\n", name);
+			ok = 0;
+		}
+
+		if (pixels)
+			MEM_freeN(pixels);
+		if (pixels16)
+			MEM_freeN(pixels16);
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+
+		if (fp) {
+			fflush(fp);
+			fclose(fp);
+		}
+
+		return(ok);
+	}
+
 #ifdef __LITTLE_ENDIAN__
 	png_set_swap(png_ptr);
 #endif
@@ -883,48 +883,104 @@ static bool q_scale_linear_interpolation(
 	return true;
 }
 
-static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
+/* ******** quality scaling ******** */
+
+/* The quality scaling functions below filter along one axis at a time, every row
+ * (for newx) or column (for newy) is computed independently from the others.
+ * Large buffers are split into blocks of lines which are filtered in parallel,
+ * the output is identical to filtering all lines in a single pass. */
+
+typedef void (*ScaleLinesFunc)(ImBuf *ibuf, int newsize, uchar *_newrect, float *_newrectf,
+                               int start_line, int tot_line);
+
+/* below this number of pixels the overhead of the threads outweighs the gain */
+#define SCALE_LINES_THREADED_MIN_PIXELS (256 * 256)
+
+typedef struct ScaleLinesThreadData {
+	ImBuf *ibuf;
+	int newsize;
+
+	uchar *newrect;
+	float *newrectf;
+
+	ScaleLinesFunc scale_lines;
+
+	int start_line;
+	int tot_line;
+} ScaleLinesThreadData;
+
+static void scale_lines_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
 {
-	const int do_rect = (ibuf->rect != NULL);
-	const int do_float = (ibuf->rect_float != NULL);
-	const size_t rect_size = ibuf->x * ibuf->y * 4;
+	ScaleLinesThreadData *data = (ScaleLinesThreadData *) data_v;
 
-	uchar *rect, *_newrect, *newrect;
-	float *rectf, *_newrectf, *newrectf;
-	float sample, add, val[4], nval[4], valf[4], nvalf[4];
-	int x, y;
+	*data = *(ScaleLinesThreadData *) init_data_v;
 
-	rectf = _newrectf = newrectf = NULL;
-	rect = _newrect = newrect = NULL;
-	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
-	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+	data->start_line = start_line;
+	data->tot_line = tot_line;
+}
 
-	if (!do_rect && !do_float) return (ibuf);
+static void *do_scale_lines_thread(void *data_v)
+{
+	ScaleLinesThreadData *data = (ScaleLinesThreadData *) data_v;
 
-	if (do_rect) {
-		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(uchar) * 4, "scaledownx");
-		if (_newrect == NULL) return(ibuf);
+	data->scale_lines(data->ibuf, data->newsize, data->newrect, data->newrectf,
+	                  data->start_line, data->tot_line);
+
+	return NULL;
+}
+
+static void scale_lines_apply(ImBuf *ibuf, int newsize, uchar *_newrect, float *_newrectf,
+                              int tot_line, ScaleLinesFunc scale_lines)
+{
+	const size_t tot_pixels = MAX2((size_t)ibuf->x * ibuf->y, (size_t)newsize * tot_line);
+
+	if (tot_pixels < SCALE_LINES_THREADED_MIN_PIXELS) {
+		scale_lines(ibuf, newsize, _newrect, _newrectf, 0, tot_line);
 	}
-	if (do_float) {
-		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaledownxf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
+	else {
+		ScaleLinesThreadData init_data = {NULL};
+
+		init_data.ibuf = ibuf;
+		init_data.newsize = newsize;
+		init_data.newrect = _newrect;
+		init_data.newrectf = _newrectf;
+		init_data.scale_lines = scale_lines;
+
+		IMB_processor_apply_threaded(tot_line, sizeof(ScaleLinesThreadData), &init_data,
+		                             scale_lines_thread_init, do_scale_lines_thread);
 	}
+}
+
+/* rows start_line to start_line + tot_line */
+static void scaledownx_lines(ImBuf *ibuf, int newx, uchar *_newrect, float *_newrectf,
+                             int start_line, int tot_line)
+{
+	const int do_rect = (_newrect != NULL);
+	const int do_float = (_newrectf != NULL);
+	const size_t rect_size = (size_t)ibuf->x * (start_line + tot_line) * 4;
+
+	uchar *rect, *newrect;
+	float *rectf, *newrectf;
+	float sample, add, val[4], nval[4], valf[4], nvalf[4];
+	int x, y;
+
+	rectf = newrectf = NULL;
+	rect = newrect = NULL;
+	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
+	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
 
 	add = (ibuf->x - 0.01) / newx;
 
 	if (do_rect) {
-		rect = (uchar *) ibuf->rect;
-		newrect = _newrect;
+		rect = (uchar *) ibuf->rect + (size_t)ibuf->x * start_line * 4;
+		newrect = _newrect + (size_t)newx * start_line * 4;
 	}
 	if (do_float) {
-		rectf = ibuf->rect_float;
-		newrectf = _newrectf;
+		rectf = ibuf->rect_float + (size_t)ibuf->x * start_line * 4;
+		newrectf = _newrectf + (size_t)newx * start_line * 4;
 	}
 		
-	for (y = ibuf->y; y > 0; y--) {
+	for (y = tot_line; y > 0; y--) {
 		sample = 0.0f;
 		val[0] =  val[1] = val[2] = val[3] = 0.0f;
 		valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
@@ -995,58 +1051,75 @@ static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
 	if (do_rect) {
 		// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
 		BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
 	}
 	if (do_float) {
 		// printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
 		BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = _newrectf;
 	}
 	(void)rect_size; /* UNUSED in release builds */
-	
-	ibuf->x = newx;
-	return(ibuf);
 }
 
-
-static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
 {
 	const int do_rect = (ibuf->rect != NULL);
 	const int do_float = (ibuf->rect_float != NULL);
-	const size_t rect_size = ibuf->x * ibuf->y * 4;
 
-	uchar *rect, *_newrect, *newrect;
-	float *rectf, *_newrectf, *newrectf;
-	float sample, add, val[4], nval[4], valf[4], nvalf[4];
-	int x, y, skipx;
-
-	rectf = _newrectf = newrectf = NULL;
-	rect = _newrect = newrect = NULL;
-	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
-	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+	uchar *_newrect = NULL;
+	float *_newrectf = NULL;
 
 	if (!do_rect && !do_float) return (ibuf);
 
 	if (do_rect) {
-		_newrect = MEM_mallocN(newy * ibuf->x * sizeof(uchar) * 4, "scaledowny");
+		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(uchar) * 4, "scaledownx");
 		if (_newrect == NULL) return(ibuf);
 	}
 	if (do_float) {
-		_newrectf = MEM_mallocN(newy * ibuf->x * sizeof(float) * 4, "scaledownyf");
+		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaledownxf");
 		if (_newrectf == NULL) {
 			if (_newrect) MEM_freeN(_newrect);
 			return(ibuf);
 		}
 	}
 
+	scale_lines_apply(ibuf, newx, _newrect, _newrectf, ibuf->y, scaledownx_lines);
+
+	if (do_rect) {
+		imb_freerectImBuf(ibuf);
+		ibuf->mall |= IB_rect;
+		ibuf->rect = (unsigned int *) _newrect;
+	}
+	if (do_float) {
+		imb_freerectfloatImBuf(ibuf);
+		ibuf->mall |= IB_rectfloat;
+		ibuf->rect_float = _newrectf;
+	}
+	
+	ibuf->x = newx;
+	return(ibuf);
+}
+
+/* columns start_line to start_line + tot_line */
+static void scaledowny_lines(ImBuf *ibuf, int newy, uchar *_newrect, float *_newrectf,
+                             int start_line, int tot_line)
+{
+	const int do_rect = (_newrect != NULL);
+	const int do_float = (_newrectf != NULL);
+	const size_t rect_size = (size_t)ibuf->x * ibuf->y * 4;
+
+	uchar *rect, *newrect;
+	float *rectf, *newrectf;
+	float sample, add, val[4], nval[4], valf[4], nvalf[4];
+	int x, y, skipx;
+
+	rectf = newrectf = NULL;
+	rect = newrect = NULL;
+	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
+	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+
 	add = (ibuf->y - 0.01) / newy;
 	skipx = 4 * ibuf->x;
 
-	for (x = skipx - 4; x >= 0; x -= 4) {
+	for (x = 4 * start_line; x < 4 * (start_line + tot_line); x += 4) {
 		if (do_rect) {
 			rect = ((uchar *) ibuf->rect) + x;
 			newrect = _newrect + x;
@@ -1121,33 +1194,67 @@ static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
 			
 			sample -= 1.0f;
 		}
+
+		if (do_rect) {
+			// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect + x), rect_size);
+			BLI_assert((uchar *)rect - ((uchar *)ibuf->rect + x) == rect_size); /* see bug [#26502] */
+		}
+		if (do_float) {
+			// printf("%ld %ld\n", rectf - (ibuf->rect_float + x), rect_size);
+			BLI_assert((rectf - (ibuf->rect_float + x)) == rect_size); /* see bug [#26502] */
+		}
+	}
+	(void)rect_size; /* UNUSED in release builds */
+}
+
+static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+{
+	const int do_rect = (ibuf->rect != NULL);
+	const int do_float = (ibuf->rect_float != NULL);
+
+	uchar *_newrect = NULL;
+	float *_newrectf = NULL;
+
+	if (!do_rect && !do_float) return (ibuf);
+
+	if (do_rect) {
+		_newrect = MEM_mallocN(newy * ibuf->x * sizeof(uchar) * 4, "scaledowny");
+		if (_newrect == NULL) return(ibuf);
+	}
+	if (do_float) {
+		_newrectf = MEM_mallocN(newy * ibuf->x * sizeof(float) * 4, "scaledownyf");
+		if (_newrectf == NULL) {
+			if (_newrect) MEM_freeN(_newrect);
+			return(ibuf);
+		}
 	}
 
+	scale_lines_apply(ibuf, newy, _newrect, _newrectf, ibuf->x, scaledowny_lines);
+
 	if (do_rect) {
-		// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-		BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
 		imb_freerectImBuf(ibuf);
 		ibuf->mall |= IB_rect;
 		ibuf->rect = (unsigned int *) _newrect;
 	}
 	if (do_float) {
-		// printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-		BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
 		imb_freerectfloatImBuf(ibuf);
 		ibuf->mall |= IB_rectfloat;
 		ibuf->rect_float = (float *) _newrectf;
 	}
-	(void)rect_size; /* UNUSED in release builds */
 	
 	ibuf->y = newy;
 	return(ibuf);
 }
 
-
-static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+/* rows start_line to start_line + tot_line */
+static void scaleupx_lines(ImBuf *ibuf, int newx, uchar *_newrect, float *_newrectf,
+                           int start_line, int tot_line)
 {
-	uchar *rect, *_newrect = NULL, *newrect;
-	float *rectf, *_newrectf = NULL, *newrectf;
+	const bool do_rect = (_newrect != NULL);
+	const bool do_float = (_newrectf != NULL);
+
+	uchar *rect = NULL, *newrect = NULL;
+	float *rectf = NULL, *newrectf = NULL;
 	float sample, add;
 	float val_a, nval_a, diff_a;
 	float val_b, nval_b, diff_b;
@@ -1158,41 +1265,28 @@ static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
 	float val_gf, nval_gf, diff_gf;
 	float val_rf, nval_rf, diff_rf;
 	int x, y;
-	bool do_rect = false, do_float = false;
 
 	val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
 	val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
 	val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
 	val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-	if (ibuf == NULL) return(NULL);
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
-
-	if (ibuf->rect) {
-		do_rect = true;
-		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (ibuf->rect_float) {
-		do_float = true;
-		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaleupxf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
-	}
 
 	add = (ibuf->x - 1.001) / (newx - 1.0);
 
-	rect = (uchar *) ibuf->rect;
-	rectf = (float *) ibuf->rect_float;
-	newrect = _newrect;
-	newrectf = _newrectf;
+	if (do_rect) {
+		newrect = _newrect + (size_t)newx * start_line * 4;
+	}
+	if (do_float) {
+		newrectf = _newrectf + (size_t)newx * start_line * 4;
+	}
 
-	for (y = ibuf->y; y > 0; y--) {
+	for (y = start_line; y < start_line + tot_line; y++) {
 
 		sample = 0;
 		
 		if (do_rect) {
+			rect = (uchar *) ibuf->rect + (size_t)ibuf->x * y * 4;
+
 			val_a = rect[0];
 			nval_a = rect[4];
 			diff_a = nval_a - val_a;
@@ -1216,6 +1310,8 @@ static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
 			rect += 8;
 		}
 		if (do_float) {
+			rectf = ibuf->rect_float + (size_t)ibuf->x * y * 4;
+
 			val_af = rectf[0];
 			nval_af = rectf[4];
 			diff_af = nval_af - val_af;
@@ -1296,6 +1392,32 @@ static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
 			sample += add;
 		}
 	}
+}
+
+static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+{
+	uchar *_newrect = NULL;
+	float *_newrectf = NULL;
+	bool do_rect = false, do_float = false;
+
+	if (ibuf == NULL) return(NULL);
+	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
+
+	if (ibuf->rect) {
+		do_rect = true;
+		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
+		if (_newrect == NULL) return(ibuf);
+	}
+	if (ibuf->rect_float) {
+		do_float = true;
+		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaleupxf");
+		if (_newrectf == NULL) {
+			if (_newrect) MEM_freeN(_newrect);
+			return(ibuf);
+		}
+	}
+
+	scale_lines_apply(ibuf, newx, _newrect, _newrectf, ibuf->y, scaleupx_lines);
 
 	if (do_rect) {
 		imb_freerectImBuf(ibuf);
@@ -1312,10 +1434,15 @@ static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
 	return(ibuf);
 }
 
-static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
+/* columns start_line to start_line + tot_line */
+static void scaleupy_lines(ImBuf *ibuf, int newy, uchar *_newrect, float *_newrectf,
+                           int start_line, int tot_line)
 {
-	uchar *rect, *_newrect = NULL, *newrect;
-	float *rectf, *_newrectf = NULL, *newrectf;
+	const bool do_rect = (_newrect != NULL);
+	const bool do_float = (_newrectf != NULL);
+
+	uchar *rect = NULL, *newrect = NULL;
+	float *rectf = NULL, *newrectf = NULL;
 	float sample, add;
 	float val_a, nval_a, diff_a;
 	float val_b, nval_b, diff_b;
@@ -1326,43 +1453,21 @@ static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
 	float val_gf, nval_gf, diff_gf;
 	float val_rf, nval_rf, diff_rf;
 	int x, y, skipx;
-	bool do_rect = false, do_float = false;
 
 	val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
 	val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
 	val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
 	val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-	if (ibuf == NULL) return(NULL);
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
-
-	if (ibuf->rect) {
-		do_rect = true;
-		_newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (ibuf->rect_float) {
-		do_float = true;
-		_newrectf = MEM_mallocN(ibuf->x * newy * sizeof(float) * 4, "scaleupyf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
-	}
 
 	add = (ibuf->y - 1.001) / (newy - 1.0);
 	skipx = 4 * ibuf->x;
 
-	rect = (uchar *) ibuf->rect;
-	rectf = (float *) ibuf->rect_float;
-	newrect = _newrect;
-	newrectf = _newrectf;
-
-	for (x = ibuf->x; x > 0; x--) {
+	for (x = start_line; x < start_line + tot_line; x++) {
 
 		sample = 0;
 		if (do_rect) {
-			rect = ((uchar *)ibuf->rect) + 4 * (x - 1);
-			newrect = _newrect + 4 * (x - 1);
+			rect = ((uchar *)ibuf->rect) + 4 * x;
+			newrect = _newrect + 4 * x;
 
 			val_a = rect[0];
 			nval_a = rect[skipx];
@@ -1387,8 +1492,8 @@ static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
 			rect += 2 * skipx;
 		}
 		if (do_float) {
-			rectf = ibuf->rect_float + 4 * (x - 1);
-			newrectf = _newrectf + 4 * (x - 1);
+			rectf = ibuf->rect_float + 4 * x;
+			newrectf = _newrectf + 4 * x;
 
 			val_af = rectf[0];
 			nval_af = rectf[skipx];
@@ -1471,6 +1576,32 @@ static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
 			sample += add;
 		}
 	}
+}
+
+static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
+{
+	uchar *_newrect = NULL;
+	float *_newrectf = NULL;
+	bool do_rect = false, do_float = false;
+
+	if (ibuf == NULL) return(NULL);
+	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
+
+	if (ibuf->rect) {
+		do_rect = true;
+		_newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
+		if (_newrect == NULL) return(ibuf);
+	}
+	if (ibuf->rect_float) {
+		do_float = true;
+		_newrectf = MEM_mallocN(ibuf->x * newy * sizeof(float) * 4, "scaleupyf");
+		if (_newrectf == NULL) {
+			if (_newrect) MEM_freeN(_newrect);
+			return(ibuf);
+		}
+	}
+
+	scale_lines_apply(ibuf, newy, _newrect, _newrectf, ibuf->x, scaleupy_lines);
 
 	if (do_rect) {
 		imb_freerectImBuf(ibuf);
@@ -45,8 +45,12 @@
 
 #include "imbuf.h"
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
  
 #include "BKE_global.h"
 
@@ -61,6 +65,7 @@
 #include "IMB_colormanagement_intern.h"
 
 #include "tiffio.h"
+#include "zlib.h"
 
 #ifdef WIN32
 #include "utfconv.h"
@@ -699,6 +704,66 @@ void imb_loadtiletiff(ImBuf *ibuf, unsigned char *mem, size_t size, int tx, int
  * \return: 1 if the function is successful, 0 on failure.
  */
 
+/* Large images are split in strips of rows that are deflated on all threads,
+ * libtiff would compress them one after another. */
+#define TIFF_THREADED_MIN_SIZE (1 << 22)
+#define TIFF_THREADED_STRIP_SIZE (1 << 20)
+
+typedef struct TIFFDeflateStrip {
+	unsigned char *data;
+	uLongf size;
+	bool ok;
+} TIFFDeflateStrip;
+
+typedef struct TIFFDeflateData {
+	const unsigned char *pixels;
+	size_t stripsize;  /* bytes in a full strip, the last one may be shorter */
+	size_t totsize;
+	TIFFDeflateStrip *strips;
+} TIFFDeflateData;
+
+static void tiff_deflate_strip_task(void *userdata, int index)
+{
+	const TIFFDeflateData *data = userdata;
+	TIFFDeflateStrip *strip = &data->strips[index];
+	const size_t offset = (size_t)index * data->stripsize;
+	const size_t size = MIN2(data->stripsize, data->totsize - offset);
+
+	/* same stream as the libtiff deflate codec writes with its default level */
+	strip->size = compressBound((uLong)size);
+	strip->data = MEM_mallocN(strip->size, "tiff deflated strip");
+	strip->ok = (compress2(strip->data, &strip->size, data->pixels + offset, (uLong)size,
+	                       Z_DEFAULT_COMPRESSION) == Z_OK);
+}
+
+/* writes pixels that are stored top to bottom as deflated strips,
+ * returns false if they could not be compressed or written */
+static bool imb_savetiff_strips(TIFF *image, const unsigned char *pixels, const size_t rowbytes,
+                                const int rows_per_strip, const int height)
+{
+	TIFFDeflateData data;
+	const int totstrip = (height + rows_per_strip - 1) / rows_per_strip;
+	bool ok = true;
+	int i;
+
+	data.pixels = pixels;
+	data.stripsize = rowbytes * rows_per_strip;
+	data.totsize = rowbytes * height;
+	data.strips = MEM_callocN(sizeof(*data.strips) * totstrip, "tiff deflate strips");
+
+	BLI_task_parallel_range_ex(0, totstrip, &data, tiff_deflate_strip_task, 2);
+
+	for (i = 0; i < totstrip; i++) {
+		const TIFFDeflateStrip *strip = &data.strips[i];
+
+		ok = ok && strip->ok && (TIFFWriteRawStrip(image, (tstrip_t)i, strip->data, (tsize_t)strip->size) != -1);
+		MEM_freeN(strip->data);
+	}
+	MEM_freeN(data.strips);
+
+	return ok;
+}
+
 int imb_savetiff(ImBuf *ibuf, const char *name, int flags)
 {
 	TIFF *image = NULL;
@@ -710,6 +775,9 @@ int imb_savetiff(ImBuf *ibuf, const char *name, int flags)
 	float *fromf = NULL;
 	float xres, yres;
 	int x, y, from_i, to_i, i;
+	size_t rowbytes;
+	int rows_per_strip;
+	bool ok;
 
 	/* check for a valid number of bytes per pixel.  Like the PNG writer,
 	 * the TIFF writer supports 1, 3 or 4 bytes per pixel, corresponding
@@ -837,10 +905,16 @@ int imb_savetiff(ImBuf *ibuf, const char *name, int flags)
 		}
 	}
 
+	rowbytes = (size_t)ibuf->x * samplesperpixel * bitspersample / 8;
+	if (rowbytes * ibuf->y >= TIFF_THREADED_MIN_SIZE && BLI_system_thread_count() > 1)
+		rows_per_strip = max_ii(1, (int)(TIFF_THREADED_STRIP_SIZE / rowbytes));
+	else
+		rows_per_strip = ibuf->y;
+
 	/* write the actual TIFF file */
 	TIFFSetField(image, TIFFTAG_IMAGEWIDTH,      ibuf->x);
 	TIFFSetField(image, TIFFTAG_IMAGELENGTH,     ibuf->y);
-	TIFFSetField(image, TIFFTAG_ROWSPERSTRIP,    ibuf->y);
+	TIFFSetField(image, TIFFTAG_ROWSPERSTRIP,    rows_per_strip);
 	TIFFSetField(image, TIFFTAG_COMPRESSION, COMPRESSION_DEFLATE);
 	TIFFSetField(image, TIFFTAG_FILLORDER, FILLORDER_MSB2LSB);
 	TIFFSetField(image, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
@@ -857,10 +931,17 @@ int imb_savetiff(ImBuf *ibuf, const char *name, int flags)
 	TIFFSetField(image, TIFFTAG_XRESOLUTION,     xres);
 	TIFFSetField(image, TIFFTAG_YRESOLUTION,     yres);
 	TIFFSetField(image, TIFFTAG_RESOLUTIONUNIT,  RESUNIT_INCH);
-	if (TIFFWriteEncodedStrip(image, 0,
-	                          (bitspersample == 16) ? (unsigned char *)pixels16 : pixels,
-	                          (size_t)ibuf->x * ibuf->y * samplesperpixel * bitspersample / 8) == -1)
-	{
+	if (rows_per_strip != ibuf->y) {
+		ok = imb_savetiff_strips(image, (bitspersample == 16) ? (unsigned char *)pixels16 : pixels,
+		                         rowbytes, rows_per_strip, ibuf->y);
+	}
+	else {
+		ok = TIFFWriteEncodedStrip(image, 0,
+		                           (bitspersample == 16) ? (unsigned char *)pixels16 : pixels,
+		                           (size_t)ibuf->x * ibuf->y * samplesperpixel * bitspersample / 8) != -1;
+	}
+
+	if (!ok) {
 		fprintf(stderr,
 		        "imb_savetiff: Could not write encoded TIFF.\n");
 		TIFFClose(image);
@@ -107,6 +107,9 @@ typedef struct ModifierData {
 	struct Scene *scene;
 
 	char *error;
+
+	/* runtime only, result of the stack up to this modifier (see ModifierCheckpoint) */
+	struct ModifierCheckpoint *checkpoint;
 } ModifierData;
 
 typedef enum {
@@ -600,7 +603,8 @@ typedef struct BooleanModifierData {
 	ModifierData modifier;
 
 	struct Object *object;
-	int operation, pad;
+	int operation;
+	char solver, pad[3];
 } BooleanModifierData;
 
 typedef enum {
@@ -609,6 +613,12 @@ typedef enum {
 	eBooleanModifierOp_Difference = 2,
 } BooleanModifierOp;
 
+/* bmd->solver */
+typedef enum {
+	eBooleanModifierSolver_Carve  = 0,
+	eBooleanModifierSolver_BMesh  = 1,
+} BooleanModifierSolver;
+
 typedef struct MDefInfluence {
 	int vertex;
 	float weight;
@@ -38,6 +38,8 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math.h"
+#include "BLI_kdtree.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_curve_types.h"
@@ -152,44 +154,57 @@ static float vertarray_size(const MVert *mvert, int numVerts, int axis)
 	return max_co - min_co;
 }
 
-BLI_INLINE float sum_v3(const float v[3])
-{
-	return v[0] + v[1] + v[2];
-}
-
-/* Structure used for sorting vertices, when processing doubles */
-typedef struct SortVertsElem {
-	int vertex_num;     /* The original index of the vertex, prior to sorting */
-	float co[3];        /* Its coordinates */
-	float sum_co;       /* sum_v3(co), just so we don't do the sum many times.  */
-} SortVertsElem;
-
+typedef struct MapDoublesUserdata {
+	int *doubles_map;
+	const MVert *mverts;
+	KDTree *tree;
+	int source_start;
+	float dist;
+	bool with_follow;
+} MapDoublesUserdata;
 
-static int svert_sum_cmp(const void *e1, const void *e2)
+static void dm_mvert_map_doubles_task(void *userdata, int i)
 {
-	const SortVertsElem *sv1 = (SortVertsElem *)e1;
-	const SortVertsElem *sv2 = (SortVertsElem *)e2;
+	MapDoublesUserdata *data = userdata;
+	const int source_vertex = data->source_start + i;
+	KDTreeNearest nearest;
+	int target_vertex;
+
+	/* If source has already been assigned to a target (in an earlier call, with other chunks) */
+	if (data->doubles_map[source_vertex] != -1) {
+		return;
+	}
 
-	if      (sv1->sum_co > sv2->sum_co) return  1;
-	else if (sv1->sum_co < sv2->sum_co) return -1;
-	else                                return  0;
-}
+	target_vertex = BLI_kdtree_find_nearest(data->tree, data->mverts[source_vertex].co, &nearest);
+	if (target_vertex == -1 || nearest.dist > data->dist) {
+		return;
+	}
 
-static void svert_from_mvert(SortVertsElem *sv, const MVert *mv, const int i_begin, const int i_end)
-{
-	int i;
-	for (i = i_begin; i < i_end; i++, sv++, mv++) {
-		sv->vertex_num = i;
-		copy_v3_v3(sv->co, mv->co);
-		sv->sum_co = sum_v3(mv->co);
+	target_vertex = nearest.index;
+
+	/* If double target is itself already mapped to other vertex,
+	 * behavior depends on with_follow option */
+	if (data->doubles_map[target_vertex] != -1) {
+		if (data->with_follow) { /* with_follow option:  map to initial target */
+			target_vertex = data->doubles_map[target_vertex];
+		}
+		else {
+			/* not with_follow: if target is mapped, then we do not map source */
+			return;
+		}
 	}
+
+	data->doubles_map[source_vertex] = target_vertex;
 }
 
 /**
  * Take as inputs two sets of verts, to be processed for detection of doubles and mapping.
  * Each set of verts is defined by its start within mverts array and its num_verts;
- * It builds a mapping for all vertices within source, to vertices within target, or -1 if no double found
+ * It builds a mapping for all vertices within source, to the nearest vertex within target,
+ * or -1 if no double found.
  * The int doubles_map[num_verts_source] array must have been allocated by caller.
+ *
+ * \note Source and target sets must not overlap, source verts are mapped in parallel.
  */
 static void dm_mvert_map_doubles(
         int *doubles_map,
@@ -201,110 +216,32 @@ static void dm_mvert_map_doubles(
         const float dist,
         const bool with_follow)
 {
-	const float dist3 = (M_SQRT3 + 0.00005f) * dist;   /* Just above sqrt(3) */
-	int i_source, i_target, i_target_low_bound, target_end, source_end;
-	SortVertsElem *sorted_verts_target, *sorted_verts_source;
-	SortVertsElem *sve_source, *sve_target, *sve_target_low_bound;
-	bool target_scan_completed;
-
-	target_end = target_start + target_num_verts;
-	source_end = source_start + source_num_verts;
-
-	/* build array of MVerts to be tested for merging */
-	sorted_verts_target = MEM_mallocN(sizeof(SortVertsElem) * target_num_verts, __func__);
-	sorted_verts_source = MEM_mallocN(sizeof(SortVertsElem) * source_num_verts, __func__);
-
-	/* Copy target vertices index and cos into SortVertsElem array */
-	svert_from_mvert(sorted_verts_target, mverts + target_start, target_start, target_end);
-
-	/* Copy source vertices index and cos into SortVertsElem array */
-	svert_from_mvert(sorted_verts_source, mverts + source_start, source_start, source_end);
-
-	/* sort arrays according to sum of vertex coordinates (sumco) */
-	qsort(sorted_verts_target, target_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
-	qsort(sorted_verts_source, source_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
-
-	sve_target_low_bound = sorted_verts_target;
-	i_target_low_bound = 0;
-	target_scan_completed = false;
-
-	/* Scan source vertices, in SortVertsElem sorted array, */
-	/* all the while maintaining the lower bound of possible doubles in target vertices */
-	for (i_source = 0, sve_source = sorted_verts_source;
-	     i_source < source_num_verts;
-	     i_source++, sve_source++)
-	{
-		bool double_found;
-		float sve_source_sumco;
-
-		/* If source has already been assigned to a target (in an earlier call, with other chunks) */
-		if (doubles_map[sve_source->vertex_num] != -1) {
-			continue;
-		}
+	MapDoublesUserdata data;
+	int i;
 
-		/* If target fully scanned already, then all remaining source vertices cannot have a double */
-		if (target_scan_completed) {
-			doubles_map[sve_source->vertex_num] = -1;
-			continue;
-		}
+	if (target_num_verts == 0 || source_num_verts == 0) {
+		return;
+	}
 
-		sve_source_sumco = sum_v3(sve_source->co);
+	BLI_assert((source_start >= target_start + target_num_verts) ||
+	           (target_start >= source_start + source_num_verts));
 
-		/* Skip all target vertices that are more than dist3 lower in terms of sumco */
-		/* and advance the overall lower bound, applicable to all remaining vertices as well. */
-		while ((i_target_low_bound < target_num_verts) &&
-		       (sve_target_low_bound->sum_co < sve_source_sumco - dist3))
-		{
-			i_target_low_bound++;
-			sve_target_low_bound++;
-		}
-		/* If end of target list reached, then no more possible doubles */
-		if (i_target_low_bound >= target_num_verts) {
-			doubles_map[sve_source->vertex_num] = -1;
-			target_scan_completed = true;
-			continue;
-		}
-		/* Test target candidates starting at the low bound of possible doubles, ordered in terms of sumco */
-		i_target = i_target_low_bound;
-		sve_target = sve_target_low_bound;
-
-		/* i_target will scan vertices in the [v_source_sumco - dist3;  v_source_sumco + dist3] range */
-
-		double_found = false;
-		while ((i_target < target_num_verts) &&
-		       (sve_target->sum_co <= sve_source_sumco + dist3))
-		{
-			/* Testing distance for candidate double in target */
-			/* v_target is within dist3 of v_source in terms of sumco;  check real distance */
-			if (compare_len_v3v3(sve_source->co, sve_target->co, dist)) {
-				/* Double found */
-				/* If double target is itself already mapped to other vertex,
-				 * behavior depends on with_follow option */
-				int target_vertex = sve_target->vertex_num;
-				if (doubles_map[target_vertex] != -1) {
-					if (with_follow) { /* with_follow option:  map to initial target */
-						target_vertex = doubles_map[target_vertex];
-					}
-					else {
-						/* not with_follow: if target is mapped, then we do not map source, and stop searching  */
-						break;
-					}
-				}
-				doubles_map[sve_source->vertex_num] = target_vertex;
-				double_found = true;
-				break;
-			}
-			i_target++;
-			sve_target++;
-		}
-		/* End of candidate scan: if none found then no doubles */
-		if (!double_found) {
-			doubles_map[sve_source->vertex_num] = -1;
-		}
+	/* build tree of the MVerts that can be merged into */
+	data.tree = BLI_kdtree_new(target_num_verts);
+	for (i = target_start; i < target_start + target_num_verts; i++) {
+		BLI_kdtree_insert(data.tree, i, mverts[i].co);
 	}
+	BLI_kdtree_balance(data.tree);
+
+	data.doubles_map = doubles_map;
+	data.mverts = mverts;
+	data.source_start = source_start;
+	data.dist = dist;
+	data.with_follow = with_follow;
+
+	BLI_task_parallel_range(0, source_num_verts, &data, dm_mvert_map_doubles_task);
 
-	MEM_freeN(sorted_verts_source);
-	MEM_freeN(sorted_verts_target);
+	BLI_kdtree_free(data.tree);
 }
 
 
@@ -199,7 +199,8 @@ ModifierTypeInfo modifierType_Bevel = {
 	/* type */              eModifierTypeType_Constructive,
 	/* flags */             eModifierTypeFlag_AcceptsMesh |
 	                        eModifierTypeFlag_SupportsEditmode |
-	                        eModifierTypeFlag_EnableInEditmode,
+	                        eModifierTypeFlag_EnableInEditmode |
+	                        eModifierTypeFlag_CacheResult,
 
 	/* copyData */          copyData,
 	/* deformVerts */       NULL,
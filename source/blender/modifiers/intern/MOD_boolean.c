@@ -37,13 +37,20 @@
 
 #include "DNA_object_types.h"
 
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
 #include "BLI_utildefines.h"
 
 #include "BLF_translation.h"
 
 #include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
 #include "BKE_modifier.h"
 
+#include "bmesh.h"
+#include "bmesh_tools.h"
+
 #include "depsgraph_private.h"
 
 #include "MOD_boolean_util.h"
@@ -92,7 +99,6 @@ static void updateDepgraph(ModifierData *md, DagForest *forest,
 	}
 }
 
-#ifdef WITH_MOD_BOOLEAN
 static DerivedMesh *get_quick_derivedMesh(DerivedMesh *derivedData, DerivedMesh *dm, int operation)
 {
 	DerivedMesh *result = NULL;
@@ -118,6 +124,91 @@ static DerivedMesh *get_quick_derivedMesh(DerivedMesh *derivedData, DerivedMesh
 	return result;
 }
 
+/* faces of the operand are tagged, see #applyModifier_bmesh */
+#define BM_FACE_TAG BM_ELEM_DRAW
+
+static int bm_face_isect_pair(BMFace *f, void *UNUSED(user_data))
+{
+	return BM_elem_flag_test(f, BM_FACE_TAG) ? 1 : 0;
+}
+
+/**
+ * Boolean using BMesh intersection,
+ * candidate faces are paired using BVH overlap, see #BM_mesh_intersect.
+ *
+ * \note Material indices of the operand are kept as is (unlike Carve, no materials are added).
+ */
+static DerivedMesh *applyModifier_bmesh(
+        BooleanModifierData *bmd, Object *ob,
+        DerivedMesh *derivedData, DerivedMesh *dm)
+{
+	DerivedMesh *result;
+	BMesh *bm;
+	BMIter iter;
+	BMVert *v;
+	BMFace *f;
+	BMLoop *(*looptris)[3];
+	int tottri;
+	float imat[4][4], omat[4][4];
+	bool is_flip;
+	int i;
+
+	{
+		const BMAllocTemplate allocsize = {
+		        derivedData->getNumVerts(derivedData) + dm->getNumVerts(dm),
+		        derivedData->getNumEdges(derivedData) + dm->getNumEdges(dm),
+		        derivedData->getNumLoops(derivedData) + dm->getNumLoops(dm),
+		        derivedData->getNumPolys(derivedData) + dm->getNumPolys(dm)};
+
+		bm = BM_mesh_create(&allocsize);
+	}
+
+	DM_to_bmesh_ex(derivedData, bm, true);
+	DM_to_bmesh_ex(dm, bm, true);
+
+	/* put the operand in the space of this object */
+	invert_m4_m4(imat, ob->obmat);
+	mul_m4_m4m4(omat, imat, bmd->object->obmat);
+	is_flip = is_negative_m4(omat);
+
+	i = 0;
+	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+		if (i++ >= derivedData->getNumVerts(derivedData)) {
+			mul_m4_v3(omat, v->co);
+		}
+	}
+
+	i = 0;
+	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+		if (i++ >= derivedData->getNumPolys(derivedData)) {
+			BM_elem_flag_enable(f, BM_FACE_TAG);
+			if (is_flip) {
+				BM_face_normal_flip(bm, f);
+			}
+			BM_face_normal_update(f);
+		}
+	}
+
+	looptris = MEM_mallocN(sizeof(*looptris) * (size_t)poly_to_tri_count(bm->totface, bm->totloop), __func__);
+	BM_bmesh_calc_tessellation(bm, looptris, &tottri);
+
+	BM_mesh_intersect(
+	        bm,
+	        looptris, tottri,
+	        bm_face_isect_pair, NULL,
+	        false, false, bmd->operation,
+	        0.000001f);
+
+	MEM_freeN(looptris);
+
+	result = CDDM_from_bmesh(bm, false);
+	BM_mesh_free(bm);
+
+	result->dirty |= DM_DIRTY_NORMALS;
+
+	return result;
+}
+
 static DerivedMesh *applyModifier(ModifierData *md, Object *ob,
                                   DerivedMesh *derivedData,
                                   ModifierApplyFlag flag)
@@ -139,12 +230,21 @@ static DerivedMesh *applyModifier(ModifierData *md, Object *ob,
 		result = get_quick_derivedMesh(derivedData, dm, bmd->operation);
 
 		if (result == NULL) {
-			// TIMEIT_START(NewBooleanDerivedMesh)
+			if (bmd->solver == eBooleanModifierSolver_BMesh) {
+				result = applyModifier_bmesh(bmd, ob, derivedData, dm);
+			}
+			else {
+#ifdef WITH_MOD_BOOLEAN
+				// TIMEIT_START(NewBooleanDerivedMesh)
 
-			result = NewBooleanDerivedMesh(dm, bmd->object, derivedData, ob,
-			                               1 + bmd->operation);
+				result = NewBooleanDerivedMesh(dm, bmd->object, derivedData, ob,
+				                               1 + bmd->operation);
 
-			// TIMEIT_END(NewBooleanDerivedMesh)
+				// TIMEIT_END(NewBooleanDerivedMesh)
+#else
+				result = derivedData;
+#endif
+			}
 		}
 
 		/* if new mesh returned, return it; otherwise there was
@@ -157,14 +257,6 @@ static DerivedMesh *applyModifier(ModifierData *md, Object *ob,
 	
 	return derivedData;
 }
-#else // WITH_MOD_BOOLEAN
-static DerivedMesh *applyModifier(ModifierData *UNUSED(md), Object *UNUSED(ob),
-                                  DerivedMesh *derivedData,
-                                  ModifierApplyFlag UNUSED(flag))
-{
-	return derivedData;
-}
-#endif // WITH_MOD_BOOLEAN
 
 static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *UNUSED(md))
 {
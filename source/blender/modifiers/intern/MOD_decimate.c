@@ -216,7 +216,8 @@ ModifierTypeInfo modifierType_Decimate = {
 	/* structSize */        sizeof(DecimateModifierData),
 	/* type */              eModifierTypeType_Nonconstructive,
 	/* flags */             eModifierTypeFlag_AcceptsMesh |
-	                        eModifierTypeFlag_AcceptsCVs,
+	                        eModifierTypeFlag_AcceptsCVs |
+	                        eModifierTypeFlag_CacheResult,
 	/* copyData */          copyData,
 	/* deformVerts */       NULL,
 	/* deformMatrices */    NULL,
@@ -40,6 +40,7 @@
 
 
 #include "BKE_cdderivedmesh.h"
+#include "BKE_image.h"
 #include "BKE_library.h"
 #include "BKE_modifier.h"
 #include "BKE_texture.h"
@@ -171,84 +172,95 @@ static void updateDepgraph(ModifierData *md, DagForest *forest,
 }
 
 /* dm must be a CDDerivedMesh */
+typedef struct DisplaceUserdata {
+	DisplaceModifierData *dmd;
+	MVert *mvert;
+	float (*tex_co)[3];
+	struct ImagePool *pool;
+} DisplaceUserdata;
+
+static void displace_vert_task(void *userdata, const int i, float co[3], const float weight,
+                               void *UNUSED(scratch))
+{
+	DisplaceUserdata *data = userdata;
+	DisplaceModifierData *dmd = data->dmd;
+	TexResult texres;
+	const float strength = dmd->strength * weight;
+	float delta;
+
+	if (dmd->texture) {
+		texres.nor = NULL;
+		BKE_texture_get_value_ex(dmd->modifier.scene, dmd->texture, data->tex_co[i], &texres, data->pool, false);
+		delta = texres.tin - dmd->midlevel;
+	}
+	else {
+		delta = 1.0f - dmd->midlevel;  /* when no texture is used, we fallback to white */
+	}
+
+	delta *= strength;
+	CLAMP(delta, -10000, 10000);
+
+	switch (dmd->direction) {
+		case MOD_DISP_DIR_X:
+			co[0] += delta;
+			break;
+		case MOD_DISP_DIR_Y:
+			co[1] += delta;
+			break;
+		case MOD_DISP_DIR_Z:
+			co[2] += delta;
+			break;
+		case MOD_DISP_DIR_RGB_XYZ:
+			co[0] += (texres.tr - dmd->midlevel) * strength;
+			co[1] += (texres.tg - dmd->midlevel) * strength;
+			co[2] += (texres.tb - dmd->midlevel) * strength;
+			break;
+		case MOD_DISP_DIR_NOR:
+		{
+			const short *no = data->mvert[i].no;
+			co[0] += delta * (no[0] / 32767.0f);
+			co[1] += delta * (no[1] / 32767.0f);
+			co[2] += delta * (no[2] / 32767.0f);
+			break;
+		}
+	}
+}
+
 static void displaceModifier_do(
         DisplaceModifierData *dmd, Object *ob,
         DerivedMesh *dm, float (*vertexCos)[3], int numVerts)
 {
-	int i;
-	MVert *mvert;
+	DisplaceUserdata data;
 	MDeformVert *dvert;
 	int defgrp_index;
-	float (*tex_co)[3];
-	float weight = 1.0f; /* init value unused but some compilers may complain */
-	const float delta_fixed = 1.0f - dmd->midlevel;  /* when no texture is used, we fallback to white */
 
 	if (!dmd->texture && dmd->direction == MOD_DISP_DIR_RGB_XYZ) return;
 	if (dmd->strength == 0.0f) return;
 
-	mvert = CDDM_get_verts(dm);
 	modifier_get_vgroup(ob, dm, dmd->defgrp_name, &dvert, &defgrp_index);
 
+	data.dmd = dmd;
+	data.mvert = CDDM_get_verts(dm);
+
 	if (dmd->texture) {
-		tex_co = MEM_callocN(sizeof(*tex_co) * numVerts,
-		                     "displaceModifier_do tex_co");
-		get_texture_coords((MappingInfoModifierData *)dmd, ob, dm, vertexCos, tex_co, numVerts);
+		data.tex_co = MEM_callocN(sizeof(*data.tex_co) * numVerts,
+		                          "displaceModifier_do tex_co");
+		get_texture_coords((MappingInfoModifierData *)dmd, ob, dm, vertexCos, data.tex_co, numVerts);
 
 		modifier_init_texture(dmd->modifier.scene, dmd->texture);
+		data.pool = BKE_image_pool_new();
 	}
 	else {
-		tex_co = NULL;
+		data.tex_co = NULL;
+		data.pool = NULL;
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		TexResult texres;
-		float strength = dmd->strength;
-		float delta;
-
-		if (dvert) {
-			weight = defvert_find_weight(dvert + i, defgrp_index);
-			if (weight == 0.0f) continue;
-		}
-
-		if (dmd->texture) {
-			texres.nor = NULL;
-			BKE_texture_get_value(dmd->modifier.scene, dmd->texture, tex_co[i], &texres, false);
-			delta = texres.tin - dmd->midlevel;
-		}
-		else {
-			delta = delta_fixed;  /* (1.0f - dmd->midlevel) */  /* never changes */
-		}
-
-		if (dvert) strength *= weight;
-
-		delta *= strength;
-		CLAMP(delta, -10000, 10000);
-
-		switch (dmd->direction) {
-			case MOD_DISP_DIR_X:
-				vertexCos[i][0] += delta;
-				break;
-			case MOD_DISP_DIR_Y:
-				vertexCos[i][1] += delta;
-				break;
-			case MOD_DISP_DIR_Z:
-				vertexCos[i][2] += delta;
-				break;
-			case MOD_DISP_DIR_RGB_XYZ:
-				vertexCos[i][0] += (texres.tr - dmd->midlevel) * strength;
-				vertexCos[i][1] += (texres.tg - dmd->midlevel) * strength;
-				vertexCos[i][2] += (texres.tb - dmd->midlevel) * strength;
-				break;
-			case MOD_DISP_DIR_NOR:
-				vertexCos[i][0] += delta * (mvert[i].no[0] / 32767.0f);
-				vertexCos[i][1] += delta * (mvert[i].no[1] / 32767.0f);
-				vertexCos[i][2] += delta * (mvert[i].no[2] / 32767.0f);
-				break;
-		}
-	}
+	modifier_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index,
+	                               &data, displace_vert_task, 0);
 
-	if (tex_co) {
-		MEM_freeN(tex_co);
+	if (data.tex_co) {
+		MEM_freeN(data.tex_co);
+		BKE_image_pool_free(data.pool);
 	}
 }
 
@@ -144,7 +144,8 @@ ModifierTypeInfo modifierType_EdgeSplit = {
 	                        eModifierTypeFlag_AcceptsCVs |
 	                        eModifierTypeFlag_SupportsMapping |
 	                        eModifierTypeFlag_SupportsEditmode |
-	                        eModifierTypeFlag_EnableInEditmode,
+	                        eModifierTypeFlag_EnableInEditmode |
+	                        eModifierTypeFlag_Checkpoint,
 
 	/* copyData */          copyData,
 	/* deformVerts */       NULL,
@@ -37,6 +37,7 @@
 #include "DNA_object_types.h"
 
 #include "BLI_math.h"
+#include "BLI_bitmap.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_action.h"
@@ -135,6 +136,40 @@ static float hook_falloff(const float co_1[3], const float co_2[3], const float
 	return fac;
 }
 
+typedef struct HookUserdata {
+	HookModifierData *hmd;
+	float (*mat)[4];
+	float falloff_squared;
+	/* when set, only verts whose original index is enabled in the bitmap are hooked */
+	const int *origindex_ar;
+	BLI_bitmap *indices;
+	int indices_len;
+} HookUserdata;
+
+static void hook_vert_task(void *userdata, const int i, float co[3], const float weight,
+                           void *UNUSED(scratch))
+{
+	HookUserdata *data = userdata;
+	float fac;
+
+	if (data->indices) {
+		const int index = data->origindex_ar[i];
+		if (index < 0 || index >= data->indices_len || !BLI_BITMAP_TEST(data->indices, index)) {
+			return;
+		}
+	}
+
+	if ((fac = hook_falloff(data->hmd->cent, co, data->falloff_squared, data->hmd->force))) {
+		fac *= weight;
+
+		if (fac) {
+			float vec[3];
+			mul_v3_m4v3(vec, data->mat, co);
+			interp_v3_v3v3(co, co, vec, fac);
+		}
+	}
+}
+
 static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
                            float (*vertexCos)[3], int numVerts)
 {
@@ -144,7 +179,8 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 	const float falloff_squared = hmd->falloff * hmd->falloff; /* for faster comparisons */
 	
 	MDeformVert *dvert;
-	int defgrp_index, max_dvert;
+	int defgrp_index;
+	HookUserdata data;
 	
 	/* get world-space matrix of target, corrected for the space the verts are in */
 	if (hmd->subtarget[0] && pchan) {
@@ -159,7 +195,13 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 	mul_m4_series(mat, ob->imat, dmat, hmd->parentinv);
 
 	modifier_get_vgroup(ob, dm, hmd->name, &dvert, &defgrp_index);
-	max_dvert = (dvert) ? numVerts : 0;
+
+	data.hmd = hmd;
+	data.mat = mat;
+	data.falloff_squared = falloff_squared;
+	data.origindex_ar = NULL;
+	data.indices = NULL;
+	data.indices_len = 0;
 
 	/* Regarding index range checking below.
 	 *
@@ -179,26 +221,21 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 		
 		/* if DerivedMesh is present and has original index data, use it */
 		if (dm && (origindex_ar = dm->getVertDataArray(dm, CD_ORIGINDEX))) {
+			/* flag the hooked original indices once, instead of searching all verts for each of them */
+			data.origindex_ar = origindex_ar;
+			data.indices = BLI_BITMAP_NEW(numVerts, __func__);
+			data.indices_len = numVerts;
+
 			for (i = 0, index_pt = hmd->indexar; i < hmd->totindex; i++, index_pt++) {
-				if (*index_pt < numVerts) {
-					int j;
-					
-					for (j = 0; j < numVerts; j++) {
-						if (origindex_ar[j] == *index_pt) {
-							float *co = vertexCos[j];
-							if ((fac = hook_falloff(hmd->cent, co, falloff_squared, fac_orig))) {
-								if (dvert)
-									fac *= defvert_find_weight(dvert + j, defgrp_index);
-								
-								if (fac) {
-									mul_v3_m4v3(vec, mat, co);
-									interp_v3_v3v3(co, co, vec, fac);
-								}
-							}
-						}
-					}
+				if (*index_pt >= 0 && *index_pt < numVerts) {
+					BLI_BITMAP_ENABLE(data.indices, *index_pt);
 				}
 			}
+
+			modifier_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index,
+			                               &data, hook_vert_task, 0);
+
+			MEM_freeN(data.indices);
 		}
 		else { /* missing dm or ORIGINDEX */
 			for (i = 0, index_pt = hmd->indexar; i < hmd->totindex; i++, index_pt++) {
@@ -218,20 +255,8 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 		}
 	}
 	else if (dvert) {  /* vertex group hook */
-		const float fac_orig = hmd->force;
-		
-		for (i = 0; i < max_dvert; i++, dvert++) {
-			float fac;
-			float *co = vertexCos[i];
-			
-			if ((fac = hook_falloff(hmd->cent, co, falloff_squared, fac_orig))) {
-				fac *= defvert_find_weight(dvert, defgrp_index);
-				if (fac) {
-					mul_v3_m4v3(vec, mat, co);
-					interp_v3_v3v3(co, co, vec, fac);
-				}
-			}
-		}
+		modifier_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index,
+		                               &data, hook_vert_task, 0);
 	}
 }
 
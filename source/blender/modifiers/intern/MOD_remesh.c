@@ -28,10 +28,12 @@
 
 #include "BLI_math_base.h"
 #include "BLI_math_vector.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_DerivedMesh.h"
+#include "BKE_global.h"
 
 #include "DNA_meshdata_types.h"
 #include "DNA_modifier_types.h"
@@ -161,6 +163,9 @@ static DerivedMesh *applyModifier(ModifierData *md,
 	if (rmd->flag & MOD_REMESH_FLOOD_FILL)
 		flags |= DUALCON_FLOOD_FILL;
 
+	if (G.debug & G_DEBUG)
+		flags |= DUALCON_PRINT_TIMINGS;
+
 	switch (rmd->mode) {
 		case MOD_REMESH_CENTROID:
 			mode = DUALCON_CENTROID;
@@ -173,6 +178,9 @@ static DerivedMesh *applyModifier(ModifierData *md,
 			break;
 	}
 	
+	/* dualcon allocates from multiple threads */
+	BLI_begin_threaded_malloc();
+
 	output = dualcon(&input,
 	                 dualcon_alloc_output,
 	                 dualcon_add_vert,
@@ -183,6 +191,9 @@ static DerivedMesh *applyModifier(ModifierData *md,
 	                 rmd->hermite_num,
 	                 rmd->scale,
 	                 rmd->depth);
+
+	BLI_end_threaded_malloc();
+
 	result = output->dm;
 	MEM_freeN(output);
 
@@ -219,7 +230,8 @@ ModifierTypeInfo modifierType_Remesh = {
 	/* type */              eModifierTypeType_Nonconstructive,
 	/* flags */             eModifierTypeFlag_AcceptsMesh |
 	                        eModifierTypeFlag_AcceptsCVs |
-	                        eModifierTypeFlag_SupportsEditmode,
+	                        eModifierTypeFlag_SupportsEditmode |
+	                        eModifierTypeFlag_CacheResult,
 	/* copyData */          copyData,
 	/* deformVerts */       NULL,
 	/* deformMatrices */    NULL,
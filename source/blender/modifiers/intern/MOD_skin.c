@@ -1891,7 +1891,8 @@ ModifierTypeInfo modifierType_Skin = {
 	/* structName */        "SkinModifierData",
 	/* structSize */        sizeof(SkinModifierData),
 	/* type */              eModifierTypeType_Constructive,
-	/* flags */             eModifierTypeFlag_AcceptsMesh | eModifierTypeFlag_SupportsEditmode,
+	/* flags */             eModifierTypeFlag_AcceptsMesh | eModifierTypeFlag_SupportsEditmode |
+	                        eModifierTypeFlag_CacheResult,
 
 	/* copyData */          copyData,
 	/* deformVerts */       NULL,
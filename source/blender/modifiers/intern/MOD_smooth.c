@@ -91,6 +91,35 @@ static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *md)
 	return dataMask;
 }
 
+typedef struct SmoothUserdata {
+	SmoothModifierData *smd;
+	const float *ftmp;
+	const unsigned char *uctmp;
+} SmoothUserdata;
+
+static void smooth_vert_task(void *userdata, const int i, float v[3], const float weight,
+                             void *UNUSED(scratch))
+{
+	SmoothUserdata *data = userdata;
+	const short flag = data->smd->flag;
+	const float *fp = &data->ftmp[i * 3];
+	const float f = data->smd->fac * weight;
+	const float fm = 1.0f - f;
+	float facw;
+
+	/* fp is the sum of uctmp[i] verts, so must be averaged */
+	facw = 0.0f;
+	if (data->uctmp[i])
+		facw = f / (float)data->uctmp[i];
+
+	if (flag & MOD_SMOOTH_X)
+		v[0] = fm * v[0] + facw * fp[0];
+	if (flag & MOD_SMOOTH_Y)
+		v[1] = fm * v[1] + facw * fp[1];
+	if (flag & MOD_SMOOTH_Z)
+		v[2] = fm * v[2] + facw * fp[2];
+}
+
 static void smoothModifier_do(
         SmoothModifierData *smd, Object *ob, DerivedMesh *dm,
         float (*vertexCos)[3], int numVerts)
@@ -100,7 +129,8 @@ static void smoothModifier_do(
 
 	int i, j, numDMEdges, defgrp_index;
 	unsigned char *uctmp;
-	float *ftmp, fac, facm;
+	float *ftmp;
+	SmoothUserdata data;
 
 	ftmp = (float *)MEM_callocN(3 * sizeof(float) * numVerts,
 	                            "smoothmodifier_f");
@@ -112,9 +142,6 @@ static void smoothModifier_do(
 		return;
 	}
 
-	fac = smd->fac;
-	facm = 1 - fac;
-
 	if (dm->getNumVerts(dm) == numVerts) {
 		medges = dm->getEdgeArray(dm);
 		numDMEdges = dm->getNumEdges(dm);
@@ -126,8 +153,10 @@ static void smoothModifier_do(
 
 	modifier_get_vgroup(ob, dm, smd->defgrp_name, &dvert, &defgrp_index);
 
-	/* NOTICE: this can be optimized a little bit by moving the
-	 * if (dvert) out of the loop, if needed */
+	data.smd = smd;
+	data.ftmp = ftmp;
+	data.uctmp = uctmp;
+
 	for (j = 0; j < smd->repeat; j++) {
 		for (i = 0; i < numDMEdges; i++) {
 			float fvec[3];
@@ -155,57 +184,9 @@ static void smoothModifier_do(
 			}
 		}
 
-		if (dvert) {
-			MDeformVert *dv = dvert;
-			for (i = 0; i < numVerts; i++, dv++) {
-				float f, fm, facw, *fp, *v;
-				short flag = smd->flag;
-
-				v = vertexCos[i];
-				fp = &ftmp[i * 3];
-
-
-				f = defvert_find_weight(dv, defgrp_index);
-				if (f <= 0.0f) continue;
-
-				f *= fac;
-				fm = 1.0f - f;
-
-				/* fp is the sum of uctmp[i] verts, so must be averaged */
-				facw = 0.0f;
-				if (uctmp[i]) 
-					facw = f / (float)uctmp[i];
-
-				if (flag & MOD_SMOOTH_X)
-					v[0] = fm * v[0] + facw * fp[0];
-				if (flag & MOD_SMOOTH_Y)
-					v[1] = fm * v[1] + facw * fp[1];
-				if (flag & MOD_SMOOTH_Z)
-					v[2] = fm * v[2] + facw * fp[2];
-			}
-		}
-		else { /* no vertex group */
-			for (i = 0; i < numVerts; i++) {
-				float facw, *fp, *v;
-				short flag = smd->flag;
-
-				v = vertexCos[i];
-				fp = &ftmp[i * 3];
-
-				/* fp is the sum of uctmp[i] verts, so must be averaged */
-				facw = 0.0f;
-				if (uctmp[i]) 
-					facw = fac / (float)uctmp[i];
-
-				if (flag & MOD_SMOOTH_X)
-					v[0] = facm * v[0] + facw * fp[0];
-				if (flag & MOD_SMOOTH_Y)
-					v[1] = facm * v[1] + facw * fp[1];
-				if (flag & MOD_SMOOTH_Z)
-					v[2] = facm * v[2] + facw * fp[2];
-			}
-
-		}
+		/* the edge pass above scatters into shared sums, only the blend runs threaded */
+		modifier_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index,
+		                               &data, smooth_vert_task, 0);
 
 		memset(ftmp, 0, 3 * sizeof(float) * numVerts);
 		memset(uctmp, 0, sizeof(unsigned char) * numVerts);
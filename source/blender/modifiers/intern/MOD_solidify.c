@@ -937,7 +937,8 @@ ModifierTypeInfo modifierType_Solidify = {
 	                        eModifierTypeFlag_AcceptsCVs |
 	                        eModifierTypeFlag_SupportsMapping |
 	                        eModifierTypeFlag_SupportsEditmode |
-	                        eModifierTypeFlag_EnableInEditmode,
+	                        eModifierTypeFlag_EnableInEditmode |
+	                        eModifierTypeFlag_Checkpoint,
 
 	/* copyData */          copyData,
 	/* deformVerts */       NULL,
@@ -145,7 +145,8 @@ ModifierTypeInfo modifierType_Subsurf = {
 	                        eModifierTypeFlag_SupportsMapping |
 	                        eModifierTypeFlag_SupportsEditmode |
 	                        eModifierTypeFlag_EnableInEditmode |
-	                        eModifierTypeFlag_AcceptsCVs,
+	                        eModifierTypeFlag_AcceptsCVs |
+	                        eModifierTypeFlag_CacheResult,
 
 	/* copyData */          copyData,
 	/* deformVerts */       NULL,
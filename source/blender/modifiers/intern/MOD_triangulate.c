@@ -106,7 +106,8 @@ ModifierTypeInfo modifierType_Triangulate = {
 	                        eModifierTypeFlag_SupportsEditmode |
 	                        eModifierTypeFlag_SupportsMapping |
 	                        eModifierTypeFlag_EnableInEditmode |
-	                        eModifierTypeFlag_AcceptsCVs,
+	                        eModifierTypeFlag_AcceptsCVs |
+	                        eModifierTypeFlag_Checkpoint,
 
 	/* copyData */          copyData,
 	/* deformVerts */       NULL,
@@ -42,6 +42,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_math_vector.h"
 #include "BLI_math_matrix.h"
+#include "BLI_task.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_deform.h"
@@ -238,6 +239,74 @@ void modifier_get_vgroup(Object *ob, DerivedMesh *dm, const char *name, MDeformV
 	}
 }
 
+/* Vertices handled by a single task, keeps scheduling overhead low for cheap deform callbacks. */
+#define DEFORM_VERTS_BATCH 1024
+
+typedef struct DeformVertsUserdata {
+	float (*vertexCos)[3];
+	int numVerts;
+	const MDeformVert *dvert;
+	int defgrp_index;
+	void *userdata;
+	ModifierDeformVertFunc func;
+	size_t scratch_size;
+} DeformVertsUserdata;
+
+static void deform_verts_batch_task(void *userdata, int batch)
+{
+	DeformVertsUserdata *data = userdata;
+	const int start = batch * DEFORM_VERTS_BATCH;
+	const int end = min_ii(start + DEFORM_VERTS_BATCH, data->numVerts);
+	void *scratch = data->scratch_size ? MEM_mallocN(data->scratch_size, __func__) : NULL;
+	int i;
+
+	for (i = start; i < end; i++) {
+		const float weight = defvert_array_find_weight_safe(data->dvert, i, data->defgrp_index);
+
+		if (weight != 0.0f) {
+			data->func(data->userdata, i, data->vertexCos[i], weight, scratch);
+		}
+	}
+
+	if (scratch) {
+		MEM_freeN(scratch);
+	}
+}
+
+/**
+ * Run \a func on every vertex of \a vertexCos, in batches on the task scheduler.
+ *
+ * The vertex group weight is looked up before calling \a func (1.0 without a group)
+ * and vertices with zero weight are skipped. \a func may only write to its own
+ * vertex, \a scratch_size bytes of scratch memory are allocated for each batch.
+ */
+void modifier_deform_verts_parallel(float (*vertexCos)[3], const int numVerts,
+                                    const MDeformVert *dvert, const int defgrp_index,
+                                    void *userdata, ModifierDeformVertFunc func, const size_t scratch_size)
+{
+	DeformVertsUserdata data;
+	const int numBatches = (numVerts + DEFORM_VERTS_BATCH - 1) / DEFORM_VERTS_BATCH;
+
+	if (numVerts <= 0) {
+		return;
+	}
+
+	data.vertexCos = vertexCos;
+	data.numVerts = numVerts;
+	data.dvert = dvert;
+	data.defgrp_index = defgrp_index;
+	data.userdata = userdata;
+	data.func = func;
+	data.scratch_size = scratch_size;
+
+	if (numBatches == 1) {
+		deform_verts_batch_task(&data, 0);
+	}
+	else {
+		BLI_task_parallel_range_ex(0, numBatches, &data, deform_verts_batch_task, 1);
+	}
+}
+
 
 #ifdef OPENNL_THREADING_HACK
 
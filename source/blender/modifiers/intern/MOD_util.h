@@ -52,6 +52,15 @@ struct DerivedMesh *get_dm_for_modifier(struct Object *ob, ModifierApplyFlag fla
 void modifier_get_vgroup(struct Object *ob, struct DerivedMesh *dm,
                          const char *name, struct MDeformVert **dvert, int *defgrp_index);
 
+/* Callback for #modifier_deform_verts_parallel, called once per vertex with a
+ * non-zero vertex group weight. \a scratch is private to the calling thread. */
+typedef void (*ModifierDeformVertFunc)(void *userdata, const int index, float co[3],
+                                       const float weight, void *scratch);
+
+void modifier_deform_verts_parallel(float (*vertexCos)[3], const int numVerts,
+                                    const struct MDeformVert *dvert, const int defgrp_index,
+                                    void *userdata, ModifierDeformVertFunc func, const size_t scratch_size);
+
 /* XXX workaround for non-threadsafe context in OpenNL (T38403)
  * OpenNL uses global pointer for "current context", which causes
  * conflict when multiple modifiers get evaluated in threaded depgraph.
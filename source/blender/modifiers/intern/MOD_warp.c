@@ -38,6 +38,7 @@
 #include "BKE_cdderivedmesh.h"
 #include "BKE_modifier.h"
 #include "BKE_deform.h"
+#include "BKE_image.h"
 #include "BKE_texture.h"
 #include "BKE_colortools.h"
 
@@ -155,25 +156,115 @@ static void updateDepgraph(ModifierData *md, DagForest *forest, struct Scene *UN
 	}
 }
 
+typedef struct WarpUserdata {
+	WarpModifierData *wmd;
+	float (*tex_co)[3];
+	struct ImagePool *pool;
+	float strength;
+	float mat_from[4][4];
+	float mat_from_inv[4][4];
+	float mat_unit[4][4];
+	float mat_final[4][4];
+} WarpUserdata;
+
+static void warp_vert_task(void *userdata, const int i, float co[3], const float vgroup_weight,
+                           void *UNUSED(scratch))
+{
+	WarpUserdata *data = userdata;
+	WarpModifierData *wmd = data->wmd;
+	const float weight = vgroup_weight * data->strength;
+	float fac = 1.0f;
+
+	if (weight <= 0.0f) /* Should never occure... */
+		return;
+
+	if (!(wmd->falloff_type == eWarp_Falloff_None ||
+	      ((fac = len_v3v3(co, data->mat_from[3])) < wmd->falloff_radius &&
+	       (fac = (wmd->falloff_radius - fac) / wmd->falloff_radius))))
+	{
+		return;
+	}
+
+	/* closely match PROP_SMOOTH and similar */
+	switch (wmd->falloff_type) {
+		case eWarp_Falloff_None:
+			fac = 1.0f;
+			break;
+		case eWarp_Falloff_Curve:
+			fac = curvemapping_evaluateF(wmd->curfalloff, 0, fac);
+			break;
+		case eWarp_Falloff_Sharp:
+			fac = fac * fac;
+			break;
+		case eWarp_Falloff_Smooth:
+			fac = 3.0f * fac * fac - 2.0f * fac * fac * fac;
+			break;
+		case eWarp_Falloff_Root:
+			fac = sqrtf(fac);
+			break;
+		case eWarp_Falloff_Linear:
+			/* pass */
+			break;
+		case eWarp_Falloff_Const:
+			fac = 1.0f;
+			break;
+		case eWarp_Falloff_Sphere:
+			fac = sqrtf(2 * fac - fac * fac);
+			break;
+	}
+
+	fac *= weight;
+
+	if (data->tex_co) {
+		TexResult texres;
+		texres.nor = NULL;
+		BKE_texture_get_value_ex(wmd->modifier.scene, wmd->texture, data->tex_co[i], &texres, data->pool, false);
+		fac *= texres.tin;
+	}
+
+	/* into the 'from' objects space */
+	mul_m4_v3(data->mat_from_inv, co);
+
+	if (fac >= 1.0f) {
+		mul_m4_v3(data->mat_final, co);
+	}
+	else if (fac > 0.0f) {
+		if (wmd->flag & MOD_WARP_VOLUME_PRESERVE) {
+			/* interpolate the matrix for nicer locations */
+			float tmat[4][4];
+			blend_m4_m4m4(tmat, data->mat_unit, data->mat_final, fac);
+			mul_m4_v3(tmat, co);
+		}
+		else {
+			float tvec[3];
+			mul_v3_m4v3(tvec, data->mat_final, co);
+			interp_v3_v3v3(co, co, tvec, fac);
+		}
+	}
+
+	/* out of the 'from' objects space */
+	mul_m4_v3(data->mat_from, co);
+}
+
 static void warpModifier_do(WarpModifierData *wmd, Object *ob,
                             DerivedMesh *dm, float (*vertexCos)[3], int numVerts)
 {
+	WarpUserdata data;
 	float obinv[4][4];
-	float mat_from[4][4];
-	float mat_from_inv[4][4];
+	float (*mat_from)[4] = data.mat_from;
+	float (*mat_from_inv)[4] = data.mat_from_inv;
 	float mat_to[4][4];
-	float mat_unit[4][4];
-	float mat_final[4][4];
+	float (*mat_unit)[4] = data.mat_unit;
+	float (*mat_final)[4] = data.mat_final;
 
 	float tmat[4][4];
 
 	float strength = wmd->strength;
-	float fac = 1.0f, weight;
-	int i;
 	int defgrp_index;
-	MDeformVert *dvert, *dv = NULL;
+	MDeformVert *dvert;
 
 	float (*tex_co)[3] = NULL;
+	struct ImagePool *pool = NULL;
 
 	if (!(wmd->object_from && wmd->object_to))
 		return;
@@ -209,97 +300,27 @@ static void warpModifier_do(WarpModifierData *wmd, Object *ob,
 		negate_v3_v3(mat_final[3], loc);
 
 	}
-	weight = strength;
 
 	if (wmd->texture) {
 		tex_co = MEM_mallocN(sizeof(*tex_co) * numVerts, "warpModifier_do tex_co");
 		get_texture_coords((MappingInfoModifierData *)wmd, ob, dm, vertexCos, tex_co, numVerts);
 
 		modifier_init_texture(wmd->modifier.scene, wmd->texture);
+		pool = BKE_image_pool_new();
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		float *co = vertexCos[i];
-
-		if (wmd->falloff_type == eWarp_Falloff_None ||
-		    ((fac = len_v3v3(co, mat_from[3])) < wmd->falloff_radius &&
-		     (fac = (wmd->falloff_radius - fac) / wmd->falloff_radius)))
-		{
-			/* skip if no vert group found */
-			if (dvert && defgrp_index != -1) {
-				dv = &dvert[i];
-
-				if (dv) {
-					weight = defvert_find_weight(dv, defgrp_index) * strength;
-					if (weight <= 0.0f) /* Should never occure... */
-						continue;
-				}
-			}
-
-
-			/* closely match PROP_SMOOTH and similar */
-			switch (wmd->falloff_type) {
-				case eWarp_Falloff_None:
-					fac = 1.0f;
-					break;
-				case eWarp_Falloff_Curve:
-					fac = curvemapping_evaluateF(wmd->curfalloff, 0, fac);
-					break;
-				case eWarp_Falloff_Sharp:
-					fac = fac * fac;
-					break;
-				case eWarp_Falloff_Smooth:
-					fac = 3.0f * fac * fac - 2.0f * fac * fac * fac;
-					break;
-				case eWarp_Falloff_Root:
-					fac = sqrtf(fac);
-					break;
-				case eWarp_Falloff_Linear:
-					/* pass */
-					break;
-				case eWarp_Falloff_Const:
-					fac = 1.0f;
-					break;
-				case eWarp_Falloff_Sphere:
-					fac = sqrtf(2 * fac - fac * fac);
-					break;
-			}
-
-			fac *= weight;
-
-			if (tex_co) {
-				TexResult texres;
-				texres.nor = NULL;
-				BKE_texture_get_value(wmd->modifier.scene, wmd->texture, tex_co[i], &texres, false);
-				fac *= texres.tin;
-			}
-
-			/* into the 'from' objects space */
-			mul_m4_v3(mat_from_inv, co);
-
-			if (fac >= 1.0f) {
-				mul_m4_v3(mat_final, co);
-			}
-			else if (fac > 0.0f) {
-				if (wmd->flag & MOD_WARP_VOLUME_PRESERVE) {
-					/* interpolate the matrix for nicer locations */
-					blend_m4_m4m4(tmat, mat_unit, mat_final, fac);
-					mul_m4_v3(tmat, co);
-				}
-				else {
-					float tvec[3];
-					mul_v3_m4v3(tvec, mat_final, co);
-					interp_v3_v3v3(co, co, tvec, fac);
-				}
-			}
-
-			/* out of the 'from' objects space */
-			mul_m4_v3(mat_from, co);
-		}
-	}
+	data.wmd = wmd;
+	data.tex_co = tex_co;
+	data.pool = pool;
+	data.strength = strength;
 
-	if (tex_co)
+	modifier_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index,
+	                               &data, warp_vert_task, 0);
+
+	if (tex_co) {
 		MEM_freeN(tex_co);
+		BKE_image_pool_free(pool);
+	}
 
 }
 
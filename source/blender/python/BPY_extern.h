@@ -81,6 +81,7 @@ void	BPY_modules_update(struct bContext *C); // XXX - annoying, need this for po
 void	BPY_modules_load_user(struct bContext *C);
 
 void	BPY_app_handlers_reset(const short do_all);
+bool	BPY_app_handlers_exist(int evt);
 
 void	BPY_driver_reset(void);
 float	BPY_driver_exec(struct ChannelDriver *driver, const float evaltime);
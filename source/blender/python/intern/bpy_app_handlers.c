@@ -286,6 +286,13 @@ void BPY_app_handlers_reset(const short do_all)
 	PyGILState_Release(gilstate);
 }
 
+/* scripts registered handlers for this event (eCbEvent) */
+bool BPY_app_handlers_exist(int evt)
+{
+	PyObject *cb_list = py_cb_array[evt];
+	return (cb_list && PyList_GET_SIZE(cb_list) > 0);
+}
+
 /* the actual callback - not necessarily called from py */
 void bpy_app_generic_callback(struct Main *UNUSED(main), struct ID *id, void *arg)
 {
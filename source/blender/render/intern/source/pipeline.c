@@ -50,6 +50,7 @@
 #include "BLI_string.h"
 #include "BLI_path_util.h"
 #include "BLI_fileops.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_rand.h"
 #include "BLI_callbacks.h"
@@ -83,6 +84,10 @@
 #  include "FRS_freestyle.h"
 #endif
 
+#ifdef WITH_PYTHON
+#  include "BPY_extern.h"
+#endif
+
 /* internal */
 #include "render_result.h"
 #include "render_types.h"
@@ -132,7 +137,10 @@ Render R;
 
 /* ********* alloc and free ******** */
 
-static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovieHandle *mh, const char *name_override);
+typedef struct RenderWriteQueue RenderWriteQueue;
+
+static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovieHandle *mh,
+                                   RenderWriteQueue *wq, const char *name_override);
 
 static volatile int g_break = 0;
 static int thread_break(void *UNUSED(arg))
@@ -2824,7 +2832,7 @@ void RE_BlenderFrame(Render *re, Main *bmain, Scene *scene, SceneRenderLayer *sr
 				                  &scene->r.im_format, (scene->r.scemode & R_EXTENSION) != 0, false);
 
 				/* reports only used for Movie */
-				do_write_image_or_movie(re, bmain, scene, NULL, name);
+				do_write_image_or_movie(re, bmain, scene, NULL, NULL, name);
 			}
 		}
 
@@ -2859,7 +2867,77 @@ void RE_RenderFreestyleExternal(Render *re)
 }
 #endif
 
-static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovieHandle *mh, const char *name_override)
+/* animation frames are written on a background thread while the next frame
+ * renders, at most one frame is pending so memory use stays bounded */
+struct RenderWriteQueue {
+	TaskPool *pool;
+
+	ImBuf *ibuf;  /* frame being written, owns all of its buffers */
+	ImageFormatData imf;
+	char name[FILE_MAX];
+	bool ok;
+};
+
+static void render_write_queue_task(TaskPool *pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	RenderWriteQueue *wq = BLI_task_pool_userdata(pool);
+
+	wq->ok = BKE_imbuf_write(wq->ibuf, wq->name, &wq->imf) != 0;
+}
+
+/* waits for the pending frame, returns false if it could not be saved */
+static bool render_write_queue_flush(RenderWriteQueue *wq)
+{
+	bool ok = true;
+
+	if (wq->ibuf) {
+		BLI_task_pool_work_and_wait(wq->pool);
+		ok = wq->ok;
+
+		if (ok) printf("Saved: %s\n", wq->name);
+		else printf("Render error: cannot save %s\n", wq->name);
+
+		IMB_freeImBuf(wq->ibuf);
+		wq->ibuf = NULL;
+	}
+
+	return ok;
+}
+
+/* takes ownership of ibuf, returns false if the previous frame could not be saved */
+static bool render_write_queue_push(RenderWriteQueue *wq, Scene *scene, Object *camera, ImBuf *ibuf, const char *name)
+{
+	bool ok = render_write_queue_flush(wq);
+
+	/* buffers shared with the render result get overwritten by the next frame */
+	if (ibuf->rect && (ibuf->mall & IB_rect) == 0) {
+		ibuf->rect = MEM_dupallocN(ibuf->rect);
+		ibuf->mall |= IB_rect;
+	}
+	if (ibuf->rect_float && (ibuf->mall & IB_rectfloat) == 0) {
+		ibuf->rect_float = MEM_dupallocN(ibuf->rect_float);
+		ibuf->mall |= IB_rectfloat;
+	}
+	if (ibuf->zbuf_float && (ibuf->mall & IB_zbuffloat) == 0) {
+		ibuf->zbuf_float = MEM_dupallocN(ibuf->zbuf_float);
+		ibuf->mall |= IB_zbuffloat;
+	}
+
+	/* stamp info reads the scene, which changes with the next frame */
+	if (scene->r.stamp & R_STAMP_ALL)
+		BKE_imbuf_stamp_info(scene, camera, ibuf);
+
+	wq->ibuf = ibuf;
+	wq->imf = scene->r.im_format;
+	BLI_strncpy(wq->name, name, sizeof(wq->name));
+
+	BLI_task_pool_push(wq->pool, render_write_queue_task, NULL, false, TASK_PRIORITY_LOW);
+
+	return ok;
+}
+
+static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovieHandle *mh,
+                                   RenderWriteQueue *wq, const char *name_override)
 {
 	char name[FILE_MAX];
 	RenderResult rres;
@@ -2914,19 +2992,29 @@ static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovie
 		}
 		else {
 			ImBuf *ibuf = render_result_rect_to_ibuf(&rres, &scene->r);
+			const bool do_preview = (scene->r.im_format.imtype == R_IMF_IMTYPE_OPENEXR &&
+			                         (scene->r.im_format.flag & R_IMF_FLAG_PREVIEW_JPG));
 
 			IMB_colormanagement_imbuf_for_write(ibuf, true, false, &scene->view_settings,
 			                                    &scene->display_settings, &scene->r.im_format);
 
-			ok = BKE_imbuf_write_stamp(scene, camera, ibuf, name, &scene->r.im_format);
-			
-			if (ok == 0) {
-				printf("Render error: cannot save %s\n", name);
+			/* the preview is made from the same buffer after saving, so it stays synchronous */
+			if (wq && !do_preview) {
+				ok = render_write_queue_push(wq, scene, camera, ibuf, name);
+				printf("Queued: %s", name);
+				ibuf = NULL;
+			}
+			else {
+				ok = BKE_imbuf_write_stamp(scene, camera, ibuf, name, &scene->r.im_format);
+
+				if (ok == 0) {
+					printf("Render error: cannot save %s\n", name);
+				}
+				else printf("Saved: %s", name);
 			}
-			else printf("Saved: %s", name);
 			
 			/* optional preview images for exr */
-			if (ok && scene->r.im_format.imtype == R_IMF_IMTYPE_OPENEXR && (scene->r.im_format.flag & R_IMF_FLAG_PREVIEW_JPG)) {
+			if (ok && ibuf && do_preview) {
 				ImageFormatData imf = scene->r.im_format;
 				imf.imtype = R_IMF_IMTYPE_JPEG90;
 
@@ -2943,7 +3031,8 @@ static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovie
 			}
 			
 			/* imbuf knows which rects are not part of ibuf */
-			IMB_freeImBuf(ibuf);
+			if (ibuf)
+				IMB_freeImBuf(ibuf);
 		}
 	}
 	
@@ -2966,12 +3055,31 @@ static int do_write_image_or_movie(Render *re, Main *bmain, Scene *scene, bMovie
 	return ok;
 }
 
+static bool render_anim_post_has_handlers(void)
+{
+#ifdef WITH_PYTHON
+	return BPY_app_handlers_exist(BLI_CB_EVT_RENDER_POST);
+#else
+	return false;
+#endif
+}
+
+/* render_post handlers may read the file, so the frame has to be saved before they run,
+ * returns false if it could not be saved */
+static bool render_anim_post_flush(RenderWriteQueue *wq)
+{
+	if (wq && render_anim_post_has_handlers())
+		return render_write_queue_flush(wq);
+	return true;
+}
+
 /* saves images to disk */
 void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_override,
                     unsigned int lay_override, int sfra, int efra, int tfra)
 {
 	RenderData rd = scene->r;
 	bMovieHandle *mh = BKE_movie_handle_get(scene->r.im_format.imtype);
+	RenderWriteQueue write_queue = {NULL}, *wq = NULL;
 	int cfrao = scene->r.cfra;
 	int nfra, totrendered = 0, totskipped = 0;
 	
@@ -3007,6 +3115,10 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 		if (!mh->start_movie(scene, &re->r, width, height, re->reports))
 			G.is_break = true;
 	}
+	else if (scene->r.im_format.imtype != R_IMF_IMTYPE_MULTILAYER) {
+		write_queue.pool = BLI_task_pool_create(BLI_task_scheduler_get(), &write_queue);
+		wq = &write_queue;
+	}
 
 	if (mh->get_next_frame) {
 		while (!(G.is_break == 1)) {
@@ -3020,7 +3132,7 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 				totrendered++;
 
 				if (re->test_break(re->tbh) == 0) {
-					if (!do_write_image_or_movie(re, bmain, scene, mh, NULL))
+					if (!do_write_image_or_movie(re, bmain, scene, mh, wq, NULL))
 						G.is_break = true;
 				}
 
@@ -3089,13 +3201,21 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 			
 			if (re->test_break(re->tbh) == 0) {
 				if (!G.is_break)
-					if (!do_write_image_or_movie(re, bmain, scene, mh, NULL))
+					if (!do_write_image_or_movie(re, bmain, scene, mh, wq, NULL))
 						G.is_break = true;
 			}
 			else
 				G.is_break = true;
+
+			if (G.is_break == false && !render_anim_post_flush(wq))
+				G.is_break = true;
 		
 			if (G.is_break == true) {
+				/* the touched file may be the frame still being written */
+				if (wq) {
+					render_write_queue_flush(wq);
+				}
+
 				/* remove touched file */
 				if (BKE_imtype_is_movie(scene->r.im_format.imtype) == 0) {
 					if (scene->r.mode & R_TOUCH && BLI_exists(name) && BLI_file_size(name) == 0) {
@@ -3112,6 +3232,13 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 		}
 	}
 	
+	/* the last frame is still being written */
+	if (wq) {
+		if (!render_write_queue_flush(wq))
+			G.is_break = true;
+		BLI_task_pool_free(wq->pool);
+	}
+
 	/* end movie */
 	if (BKE_imtype_is_movie(scene->r.im_format.imtype))
 		mh->end_movie();
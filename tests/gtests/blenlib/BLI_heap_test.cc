@@ -0,0 +1,67 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include <string.h>
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_heap.h"
+#include "BLI_utildefines.h"
+};
+
+#define SIZE 1024
+
+/* values that aren't in order, so the heap has to sort them */
+static float heap_test_value(int i)
+{
+	return (float)TESTING_PERMUTE(i, SIZE);
+}
+
+TEST(heap, Empty)
+{
+	Heap *heap;
+
+	heap = BLI_heap_new();
+	EXPECT_EQ(BLI_heap_is_empty(heap), true);
+	EXPECT_EQ(BLI_heap_size(heap), 0);
+	BLI_heap_free(heap, NULL);
+}
+
+TEST(heap, Range)
+{
+	Heap *heap = BLI_heap_new();
+	int i;
+
+	for (i = 0; i < SIZE; i++) {
+		BLI_heap_insert(heap, heap_test_value(i), SET_INT_IN_POINTER(i));
+	}
+	for (i = 0; i < SIZE; i++) {
+		EXPECT_EQ(BLI_heap_node_value(BLI_heap_top(heap)), (float)i);
+		BLI_heap_popmin(heap);
+	}
+	EXPECT_EQ(BLI_heap_is_empty(heap), true);
+	BLI_heap_free(heap, NULL);
+}
+
+TEST(heap, ValueUpdate)
+{
+	Heap *heap = BLI_heap_new();
+	HeapNode *nodes[SIZE];
+	int i;
+
+	for (i = 0; i < SIZE; i++) {
+		nodes[i] = BLI_heap_insert(heap, heap_test_value(i), SET_INT_IN_POINTER(i));
+	}
+
+	/* reverse the order, moving nodes both up and down the heap */
+	for (i = 0; i < SIZE; i++) {
+		BLI_heap_node_value_update(heap, nodes[i], (float)(SIZE - i));
+	}
+	EXPECT_EQ(BLI_heap_size(heap), SIZE);
+
+	for (i = SIZE - 1; i >= 0; i--) {
+		EXPECT_EQ(BLI_heap_popmin(heap), SET_INT_IN_POINTER(i));
+	}
+	EXPECT_EQ(BLI_heap_is_empty(heap), true);
+	BLI_heap_free(heap, NULL);
+}
@@ -0,0 +1,120 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_kdtree.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+};
+
+/* the duplicates search runs on the task scheduler */
+static void kdtree_test_threads_init(void)
+{
+	static bool is_init = false;
+	if (!is_init) {
+		BLI_threadapi_init();
+		is_init = true;
+	}
+}
+
+static KDTree *kdtree_from_points(const float (*co)[3], const int tot)
+{
+	KDTree *tree = BLI_kdtree_new(tot);
+	for (int i = 0; i < tot; i++) {
+		BLI_kdtree_insert(tree, i, co[i]);
+	}
+	BLI_kdtree_balance(tree);
+	return tree;
+}
+
+/* reference implementation, claims neighbors in index order */
+static int calc_duplicates_brute_force(const float (*co)[3], const int tot, const float range, int *duplicates)
+{
+	int found = 0;
+	for (int pass = 0; pass < 2; pass++) {
+		for (int i = 0; i < tot; i++) {
+			if (duplicates[i] != ((pass == 0) ? i : -1)) {
+				continue;
+			}
+			const int found_prev = found;
+			for (int j = 0; j < tot; j++) {
+				if (j != i && duplicates[j] == -1 && len_squared_v3v3(co[i], co[j]) <= range * range) {
+					duplicates[j] = i;
+					found++;
+				}
+			}
+			if (pass == 1 && found != found_prev) {
+				duplicates[i] = i;
+			}
+		}
+	}
+	return found;
+}
+
+TEST(kdtree, DuplicatesNone)
+{
+	const float co[4][3] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+	int duplicates[4] = {-1, -1, -1, -1};
+
+	kdtree_test_threads_init();
+
+	KDTree *tree = kdtree_from_points(co, 4);
+	EXPECT_EQ(0, BLI_kdtree_calc_duplicates_fast(tree, 0.5f, true, duplicates));
+	for (int i = 0; i < 4; i++) {
+		EXPECT_EQ(-1, duplicates[i]);
+	}
+	BLI_kdtree_free(tree);
+}
+
+TEST(kdtree, DuplicatesPreferredTarget)
+{
+	const float co[3][3] = {{0, 0, 0}, {0.1f, 0, 0}, {0.2f, 0, 0}};
+	/* the last point is preferred, so it claims the others even though it has the highest index */
+	int duplicates[3] = {-1, -1, 2};
+
+	kdtree_test_threads_init();
+
+	KDTree *tree = kdtree_from_points(co, 3);
+	EXPECT_EQ(2, BLI_kdtree_calc_duplicates_fast(tree, 0.25f, true, duplicates));
+	EXPECT_EQ(2, duplicates[0]);
+	EXPECT_EQ(2, duplicates[1]);
+	EXPECT_EQ(2, duplicates[2]);
+	BLI_kdtree_free(tree);
+}
+
+/* axis aligned grid with clustered points, many equal coordinates */
+TEST(kdtree, DuplicatesGrid)
+{
+	const int tot = 8000;
+	const float range = 0.0015f;
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * tot, __func__);
+	int *duplicates = (int *)MEM_mallocN(sizeof(int) * tot, __func__);
+	int *duplicates_ref = (int *)MEM_mallocN(sizeof(int) * tot, __func__);
+
+	kdtree_test_threads_init();
+
+	for (int i = 0; i < tot; i++) {
+		const int cell = TESTING_PERMUTE(i, tot / 4);
+		co[i][0] = (float)(cell % 20) + (float)(i % 3) * 0.001f;
+		co[i][1] = (float)((cell / 20) % 20);
+		co[i][2] = (float)(cell / 400);
+		duplicates[i] = duplicates_ref[i] = (i % 97 == 0) ? i : -1;
+	}
+
+	KDTree *tree = kdtree_from_points(co, tot);
+	const int found = BLI_kdtree_calc_duplicates_fast(tree, range, true, duplicates);
+	const int found_ref = calc_duplicates_brute_force(co, tot, range, duplicates_ref);
+
+	EXPECT_EQ(found_ref, found);
+	for (int i = 0; i < tot; i++) {
+		EXPECT_EQ(duplicates_ref[i], duplicates[i]);
+	}
+
+	BLI_kdtree_free(tree);
+	MEM_freeN(co);
+	MEM_freeN(duplicates);
+	MEM_freeN(duplicates_ref);
+}
@@ -0,0 +1,163 @@
+#include "testing/testing.h"
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+
+#include "bmesh.h"
+
+/* grid of quads, each vertex stores its index in a float layer,
+ * with use_bumps the heights vary so most quads aren't planar */
+static BMesh *bm_grid_create(const int size, const bool use_bumps)
+{
+	const BMAllocTemplate allocsize = {
+	    (size + 1) * (size + 1), 2 * size * (size + 1), 4 * size * size, size * size};
+	BMesh *bm = BM_mesh_create(&allocsize);
+	BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * allocsize.totvert, __func__);
+	int x, y;
+
+	BM_data_layer_add(bm, &bm->vdata, CD_PROP_FLT);
+
+	for (y = 0; y <= size; y++) {
+		for (x = 0; x <= size; x++) {
+			const int i = y * (size + 1) + x;
+			const float co[3] = {(float)x, (float)y, use_bumps ? (float)((x * y) % 3) * 0.3f : 0.0f};
+			verts[i] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+			BM_elem_float_data_set(&bm->vdata, verts[i], CD_PROP_FLT, (float)i);
+		}
+	}
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			const int i = y * (size + 1) + x;
+			BMVert *f_verts[4] = {verts[i], verts[i + 1], verts[i + size + 2], verts[i + size + 1]};
+			BM_face_create_verts(bm, f_verts, 4, NULL, BM_CREATE_NOP, true);
+		}
+	}
+
+	MEM_freeN(verts);
+
+	return bm;
+}
+
+static void mesh_data_free(Mesh *me)
+{
+	CustomData_free(&me->vdata, me->totvert);
+	CustomData_free(&me->edata, me->totedge);
+	CustomData_free(&me->fdata, me->totface);
+	CustomData_free(&me->ldata, me->totloop);
+	CustomData_free(&me->pdata, me->totpoly);
+	if (me->mselect) {
+		MEM_freeN(me->mselect);
+	}
+}
+
+TEST(bmesh_mesh_conv, RoundTrip) {
+	const int size = 16;
+	BMesh *bm = bm_grid_create(size, false);
+	BMesh *bm_copy;
+	Mesh me;
+	int i;
+
+	memset(&me, 0, sizeof(me));
+	BM_mesh_bm_to_me(bm, &me, false);
+
+	EXPECT_EQ(bm->totvert, me.totvert);
+	EXPECT_EQ(bm->totedge, me.totedge);
+	EXPECT_EQ(bm->totloop, me.totloop);
+	EXPECT_EQ(bm->totface, me.totpoly);
+	ASSERT_TRUE(CustomData_has_layer(&me.vdata, CD_PROP_FLT));
+
+	bm_copy = BM_mesh_create(&bm_mesh_allocsize_default);
+	BM_mesh_bm_from_me(bm_copy, &me, true, false, 0);
+
+	EXPECT_EQ(bm->totvert, bm_copy->totvert);
+	EXPECT_EQ(bm->totedge, bm_copy->totedge);
+	EXPECT_EQ(bm->totloop, bm_copy->totloop);
+	EXPECT_EQ(bm->totface, bm_copy->totface);
+
+	BM_mesh_elem_table_ensure(bm_copy, BM_VERT);
+	for (i = 0; i < bm_copy->totvert; i++) {
+		BMVert *v = BM_vert_at_index(bm_copy, i);
+		EXPECT_EQ((float)i, BM_elem_float_data_get(&bm_copy->vdata, v, CD_PROP_FLT));
+		EXPECT_EQ((float)(i % (size + 1)), v->co[0]);
+		EXPECT_EQ((float)(i / (size + 1)), v->co[1]);
+	}
+
+	BM_mesh_free(bm_copy);
+	BM_mesh_free(bm);
+	mesh_data_free(&me);
+}
+
+/* enough faces for the normals to be calculated in parallel,
+ * they have to match the ones calculated one face at a time */
+TEST(bmesh_mesh_conv, FaceNormals) {
+	const int size = 128;
+	BMesh *bm = bm_grid_create(size, true);
+	BMesh *bm_copy;
+	Mesh me;
+	int i, tot_tilted = 0;
+
+	ASSERT_GE(size * size, BM_OMP_LIMIT);
+
+	memset(&me, 0, sizeof(me));
+	BM_mesh_bm_to_me(bm, &me, false);
+
+	bm_copy = BM_mesh_create(&bm_mesh_allocsize_default);
+	BM_mesh_bm_from_me(bm_copy, &me, true, false, 0);
+	ASSERT_EQ(size * size, bm_copy->totface);
+
+	BM_mesh_elem_table_ensure(bm_copy, BM_FACE);
+	for (i = 0; i < bm_copy->totface; i++) {
+		BMFace *f = BM_face_at_index(bm_copy, i);
+		float no[3];
+
+		copy_v3_v3(no, f->no);
+		zero_v3(f->no);
+		BM_face_normal_update(f);
+
+		EXPECT_V3_NEAR(f->no, no, 1e-6f);
+		if (fabsf(no[2]) < 0.999f) {
+			tot_tilted++;
+		}
+	}
+	/* make sure the grid isn't flat, so the normals differ between faces */
+	EXPECT_GT(tot_tilted, bm_copy->totface / 2);
+
+	BM_mesh_free(bm_copy);
+	BM_mesh_free(bm);
+	mesh_data_free(&me);
+}
+
+/* Benchmark, run with --gtest_also_run_disabled_tests, the timing is the one
+ * gtest reports for the test. Converts a million face grid both ways. */
+TEST(bmesh_mesh_conv, DISABLED_Benchmark) {
+	const int size = 1000;
+	BMesh *bm = bm_grid_create(size, false);
+	BMesh *bm_copy;
+	Mesh me;
+
+	memset(&me, 0, sizeof(me));
+	BM_mesh_bm_to_me(bm, &me, false);
+	EXPECT_EQ(size * size, me.totpoly);
+
+	{
+		const BMAllocTemplate allocsize = BMALLOC_TEMPLATE_FROM_ME(&me);
+		bm_copy = BM_mesh_create(&allocsize);
+	}
+
+	BM_mesh_bm_from_me(bm_copy, &me, true, false, 0);
+	EXPECT_EQ(size * size, bm_copy->totface);
+
+	BM_mesh_free(bm_copy);
+	BM_mesh_free(bm);
+	mesh_data_free(&me);
+}
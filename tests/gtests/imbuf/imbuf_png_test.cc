@@ -0,0 +1,146 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_threads.h"
+
+#include "IMB_imbuf_types.h"
+#include "IMB_imbuf.h"
+}
+
+/* large enough to be compressed in chunks on several threads, with a height
+ * that doesn't divide into whole chunks, 16 bit images use half of it */
+#define WIDTH 2048
+#define HEIGHT 2049
+
+static unsigned char png_pattern_value(const int i, const int j, const int c)
+{
+	return (unsigned char)((i * 3 + j * 5 + c * 37 + (i * j) % 7) & 255);
+}
+
+/* with use_float the float buffer gets values that use all 16 bits */
+static ImBuf *png_pattern_create(const int x, const int y, const int planes, const bool use_float)
+{
+	ImBuf *ibuf = IMB_allocImBuf(x, y, planes, use_float ? IB_rect | IB_rectfloat : IB_rect);
+	unsigned char *rect = (unsigned char *)ibuf->rect;
+	int i, j, c;
+
+	for (j = 0; j < y; j++) {
+		for (i = 0; i < x; i++) {
+			for (c = 0; c < 4; c++) {
+				const size_t ofs = ((size_t)j * x + i) * 4 + c;
+				rect[ofs] = png_pattern_value(i, j, c);
+				if (use_float) {
+					ibuf->rect_float[ofs] = (float)((i * 7 + j * 13 + c * 1009) & 65535) / 65535.0f;
+				}
+			}
+		}
+	}
+
+	return ibuf;
+}
+
+/* saves the pattern to memory and loads it back, with one thread libpng compresses
+ * the image itself, which the chunked files are compared to, the thread count is
+ * set so chunks are used on single core machines too */
+static ImBuf *png_pattern_round_trip(const int x, const int y, const int planes, const bool is_16bit,
+                                     const bool use_threads, size_t *r_size)
+{
+	ImBuf *ibuf = png_pattern_create(x, y, planes, is_16bit);
+	ImBuf *ibuf_load;
+	char colorspace[IM_MAX_SPACE] = "";
+
+	ibuf->ftype = PNG | 90;
+	if (is_16bit) {
+		ibuf->ftype |= PNG_16BIT;
+	}
+
+	BLI_system_num_threads_override_set(use_threads ? 4 : 1);
+	EXPECT_TRUE(IMB_saveiff(ibuf, "<memory>", IB_rect | IB_mem));
+	BLI_system_num_threads_override_set(0);
+
+	*r_size = ibuf->encodedsize;
+	ibuf_load = IMB_ibImageFromMemory(ibuf->encodedbuffer, ibuf->encodedsize, IB_rect, colorspace, "<memory>");
+	IMB_freeImBuf(ibuf);
+
+	return ibuf_load;
+}
+
+static void png_round_trip_test(const int planes, const bool is_16bit)
+{
+	const int x = is_16bit ? WIDTH / 2 : WIDTH, y = is_16bit ? HEIGHT / 2 : HEIGHT;
+	size_t size, size_ref;
+	ImBuf *ibuf = png_pattern_round_trip(x, y, planes, is_16bit, true, &size);
+	ImBuf *ibuf_ref = png_pattern_round_trip(x, y, planes, is_16bit, false, &size_ref);
+	const size_t len = (size_t)x * y * 4;
+
+	ASSERT_TRUE(ibuf != NULL);
+	ASSERT_TRUE(ibuf_ref != NULL);
+	ASSERT_EQ(x, ibuf->x);
+	ASSERT_EQ(y, ibuf->y);
+
+	/* the filter and the chunks cost some compression, but not much */
+	EXPECT_LT(size, size_ref + size_ref / 10);
+
+	if (is_16bit) {
+		ASSERT_TRUE(ibuf->rect_float != NULL);
+		ASSERT_TRUE(ibuf_ref->rect_float != NULL);
+		EXPECT_EQ(0, memcmp(ibuf_ref->rect_float, ibuf->rect_float, len * sizeof(float)));
+	}
+	else {
+		const unsigned char *rect = (unsigned char *)ibuf->rect;
+		int i, j, c;
+
+		ASSERT_EQ(0, memcmp(ibuf_ref->rect, ibuf->rect, len));
+
+		for (j = 0; j < y; j++) {
+			for (i = 0; i < x; i++) {
+				for (c = 0; c < 4; c++) {
+					/* gray is saved from red, missing alpha is loaded opaque */
+					const unsigned char expected = (c == 3 && planes != 32) ? 255 :
+					                               png_pattern_value(i, j, planes == 8 ? 0 : c);
+					ASSERT_EQ(expected, rect[((size_t)j * x + i) * 4 + c]);
+				}
+			}
+		}
+	}
+
+	IMB_freeImBuf(ibuf);
+	IMB_freeImBuf(ibuf_ref);
+}
+
+TEST(imbuf_png, RGBA) {
+	IMB_init();
+	png_round_trip_test(32, false);
+	IMB_exit();
+}
+
+TEST(imbuf_png, RGB) {
+	IMB_init();
+	png_round_trip_test(24, false);
+	IMB_exit();
+}
+
+TEST(imbuf_png, BW) {
+	IMB_init();
+	png_round_trip_test(8, false);
+	IMB_exit();
+}
+
+TEST(imbuf_png, RGBA16) {
+	IMB_init();
+	png_round_trip_test(32, true);
+	IMB_exit();
+}
+
+TEST(imbuf_png, RGB16) {
+	IMB_init();
+	png_round_trip_test(24, true);
+	IMB_exit();
+}
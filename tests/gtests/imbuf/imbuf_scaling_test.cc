@@ -0,0 +1,179 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf_types.h"
+#include "IMB_imbuf.h"
+}
+
+static void imbuf_pattern_value(const int i, const int j, const int c, unsigned char *r_byte, float *r_float)
+{
+	*r_byte = (unsigned char)((i * 3 + j * 5 + c * 37) & 255);
+	*r_float = (float)*r_byte / 255.0f;
+}
+
+static ImBuf *imbuf_pattern_create(const int x, const int y)
+{
+	ImBuf *ibuf = IMB_allocImBuf(x, y, 32, IB_rect | IB_rectfloat);
+	unsigned char *rect = (unsigned char *)ibuf->rect;
+	float *rectf = ibuf->rect_float;
+	int i, j, c;
+
+	for (j = 0; j < y; j++) {
+		for (i = 0; i < x; i++) {
+			for (c = 0; c < 4; c++) {
+				const size_t ofs = ((size_t)j * x + i) * 4 + c;
+				imbuf_pattern_value(i, j, c, &rect[ofs], &rectf[ofs]);
+			}
+		}
+	}
+
+	return ibuf;
+}
+
+/* a single row or column of the pattern, small enough to be scaled without threads */
+static ImBuf *imbuf_pattern_line_create(const int x, const int y, const int line, const bool is_row)
+{
+	const int len = is_row ? x : y;
+	ImBuf *ibuf = IMB_allocImBuf(is_row ? len : 1, is_row ? 1 : len, 32, IB_rect | IB_rectfloat);
+	unsigned char *rect = (unsigned char *)ibuf->rect;
+	float *rectf = ibuf->rect_float;
+	int k, c;
+
+	for (k = 0; k < len; k++) {
+		for (c = 0; c < 4; c++) {
+			if (is_row) {
+				imbuf_pattern_value(k, line, c, &rect[k * 4 + c], &rectf[k * 4 + c]);
+			}
+			else {
+				imbuf_pattern_value(line, k, c, &rect[k * 4 + c], &rectf[k * 4 + c]);
+			}
+		}
+	}
+
+	return ibuf;
+}
+
+/* Scale along one axis, the rows (or columns) are filtered independently,
+ * so every one of them has to match the same line scaled on its own. */
+static void imbuf_scale_lines_test(const int x, const int y, const int newx, const int newy)
+{
+	const bool is_row = (newy == y);
+	const int tot_line = is_row ? y : x;
+	ImBuf *ibuf = imbuf_pattern_create(x, y);
+	const unsigned char *rect;
+	const float *rectf;
+	int line, k, c;
+
+	IMB_scaleImBuf(ibuf, newx, newy);
+
+	ASSERT_EQ(newx, ibuf->x);
+	ASSERT_EQ(newy, ibuf->y);
+
+	rect = (unsigned char *)ibuf->rect;
+	rectf = ibuf->rect_float;
+
+	for (line = 0; line < tot_line; line++) {
+		ImBuf *ibuf_line = imbuf_pattern_line_create(x, y, line, is_row);
+		const int len = is_row ? newx : newy;
+		const unsigned char *line_rect;
+		const float *line_rectf;
+
+		IMB_scaleImBuf(ibuf_line, is_row ? newx : 1, is_row ? 1 : newy);
+		line_rect = (unsigned char *)ibuf_line->rect;
+		line_rectf = ibuf_line->rect_float;
+
+		for (k = 0; k < len; k++) {
+			const size_t ofs = is_row ? ((size_t)line * newx + k) : ((size_t)k * newx + line);
+
+			for (c = 0; c < 4; c++) {
+				ASSERT_EQ(line_rect[k * 4 + c], rect[ofs * 4 + c]);
+				ASSERT_EQ(line_rectf[k * 4 + c], rectf[ofs * 4 + c]);
+			}
+		}
+
+		IMB_freeImBuf(ibuf_line);
+	}
+
+	IMB_freeImBuf(ibuf);
+}
+
+TEST(imbuf_scaling, PatternValues) {
+	ImBuf *ibuf;
+	const unsigned char *rect;
+
+	IMB_init();
+
+	/* halving averages pairs of pixels, the pattern steps by 3 between them */
+	ibuf = imbuf_pattern_create(4, 1);
+	IMB_scaleImBuf(ibuf, 2, 1);
+	rect = (unsigned char *)ibuf->rect;
+	EXPECT_NEAR(1.5f, rect[0], 1.0f);
+	EXPECT_NEAR(7.5f, rect[4], 1.0f);
+	EXPECT_NEAR(1.5f / 255.0f, ibuf->rect_float[0], 1e-4f);
+	EXPECT_NEAR(7.5f / 255.0f, ibuf->rect_float[4], 1e-4f);
+	IMB_freeImBuf(ibuf);
+
+	IMB_exit();
+}
+
+TEST(imbuf_scaling, Small) {
+	IMB_init();
+
+	imbuf_scale_lines_test(64, 32, 17, 32);
+	imbuf_scale_lines_test(64, 32, 128, 32);
+	imbuf_scale_lines_test(64, 32, 64, 8);
+	imbuf_scale_lines_test(64, 32, 64, 100);
+
+	IMB_exit();
+}
+
+/* large enough for the lines to be split over threads */
+TEST(imbuf_scaling, Large) {
+	IMB_init();
+
+	imbuf_scale_lines_test(1024, 512, 333, 512);
+	imbuf_scale_lines_test(1024, 512, 2000, 512);
+	imbuf_scale_lines_test(1024, 512, 1024, 131);
+	imbuf_scale_lines_test(1024, 512, 1024, 1001);
+
+	IMB_exit();
+}
+
+/* Benchmark, run with --gtest_also_run_disabled_tests, the timings are the ones
+ * gtest reports for the test. Scales a 4K frame with the quality
+ * functions and the ones they are compared to. */
+TEST(imbuf_scaling, DISABLED_Benchmark) {
+	const int x = 3840, y = 2160;
+	ImBuf *ibuf;
+
+	IMB_init();
+
+	ibuf = imbuf_pattern_create(x, y);
+	IMB_scaleImBuf(ibuf, x / 2, y / 2);
+	EXPECT_EQ(x / 2, ibuf->x);
+	IMB_freeImBuf(ibuf);
+
+	ibuf = imbuf_pattern_create(x / 2, y / 2);
+	IMB_scaleImBuf(ibuf, x, y);
+	EXPECT_EQ(x, ibuf->x);
+	IMB_freeImBuf(ibuf);
+
+	/* the bilinear and nearest neighbor functions, for comparison */
+	ibuf = imbuf_pattern_create(x, y);
+	IMB_scaleImBuf_threaded(ibuf, x / 2, y / 2);
+	EXPECT_EQ(x / 2, ibuf->x);
+	IMB_freeImBuf(ibuf);
+
+	ibuf = imbuf_pattern_create(x, y);
+	IMB_scalefastImBuf(ibuf, x / 2, y / 2);
+	EXPECT_EQ(x / 2, ibuf->x);
+	IMB_freeImBuf(ibuf);
+
+	IMB_exit();
+}
@@ -0,0 +1,167 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
+
+namespace {
+
+struct CacheItem {
+	size_t size;
+	int priority;
+	bool destroyed;
+	MEM_CacheLimiterHandleC *handle;
+};
+
+void item_destruct(void *data)
+{
+	((CacheItem *)data)->destroyed = true;
+}
+
+size_t item_size(void *data)
+{
+	return ((CacheItem *)data)->size;
+}
+
+int item_priority(void *data, int /*default_priority*/)
+{
+	return ((CacheItem *)data)->priority;
+}
+
+/* Creates a limiter holding totitem items of one byte each,
+ * the global cache maximum is restored by cache_free(). */
+MEM_CacheLimiterC *cache_create(CacheItem *items, int totitem, bool use_priority)
+{
+	MEM_CacheLimiterC *cache = new_MEM_CacheLimiter(item_destruct, item_size);
+
+	if (use_priority) {
+		MEM_CacheLimiter_ItemPriority_Func_set(cache, item_priority);
+	}
+
+	for (int i = 0; i < totitem; i++) {
+		items[i].size = 1;
+		/* scatter priorities so they don't follow the insertion order */
+		items[i].priority = TESTING_PERMUTE(i, totitem);
+		items[i].destroyed = false;
+		items[i].handle = MEM_CacheLimiter_insert(cache, &items[i]);
+	}
+
+	return cache;
+}
+
+void cache_free(MEM_CacheLimiterC *cache, CacheItem *items, int totitem)
+{
+	for (int i = 0; i < totitem; i++) {
+		if (!items[i].destroyed) {
+			MEM_CacheLimiter_unmanage(items[i].handle);
+		}
+	}
+	delete_MEM_CacheLimiter(cache);
+}
+
+class CacheLimiterTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		maximum_orig = MEM_CacheLimiter_get_maximum();
+	}
+
+	virtual void TearDown() {
+		MEM_CacheLimiter_set_maximum(maximum_orig);
+	}
+
+	size_t maximum_orig;
+};
+
+}  // namespace
+
+#define SIZE 1024
+
+TEST_F(CacheLimiterTest, MemoryInUse)
+{
+	CacheItem items[SIZE];
+	MEM_CacheLimiterC *cache = cache_create(items, SIZE, false);
+
+	EXPECT_EQ((size_t)SIZE, MEM_CacheLimiter_get_memory_in_use(cache));
+
+	MEM_CacheLimiter_unmanage(items[0].handle);
+	items[0].destroyed = true;
+	EXPECT_EQ((size_t)(SIZE - 1), MEM_CacheLimiter_get_memory_in_use(cache));
+
+	/* size changes are picked up on touch */
+	items[1].size = 10;
+	MEM_CacheLimiter_touch(items[1].handle);
+	EXPECT_EQ((size_t)(SIZE + 8), MEM_CacheLimiter_get_memory_in_use(cache));
+
+	cache_free(cache, items, SIZE);
+}
+
+TEST_F(CacheLimiterTest, LeastRecentlyUsed)
+{
+	CacheItem items[SIZE];
+	MEM_CacheLimiterC *cache = cache_create(items, SIZE, false);
+	int i;
+
+	MEM_CacheLimiter_touch(items[0].handle);
+	MEM_CacheLimiter_ref(items[1].handle);
+
+	MEM_CacheLimiter_set_maximum(SIZE / 2);
+	MEM_CacheLimiter_enforce_limits(cache);
+	EXPECT_EQ((size_t)(SIZE / 2), MEM_CacheLimiter_get_memory_in_use(cache));
+
+	/* touched and referenced items are kept, others are freed in insertion order */
+	EXPECT_FALSE(items[0].destroyed);
+	EXPECT_FALSE(items[1].destroyed);
+	for (i = 2; i < SIZE / 2 + 2; i++) {
+		EXPECT_TRUE(items[i].destroyed);
+	}
+	for (; i < SIZE; i++) {
+		EXPECT_FALSE(items[i].destroyed);
+	}
+
+	MEM_CacheLimiter_unref(items[1].handle);
+	cache_free(cache, items, SIZE);
+}
+
+TEST_F(CacheLimiterTest, Priority)
+{
+	CacheItem items[SIZE];
+	MEM_CacheLimiterC *cache = cache_create(items, SIZE, true);
+
+	MEM_CacheLimiter_set_maximum(SIZE / 4);
+	MEM_CacheLimiter_enforce_limits(cache);
+	EXPECT_EQ((size_t)(SIZE / 4), MEM_CacheLimiter_get_memory_in_use(cache));
+
+	/* lowest priorities are freed first */
+	for (int i = 0; i < SIZE; i++) {
+		EXPECT_EQ(items[i].priority < SIZE - SIZE / 4, items[i].destroyed);
+	}
+
+	cache_free(cache, items, SIZE);
+}
+
+/* Benchmark, run with --gtest_also_run_disabled_tests, the timing is the one
+ * gtest reports for the test. Touches every item of a large cache and frees
+ * half of it by priority. */
+TEST_F(CacheLimiterTest, DISABLED_Benchmark)
+{
+	const int totitem = 100000;
+	CacheItem *items = (CacheItem *)MEM_mallocN(sizeof(*items) * totitem, __func__);
+	MEM_CacheLimiterC *cache;
+
+	MEM_CacheLimiter_set_maximum(totitem);
+
+	cache = cache_create(items, totitem, true);
+	for (int i = 0; i < totitem; i++) {
+		MEM_CacheLimiter_touch(items[i].handle);
+		MEM_CacheLimiter_enforce_limits(cache);
+	}
+	EXPECT_EQ((size_t)totitem, MEM_CacheLimiter_get_memory_in_use(cache));
+
+	MEM_CacheLimiter_set_maximum(totitem / 2);
+	MEM_CacheLimiter_enforce_limits(cache);
+	EXPECT_EQ((size_t)(totitem / 2), MEM_CacheLimiter_get_memory_in_use(cache));
+
+	cache_free(cache, items, totitem);
+	MEM_freeN(items);
+}
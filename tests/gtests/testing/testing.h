@@ -12,6 +12,10 @@
     EXPECT_NEAR(a[2], b[2], eps); \
   } (void) 0
 
+// i-th element of a fixed permutation of 0..n-1 (n must not be a multiple
+// of 7919), for feeding test data in an order that isn't sorted.
+#define TESTING_PERMUTE(i, n) ((int)(((long long)(i) * 7919) % (n)))
+
 #define EXPECT_MATRIX_NEAR(a, b, tolerance) \
 do { \
   bool dims_match = (a.rows() == b.rows()) && (a.cols() == b.cols()); \